@@ -145,6 +145,38 @@ BN_EXPORT extern double bn_noise_mf(point_t point,
 				    double octaves,
 				    double offset);
 
+/**
+ * @brief
+ * Batched versions of bn_noise_perlin(), bn_noise_fbm(),
+ * bn_noise_turb() and bn_noise_mf().
+ *
+ * Evaluate n points given in structure-of-arrays form - the i-th
+ * point is (x[i], y[i], z[i]) - storing the i-th value in result[i].
+ * The values are the same as calling the single point functions on
+ * each point, but points are processed in blocks laid out so the
+ * compiler can vectorize the arithmetic, and the spectral weights
+ * table is looked up once per call rather than once per point.  Safe
+ * to call from multiple threads.
+ */
+BN_EXPORT extern void bn_noise_perlin_n(double *result, size_t n,
+					const fastf_t *x, const fastf_t *y, const fastf_t *z);
+BN_EXPORT extern void bn_noise_fbm_n(double *result, size_t n,
+				     const fastf_t *x, const fastf_t *y, const fastf_t *z,
+				     double h_val,
+				     double lacunarity,
+				     double octaves);
+BN_EXPORT extern void bn_noise_turb_n(double *result, size_t n,
+				      const fastf_t *x, const fastf_t *y, const fastf_t *z,
+				      double h_val,
+				      double lacunarity,
+				      double octaves);
+BN_EXPORT extern void bn_noise_mf_n(double *result, size_t n,
+				    const fastf_t *x, const fastf_t *y, const fastf_t *z,
+				    double h_val,
+				    double lacunarity,
+				    double octaves,
+				    double offset);
+
 /**
  *@brief
  * A ridged noise pattern
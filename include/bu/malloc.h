@@ -146,12 +146,16 @@ BU_EXPORT extern size_t bu_malloc_len_roundup(size_t nbytes);
  * really fast heap-based memory allocation intended for "small"
  * allocation sizes (e.g., single structs).
  *
- * the implementation allocates chunks of memory ('pages') in order to
- * substantially reduce calls to system malloc.  it has a nice
- * property of having O(1) constant time complexity and profiles
- * significantly faster than system malloc().
+ * the implementation keeps a per-thread cache of free objects for
+ * each 16-byte size class, refilled from and spilled to shared
+ * per-class lists in batches, so the common get and put take no lock.
+ * objects come from 64KB slabs carved out of one reserved address
+ * range, and slabs left with no live objects are given back to the
+ * system.  memory is zeroed and 16-byte aligned.  requests larger
+ * than 256 bytes are passed to bu_calloc().
  *
- * release memory with bu_heap_put() only.
+ * release memory with bu_heap_put().  bu_free() also recognizes heap
+ * memory and will release it correctly.
  */
 BU_EXPORT extern void *bu_heap_get(size_t sz);
 
@@ -159,9 +163,10 @@ BU_EXPORT extern void *bu_heap_get(size_t sz);
  * counterpart to bu_heap_get() for releasing fast heap-based memory
  * allocations.
  *
- * the implementation may do nothing, relying on free-on-exit, or may
- * mark deallocations for reuse.  pass a NULL pointer and zero size to
- * force compaction of any unused memory.
+ * the size is only advisory, the real size is looked up from the
+ * pointer, and memory that did not come from the heap is passed to
+ * bu_free().  pass a NULL pointer and zero size to return the calling
+ * thread's cached objects and give unused slabs back to the system.
  */
 BU_EXPORT extern void bu_heap_put(void *ptr, size_t sz);
 
@@ -185,6 +190,10 @@ BU_EXPORT extern bu_heap_func_t bu_heap_log(bu_heap_func_t log);
 /**
  * Memory pools. To be used when you need to dynamically allocate
  * lots of small elements which will all be freed at the same time.
+ *
+ * A pool is one contiguous block that is reallocated as it grows, so
+ * pointers returned by bu_pool_alloc() may move.  Use a bu_arena when
+ * elements point at each other.
  */
 struct bu_pool
 {
@@ -200,6 +209,65 @@ BU_EXPORT extern void *bu_pool_alloc(struct bu_pool *pool, size_t nelem, size_t
 BU_EXPORT extern void bu_pool_delete(struct bu_pool *pool);
 
 
+/**
+ * Memory arenas.  Like a pool, an arena hands out memory from large
+ * chunks and frees it all at once, but it grows by adding chunks so
+ * its memory never moves.  Requests too big for a chunk get one of
+ * their own.  A mark records the current fill so everything allocated
+ * after it can be released in one step, which lets an arena serve as
+ * scratch space for nested or repeated work.
+ */
+struct bu_arena_chunk; /* private */
+struct bu_arena {
+    struct bu_arena_chunk *chunks;	/* newest first */
+    struct bu_arena_chunk *spare;	/* kept by a reset for reuse */
+    size_t chunk_size;
+    size_t align;
+    size_t pos;			/* fill of the chunk at the head */
+    size_t seq;			/* chunks created so far */
+};
+
+struct bu_arena_mark {
+    size_t seq;
+    size_t pos;
+};
+
+/**
+ * create an arena handing out chunk_size byte chunks (0 for a
+ * default), with every allocation aligned to align bytes, which must
+ * be a power of two (0 for 16).
+ */
+BU_EXPORT extern struct bu_arena *bu_arena_create(size_t chunk_size, size_t align);
+
+/**
+ * allocate nelem*elsize bytes from the arena.  memory is not
+ * initialized, and is only released by bu_arena_reset() or
+ * bu_arena_delete().  never returns NULL.
+ */
+BU_EXPORT extern void *bu_arena_alloc(struct bu_arena *arena, size_t nelem, size_t elsize);
+
+/**
+ * record the arena's current fill in mark.
+ */
+BU_EXPORT extern void bu_arena_mark(struct bu_arena *arena, struct bu_arena_mark *mark);
+
+/**
+ * release everything allocated since mark was set, or everything if
+ * mark is NULL.  marks set after mark become invalid.
+ */
+BU_EXPORT extern void bu_arena_reset(struct bu_arena *arena, const struct bu_arena_mark *mark);
+
+BU_EXPORT extern void bu_arena_delete(struct bu_arena *arena);
+
+/**
+ * the calling thread's own arena, created on first use, for scratch
+ * memory that needs no locking.  callers should bracket their use
+ * with bu_arena_mark() and bu_arena_reset() so that memory is reused.
+ * it is deleted when a bu_parallel() thread exits.
+ */
+BU_EXPORT extern struct bu_arena *bu_arena_thread(void);
+
+
 /**
  * Attempt to get shared memory - returns -1 if new memory was
  * created, 0 if successfully returning existing memory, and 1
@@ -213,14 +281,21 @@ BU_EXPORT extern int bu_shmget(int *shmid, char **shared_memory, int key, size_t
  * Memory is automatically initialized to zero and, similar to
  * bu_calloc(), is guaranteed to return non-NULL (or bu_bomb()).
  *
- * Memory acquired with BU_GET() should be returned with BU_PUT(), NOT
- * with bu_free().
+ * Memory acquired with BU_GET() should be returned with BU_PUT().
+ * bu_free() will also release it correctly, but is slower.
  *
  * Use BU_ALLOC() for dynamically allocating structures that are
  * relatively large, infrequently allocated, or otherwise don't need
  * to be fast.
+ *
+ * The objects come from slabs carved out of address space libbu
+ * reserves at startup (64 GiB on 64-bit hosts).  Nothing is committed
+ * until used, but the reservation counts against an address space
+ * limit such as ulimit -v, so it is cut to an eighth of any such
+ * limit.  Setting BU_HEAP_RESERVE in the environment gives the size
+ * in megabytes, with 0 falling back to bu_calloc() entirely.
  */
-#if 0
+#ifndef BU_HEAP_DISABLE
 #define BU_GET(_ptr, _type) _ptr = (_type *)bu_heap_get(sizeof(_type))
 #else
 #define BU_GET(_ptr, _type) _ptr = (_type *)bu_calloc(1, sizeof(_type), #_type " (BU_GET) " CPP_FILELINE)
@@ -234,8 +309,8 @@ BU_EXPORT extern int bu_shmget(int *shmid, char **shared_memory, int key, size_t
  * Memory acquired with bu_malloc()/bu_calloc() should be returned
  * with bu_free(), NOT with BU_PUT().
  */
-#if 0
-#define BU_PUT(_ptr, _type) *(uint8_t *)(_type *)(_ptr) = /*zap*/ 0; bu_heap_put(_ptr, sizeof(_type)); _ptr = NULL
+#ifndef BU_HEAP_DISABLE
+#define BU_PUT(_ptr, _type) do { *(uint8_t *)(_type *)(_ptr) = /*zap*/ 0; bu_heap_put(_ptr, sizeof(_type)); _ptr = NULL; } while (0)
 #else
 #define BU_PUT(_ptr, _type) do { *(uint8_t *)(_type *)(_ptr) = /*zap*/ 0; bu_free(_ptr, #_type " (BU_PUT) " CPP_FILELINE); _ptr = NULL; } while (0)
 #endif
@@ -541,6 +541,12 @@ typedef struct fb_internal FBIO;
 #define MSG_FBBWREADRECT  32            /**< @brief NEW in Release 4.6 */
 #define MSG_FBBWWRITERECT 33            /**< @brief NEW in Release 4.6 */
 #define MSG_FBAUTH        34            /**< @brief Session token authentication */
+#define MSG_FBSHMOPEN     35            /**< @brief Request a shared-memory pixel mirror */
+#define MSG_FBSHMREADY    36            /**< @brief Client attached (or gave up on) the mirror */
+#define MSG_FBSHMWRITE    37            /**< @brief Span written into the mirror */
+#define MSG_FBSHMWRITERECT 38           /**< @brief Rectangle written into the mirror */
+#define MSG_FBSHMREAD     39            /**< @brief Refresh a span of the mirror */
+#define MSG_FBSHMREADRECT 40            /**< @brief Refresh a rectangle of the mirror */
 
 #define MSG_DATA          20
 #define MSG_RETURN        21
@@ -83,6 +83,7 @@ struct fbserv_client {
     int fbsc_auth_ok;                   /**< @brief !0 = client has sent a valid MSG_FBAUTH */
     int fbsc_pending_drop;              /**< @brief !0 = drop this client after pkg_process() returns */
     int fbsc_is_ipc;                    /**< @brief !0 = client is connected via IPC (not TCP) */
+    void *fbsc_shm;                     /**< @brief shared pixel mirror (MSG_FBSHMOPEN), NULL if none */
 };
 
 
@@ -189,6 +190,68 @@ DM_EXPORT extern const char *fbs_ipc_child_addr_env(struct fbserv_obj *fbsp);
 DM_EXPORT extern const char *fbs_generate_token(struct fbserv_obj *fbsp);
 
 
+/* Shared-memory pixel transport */
+
+/** fb_open() name prefix selecting the shared-memory transport */
+#define FBSERV_SHM_PREFIX "shm:"
+#define FBSERV_SHM_HDRLEN 64 /**< @brief pixels start this far into the segment */
+
+/**
+ * A SysV segment holding a width x height RGB mirror of a framebuffer,
+ * shared between fbserv and a local client.  See libdm/fbserv_shm.c for
+ * the protocol.
+ */
+struct fbserv_shm {
+    int fbsh_id;                        /**< @brief SysV segment id, -1 when unused */
+    int fbsh_key;                       /**< @brief bu_shmget() key of the segment */
+    unsigned char *fbsh_base;           /**< @brief attached segment, NULL when unused */
+    unsigned char *fbsh_pix;            /**< @brief RGB mirror, fbsh_width*fbsh_height pixels */
+    int fbsh_width;
+    int fbsh_height;
+    uint32_t fbsh_cookie;
+    int fbsh_owner;                     /**< @brief !0 = we created the segment */
+    int fbsh_linked;                    /**< @brief !0 = segment key is still attachable */
+};
+
+DM_EXPORT extern void fbs_shm_init(struct fbserv_shm *s);
+
+/**
+ * Remove the segment from the system namespace.  Existing attachments
+ * stay valid until they are detached.
+ */
+DM_EXPORT extern void fbs_shm_unlink(struct fbserv_shm *s);
+DM_EXPORT extern void fbs_shm_release(struct fbserv_shm *s);
+
+/** Bounds checks for a span or rectangle of the mirror */
+DM_EXPORT extern int fbs_shm_span_ok(const struct fbserv_shm *s, int x, int y, size_t num);
+DM_EXPORT extern int fbs_shm_rect_ok(const struct fbserv_shm *s, int x, int y, int w, int h);
+DM_EXPORT extern unsigned char *fbs_shm_pixel(const struct fbserv_shm *s, int x, int y);
+
+/**
+ * Server side: create and attach a segment large enough for a width x
+ * height mirror.  Returns 0 on success, -1 on failure (including
+ * platforms without SysV shared memory).
+ */
+DM_EXPORT extern int fbs_shm_create(struct fbserv_shm *s, int width, int height);
+
+/**
+ * Server side: copy a span or rectangle of the mirror to the
+ * framebuffer (push) or refresh it from the framebuffer (pull).  A
+ * height of 0 means (x, y, w) is an fb_write() style span.  Returns
+ * what the underlying fb call returns.
+ */
+DM_EXPORT extern int fbs_shm_push(const struct fbserv_shm *s, struct fb *fbp, int x, int y, int w, int h);
+DM_EXPORT extern int fbs_shm_pull(const struct fbserv_shm *s, struct fb *fbp, int x, int y, int w, int h);
+
+/**
+ * Client side: attach to a segment announced by the server and verify
+ * its header.  Returns 0 on success, -1 if the segment is not reachable
+ * from this process (e.g. the server is on another host) or does not
+ * match.
+ */
+DM_EXPORT extern int fbs_shm_attach(struct fbserv_shm *s, int key, uint32_t cookie, int width, int height);
+
+
 __END_DECLS
 
 #endif /* DM_FBSERV_H */
@@ -78,6 +78,7 @@ struct pkg_header {
 };
 
 #define	PKG_STREAMLEN	(32*1024)
+#define	PKG_RINGLEN	(256*1024)	/**< @brief size of the input ring */
 struct pkg_conn {
     int	pkc_fd;					/**< @brief TCP connection fd */
     int pkc_in_fd;                              /**< @brief input fd for split-fd (pipe) transports */
@@ -177,8 +178,11 @@ PKG_EXPORT extern int pkg_process(struct pkg_conn *);
  * This routine is the only place where data is taken off the network.
  * All input is appended to the internal buffer for later processing.
  *
- * Subscripting was used for pkc_incur/pkc_inend to avoid having to
- * recompute pointers after a realloc().
+ * The internal buffer is a fixed size ring of PKG_RINGLEN bytes.
+ * pkc_incur and pkc_inend count bytes from its start and may run up
+ * to one lap past its end, so pkc_inend - pkc_incur is always the
+ * amount buffered.  When the ring is full nothing is read and 1 is
+ * returned, as there is input waiting to be processed.
  *
  * Returns -
  *	-1 on error
@@ -210,6 +214,30 @@ PKG_EXPORT extern int pkg_send(int type, const char *buf, size_t len, struct pkg
  */
 PKG_EXPORT extern int pkg_2send(int type, const char *buf1, size_t len1, const char *buf2, size_t len2, struct pkg_conn* pc);
 
+/**
+ * One piece of a message gathered by pkg_sendv().
+ */
+struct pkg_iovec {
+    const void *iov_base;	/**< @brief start of this piece */
+    size_t iov_len;		/**< @brief byte count of this piece */
+};
+#define PKG_MAXIOV	16	/**< @brief most pieces per pkg_sendv() */
+
+/**
+ * Send a message whose data is gathered from up to PKG_MAXIOV
+ * disjoint buffers.
+ *
+ * The pieces are handed to writev() straight from the caller's
+ * memory; they are only copied when the transport can not gather
+ * (TLS, or systems without writev()), and then only small pieces
+ * are.  A short write is resumed until the whole message is out, so
+ * a message is only ever partly sent when the connection fails.
+ * pkg_send() and pkg_2send() are built on this routine.
+ *
+ * Returns number of bytes of user data actually sent, or -1.
+ */
+PKG_EXPORT extern int pkg_sendv(int type, const struct pkg_iovec *iov, int iovcnt, struct pkg_conn *pc);
+
 /**
  * Send a message that doesn't need a push.
  *
@@ -134,6 +134,8 @@ __BEGIN_DECLS
 
 #include "./rt/timer.h"
 
+#include "./rt/profile.h"
+
 #include "./rt/boolweave.h"
 
 #include "./rt/calc.h"
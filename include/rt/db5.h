@@ -111,6 +111,7 @@ struct db5_ondisk_header {
 #define DB5_ZZZ_UNCOMPRESSED			0
 #define DB5_ZZZ_GNU_GZIP			1
 #define DB5_ZZZ_BURROUGHS_WHEELER		2
+#define DB5_ZZZ_LZ4				3
 
 
 /* major_type */
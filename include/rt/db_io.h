@@ -144,7 +144,9 @@ RT_EXPORT extern int db5_realloc(struct db_i *dbip,
  * A routine for merging together the three optional parts of an
  * object into the final on-disk format.  Results in extra data
  * copies, but serves as a starting point for testing.  Any of name,
- * attrib, and body may be null.
+ * attrib, and body may be null.  a_zzz and b_zzz are the DB5_ZZZ_*
+ * compression to apply to the (uncompressed) attrib and body; a
+ * section that does not get smaller is stored uncompressed.
  */
 RT_EXPORT extern void db5_export_object3(struct bu_external *out,
 					 int dli,
@@ -157,6 +159,23 @@ RT_EXPORT extern void db5_export_object3(struct bu_external *out,
 					 int a_zzz,
 					 int b_zzz);
 
+/**
+ * Re-serialize the object in 'in' with its attribute and body
+ * sections stored using compression code zzz (one of the DB5_ZZZ_*
+ * values), expanding any sections that are compressed differently.
+ * DB5_ZZZ_UNCOMPRESSED yields the plain form.  Sections that would not
+ * get smaller are stored uncompressed, and objects other than
+ * application data (free space, the header) are copied as is.  'out'
+ * is always newly allocated on success.
+ *
+ * Returns -
+ * 0 OK
+ * -1 Failure
+ */
+RT_EXPORT extern int db5_compress_external(struct bu_external *out,
+					   const struct bu_external *in,
+					   int zzz);
+
 
 /**
  * The attributes are taken from ip->idb_avs
@@ -529,6 +548,30 @@ RT_EXPORT extern int db_get_external(struct bu_external *ep,
 				     const struct directory *dp,
 				     const struct db_i *dbip);
 
+/**
+ * Like db_get_external(), but when the database is mapped into memory
+ * ep->ext_buf points straight into the mapping instead of at a copy.
+ * The buffer must be treated as read-only, and stays valid until the
+ * database is closed.  Otherwise this falls back to db_get_external().
+ *
+ * Either way, release 'ep' with db_release_external(), never with
+ * bu_free_external().
+ *
+ * Returns -
+ * -1 error
+ * 0 success
+ */
+RT_EXPORT extern int db_borrow_external(struct bu_external *ep,
+					const struct directory *dp,
+					const struct db_i *dbip);
+
+/**
+ * Release an external representation obtained with
+ * db_borrow_external().
+ */
+RT_EXPORT extern void db_release_external(struct bu_external *ep,
+					  const struct db_i *dbip);
+
 /**
  * Given that caller already has an external representation of the
  * database object, update it to have a new name (taken from
@@ -193,6 +193,10 @@
 #define RT_PART_NUBSPT  0       /**< @brief Non-uniform binary space partitioning tree */
 #define RT_PART_NULL    1       /**< @brief No-op spatial partitioning: one model-sized leaf */
 
+#define RT_WEAVE_AUTO   0       /**< @brief Sorted sweep for rays with many segments, list weave otherwise */
+#define RT_WEAVE_LIST   1       /**< @brief Always weave one segment at a time into the partition list */
+#define RT_WEAVE_SWEEP  2       /**< @brief Sorted sweep whenever the partition list starts out empty */
+
 #endif /* RT_DEFINES_H */
 
 /** @} */
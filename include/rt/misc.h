@@ -64,6 +64,25 @@ RT_EXPORT extern void rt_reduce_obj(struct rt_db_internal *dest, const struct rt
  */
 RT_EXPORT extern void rt_reduce_db(struct db_i *db, size_t num_preserved_attributes, const char * const * preserved_attributes, const struct bu_ptbl *preserved_combs_dirs);
 
+/**
+ * Compress the contents of src into dest with the LZ4 codec used by
+ * the prep cache.  dest holds the uncompressed byte count as a 4-byte
+ * network order integer followed by the compressed data, and is
+ * released with bu_free_external().
+ *
+ * Returns 0 on success, -1 on error (dest is left empty).
+ */
+RT_EXPORT extern int rt_compress_external(struct bu_external *dest, const struct bu_external *src);
+
+/**
+ * Reverse of rt_compress_external().  The input is fully bounds
+ * checked, so it is safe to use on data received over the network
+ * or read from a damaged file.
+ *
+ * Returns 0 on success, -1 on error (dest is left empty).
+ */
+RT_EXPORT extern int rt_uncompress_external(struct bu_external *dest, const struct bu_external *src);
+
 /* below are librt table implementation detail */
 
 RT_EXPORT extern int rt_generic_xform(struct rt_db_internal     *op,
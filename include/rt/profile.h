@@ -0,0 +1,140 @@
+/*                       P R O F I L E . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup rt_profile
+ *
+ * @brief
+ * Per-primitive and per-region ray cost accounting.
+ *
+ * Once enabled on an rt_i, rt_shootray() counts the ft_shot() and
+ * ft_piece_shot() calls made on every prepped primitive, how many of
+ * them hit, and how long they took.  Counters live in each thread's
+ * struct resource and are only merged when results are requested, so
+ * nothing is locked while rays are in flight.  Region costs are the
+ * sum of the costs of the primitives each region references.
+ *
+ * Results, resets and write-back must only be requested while no
+ * rays are being fired on the rt_i.
+ */
+/** @{ */
+/** @file rt/profile.h */
+
+#ifndef RT_PROFILE_H
+#define RT_PROFILE_H
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu/vls.h"
+#include "rt/defines.h"
+#include "rt/region.h"
+#include "rt/soltab.h"
+
+__BEGIN_DECLS
+
+struct rt_i; /* forward declaration */
+
+/**
+ * Accumulated cost of one primitive (or region).
+ */
+struct rt_profile_solid {
+    size_t shots;	/**< @brief ft_shot() and ft_piece_shot() calls */
+    size_t hits;	/**< @brief calls that reported at least one hit */
+    int64_t nsec;	/**< @brief time spent in those calls, nanoseconds */
+};
+
+/**
+ * One row of a merged profile.  Exactly one of stp and regp is set.
+ */
+struct rt_profile_entry {
+    const char *name;			/**< @brief primitive name or region path */
+    const struct soltab *stp;		/**< @brief primitive, or NULL */
+    const struct region *regp;		/**< @brief region, or NULL */
+    struct rt_profile_solid cost;
+};
+
+/**
+ * Turn cost accounting on (non-zero) or off for rays shot on rtip.
+ * Counters already gathered are kept; see rt_profile_reset().
+ */
+RT_EXPORT extern void rt_profile_enable(struct rt_i *rtip, int enable);
+
+/**
+ * Returns non-zero when cost accounting is on for rtip.
+ */
+RT_EXPORT extern int rt_profile_enabled(const struct rt_i *rtip);
+
+/**
+ * Zero the counters in every resource registered with rtip.
+ */
+RT_EXPORT extern void rt_profile_reset(struct rt_i *rtip);
+
+/**
+ * Merge the per-thread counters into one entry per primitive that was
+ * shot at, sorted by descending time.  Returns the number of entries;
+ * the caller must bu_free() *entries.
+ */
+RT_EXPORT extern size_t rt_profile_solids(struct rt_i *rtip, struct rt_profile_entry **entries);
+
+/**
+ * As rt_profile_solids(), but one entry per region that references
+ * at least one of those primitives.
+ */
+RT_EXPORT extern size_t rt_profile_regions(struct rt_i *rtip, struct rt_profile_entry **entries);
+
+/**
+ * Append a human-readable report of the (at most max, or all if max
+ * is 0) most expensive primitives and regions to vls.
+ */
+RT_EXPORT extern void rt_profile_report(struct bu_vls *vls, struct rt_i *rtip, size_t max);
+
+/**
+ * Write every primitive and region entry to fp as CSV, with the
+ * columns kind,name,type,shots,hits,nsec,nsec_per_shot.
+ *
+ * Returns 0 on success, -1 on a write error.
+ */
+RT_EXPORT extern int rt_profile_csv(FILE *fp, struct rt_i *rtip);
+
+/**
+ * Store the results as rt_profile_shots, rt_profile_hits and
+ * rt_profile_nsec attributes on each primitive and region object in
+ * rtip's database.  Instances of the same object are summed.
+ *
+ * Returns the number of objects updated, or -1 if the database is
+ * read-only.
+ */
+RT_EXPORT extern int rt_profile_write_attributes(struct rt_i *rtip);
+
+__END_DECLS
+
+#endif /* RT_PROFILE_H */
+
+/** @} */
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
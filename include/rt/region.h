@@ -36,6 +36,7 @@ __BEGIN_DECLS
 
 union tree; /* forward declaration */
 struct db_i; /* forward declaration */
+struct rt_bool_prog; /* forward declaration, private to librt */
 
 /**
  * The region structure.
@@ -60,6 +61,7 @@ struct region {
 #define REGION_FASTGEN_PLATE    1
 #define REGION_FASTGEN_VOLUME   2
     struct bu_attribute_value_set attr_values;  /**< @brief Attribute/value set */
+    struct rt_bool_prog *reg_bool;  /**< @brief compiled reg_treetop, NULL to interpret it */
 };
 #define REGION_NULL     ((struct region *)0)
 #define RT_CK_REGION(_p) BU_CKMAG(_p, RT_REGION_MAGIC, "struct region")
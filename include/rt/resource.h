@@ -38,6 +38,8 @@
 
 __BEGIN_DECLS
 
+struct rt_profile_solid; /* forward declaration, see rt/profile.h */
+
 /**
  * One of these structures is needed per thread of execution, usually
  * with calling applications creating an array with at least MAX_PSW
@@ -100,11 +102,14 @@ struct resource {
     long                re_tree_get;
     long                re_tree_malloc;
     long                re_tree_free;
+    /* Per-processor ray cost accounting, see rt/profile.h */
+    struct rt_profile_solid *re_profile; /**< @brief  array [nsolids], or NULL */
+    size_t              re_profile_len; /**< @brief  # elements in re_profile[] */
 };
 
 #define RESOURCE_NULL   ((struct resource *)0)
 #define RT_CK_RESOURCE(_p) BU_CKMAG(_p, RESOURCE_MAGIC, "struct resource")
-#define RT_RESOURCE_INIT_ZERO { RESOURCE_MAGIC, 0, BU_LIST_INIT_ZERO, BU_PTBL_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, NULL, 0, NULL, 0, 0, 0, 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, BU_PTBL_INIT_ZERO, NULL, 0, 0, 0 }
+#define RT_RESOURCE_INIT_ZERO { RESOURCE_MAGIC, 0, BU_LIST_INIT_ZERO, BU_PTBL_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, NULL, 0, NULL, 0, 0, 0, 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, BU_PTBL_INIT_ZERO, NULL, 0, 0, 0, NULL, 0 }
 
 /**
  * Definition of global parallel-processing semaphores.
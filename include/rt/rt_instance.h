@@ -113,6 +113,7 @@ struct rt_i {
     int                 rti_prismtrace; /**< @brief  add support for pixel prism trace */
     char *              rti_region_fix_file; /**< @brief  rt_regionfix() file or NULL */
     int                 rti_space_partition;  /**< @brief  space partitioning method */
+    int                 rti_weave;      /**< @brief  partition weaving method, RT_WEAVE_* */
     struct bn_tol       rti_tol;        /**< @brief  Math tolerances for this model */
     struct bg_tess_tol  rti_ttol;       /**< @brief  Tessellation tolerance defaults */
     fastf_t             rti_max_beam_radius; /**< @brief  Max threat radius for FASTGEN cline solid */
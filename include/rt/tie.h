@@ -56,6 +56,7 @@ __BEGIN_DECLS
 
 #define TIE_KDTREE_FAST		0x0
 #define TIE_KDTREE_OPTIMAL	0x1
+#define TIE_KDTREE_SAH		0x2	/* binned surface area heuristic, multithreaded */
 
 /* Type to use for floating precision */
 #if TIE_PRECISION == 0
@@ -119,10 +120,11 @@ struct tie_s {
     unsigned int tri_num_alloc;
     struct tie_tri_s *tri_list;
     int stat;			/* used for testing various statistics */
-    unsigned int kdmethod;	/* Optimal or Fast */
+    unsigned int kdmethod;	/* Optimal, Fast or SAH */
     point_t min, max;
     vect_t amin, amax, mid;
     fastf_t radius;
+    void *kdstore;		/* node and leaf arrays of a TIE_KDTREE_SAH tree */
 };
 
 RT_EXPORT extern int tie_check_degenerate;
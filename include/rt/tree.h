@@ -515,7 +515,9 @@ RT_EXPORT extern int db_tally_subtree_regions(union tree        *tp,
  *                      0 if region should be skipped without
  *                      recursing, otherwise non-zero.  DO NOT USE FOR
  *                      OTHER PURPOSES!  For example, can be used to
- *                      quickly skip air regions.
+ *                      quickly skip air regions.  When ncpu != 1
+ *                      it may be called from several threads, one
+ *                      call at a time, in no particular order.
  *
  *      reg_end_func    Called after all nodes within a region have been
  *                      recursively processed by leaf_func.  If it
@@ -533,8 +535,9 @@ RT_EXPORT extern int db_tally_subtree_regions(union tree        *tp,
  *                      does not exist or has an error.
  *
  *
- * This routine will employ multiple CPUs if asked, but is not
- * multiply-parallel-recursive.  Call this routine with ncpu > 1 from
+ * This routine will employ multiple CPUs if asked, both to find the
+ * regions and to walk them, but is not multiply-parallel-recursive.
+ * The resulting region order is the same as a serial walk's.  Call this routine with ncpu > 1 from
  * serial code only.  When called from within an existing thread, ncpu
  * must be 1.
  *
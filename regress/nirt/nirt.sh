@@ -575,6 +575,28 @@ EOF
 run cmp nirt.ref nirt.out
 STATUS=$?
 
+# batch output goes to files rather than the nirt output stream, so it
+# is checked separately: the same rays shot on one and on several
+# threads must produce identical, correctly ordered results.
+log "*** Test 12 - batch shotlines ***"
+rm -f nirt_rays.txt nirt_batch*
+cat > nirt_rays.txt <<EOF
+# x y z dx dy dz
+5 0 0 -1 0 0
+0 5 0 0 -1 0
+0 10 10 1 0 0
+0 0 5 0 0 -1
+EOF
+run $NIRT -H 0 -e "backout 0;batch -P 1 -o nirt_batch1.out nirt_rays.txt;batch -P 3 -o nirt_batch3.out nirt_rays.txt;batch -P 1 -B -o nirt_batch1.bin nirt_rays.txt;batch -P 3 -B -o nirt_batch3.bin nirt_rays.txt;q" nirt.g all_cubes.r
+printf '# ray\td_in\td_out\tlos\tobliq_in\tobliq_out\tclaimants\tpath_name\n' > nirt_batch.ref
+printf '0\t2\t8\t6\t0\t0\t1\t/all_cubes.r\n' >> nirt_batch.ref
+printf '1\t4\t6\t2\t0\t0\t1\t/all_cubes.r\n' >> nirt_batch.ref
+printf '3\t4\t6\t2\t0\t0\t1\t/all_cubes.r\n' >> nirt_batch.ref
+cut -f1,3- nirt_batch1.out > nirt_batch.cut
+run cmp nirt_batch.ref nirt_batch.cut
+run cmp nirt_batch1.out nirt_batch3.out
+run cmp nirt_batch1.bin nirt_batch3.bin
+
 if [ X$STATUS = X0 ] ; then
     log "-> nirt.sh succeeded"
 else
@@ -94,6 +94,25 @@ enum
 
 RENDER_EXPORT extern int load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct adrt_mesh_s **);
 
+/*
+ * Direct BoT loading for db_walk_tree() based loaders.  Call
+ * load_g_bots_regstart() from the region start function: it returns 1
+ * (and queues the region under a new mesh in meshes) when the region
+ * is a union of BoTs, in which case the caller should return -1 to
+ * skip NMG evaluation, or 0 otherwise.  After the walk, and before the
+ * database is closed, load_g_bots_finish() reads the queued BoTs in
+ * parallel, pushes their triangles into the tie, frees the loader and
+ * returns the number of triangles pushed.
+ */
+struct db_i;
+struct db_tree_state;
+struct db_full_path;
+struct rt_comb_internal;
+struct load_g_bots;
+RENDER_EXPORT extern struct load_g_bots *load_g_bots_create(struct db_i *dbip, struct tie_s *tie);
+RENDER_EXPORT extern int load_g_bots_regstart(struct load_g_bots *lb, const struct db_tree_state *ts, const struct db_full_path *path, const struct rt_comb_internal *rci, struct adrt_mesh_s *meshes);
+RENDER_EXPORT extern size_t load_g_bots_finish(struct load_g_bots *lb);
+
 #endif
 
 /*
@@ -23,8 +23,12 @@
  * Attempt to load a single top-level comb from a named .g file. The file must
  * exist on the machine the 'slave' program is running, with the correct path
  * passed to it. Only one combination is used, intended to be the top of the
- * tree of concern. It's assumed that only BOT's are to be loaded, non-bots will
- * be silently ignored for now. No KD-TREE caching is assumed. I like tacos.
+ * tree of concern. No KD-TREE caching is assumed. I like tacos.
+ *
+ * Regions whose trees are nothing but unions of BoTs are read directly
+ * from the BoT internals, in parallel once the walk is done (see the
+ * load_g_bots_*() functions).  Everything else is tessellated through
+ * NMG as before.
  */
 
 #include "common.h"
@@ -37,6 +41,7 @@
 
 /* interface headers */
 #include "vmath.h"
+#include "bu/parallel.h"
 #include "nmg.h"
 #include "rt/geom.h"
 #include "raytrace.h"
@@ -49,6 +54,7 @@
 static struct bn_tol tol;		/* calculation tolerance */
 static struct tie_s *cur_tie;
 static struct db_i *dbip;
+static struct load_g_bots *cur_bots;
 TIE_3 **tribuf;
 
 static void load_nmg_to_adrt_gcvwrite(struct nmgregion *r, const struct db_full_path *pathp, struct db_tree_state *tsp, void *client_data);
@@ -129,44 +135,136 @@ load_nmg_to_adrt_internal(struct adrt_mesh_s *mesh, struct nmgregion *r)
 }
 
 
+/* Deepest comb nesting followed below a region before giving up on
+ * the BoT fast path. */
+#define LOAD_G_BOTS_MAXDEPTH 32
+
+struct load_g_leaf {
+    struct directory *dp;
+    mat_t mat;			/* region state matrix times leaf matrices */
+};
+
+struct load_g_job {
+    struct adrt_mesh_s *mesh;
+    size_t first;		/* index of the first leaf in lb->leaves */
+    size_t count;
+};
+
+struct load_g_bots {
+    struct db_i *dbip;
+    struct tie_s *tie;
+    struct load_g_leaf *leaves;
+    size_t leaf_num;
+    size_t leaf_alloc;
+    struct load_g_job *jobs;
+    size_t job_num;
+    size_t job_alloc;
+    size_t next;		/* next job to hand to a worker */
+    size_t tri_num;		/* triangles pushed so far */
+    int sem;
+};
+
+
+struct load_g_bots *
+load_g_bots_create(struct db_i *db, struct tie_s *tie)
+{
+    struct load_g_bots *lb;
+
+    BU_ALLOC(lb, struct load_g_bots);
+    lb->dbip = db;
+    lb->tie = tie;
+    lb->sem = bu_semaphore_register("LOAD_G_SEM_BOTS");
+    return lb;
+}
+
+
+/*
+ * Append the BoT leaves of a union-only tree to lb->leaves.  Combs
+ * below the region are followed as long as they are unions too.
+ * Returns 0 on success, -1 if anything other than a BoT or a union
+ * is found.
+ */
+static int
+load_g_bots_collect(struct load_g_bots *lb, const union tree *tp, const mat_t mat, int depth)
+{
+    struct directory *dp;
+    struct load_g_leaf *leaf;
+    mat_t lmat;
+
+    if (!tp)
+	return 0;
+    RT_CK_TREE(tp);
+
+    switch (tp->tr_op) {
+	case OP_UNION:
+	    if (load_g_bots_collect(lb, tp->tr_b.tb_left, mat, depth) < 0)
+		return -1;
+	    return load_g_bots_collect(lb, tp->tr_b.tb_right, mat, depth);
+	case OP_DB_LEAF:
+	    break;
+	default:
+	    return -1;
+    }
+
+    if ((dp = db_lookup(lb->dbip, tp->tr_l.tl_name, LOOKUP_QUIET)) == RT_DIR_NULL)
+	return -1;
+
+    if (tp->tr_l.tl_mat)
+	bn_mat_mul(lmat, mat, tp->tr_l.tl_mat);
+    else
+	MAT_COPY(lmat, mat);
+
+    if (dp->d_flags & RT_DIR_COMB) {
+	struct rt_db_internal intern;
+	struct rt_comb_internal *comb;
+	int ret;
+
+	if (depth >= LOAD_G_BOTS_MAXDEPTH)
+	    return -1;
+	if (rt_db_get_internal(&intern, dp, lb->dbip, NULL) < 0)
+	    return -1;
+	comb = (struct rt_comb_internal *)intern.idb_ptr;
+	RT_CK_COMB(comb);
+	ret = load_g_bots_collect(lb, comb->tree, lmat, depth + 1);
+	rt_db_free_internal(&intern);
+	return ret;
+    }
+
+    if (dp->d_major_type != DB5_MAJORTYPE_BRLCAD || dp->d_minor_type != ID_BOT)
+	return -1;
+
+    if (lb->leaf_num == lb->leaf_alloc) {
+	lb->leaf_alloc = lb->leaf_alloc ? lb->leaf_alloc * 2 : 64;
+	lb->leaves = (struct load_g_leaf *)bu_realloc(lb->leaves, lb->leaf_alloc * sizeof(struct load_g_leaf), "load_g leaves");
+    }
+    leaf = &lb->leaves[lb->leaf_num++];
+    leaf->dp = dp;
+    MAT_COPY(leaf->mat, lmat);
+    return 0;
+}
+
+
 int
-load_nmg_to_adrt_regstart(struct db_tree_state *ts, const struct db_full_path *path, const struct rt_comb_internal *rci, void *UNUSED(client_data))
+load_g_bots_regstart(struct load_g_bots *lb, const struct db_tree_state *ts, const struct db_full_path *path, const struct rt_comb_internal *rci, struct adrt_mesh_s *meshes)
 {
-    /*
-     * if it's a simple single bot region, just eat the bots and return -1.
-     * Omnomnom. Return 0 to do nmg eval.
-     */
-    struct directory *dir;
-    struct rt_db_internal intern;
     struct adrt_mesh_s *mesh;
-    unsigned char rgb[3] = { 0xc0, 0xc0, 0xc0 };
+    struct load_g_job *job;
+    size_t first = lb->leaf_num;
+    char *name;
 
     RT_CHECK_COMB(rci);
 
-    /* abort cases, no fast loading. */
     if (rci->tree == NULL)
 	return 0;
-    RT_CK_TREE(rci->tree);
-    if ( rci->tree->tr_op != OP_DB_LEAF )
-	return 0;
-    if ((dir = db_lookup(dbip, rci->tree->tr_l.tl_name, 1)) == NULL) {
-	printf("Lookup failed: %s\n", rci->tree->tr_l.tl_name);
-	return 0;
-    }
-    if (dir->d_minor_type != ID_BOT && dir->d_minor_type != ID_NMG)
-	return 0;
-    if (rt_db_get_internal(&intern, dir, dbip, (fastf_t *)NULL) < 0) {
-	printf("Failed to load\n");
+    if (load_g_bots_collect(lb, rci->tree, ts->ts_mat, 0) < 0 || lb->leaf_num == first) {
+	lb->leaf_num = first;
 	return 0;
     }
 
-    if (dir->d_minor_type == ID_NMG)
-	return 0;
-
     /* FIXME: where is this released? */
     BU_ALLOC(mesh, struct adrt_mesh_s);
 
-    BU_LIST_PUSH(&((*gcvwriter.meshes)->l), &(mesh->l));
+    BU_LIST_PUSH(&(meshes->l), &(mesh->l));
 
     mesh->texture = NULL;
     mesh->flags = 0;
@@ -174,32 +272,142 @@ load_nmg_to_adrt_regstart(struct db_tree_state *ts, const struct db_full_path *p
     BU_ALLOC(mesh->attributes, struct adrt_mesh_attributes_s);
     mesh->matid = ts->ts_gmater;
 
-    rt_comb_get_color(dbip, rgb, rci);
-    VSCALE(mesh->attributes->color.v, rgb, 1.0/256.0);
+    VMOVE(mesh->attributes->color.v, ts->ts_mater.ma_color);
+    name = db_path_to_string(path);
+    bu_strlcpy(mesh->name, name, sizeof(mesh->name));
+    bu_free(name, "path string");
 
-    bu_strlcpy(mesh->name, db_path_to_string(path), sizeof(mesh->name));
+    if (lb->job_num == lb->job_alloc) {
+	lb->job_alloc = lb->job_alloc ? lb->job_alloc * 2 : 64;
+	lb->jobs = (struct load_g_job *)bu_realloc(lb->jobs, lb->job_alloc * sizeof(struct load_g_job), "load_g jobs");
+    }
+    job = &lb->jobs[lb->job_num++];
+    job->mesh = mesh;
+    job->first = first;
+    job->count = lb->leaf_num - first;
 
-    if (intern.idb_minor_type == ID_NMG) {
-	load_nmg_to_adrt_internal(mesh, (struct nmgregion *)intern.idb_ptr);
-	return -1;
-    } else if (intern.idb_minor_type == ID_BOT) {
-	size_t i;
-	struct rt_bot_internal *bot = (struct rt_bot_internal *)intern.idb_ptr;
+    return 1;
+}
 
-	RT_BOT_CK_MAGIC(bot);
 
-	for (i=0;i<bot->num_faces;i++)
-	{
-	    VSCALE((*tribuf[0]).v, (bot->vertices+3*bot->faces[3*i+0]), 1.0/1000.0);
-	    VSCALE((*tribuf[1]).v, (bot->vertices+3*bot->faces[3*i+1]), 1.0/1000.0);
-	    VSCALE((*tribuf[2]).v, (bot->vertices+3*bot->faces[3*i+2]), 1.0/1000.0);
+static void
+load_g_bots_worker(int UNUSED(cpu), void *ptr)
+{
+    struct load_g_bots *lb = (struct load_g_bots *)ptr;
+    TIE_3 *verts = NULL;
+    TIE_3 **tlist = NULL;
+    size_t vert_alloc = 0;
+    size_t tlist_alloc = 0;
+
+    while (1) {
+	struct load_g_job *job;
+	size_t ntri = 0;
+	size_t i, j;
+
+	bu_semaphore_acquire(lb->sem);
+	if (lb->next >= lb->job_num) {
+	    bu_semaphore_release(lb->sem);
+	    break;
+	}
+	job = &lb->jobs[lb->next++];
+	bu_semaphore_release(lb->sem);
 
-	    TIE_VAL(tie_push)(cur_tie, tribuf, 1, mesh, 0);
+	for (i = job->first; i < job->first + job->count; i++) {
+	    struct load_g_leaf *leaf = &lb->leaves[i];
+	    struct rt_db_internal intern;
+	    struct rt_bot_internal *bot;
+
+	    /* the matrix is applied to the vertices on import */
+	    if (rt_db_get_internal(&intern, leaf->dp, lb->dbip, leaf->mat) < 0) {
+		bu_log("load_g: unable to read %s\n", leaf->dp->d_namep);
+		continue;
+	    }
+	    bot = (struct rt_bot_internal *)intern.idb_ptr;
+	    RT_BOT_CK_MAGIC(bot);
+
+	    if ((ntri + bot->num_faces) * 3 > vert_alloc) {
+		vert_alloc = (ntri + bot->num_faces) * 3 * 2;
+		verts = (TIE_3 *)bu_realloc(verts, vert_alloc * sizeof(TIE_3), "load_g verts");
+	    }
+	    for (j = 0; j < bot->num_faces; j++) {
+		const int *f = &bot->faces[3*j];
+
+		if (f[0] < 0 || f[1] < 0 || f[2] < 0
+		    || (size_t)f[0] >= bot->num_vertices
+		    || (size_t)f[1] >= bot->num_vertices
+		    || (size_t)f[2] >= bot->num_vertices)
+		    continue;
+
+		/* convert mm to m */
+		VSCALE(verts[ntri*3+0].v, &bot->vertices[3*f[0]], 1.0/1000.0);
+		VSCALE(verts[ntri*3+1].v, &bot->vertices[3*f[1]], 1.0/1000.0);
+		VSCALE(verts[ntri*3+2].v, &bot->vertices[3*f[2]], 1.0/1000.0);
+		ntri++;
+	    }
+	    rt_db_free_internal(&intern);
 	}
-	return -1;
+
+	if (!ntri)
+	    continue;
+
+	if (ntri * 3 > tlist_alloc) {
+	    tlist_alloc = vert_alloc;
+	    tlist = (TIE_3 **)bu_realloc(tlist, tlist_alloc * sizeof(TIE_3 *), "load_g tlist");
+	}
+	for (j = 0; j < ntri * 3; j++)
+	    tlist[j] = &verts[j];
+
+	/* tie_push copies the vertices, so only the push is serialized */
+	bu_semaphore_acquire(lb->sem);
+	TIE_VAL(tie_push)(lb->tie, tlist, (unsigned int)ntri, job->mesh, 0);
+	lb->tri_num += ntri;
+	bu_semaphore_release(lb->sem);
     }
 
-    bu_log("Strange, %d is not %d or %d\n", intern.idb_minor_type, ID_BOT, ID_NMG);
+    if (verts)
+	bu_free(verts, "load_g verts");
+    if (tlist)
+	bu_free(tlist, "load_g tlist");
+}
+
+
+size_t
+load_g_bots_finish(struct load_g_bots *lb)
+{
+    size_t tri_num;
+    size_t ncpu;
+
+    if (!lb)
+	return 0;
+
+    ncpu = bu_avail_cpus();
+    if (ncpu > lb->job_num)
+	ncpu = lb->job_num;
+    if (ncpu > 1)
+	bu_parallel(load_g_bots_worker, ncpu, lb);
+    else if (lb->job_num)
+	load_g_bots_worker(0, lb);
+
+    tri_num = lb->tri_num;
+    if (lb->leaves)
+	bu_free(lb->leaves, "load_g leaves");
+    if (lb->jobs)
+	bu_free(lb->jobs, "load_g jobs");
+    bu_free(lb, "load_g bots");
+
+    return tri_num;
+}
+
+
+int
+load_nmg_to_adrt_regstart(struct db_tree_state *ts, const struct db_full_path *path, const struct rt_comb_internal *rci, void *UNUSED(client_data))
+{
+    /*
+     * if it's a BoT-only region, queue the bots and return -1.
+     * Omnomnom. Return 0 to do nmg eval.
+     */
+    if (load_g_bots_regstart(cur_bots, ts, path, rci, *gcvwriter.meshes))
+	return -1;
     return 0;
 }
 
@@ -288,7 +496,7 @@ load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct ad
     BN_CK_TOL(tree_state.ts_tol);
     BG_CK_TESS_TOL(tree_state.ts_ttol);
 
-    TIE_VAL(tie_init)(cur_tie, BU_PAGE_SIZE, TIE_KDTREE_FAST);
+    TIE_VAL(tie_init)(cur_tie, BU_PAGE_SIZE, TIE_KDTREE_SAH);
 
     /* FIXME: where is this released? */
     BU_ALLOC(*meshes, struct adrt_mesh_s);
@@ -302,6 +510,10 @@ load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct ad
     tribuf[1] = (TIE_3 *)bu_malloc(sizeof(TIE_3) * 3, "triangle tribuffer");
     tribuf[2] = (TIE_3 *)bu_malloc(sizeof(TIE_3) * 3, "triangle tribuffer");
 
+    cur_bots = load_g_bots_create(dbip, cur_tie);
+
+    /* The walk itself stays serial: the NMG fallback evaluates every
+     * region into the one shared model. */
     (void) db_walk_tree(dbip,
 			argc,			/* number of toplevel regions */
 			argv,			/* region names */
@@ -312,6 +524,9 @@ load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct ad
 			rt_booltree_leaf_tess,	/* leaf func */
 			(void *)&gcvwriter);	/* client data */
 
+    (void)load_g_bots_finish(cur_bots);
+    cur_bots = NULL;
+
     /* Release dynamic storage */
     nmg_km(the_model);
     rt_vlist_cleanup();
@@ -178,6 +178,7 @@ extern int *fb_server_max_fd;
 extern int fb_server_got_fb_free;       /* !0 => we have received an fb_free */
 extern int fb_server_refuse_fb_free;    /* !0 => don't accept fb_free() */
 extern int fb_server_retain_on_close;   /* !0 => we are holding a reusable FB open */
+extern void fb_server_shm_drop(int idx);
 
 /* auth state accessors for server.c handlers */
 int fbserv_client_auth_ok(int idx)   { return clients_auth[idx]; }
@@ -385,6 +386,7 @@ fbserv_drop_client(int sub)
     clients[sub] = PKC_NULL;
     clients_auth[sub] = 0;
     clients_pending_drop[sub] = 0;
+    fb_server_shm_drop(sub);
 }
 
 static void
@@ -69,6 +69,24 @@ extern void fbserv_request_drop(int sub);
 extern int fbserv_client_auth_ok(int idx);
 extern void fbserv_set_client_auth(int idx, int val);
 
+/* Per-client shared pixel mirror (parallel to fbserv.c's clients[]) */
+static struct fbserv_shm *fb_server_shm[MAX_CLIENTS];
+
+
+/**
+ * Release the shared pixel mirror of client idx, if it has one.
+ * Called by fbserv.c when the client is dropped.
+ */
+void
+fb_server_shm_drop(int idx)
+{
+    if (idx < 0 || idx >= MAX_CLIENTS || !fb_server_shm[idx])
+	return;
+    fbs_shm_release(fb_server_shm[idx]);
+    BU_PUT(fb_server_shm[idx], struct fbserv_shm);
+    fb_server_shm[idx] = NULL;
+}
+
 
 /**
  * Check that a client is authenticated (when strict mode is active) and
@@ -944,6 +962,142 @@ fb_server_fb_help(struct pkg_conn *pcp, char *buf)
 	(void)free(buf);
 }
 
+/*
+ * Create a shared pixel mirror for this client, sized to the current
+ * framebuffer.  Replies with ret, segment key, cookie, width, height.
+ */
+static void
+fb_server_fb_shmopen(struct pkg_conn *pcp, char *buf)
+{
+    char rbuf[5*NET_LONG_LEN+1] = {0};
+    struct fbserv_shm *shm;
+    int idx;
+
+    if (buf == NULL)
+	return;
+    if (pcp == PKC_NULL)
+	return;
+    if (fbserv_guard(pcp, buf) < 0) return;
+
+    idx = fbserv_conn_idx(pcp);
+    fb_server_shm_drop(idx);
+
+    (void)pkg_plong(&rbuf[0*NET_LONG_LEN], -1);
+    if (idx >= 0) {
+	BU_GET(shm, struct fbserv_shm);
+	if (fbs_shm_create(shm, fb_getwidth(fb_server_fbp), fb_getheight(fb_server_fbp)) < 0) {
+	    BU_PUT(shm, struct fbserv_shm);
+	} else {
+	    fb_server_shm[idx] = shm;
+	    (void)pkg_plong(&rbuf[0*NET_LONG_LEN], 0);
+	    (void)pkg_plong(&rbuf[1*NET_LONG_LEN], shm->fbsh_key);
+	    (void)pkg_plong(&rbuf[2*NET_LONG_LEN], shm->fbsh_cookie);
+	    (void)pkg_plong(&rbuf[3*NET_LONG_LEN], shm->fbsh_width);
+	    (void)pkg_plong(&rbuf[4*NET_LONG_LEN], shm->fbsh_height);
+	}
+    }
+    pkg_send(MSG_RETURN, rbuf, 5*NET_LONG_LEN, pcp);
+    if (buf)
+	(void)free(buf);
+}
+
+
+/*
+ * The client has attached to the mirror (or failed to).  Either way
+ * nobody else needs the segment key any more.
+ */
+static void
+fb_server_fb_shmready(struct pkg_conn *pcp, char *buf)
+{
+    int idx;
+
+    if (buf == NULL)
+	return;
+    if (pcp == PKC_NULL)
+	return;
+
+    idx = fbserv_conn_idx(pcp);
+    if (idx >= 0 && fb_server_shm[idx]) {
+	if (pkg_glong(&buf[0*NET_LONG_LEN]))
+	    fbs_shm_unlink(fb_server_shm[idx]);
+	else
+	    fb_server_shm_drop(idx);
+    }
+    (void)free(buf);
+}
+
+
+/*
+ * Pixels for a span (MSG_FBSHMWRITE) or rectangle (MSG_FBSHMWRITERECT)
+ * are already in the mirror; copy them to the framebuffer.
+ */
+static void
+fb_server_fb_shmwrite(struct pkg_conn *pcp, char *buf)
+{
+    int x, y, w, h;
+    char rbuf[NET_LONG_LEN+1];
+    int ret = -1;
+    int type;
+    int idx;
+
+    if (buf == NULL)
+	return;
+    if (pcp == PKC_NULL)
+	return;
+    if (fbserv_guard(pcp, buf) < 0) return;
+
+    type = pcp->pkc_type;
+    x = pkg_glong(&buf[0*NET_LONG_LEN]);
+    y = pkg_glong(&buf[1*NET_LONG_LEN]);
+    w = pkg_glong(&buf[2*NET_LONG_LEN]);
+    h = (type % MSG_NORETURN == MSG_FBSHMWRITERECT) ? (int)pkg_glong(&buf[3*NET_LONG_LEN]) : 0;
+
+    idx = fbserv_conn_idx(pcp);
+    if (idx >= 0 && fb_server_shm[idx])
+	ret = fbs_shm_push(fb_server_shm[idx], fb_server_fbp, x, y, w, h);
+
+    if (type < MSG_NORETURN) {
+	(void)pkg_plong(&rbuf[0*NET_LONG_LEN], ret);
+	pkg_send(MSG_RETURN, rbuf, NET_LONG_LEN, pcp);
+    }
+    if (buf)
+	(void)free(buf);
+}
+
+
+/*
+ * Refresh a span (MSG_FBSHMREAD) or rectangle (MSG_FBSHMREADRECT) of
+ * the mirror from the framebuffer and return the pixel count.
+ */
+static void
+fb_server_fb_shmread(struct pkg_conn *pcp, char *buf)
+{
+    int x, y, w, h;
+    char rbuf[NET_LONG_LEN+1];
+    int ret = -1;
+    int idx;
+
+    if (buf == NULL)
+	return;
+    if (pcp == PKC_NULL)
+	return;
+    if (fbserv_guard(pcp, buf) < 0) return;
+
+    x = pkg_glong(&buf[0*NET_LONG_LEN]);
+    y = pkg_glong(&buf[1*NET_LONG_LEN]);
+    w = pkg_glong(&buf[2*NET_LONG_LEN]);
+    h = (pcp->pkc_type == MSG_FBSHMREADRECT) ? (int)pkg_glong(&buf[3*NET_LONG_LEN]) : 0;
+
+    idx = fbserv_conn_idx(pcp);
+    if (idx >= 0 && fb_server_shm[idx])
+	ret = fbs_shm_pull(fb_server_shm[idx], fb_server_fbp, x, y, w, h);
+
+    (void)pkg_plong(&rbuf[0*NET_LONG_LEN], ret);
+    pkg_send(MSG_RETURN, rbuf, NET_LONG_LEN, pcp);
+    if (buf)
+	(void)free(buf);
+}
+
 struct pkg_switch pkg_switch[] = {
     { MSG_FBAUTH,                       fb_server_fb_auth,        "Session Authentication", NULL },
     { MSG_FBOPEN,                       fb_server_fb_open,        "Open Framebuffer", NULL },
@@ -976,6 +1130,14 @@ struct pkg_switch pkg_switch[] = {
     { MSG_FBPOLL,                       fb_server_fb_poll,        "Handle Events", NULL },
     { MSG_FBSETCURSOR,                  fb_server_fb_setcursor,   "Set Cursor Shape", NULL },
     { MSG_FBSETCURSOR + MSG_NORETURN,   fb_server_fb_setcursor,   "Set Cursor Shape", NULL },
+    { MSG_FBSHMOPEN,                    fb_server_fb_shmopen,     "Open Shared Pixels", NULL },
+    { MSG_FBSHMREADY,                   fb_server_fb_shmready,    "Shared Pixels Attached", NULL },
+    { MSG_FBSHMWRITE,                   fb_server_fb_shmwrite,    "Write Shared Pixels", NULL },
+    { MSG_FBSHMWRITE + MSG_NORETURN,    fb_server_fb_shmwrite,    "Write Shared Pixels", NULL },
+    { MSG_FBSHMWRITERECT,               fb_server_fb_shmwrite,    "Write Shared Rectangle", NULL },
+    { MSG_FBSHMWRITERECT + MSG_NORETURN, fb_server_fb_shmwrite,   "Write Shared Rectangle", NULL },
+    { MSG_FBSHMREAD,                    fb_server_fb_shmread,     "Read Shared Pixels", NULL },
+    { MSG_FBSHMREADRECT,                fb_server_fb_shmread,     "Read Shared Rectangle", NULL },
     { 0,                                NULL,           NULL, NULL }
 };
 
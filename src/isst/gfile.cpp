@@ -42,6 +42,7 @@ struct isst_nmg_data {
     struct db_i *dbip;
     struct bn_tol *tol;
     struct bu_list *vlfree;
+    struct load_g_bots *bots;
 };
 
 struct gcv_data {
@@ -126,75 +127,14 @@ static int
 nmg_to_adrt_regstart(struct db_tree_state *ts, const struct db_full_path *path, const struct rt_comb_internal *rci, void *client_data)
 {
     /*
-     * if it's a simple single bot region, just eat the bots and return -1.
+     * if it's a BoT-only region, queue the bots and return -1.
      * Omnomnom. Return 0 to do nmg eval.
      */
     struct gcv_region_end_data *rd = (struct gcv_region_end_data *)client_data;
     struct isst_nmg_data *d = (struct isst_nmg_data *)rd->client_data;
-    struct directory *dir;
-    struct rt_db_internal intern;
-    struct adrt_mesh_s *mesh;
-    unsigned char rgb[3] = { 0xc0, 0xc0, 0xc0 };
-
-    RT_CHECK_COMB(rci);
-
-    /* abort cases, no fast loading. */
-    if (rci->tree == NULL)
-	return 0;
-    RT_CK_TREE(rci->tree);
-    if ( rci->tree->tr_op != OP_DB_LEAF )
-	return 0;
-    if ((dir = db_lookup(d->dbip, rci->tree->tr_l.tl_name, 1)) == NULL) {
-	printf("Lookup failed: %s\n", rci->tree->tr_l.tl_name);
-	return 0;
-    }
-    if (dir->d_minor_type != ID_BOT && dir->d_minor_type != ID_NMG)
-	return 0;
-    if (rt_db_get_internal(&intern, dir, d->dbip, (fastf_t *)NULL) < 0) {
-	printf("Failed to load\n");
-	return 0;
-    }
-
-    if (dir->d_minor_type == ID_NMG)
-	return 0;
-
-    /* FIXME: where is this released? */
-    BU_ALLOC(mesh, struct adrt_mesh_s);
 
-    BU_LIST_PUSH(&((*gcvwriter.meshes)->l), &(mesh->l));
-
-    mesh->texture = NULL;
-    mesh->flags = 0;
-
-    BU_ALLOC(mesh->attributes, struct adrt_mesh_attributes_s);
-    mesh->matid = ts->ts_gmater;
-
-    rt_comb_get_color(d->dbip, rgb, rci);
-    VSCALE(mesh->attributes->color.v, rgb, 1.0/256.0);
-
-    bu_strlcpy(mesh->name, db_path_to_string(path), sizeof(mesh->name));
-
-    if (intern.idb_minor_type == ID_NMG) {
-	nmg_to_adrt_internal(d->tribuf, d->cur_tie, mesh, (struct nmgregion *)intern.idb_ptr);
-	return -1;
-    } else if (intern.idb_minor_type == ID_BOT) {
-	size_t i;
-	struct rt_bot_internal *bot = (struct rt_bot_internal *)intern.idb_ptr;
-
-	RT_BOT_CK_MAGIC(bot);
-
-	for (i=0;i<bot->num_faces;i++)
-	{
-	    VSCALE((*d->tribuf[0]).v, (bot->vertices+3*bot->faces[3*i+0]), 1.0/1000.0);
-	    VSCALE((*d->tribuf[1]).v, (bot->vertices+3*bot->faces[3*i+1]), 1.0/1000.0);
-	    VSCALE((*d->tribuf[2]).v, (bot->vertices+3*bot->faces[3*i+2]), 1.0/1000.0);
-
-	    TIE_VAL(tie_push)(d->cur_tie, d->tribuf, 1, mesh, 0);
-	}
+    if (load_g_bots_regstart(d->bots, ts, path, rci, *gcvwriter.meshes))
 	return -1;
-    }
-
-    bu_log("Strange, %d is not %d or %d\n", intern.idb_minor_type, ID_BOT, ID_NMG);
     return 0;
 }
 
@@ -288,7 +228,7 @@ GFile::load_g(const char *filename, int argc, const char *argv[])
     BN_CK_TOL(tree_state.ts_tol);
     BG_CK_TESS_TOL(tree_state.ts_ttol);
 
-    TIE_VAL(tie_init)(d.cur_tie, BU_PAGE_SIZE, TIE_KDTREE_FAST);
+    TIE_VAL(tie_init)(d.cur_tie, BU_PAGE_SIZE, TIE_KDTREE_SAH);
 
     /* FIXME: where is this released? */
     BU_ALLOC(this->meshes, struct adrt_mesh_s);
@@ -303,6 +243,7 @@ GFile::load_g(const char *filename, int argc, const char *argv[])
     tribuf[1] = (TIE_3 *)bu_malloc(sizeof(TIE_3) * 3, "triangle tribuffer");
     tribuf[2] = (TIE_3 *)bu_malloc(sizeof(TIE_3) * 3, "triangle tribuffer");
     d.tribuf = this->tribuf;
+    d.bots = load_g_bots_create(dbip, d.cur_tie);
 
     (void) db_walk_tree(dbip,
 			argc,			/* number of toplevel regions */
@@ -314,6 +255,8 @@ GFile::load_g(const char *filename, int argc, const char *argv[])
 			rt_booltree_leaf_tess,	/* leaf func */
 			(void *)&gcvwriter);	/* client data */
 
+    (void)load_g_bots_finish(d.bots);
+
     /* Release dynamic storage */
     nmg_km(the_model);
     rt_vlist_cleanup();
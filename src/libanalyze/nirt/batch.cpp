@@ -0,0 +1,507 @@
+/*                       B A T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file batch.cpp
+ *
+ * Batch shotline evaluation for NIRT.
+ *
+ * The "s" command routes every partition through the fmt machinery and
+ * the textual output buffer, which is the right thing for interactive
+ * use but dominates the run time when a caller feeds in very large
+ * numbers of shotlines.  The "batch" command instead reads a whole file
+ * of rays, shoots them with one librt resource per thread, and writes a
+ * fixed set of per-partition values either as tab separated columns or
+ * as a compact binary record stream.
+ *
+ * Rays are processed in blocks.  Within a block, threads claim small
+ * chunks of rays and encode each ray's result into its own slot; once
+ * the block is done the slots are written out in input order, so the
+ * output is identical regardless of the number of threads used.
+ *
+ * Input ray file formats:
+ *
+ * text (default) - one ray per line: "x y z dx dy dz", origin in the
+ *                  current nirt units.  Blank lines and lines starting
+ *                  with '#' are skipped.
+ *
+ * binary (-b)    - six big-endian IEEE doubles per ray, in the same
+ *                  order and units as the text form.
+ *
+ * Output formats:
+ *
+ * columns (default) - a '#' header line, then one line per partition:
+ *
+ *     ray reg_id d_in d_out los obliq_in obliq_out claimants path_name
+ *
+ *     where ray is the zero based index of the ray in the input file
+ *     and d_in/d_out are distances along the ray from the supplied
+ *     origin in the current units.  Missed rays produce no lines.
+ *
+ * binary (-B) - all integers are big-endian 32 bit, all floating point
+ *     values are big-endian IEEE doubles:
+ *
+ *     header:    "NIRTBAT1", base2local, region count, then per
+ *                region: reg_id, name length, name bytes (no NUL)
+ *     per ray:   partition count, then per partition: region index
+ *                into the header table, claimant count, d_in, d_out,
+ *                obliq_in, obliq_out
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bnetwork.h"
+#include "bu/cv.h"
+#include "bu/opt.h"
+#include "bu/parallel.h"
+#include "bu/time.h"
+
+#include "./nirt.h"
+
+#define NIRT_BATCH_BLOCK 65536	/* rays shot between ordered writes */
+#define NIRT_BATCH_CHUNK 64	/* rays claimed by a thread at a time */
+#define NIRT_BATCH_MAGIC "NIRTBAT1"
+
+struct nirt_batch_ray {
+    point_t orig;
+    vect_t dir;
+};
+
+struct nirt_batch_state {
+    struct nirt_state *nss;
+    struct rt_i *rtip;
+    int binary;
+    double base2local;
+    std::vector<struct resource *> resp;
+    std::vector<nirt_batch_ray> rays;
+    std::vector<std::string> results;
+    size_t first;	/* index of rays[0] within the input file */
+    size_t next;	/* next unclaimed ray in the current block */
+    size_t nres;	/* next unclaimed entry in resp */
+};
+
+
+static void
+_nirt_batch_put_uint32(std::string &s, uint32_t v)
+{
+    uint32_t nv = htonl(v);
+    s.append((const char *)&nv, sizeof(nv));
+}
+
+
+static void
+_nirt_batch_put_dbl(std::string &s, double v)
+{
+    unsigned char buf[SIZEOF_NETWORK_DOUBLE];
+    bu_cv_htond(buf, (const unsigned char *)&v, 1);
+    s.append((const char *)buf, SIZEOF_NETWORK_DOUBLE);
+}
+
+
+extern "C" int
+_nirt_batch_hit(struct application *ap, struct partition *part_head, struct seg *UNUSED(segs))
+{
+    struct nirt_batch_state *bs = (struct nirt_batch_state *)ap->a_uptr;
+    std::string &out = bs->results[ap->a_user];
+    uint32_t pcnt = 0;
+    struct partition *part;
+    char line[512];
+
+    if (bs->nss->i->overlap_claims == NIRT_OVLP_REBUILD_FASTGEN) {
+	rt_rebuild_overlaps(part_head, ap, 1);
+    } else if (bs->nss->i->overlap_claims == NIRT_OVLP_REBUILD_ALL) {
+	rt_rebuild_overlaps(part_head, ap, 0);
+    }
+
+    /* partition count is patched in once we know it */
+    if (bs->binary)
+	_nirt_batch_put_uint32(out, 0);
+
+    for (part = part_head->pt_forw; part != part_head; part = part->pt_forw) {
+	vect_t nm_in, nm_out;
+	int claimants = 1;
+
+	RT_HIT_NORMAL(nm_in, part->pt_inhit, part->pt_inseg->seg_stp, &ap->a_ray, part->pt_inflip);
+	RT_HIT_NORMAL(nm_out, part->pt_outhit, part->pt_outseg->seg_stp, &ap->a_ray, part->pt_outflip);
+
+	/* a_dist holds the backout, so distances are measured from the
+	 * origin as given in the ray file */
+	double d_in = (part->pt_inhit->hit_dist - ap->a_dist) * bs->base2local;
+	double d_out = (part->pt_outhit->hit_dist - ap->a_dist) * bs->base2local;
+	double obliq_in = _nirt_get_obliq(ap->a_ray.r_dir, nm_in);
+	double obliq_out = _nirt_get_obliq(ap->a_ray.r_dir, nm_out);
+
+	if (part->pt_overlap_reg) {
+	    struct region **rpp;
+	    claimants = 0;
+	    for (rpp = part->pt_overlap_reg; *rpp != REGION_NULL; ++rpp)
+		claimants++;
+	}
+
+	if (bs->binary) {
+	    _nirt_batch_put_uint32(out, (uint32_t)part->pt_regionp->reg_bit);
+	    _nirt_batch_put_uint32(out, (uint32_t)claimants);
+	    _nirt_batch_put_dbl(out, d_in);
+	    _nirt_batch_put_dbl(out, d_out);
+	    _nirt_batch_put_dbl(out, obliq_in);
+	    _nirt_batch_put_dbl(out, obliq_out);
+	} else {
+	    snprintf(line, sizeof(line), "%zu\t%d\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%d\t",
+		     bs->first + (size_t)ap->a_user, part->pt_regionp->reg_regionid,
+		     d_in, d_out, d_out - d_in, obliq_in, obliq_out, claimants);
+	    out.append(line);
+	    out.append(part->pt_regionp->reg_name);
+	    out.push_back('\n');
+	}
+	pcnt++;
+    }
+
+    if (bs->binary) {
+	uint32_t ncnt = htonl(pcnt);
+	memcpy(&out[0], &ncnt, sizeof(ncnt));
+    }
+
+    return HIT;
+}
+
+
+extern "C" int
+_nirt_batch_miss(struct application *ap)
+{
+    struct nirt_batch_state *bs = (struct nirt_batch_state *)ap->a_uptr;
+    if (bs->binary)
+	_nirt_batch_put_uint32(bs->results[ap->a_user], 0);
+    return MISS;
+}
+
+
+static void
+_nirt_batch_worker(int UNUSED(cpu), void *data)
+{
+    struct nirt_batch_state *bs = (struct nirt_batch_state *)data;
+    struct nirt_state *nss = bs->nss;
+    struct application ap;
+    size_t slot;
+
+    /* bu_parallel() cpu ids aren't guaranteed to be 0..ncpu-1, so
+     * each worker claims its own resource */
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    slot = bs->nres++;
+    bu_semaphore_release(BU_SEM_GENERAL);
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = bs->rtip;
+    ap.a_resource = bs->resp[slot];
+    ap.a_hit = _nirt_batch_hit;
+    ap.a_miss = _nirt_batch_miss;
+    ap.a_overlap = rt_defoverlap;
+    ap.a_logoverlap = rt_silent_logoverlap;
+    ap.a_onehit = 0;
+    ap.a_purpose = "NIRT batch ray";
+    ap.a_uptr = (void *)bs;
+
+    while (1) {
+	size_t start, end;
+
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	start = bs->next;
+	bs->next += NIRT_BATCH_CHUNK;
+	bu_semaphore_release(BU_SEM_GENERAL);
+
+	if (start >= bs->rays.size())
+	    break;
+	end = start + NIRT_BATCH_CHUNK;
+	if (end > bs->rays.size())
+	    end = bs->rays.size();
+
+	for (size_t i = start; i < end; i++) {
+	    nirt_batch_ray &r = bs->rays[i];
+	    ap.a_dist = (nss->i->backout) ? _nirt_backout_dist(bs->rtip, r.orig, r.dir) : 0.0;
+	    VJOIN1(ap.a_ray.r_pt, r.orig, -ap.a_dist, r.dir);
+	    VMOVE(ap.a_ray.r_dir, r.dir);
+	    ap.a_user = (int)i;
+	    bs->results[i].clear();
+	    (void)rt_shootray(&ap);
+	}
+    }
+}
+
+
+/* Read up to NIRT_BATCH_BLOCK rays.  Returns -1 on a malformed ray,
+ * otherwise the number of rays read (0 at end of file). */
+static long
+_nirt_batch_read(struct nirt_batch_state *bs, FILE *fp, int binary_in, size_t *lineno)
+{
+    struct nirt_state *nss = bs->nss;
+    char line[1024];
+
+    bs->rays.clear();
+    while (bs->rays.size() < NIRT_BATCH_BLOCK) {
+	double v[6];
+	nirt_batch_ray r;
+
+	if (binary_in) {
+	    unsigned char buf[6*SIZEOF_NETWORK_DOUBLE];
+	    size_t got = fread(buf, 1, sizeof(buf), fp);
+	    if (got == 0)
+		break;
+	    if (got != sizeof(buf)) {
+		nerr(nss, "Error: batch: truncated binary ray %zu\n", *lineno);
+		return -1;
+	    }
+	    bu_cv_ntohd((unsigned char *)v, buf, 6);
+	    (*lineno)++;
+	} else {
+	    if (!bu_fgets(line, sizeof(line), fp))
+		break;
+	    (*lineno)++;
+	    char *s = line;
+	    while (*s == ' ' || *s == '\t')
+		s++;
+	    if (*s == '#' || *s == '\n' || *s == '\r' || *s == '\0')
+		continue;
+	    if (sscanf(s, "%lf %lf %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6) {
+		nerr(nss, "Error: batch: line %zu: expected \"x y z dx dy dz\"\n", *lineno);
+		return -1;
+	    }
+	}
+
+	VSET(r.orig, v[0], v[1], v[2]);
+	VSCALE(r.orig, r.orig, nss->i->local2base);
+	VSET(r.dir, v[3], v[4], v[5]);
+	if (MAGSQ(r.dir) < SMALL_FASTF) {
+	    nerr(nss, "Error: batch: ray %zu has a zero length direction\n", *lineno);
+	    return -1;
+	}
+	VUNITIZE(r.dir);
+	bs->rays.push_back(r);
+    }
+
+    return (long)bs->rays.size();
+}
+
+
+static void
+_nirt_batch_header(struct nirt_batch_state *bs, std::string &out)
+{
+    if (!bs->binary) {
+	out.append("# ray\treg_id\td_in\td_out\tlos\tobliq_in\tobliq_out\tclaimants\tpath_name\n");
+	return;
+    }
+
+    std::vector<struct region *> regs(bs->rtip->stats.nregions, (struct region *)NULL);
+    struct region *regp;
+    for (BU_LIST_FOR(regp, region, &bs->rtip->HeadRegion)) {
+	if ((size_t)regp->reg_bit < regs.size())
+	    regs[regp->reg_bit] = regp;
+    }
+
+    out.append(NIRT_BATCH_MAGIC);
+    _nirt_batch_put_dbl(out, bs->base2local);
+    _nirt_batch_put_uint32(out, (uint32_t)regs.size());
+    for (size_t i = 0; i < regs.size(); i++) {
+	const char *name = (regs[i]) ? regs[i]->reg_name : "";
+	_nirt_batch_put_uint32(out, (regs[i]) ? (uint32_t)regs[i]->reg_regionid : 0);
+	_nirt_batch_put_uint32(out, (uint32_t)strlen(name));
+	out.append(name);
+    }
+}
+
+
+static int
+_nirt_batch_emit(struct nirt_state *nss, FILE *ofp, const std::string &s)
+{
+    if (!s.length())
+	return 0;
+    if (!ofp) {
+	nout(nss, "%s", s.c_str());
+	return 0;
+    }
+    if (fwrite(s.data(), 1, s.length(), ofp) != s.length()) {
+	nerr(nss, "Error: batch: short write to output file\n");
+	return -1;
+    }
+    return 0;
+}
+
+
+extern "C" int
+_nirt_cmd_batch(void *ns, int argc, const char *argv[])
+{
+    if (!ns) return -1;
+    struct nirt_state *nss = (struct nirt_state *)ns;
+    int ac = 0;
+    int ret = 0;
+    int print_help = 0;
+    int binary_in = 0;
+    int binary_out = 0;
+    int ncpu = (int)bu_avail_cpus();
+    struct bu_vls ofile = BU_VLS_INIT_ZERO;
+    struct bu_vls optparse_msg = BU_VLS_INIT_ZERO;
+    struct bu_opt_desc d[6];
+    BU_OPT(d[0],  "h", "help",         "",     NULL,         &print_help, "print help and exit");
+    BU_OPT(d[1],  "b", "binary-input", "",     NULL,         &binary_in,  "ray file holds six big-endian doubles per ray");
+    BU_OPT(d[2],  "B", "binary",       "",     NULL,         &binary_out, "write binary records instead of columns");
+    BU_OPT(d[3],  "P", "threads",      "#",    &bu_opt_int,  &ncpu,       "number of threads to shoot with");
+    BU_OPT(d[4],  "o", "output",       "file", &bu_opt_vls,  &ofile,      "write results to file instead of the nirt output");
+    BU_OPT_NULL(d[5]);
+    const char *ustr = "Usage: batch <opts> rayfile\nOptions:";
+
+    argv++; argc--;
+
+    if ((ac = bu_opt_parse(&optparse_msg, argc, (const char **)argv, d)) == -1) {
+	char *help = bu_opt_describe(d, NULL);
+	nerr(nss, "Error: bu_opt value read failure: %s\n\n%s\n%s\n", bu_vls_cstr(&optparse_msg), ustr, help);
+	if (help) bu_free(help, "help str");
+	bu_vls_free(&optparse_msg);
+	bu_vls_free(&ofile);
+	return -1;
+    }
+    bu_vls_free(&optparse_msg);
+
+    if (print_help || ac != 1) {
+	char *help = bu_opt_describe(d, NULL);
+	nerr(nss, "%s\n%s", ustr, help);
+	if (help) bu_free(help, "help str");
+	bu_vls_free(&ofile);
+	return -1;
+    }
+
+    if (binary_out && !bu_vls_strlen(&ofile)) {
+	nerr(nss, "Error: batch: binary output requires an output file (-o)\n");
+	bu_vls_free(&ofile);
+	return -1;
+    }
+
+    if (ncpu < 1)
+	ncpu = 1;
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+
+    /* Same prep logic as a single shot */
+    if (!_nirt_get_rtip(nss)) {
+	nerr(nss, "Error: batch: no active objects to shoot at\n");
+	bu_vls_free(&ofile);
+	return -1;
+    }
+    if (nss->i->need_reprep && _nirt_raytrace_prep(nss)) {
+	nerr(nss, "Error: raytrace prep failed!\n");
+	bu_vls_free(&ofile);
+	return -1;
+    }
+
+    FILE *ifp = fopen(argv[0], (binary_in) ? "rb" : "r");
+    if (!ifp) {
+	nerr(nss, "Error: batch: cannot open ray file %s\n", argv[0]);
+	bu_vls_free(&ofile);
+	return -1;
+    }
+    FILE *ofp = NULL;
+    if (bu_vls_strlen(&ofile)) {
+	ofp = fopen(bu_vls_cstr(&ofile), (binary_out) ? "wb" : "w");
+	if (!ofp) {
+	    nerr(nss, "Error: batch: cannot open output file %s\n", bu_vls_cstr(&ofile));
+	    fclose(ifp);
+	    bu_vls_free(&ofile);
+	    return -1;
+	}
+    }
+
+    struct nirt_batch_state bs;
+    bs.nss = nss;
+    bs.rtip = _nirt_get_rtip(nss);
+    bs.binary = binary_out;
+    bs.base2local = nss->i->base2local;
+    bs.first = 0;
+    bs.next = 0;
+    bs.nres = 0;
+
+    /* cpu 0 shares the interactive resource, the rest are kept in the
+     * nirt state so repeated batches don't re-register them */
+    std::vector<struct resource *> &extra = (nss->i->use_air) ? nss->i->batch_res_air : nss->i->batch_res;
+    bs.resp.push_back(_nirt_get_resource(nss));
+    for (int i = 1; i < ncpu; i++) {
+	if (extra.size() < (size_t)i) {
+	    struct resource *r;
+	    BU_GET(r, struct resource);
+	    rt_init_resource(r, i, bs.rtip);
+	    extra.push_back(r);
+	}
+	bs.resp.push_back(extra[i-1]);
+    }
+    bs.results.resize(NIRT_BATCH_BLOCK);
+
+    int64_t start_time = bu_gettime();
+    size_t lineno = 0;
+    std::string hdr;
+    _nirt_batch_header(&bs, hdr);
+    ret = _nirt_batch_emit(nss, ofp, hdr);
+
+    while (!ret) {
+	long cnt = _nirt_batch_read(&bs, ifp, binary_in, &lineno);
+	if (cnt < 0) {
+	    ret = -1;
+	    break;
+	}
+	if (cnt == 0)
+	    break;
+
+	bs.next = 0;
+	bs.nres = 0;
+	bu_parallel(_nirt_batch_worker, (size_t)ncpu, &bs);
+
+	/* ordered merge */
+	if (ofp) {
+	    for (size_t i = 0; i < bs.rays.size() && !ret; i++)
+		ret = _nirt_batch_emit(nss, ofp, bs.results[i]);
+	} else {
+	    std::string blk;
+	    for (size_t i = 0; i < bs.rays.size(); i++)
+		blk.append(bs.results[i]);
+	    ret = _nirt_batch_emit(nss, ofp, blk);
+	}
+	bs.first += bs.rays.size();
+    }
+
+    double secs = (bu_gettime() - start_time) / 1.0e6;
+    nmsg(nss, "batch: %zu rays shot on %d thread%s in %.2f seconds", bs.first, ncpu, (ncpu == 1) ? "" : "s", secs);
+    if (secs > 0.0)
+	nmsg(nss, " (%.0f rays/s)", bs.first / secs);
+    nmsg(nss, "\n");
+
+    fclose(ifp);
+    if (ofp && fclose(ofp)) {
+	nerr(nss, "Error: batch: failed closing %s\n", bu_vls_cstr(&ofile));
+	ret = -1;
+    }
+    bu_vls_free(&ofile);
+
+    return ret;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -361,19 +361,14 @@ static void _nirt_ae2dir(struct nirt_state *nss)
 }
 
 
-static double _nirt_backout(struct nirt_state *nss)
+double
+_nirt_backout_dist(struct rt_i *rtip, const point_t ray_point, const vect_t ray_dir)
 {
     double bov;
-    point_t ray_point;
-    vect_t diag, dvec, ray_dir, center_bsphere;
+    vect_t diag, dvec, center_bsphere;
     fastf_t bsphere_diameter, dist_to_target, delta;
 
-    if (!nss || !nss->i->backout) return 0.0;
-
-    VMOVE(ray_point, nss->i->vals->orig);
-    VMOVE(ray_dir, nss->i->vals->dir);
-
-    VSUB2(diag, nss->i->ap->a_rt_i->mdl_max, nss->i->ap->a_rt_i->mdl_min);
+    VSUB2(diag, rtip->mdl_max, rtip->mdl_min);
     bsphere_diameter = MAGNITUDE(diag);
 
     /*
@@ -381,7 +376,7 @@ static double _nirt_backout(struct nirt_state *nss)
      * through the center of the bounding sphere and a plane normal to
      * the ray direction through the aim point.
      */
-    VADD2SCALE(center_bsphere, nss->i->ap->a_rt_i->mdl_max, nss->i->ap->a_rt_i->mdl_min, 0.5);
+    VADD2SCALE(center_bsphere, rtip->mdl_max, rtip->mdl_min, 0.5);
 
     dist_to_target = DIST_PNT_PNT(center_bsphere, ray_point);
 
@@ -399,8 +394,16 @@ static double _nirt_backout(struct nirt_state *nss)
 }
 
 
-static fastf_t
-_nirt_get_obliq(fastf_t *ray, fastf_t *normal)
+static double _nirt_backout(struct nirt_state *nss)
+{
+    if (!nss || !nss->i->backout) return 0.0;
+
+    return _nirt_backout_dist(nss->i->ap->a_rt_i, nss->i->vals->orig, nss->i->vals->dir);
+}
+
+
+fastf_t
+_nirt_get_obliq(const fastf_t *ray, const fastf_t *normal)
 {
     fastf_t cos_obl;
     fastf_t obliquity;
@@ -1550,6 +1553,7 @@ static const struct nirt_cmd_desc nirt_descs[] = {
     { "hv",             "set/query gridplane coordinates",               "horz vert [dist]" },
     { "xyz",            "set/query target coordinates",                  "X Y Z" },
     { "s",              "shoot a ray at the target",                     NULL },
+    { "batch",          "shoot all rays listed in a file, in parallel",  "[-b] [-B] [-P ncpu] [-o file] rayfile" },
     { "backout",        "back out of model",                             NULL },
     { "useair",         "set/query use of air",                          "<0|1|2|...>" },
     { "units",          "set/query local units",                         "<mm|cm|m|in|ft>" },
@@ -2602,6 +2606,7 @@ const struct bu_cmdtab _libanalyze_nirt_cmds[] = {
     { "ae",             _nirt_cmd_az_el},
     { "attr",           _nirt_cmd_attr},
     { "backout",        _nirt_cmd_backout},
+    { "batch",          _nirt_cmd_batch},
     { "center",         _nirt_cmd_target_coor},
     { "color",          _nirt_cmd_color_plot},
     { "debug",          _nirt_cmd_debug},
@@ -3058,6 +3063,11 @@ nirt_destroy(struct nirt_state *ns)
     if (ns->i->rtip != RTI_NULL) rt_free_rti(ns->i->rtip);
     if (ns->i->rtip_air != RTI_NULL) rt_free_rti(ns->i->rtip_air);
 
+    for (size_t i = 0; i < ns->i->batch_res.size(); i++)
+	BU_PUT(ns->i->batch_res[i], struct resource);
+    for (size_t i = 0; i < ns->i->batch_res_air.size(); i++)
+	BU_PUT(ns->i->batch_res_air[i], struct resource);
+
     db_close(ns->i->dbip);
 
     BU_PUT(ns->i->vals, struct nirt_output_record);
@@ -368,6 +368,9 @@ struct nirt_state_impl {
     struct resource *res;
     struct rt_i *rtip_air;
     struct resource *res_air;
+    /* Extra per-thread resources for batch shooting (cpu 1 and up) */
+    std::vector<struct resource *> batch_res;
+    std::vector<struct resource *> batch_res_air;
     int need_reprep;
 
     /* internal format specifier arrays */
@@ -410,6 +413,12 @@ void _nirt_targ2grid(struct nirt_state *nss);
 
 void _nirt_dir2ae(struct nirt_state *nss);
 
+/* Distance to back a ray out along -dir so it starts outside the model */
+double _nirt_backout_dist(struct rt_i *rtip, const point_t ray_point, const vect_t ray_dir);
+
+/* Angle in degrees between a ray and a surface normal */
+fastf_t _nirt_get_obliq(const fastf_t *ray, const fastf_t *normal);
+
 struct rt_i * _nirt_get_rtip(struct nirt_state *nss);
 struct resource * _nirt_get_resource(struct nirt_state *nss);
 void _nirt_init_ovlp(struct nirt_state *nss);
@@ -421,6 +430,8 @@ void _nirt_diff_destroy(struct nirt_state *nss);
 void _nirt_diff_add_seg(struct nirt_state *nss, nirt_seg *nseg);
 extern "C" int _nirt_cmd_diff(void *ns, int argc, const char *argv[]);
 
+extern "C" int _nirt_cmd_batch(void *ns, int argc, const char *argv[]);
+
 
 // Local Variables:
 // tab-width: 8
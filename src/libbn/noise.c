@@ -59,6 +59,37 @@
  * Defined before filter_args so that function can reference it directly. */
 #define TABLE_SIZE 4096
 
+/* Number of points the batched evaluators work on at a time */
+#define NOISE_BLOCK 64
+
+
+/**
+ * Fold one coordinate into the noise domain [0, TABLE_SIZE).
+ */
+static inline double
+noise_fold(double v)
+{
+    /* FOLD_PERIOD must equal TABLE_SIZE (defined earlier in this file).
+     * Use TABLE_SIZE directly so they cannot drift apart. */
+    static const double FOLD_PERIOD = (double)TABLE_SIZE;
+
+    /* assure values are positive */
+    v = fabs(v);
+
+    /* handle Inf/NaN by zeroing - avoids propagating bad values */
+    if (!isfinite(v))
+	v = 0.0;
+
+    /* fold space into [0, FOLD_PERIOD) in O(1).
+     * fmod is well-defined for all finite inputs and returns the exact
+     * remainder, so the fractional part of v is preserved.  Values
+     * already in range come back unchanged, so skip the call for
+     * them - it is the single most expensive step of a lookup. */
+    if (v < FOLD_PERIOD)
+	return v;
+    return fmod(v, FOLD_PERIOD);
+}
+
 
 /**
  * @brief
@@ -95,26 +126,11 @@ filter_args(fastf_t *src, fastf_t *p, fastf_t *f, int *ip)
      * fmod(x, TABLE_SIZE) or the original folded value, because the hash
      * lookup is already modulo TABLE_SIZE. */
 
-    /* FOLD_PERIOD must equal TABLE_SIZE (defined earlier in this file).
-     * Use TABLE_SIZE directly so they cannot drift apart. */
-    static const double FOLD_PERIOD = (double)TABLE_SIZE;
-
     int i;
     point_t dst = VINIT_ZERO;
 
-    for (i=0; i < 3; i++) {
-	/* assure values are positive */
-	dst[i] = fabs(src[i]);
-
-	/* handle Inf/NaN by zeroing - avoids propagating bad values */
-	if (!isfinite(dst[i]))
-	    dst[i] = 0.0;
-
-	/* fold space into [0, FOLD_PERIOD) in O(1).
-	 * fmod is well-defined for all finite inputs and returns the exact
-	 * remainder, so the fractional part of src[i] is preserved. */
-	dst[i] = fmod(dst[i], FOLD_PERIOD);
-    }
+    for (i=0; i < 3; i++)
+	dst[i] = noise_fold(src[i]);
 
     /* calculate our destination point */
     p[X] = dst[0];
@@ -314,6 +330,97 @@ bn_noise_perlin(point_t point)
 }
 
 
+/**
+ * Evaluate bn_noise_perlin() at n <= NOISE_BLOCK points given in
+ * structure-of-arrays form.
+ *
+ * The work is split into passes over the whole block - lattice setup,
+ * corner hashing and interpolation - so the arithmetic passes are
+ * plain loops over contiguous arrays the compiler can vectorize, and
+ * only the hash table gathers remain scalar.  The arithmetic matches
+ * bn_noise_perlin() term for term so results are the same.
+ */
+static void
+perlin_block(double *result, size_t n, const fastf_t *px, const fastf_t *py, const fastf_t *pz)
+{
+    double x[NOISE_BLOCK], y[NOISE_BLOCK], z[NOISE_BLOCK];
+    double sx[NOISE_BLOCK], sy[NOISE_BLOCK], sz[NOISE_BLOCK];
+    int ix[NOISE_BLOCK], iy[NOISE_BLOCK], iz[NOISE_BLOCK];
+    int m[8][NOISE_BLOCK];
+    size_t i;
+
+    /* fold into the noise domain and locate the lattice cell */
+    for (i = 0; i < n; i++) {
+	x[i] = noise_fold(px[i]);
+	y[i] = noise_fold(py[i]);
+	z[i] = noise_fold(pz[i]);
+	ix[i] = floor(x[i]);
+	iy[i] = floor(y[i]);
+	iz[i] = floor(z[i]);
+    }
+
+    for (i = 0; i < n; i++) {
+	double fx = x[i] - ix[i];
+	double fy = y[i] - iy[i];
+	double fz = z[i] - iz[i];
+	sx[i] = SMOOTHSTEP(fx);
+	sy[i] = SMOOTHSTEP(fy);
+	sz[i] = SMOOTHSTEP(fz);
+    }
+
+    /* repeatable random #s for the eight cell corners */
+    for (i = 0; i < n; i++) {
+	int jx = ix[i] + 1;
+	int jy = iy[i] + 1;
+	int jz = iz[i] + 1;
+	m[0][i] = Hash3d(ix[i], iy[i], iz[i]) & 0xFF;
+	m[1][i] = Hash3d(jx, iy[i], iz[i]) & 0xFF;
+	m[2][i] = Hash3d(ix[i], jy, iz[i]) & 0xFF;
+	m[3][i] = Hash3d(jx, jy, iz[i]) & 0xFF;
+	m[4][i] = Hash3d(ix[i], iy[i], jz) & 0xFF;
+	m[5][i] = Hash3d(jx, iy[i], jz) & 0xFF;
+	m[6][i] = Hash3d(ix[i], jy, jz) & 0xFF;
+	m[7][i] = Hash3d(jx, jy, jz) & 0xFF;
+    }
+
+    /* interpolate! */
+    for (i = 0; i < n; i++) {
+	double tx = 1.0 - sx[i];
+	double ty = 1.0 - sy[i];
+	double tz = 1.0 - sz[i];
+	double dx0 = x[i] - ix[i], dx1 = x[i] - (ix[i] + 1);
+	double dy0 = y[i] - iy[i], dy1 = y[i] - (iy[i] + 1);
+	double dz0 = z[i] - iz[i], dz1 = z[i] - (iz[i] + 1);
+	double sum;
+
+	sum = INCRSUM(m[0][i], (tx*ty*tz), dx0, dy0, dz0);
+	sum += INCRSUM(m[1][i], (sx[i]*ty*tz), dx1, dy0, dz0);
+	sum += INCRSUM(m[2][i], (tx*sy[i]*tz), dx0, dy1, dz0);
+	sum += INCRSUM(m[3][i], (sx[i]*sy[i]*tz), dx1, dy1, dz0);
+	sum += INCRSUM(m[4][i], (tx*ty*sz[i]), dx0, dy0, dz1);
+	sum += INCRSUM(m[5][i], (sx[i]*ty*sz[i]), dx1, dy0, dz1);
+	sum += INCRSUM(m[6][i], (tx*sy[i]*sz[i]), dx0, dy1, dz1);
+	sum += INCRSUM(m[7][i], (sx[i]*sy[i]*sz[i]), dx1, dy1, dz1);
+	result[i] = sum;
+    }
+}
+
+
+void
+bn_noise_perlin_n(double *result, size_t n, const fastf_t *x, const fastf_t *y, const fastf_t *z)
+{
+    size_t b;
+
+    if (!ht.hashTableValid)
+	bn_noise_init();
+
+    for (b = 0; b < n; b += NOISE_BLOCK) {
+	size_t cnt = (n - b < NOISE_BLOCK) ? n - b : NOISE_BLOCK;
+	perlin_block(result + b, cnt, x + b, y + b, z + b);
+    }
+}
+
+
 void
 bn_noise_vec(point_t point, point_t result)
 {
@@ -437,7 +544,10 @@ struct fbm_spec {
 };
 #define MAGIC_fbm_spec_wgt 0x837592
 
-static struct fbm_spec *etbl = (struct fbm_spec *)NULL;
+/* Tables are allocated individually and never freed or moved, so a
+ * pointer handed out by find_spec_wgt() stays valid while other threads
+ * add entries.  Only the etbl index array itself is reallocated. */
+static struct fbm_spec **etbl = (struct fbm_spec **)NULL;
 static int etbl_next = 0;
 static int etbl_size = 0;
 
@@ -462,19 +572,19 @@ build_spec_tbl(double h_val, double lacunarity, double octaves)
     if (etbl_next >= etbl_size) {
 	if (etbl_size) {
 	    etbl_size *= 2;
-	    etbl = (struct fbm_spec *)bu_realloc((void *)etbl,
-						 etbl_size*sizeof(struct fbm_spec),
-						 "spectral weights table");
+	    etbl = (struct fbm_spec **)bu_realloc((void *)etbl,
+						  etbl_size*sizeof(struct fbm_spec *),
+						  "spectral weights table");
 	} else {
 	    etbl_size = 128;
-	    etbl = (struct fbm_spec *)bu_calloc(etbl_size,
-						sizeof(struct fbm_spec),
-						"spectral weights table");
+	    etbl = (struct fbm_spec **)bu_calloc(etbl_size,
+						 sizeof(struct fbm_spec *),
+						 "spectral weights table");
 	}
     }
 
     /* set up the next available table */
-    ep = &etbl[etbl_next];
+    BU_ALLOC(ep, struct fbm_spec);
     ep->h_val = h_val;
     ep->lacunarity = lacunarity;
     ep->octaves = octaves;
@@ -488,6 +598,7 @@ build_spec_tbl(double h_val, double lacunarity, double octaves)
 	frequency *= lacunarity;
     }
 
+    etbl[etbl_next] = ep;
     etbl_next++; /* saved for last in case we're running multi-threaded */
     return ep;
 }
@@ -503,7 +614,9 @@ build_spec_tbl(double h_val, double lacunarity, double octaves)
  * previous "optimistic unsynchronized first scan" pattern was a data
  * race: build_spec_tbl() can call bu_realloc() which moves etbl to a
  * new address while another thread is scanning the old pointer, causing
- * a use-after-free and potential multi-thread deadlock.
+ * a use-after-free and potential multi-thread deadlock.  The tables
+ * themselves never move, so the returned pointer may be used without
+ * holding the semaphore.
  */
 struct fbm_spec *
 find_spec_wgt(double h, double l, double o)
@@ -511,10 +624,14 @@ find_spec_wgt(double h, double l, double o)
     struct fbm_spec *ep = NULL;
     int i;
 
+    /* also registers sem_noise */
+    if (!ht.hashTableValid)
+	bn_noise_init();
+
     bu_semaphore_acquire(sem_noise);
 
     for (i=0; i < etbl_next; i++) {
-	ep = &etbl[i];
+	ep = etbl[i];
 	if (ep->magic != MAGIC_fbm_spec_wgt)
 	    bu_bomb("find_spec_wgt");
 	if (EQUAL(ep->lacunarity, l)
@@ -534,100 +651,117 @@ find_spec_wgt(double h, double l, double o)
 }
 
 
-double
-bn_noise_fbm(point_t point, double h_val, double lacunarity, double octaves)
+/**
+ * Spectral sum shared by the fBm and turbulence evaluators.  Points are
+ * processed NOISE_BLOCK at a time, one octave per pass over the block,
+ * so each pass is a single perlin_block() call over contiguous arrays.
+ * With turb set the full octaves contribute their absolute value; the
+ * fractional octave never does (matching the historical behavior of
+ * bn_noise_turb).
+ */
+static void
+spectral_n(double *result, size_t n, const fastf_t *x, const fastf_t *y, const fastf_t *z,
+	   const double *spec_wgts, double lacunarity, double octaves, int turb)
 {
-    struct fbm_spec *ep;
-    double value, noise_remainder, *spec_wgts;
-    point_t pt;
-    int i, oct;
+    fastf_t px[NOISE_BLOCK], py[NOISE_BLOCK], pz[NOISE_BLOCK];
+    double nv[NOISE_BLOCK];
+    double noise_remainder = octaves - (int)octaves;
+    int oct = (int)octaves; /* save repeating double->int cast */
+    size_t b, j;
+    int i;
 
-    /* The first order of business is to see if we have pre-computed
-     * the spectral weights table for these parameters in a previous
-     * invocation.  If not, then we compute them and save them for
-     * possible future use
-     */
+    for (b = 0; b < n; b += NOISE_BLOCK) {
+	size_t cnt = (n - b < NOISE_BLOCK) ? n - b : NOISE_BLOCK;
+	double *value = result + b;
 
-    ep = find_spec_wgt(h_val, lacunarity, octaves);
+	/* copy the points so we don't corrupt the caller's version */
+	for (j = 0; j < cnt; j++) {
+	    px[j] = x[b+j];
+	    py[j] = y[b+j];
+	    pz[j] = z[b+j];
+	    value[j] = 0.0;
+	}
 
-    /* now we're ready to compute the fBm value */
+	/* inner loop of spectral construction */
+	for (i = 0; i < oct; i++) {
+	    perlin_block(nv, cnt, px, py, pz);
+	    if (turb) {
+		for (j = 0; j < cnt; j++)
+		    value[j] += fabs(nv[j]) * spec_wgts[i];
+	    } else {
+		for (j = 0; j < cnt; j++)
+		    value[j] += nv[j] * spec_wgts[i];
+	    }
+	    for (j = 0; j < cnt; j++) {
+		px[j] *= lacunarity;
+		py[j] *= lacunarity;
+		pz[j] *= lacunarity;
+	    }
+	}
 
-    value = 0.0;            /* initialize vars to proper values */
-    /* copy the point so we don't corrupt the caller's version */
-    PCOPY(pt, point);
+	if (!ZERO(noise_remainder)) {
+	    /* add in ``octaves'' noise_remainder ``i'' and spatial freq. are
+	     * preset in loop above
+	     */
+	    perlin_block(nv, cnt, px, py, pz);
+	    for (j = 0; j < cnt; j++)
+		value[j] += noise_remainder * nv[j] * spec_wgts[i];
+	}
+    }
+}
 
-    spec_wgts = ep->spec_wgts;
 
-    /* inner loop of spectral construction */
-    oct=(int)octaves; /* save repeating double->int cast */
-    for (i=0; i < oct; i++) {
-	value += bn_noise_perlin(pt) * spec_wgts[i];
-	PSCALE(pt, lacunarity);
-    }
+double
+bn_noise_fbm(point_t point, double h_val, double lacunarity, double octaves)
+{
+    struct fbm_spec *ep;
+    double value;
 
-    noise_remainder = octaves - (int)octaves;
-    if (!ZERO(noise_remainder)) {
-	/* add in ``octaves'' noise_remainder ``i'' and spatial freq. are
-	 * preset in loop above
-	 */
-	value += noise_remainder * bn_noise_perlin(pt) * spec_wgts[i];
-    }
+    ep = find_spec_wgt(h_val, lacunarity, octaves);
+    spectral_n(&value, 1, &point[X], &point[Y], &point[Z], ep->spec_wgts, lacunarity, octaves, 0);
 
     return value;
-
 }
 
 
-double
-bn_noise_turb(point_t point, double h_val, double lacunarity, double octaves)
+void
+bn_noise_fbm_n(double *result, size_t n, const fastf_t *x, const fastf_t *y, const fastf_t *z,
+	       double h_val, double lacunarity, double octaves)
 {
     struct fbm_spec *ep;
-    double value, noise_remainder, *spec_wgts;
-    point_t pt;
-    int i, oct;
 
-
-    /* The first order of business is to see if we have pre-computed
-     * the spectral weights table for these parameters in a previous
-     * invocation.  If not, then we compute them and save them for
-     * possible future use
-     */
+    if (!n)
+	return;
 
     ep = find_spec_wgt(h_val, lacunarity, octaves);
+    spectral_n(result, n, x, y, z, ep->spec_wgts, lacunarity, octaves, 0);
+}
 
-    /* now we're ready to compute the fBm value */
 
-    value = 0.0;            /* initialize vars to proper values */
-    /* not cached: frequency = 1.0; */
+double
+bn_noise_turb(point_t point, double h_val, double lacunarity, double octaves)
+{
+    struct fbm_spec *ep;
+    double value;
 
-    /* copy the point so we don't corrupt the caller's copy of the
-     * variable
-     */
-    PCOPY(pt, point);
-    spec_wgts = ep->spec_wgts;
+    ep = find_spec_wgt(h_val, lacunarity, octaves);
+    spectral_n(&value, 1, &point[X], &point[Y], &point[Z], ep->spec_wgts, lacunarity, octaves, 1);
 
-    /* inner loop of spectral construction */
-    oct=(int)octaves; /* save repeating double->int cast */
-    for (i=0; i < oct; i++) {
-	/* not cached:
-	 * value += fabs(bn_noise_perlin(pt)) * pow(frequency, -h_val);
-	 * frequency *= lacunarity;
-	 */
-	value += fabs(bn_noise_perlin(pt)) * spec_wgts[i];
-	PSCALE(pt, lacunarity);
-    }
+    return value;
+}
 
-    noise_remainder = octaves - (int)octaves;
-    if (!ZERO(noise_remainder)) {
-	/* add in ``octaves'' noise_remainder ``i'' and spatial freq. are
-	 * preset in loop above
-	 */
-	value += noise_remainder * bn_noise_perlin(pt) * spec_wgts[i];
-	/* not cached: value += noise_remainder * bn_noise_perlin(pt) * pow(frequency, -h_val); */
-    }
 
-    return value;
+void
+bn_noise_turb_n(double *result, size_t n, const fastf_t *x, const fastf_t *y, const fastf_t *z,
+		double h_val, double lacunarity, double octaves)
+{
+    struct fbm_spec *ep;
+
+    if (!n)
+	return;
 
+    ep = find_spec_wgt(h_val, lacunarity, octaves);
+    spectral_n(result, n, x, y, z, ep->spec_wgts, lacunarity, octaves, 1);
 }
 
 
@@ -735,6 +869,26 @@ bn_noise_mf(point_t point, double h_val, double lacunarity, double octaves, doub
     return result;
 }
 
+
+void
+bn_noise_mf_n(double *result, size_t n, const fastf_t *x, const fastf_t *y, const fastf_t *z,
+	      double h_val, double lacunarity, double octaves, double UNUSED(offset))
+{
+    struct fbm_spec *ep;
+    size_t i;
+
+    if (!n)
+	return;
+
+    ep = find_spec_wgt(h_val, lacunarity, octaves);
+
+    /* as in bn_noise_mf, only the first octave contributes and the
+     * offset is fixed at 1.0 */
+    bn_noise_perlin_n(result, n, x, y, z);
+    for (i = 0; i < n; i++)
+	result[i] = (result[i] + 1.0) * ep->spec_wgts[0];
+}
+
 /** @} */
 /*
  * Local Variables:
@@ -19,7 +19,8 @@
  */
 /** @file libbn/tests/noise.c
  *
- * Tests for bn_noise_turb, bn_noise_fbm, and bn_noise_perlin.
+ * Tests for bn_noise_turb, bn_noise_fbm, and bn_noise_perlin, and their
+ * batched counterparts.
  *
  * Exercises two previously-broken paths:
  *
@@ -235,6 +236,71 @@ test_noise_perlin_basic(int UNUSED(argc), char **UNUSED(argv))
 }
 
 
+/* --------------------------------------------------------------------------
+ * 4.  Batched evaluation
+ *     The _n functions must give the same values as the single point
+ *     functions, for batches spanning several internal blocks and for
+ *     fractional octave counts.
+ * -------------------------------------------------------------------------- */
+#define NOISE_BATCH_NPTS 203
+
+static int
+test_noise_batch(int UNUSED(argc), char **UNUSED(argv))
+{
+    fastf_t x[NOISE_BATCH_NPTS], y[NOISE_BATCH_NPTS], z[NOISE_BATCH_NPTS];
+    double perlin[NOISE_BATCH_NPTS], fbm[NOISE_BATCH_NPTS];
+    double turb[NOISE_BATCH_NPTS], mf[NOISE_BATCH_NPTS];
+    static const double octaves[] = { 4.0, 2.5, 1.0, 0.5 };
+    size_t i, j;
+    int failures = 0;
+
+    bn_noise_init();
+
+    for (i = 0; i < NOISE_BATCH_NPTS; i++) {
+	x[i] = (double)i * 0.37 - 20.0;
+	y[i] = (double)i * 1.13;
+	z[i] = (i % 17) ? (double)i * 7.9 : 1e36;
+    }
+
+    bn_noise_perlin_n(perlin, NOISE_BATCH_NPTS, x, y, z);
+    for (i = 0; i < NOISE_BATCH_NPTS; i++) {
+	point_t pt;
+	VSET(pt, x[i], y[i], z[i]);
+	if (!NEAR_EQUAL(perlin[i], bn_noise_perlin(pt), 1e-12)) {
+	    bu_log("FAIL [noise_batch] bn_noise_perlin_n mismatch at point %zu\n", i);
+	    failures++;
+	}
+    }
+
+    for (j = 0; j < sizeof(octaves)/sizeof(octaves[0]); j++) {
+	bn_noise_fbm_n(fbm, NOISE_BATCH_NPTS, x, y, z, 1.0, 2.1753974, octaves[j]);
+	bn_noise_turb_n(turb, NOISE_BATCH_NPTS, x, y, z, 1.0, 2.1753974, octaves[j]);
+	bn_noise_mf_n(mf, NOISE_BATCH_NPTS, x, y, z, 1.0, 2.1753974, octaves[j], 1.0);
+	for (i = 0; i < NOISE_BATCH_NPTS; i++) {
+	    point_t pt;
+	    VSET(pt, x[i], y[i], z[i]);
+	    if (!NEAR_EQUAL(fbm[i], bn_noise_fbm(pt, 1.0, 2.1753974, octaves[j]), 1e-12)) {
+		bu_log("FAIL [noise_batch] bn_noise_fbm_n mismatch at point %zu, octaves %g\n", i, octaves[j]);
+		failures++;
+	    }
+	    if (!NEAR_EQUAL(turb[i], bn_noise_turb(pt, 1.0, 2.1753974, octaves[j]), 1e-12)) {
+		bu_log("FAIL [noise_batch] bn_noise_turb_n mismatch at point %zu, octaves %g\n", i, octaves[j]);
+		failures++;
+	    }
+	    if (!NEAR_EQUAL(mf[i], bn_noise_mf(pt, 1.0, 2.1753974, octaves[j], 1.0), 1e-12)) {
+		bu_log("FAIL [noise_batch] bn_noise_mf_n mismatch at point %zu, octaves %g\n", i, octaves[j]);
+		failures++;
+	    }
+	}
+    }
+
+    if (!failures)
+	bu_log("  PASS batched noise (%d points)\n", NOISE_BATCH_NPTS);
+
+    return failures;
+}
+
+
 /* --------------------------------------------------------------------------
  * Main dispatcher
  * -------------------------------------------------------------------------- */
@@ -247,7 +313,8 @@ noise_main(int argc, char *argv[])
 	bu_exit(1, "Usage: bn_test noise <function_num>\n"
 		"  1 = large coordinate single-thread\n"
 		"  2 = concurrent multi-thread\n"
-		"  3 = basic perlin sanity\n");
+		"  3 = basic perlin sanity\n"
+		"  4 = batched evaluation\n");
     }
 
     sscanf(argv[1], "%d", &function_num);
@@ -259,9 +326,11 @@ noise_main(int argc, char *argv[])
 	    return test_noise_concurrent(argc, argv);
 	case 3:
 	    return test_noise_perlin_basic(argc, argv);
+	case 4:
+	    return test_noise_batch(argc, argv);
     }
 
-    bu_log("ERROR: function_num %d is not valid (expected 1-3) [%s]\n", function_num, argv[0]);
+    bu_log("ERROR: function_num %d is not valid (expected 1-4) [%s]\n", function_num, argv[0]);
     return 1;
 }
 
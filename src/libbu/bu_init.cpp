@@ -49,9 +49,13 @@ int BU_SEM_MAPPEDFILE;
 /* These ARE NOT exported outside LIBBU */
 extern "C" int BU_SEM_DATETIME;
 extern "C" int BU_SEM_DIR;
+extern "C" int BU_SEM_HEAP;
 extern "C" int BU_SEM_MALLOC;
 extern "C" int BU_SEM_THREAD;
 
+/* from heap.c */
+extern "C" void heap_init(void);
+
 
 static void
 libbu_init(void)
@@ -66,6 +70,10 @@ libbu_init(void)
     BU_SEMAPHORE_DEFINE(BU_SEM_MALLOC);
     BU_SEMAPHORE_DEFINE(BU_SEM_DATETIME);
     BU_SEMAPHORE_DEFINE(BU_SEM_DIR);
+    BU_SEMAPHORE_DEFINE(BU_SEM_HEAP);
+
+    /* reserve the BU_GET() slab range while there is only one thread */
+    heap_init();
 
     bu_getiwd(iwd, MAXPATHLEN);
 }
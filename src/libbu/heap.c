@@ -18,9 +18,27 @@
  * information.
  */
 
+
 #include "common.h"
 
 #include <stdlib.h> /* for getenv, atoi, and atexit */
+#include <string.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#  include <sys/resource.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+#  if !defined(MAP_FAILED)
+#    define MAP_FAILED ((void *)-1)
+#  endif
+#  if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#    define MAP_ANONYMOUS MAP_ANON
+#  endif
+#  if !defined(MAP_NORESERVE)
+#    define MAP_NORESERVE 0
+#  endif
+#endif
+#include "bio.h"
 
 #include "bu/debug.h"
 #include "bu/log.h"
@@ -28,69 +46,101 @@
 #include "bu/parallel.h"
 #include "bu/vls.h"
 
+#include "./parallel.h"
+
 /**
  * This number specifies the range of byte sizes to support for fast
  * memory allocations.  Any request outside this range will get passed
  * to bu_calloc().
  *
- * 1-to-HEAP_BINS byte size allocations are allocated in PAGESIZE chunks as
- * they are requested.  There's minimal penalty for making this
- * arbitrarily large except where there are very few allocations (each
- * size will allocate at least one page).  PAGESIZE should be some
- * multiple larger than HEAP_BINS.
+ * Requests are rounded up to a multiple of HEAP_ALIGN, which gives
+ * HEAP_CLASSES size classes.  Every object is HEAP_ALIGN aligned,
+ * matching what malloc() promises on 64-bit platforms.
  *
  * Embedded or memory-constrained environments probably want to set
  * this a lot smaller than the default.
  */
 #define HEAP_BINS 256
+#define HEAP_ALIGN 16
+#define HEAP_CLASSES (HEAP_BINS / HEAP_ALIGN)
 
 /**
- * This specifies how much memory we should preallocate for each
- * allocation size.  Note that this number should be some multiple of
- * HEAP_BINS and system page size in order to be useful.  Ideally sized to
- * keep the allocation size with the most requests down to
- * single-digit page counts.  Testing showed a 1M page size was very
- * effective at eliminating allocation overhead.
- *
- * Embedded or memory-constrained environments probably want to set
- * this a lot smaller than the default.
+ * Size of a slab, the unit memory is taken from and given back to the
+ * system in.  Each slab holds objects of one size class behind a small
+ * header.  Slabs are carved out of one reserved address range so that
+ * any pointer can be tested for membership, and its slab header found,
+ * with a subtraction and a shift.
  */
 #define HEAP_PAGESIZE (HEAP_BINS * 256)
+#define HEAP_HEADER 64
 
+/**
+ * Objects are exchanged between a thread's cache and the shared lists
+ * HEAP_BATCH at a time, and a thread never keeps more than twice that
+ * many of one size.  When the shared free list of a size class grows
+ * past HEAP_RECLAIM bytes, slabs with no live objects left are
+ * released for use by any size class.  Up to HEAP_RETAIN released
+ * slabs are kept ready, the rest are given back to the system.
+ */
+#define HEAP_BATCH 32
+#define HEAP_RECLAIM (8 * HEAP_PAGESIZE)
+#define HEAP_RETAIN 64
 
-struct heap {
-    /**
-     * pages is an array of memory pages.  they are allocated one at a
-     * time so we only have to keep track of the last page.
-     */
-    char **pages;
-
-    /**
-     * a count of how many heap pages have been allocated so we can
-     * quickly jump into the current.
-     */
-    size_t count;
 
-    /**
-     * given tabulates how much memory the current page has been
-     * allocated to callers.  not a counter to avoid a multiply.
-     */
-    size_t given;
+/* free objects are chained through their first word */
+struct heap_obj {
+    struct heap_obj *next;
 };
 
-struct cpus {
-    /** each allocation size gets a bin for holding memory pages */
-    struct heap heap[HEAP_BINS];
+struct heap_slab {
+    struct heap_slab *next;	/* slabs of the same class, or unused slabs */
+    size_t cls;			/* size class, index into classes[] */
+    size_t carved;		/* objects handed out at least once */
+    size_t nfree;		/* scratch count while reclaiming */
+};
 
-    /** keep track of allocation sizes outside our supported range */
-    size_t misses;
+/**
+ * shared state of one size class, protected by BU_SEM_HEAP.
+ */
+struct heap_class {
+    struct heap_obj *free;	/* objects returned by threads */
+    size_t nfree;
+    size_t reclaim_at;		/* nfree that triggers the next reclaim */
+    struct heap_slab *slabs;	/* every slab of this class */
+    struct heap_slab *carving;	/* slab with objects never handed out */
+    size_t nslabs;
+    size_t gets;		/* objects handed to thread caches */
 };
 
 /**
- * store data in a cpu-specific structure so we can avoid the need for
- * mutex locking entirely.  relies on static zero-initialization.
+ * per-thread cache of one size class.  needs no locking at all.
  */
-static struct cpus per_cpu[MAX_PSW] = {{{{0, 0, 0}}, 0}};
+struct heap_cache {
+    struct heap_obj *head;
+    size_t count;
+};
+
+int BU_SEM_HEAP;
+
+static struct heap_class classes[HEAP_CLASSES];
+static THREADLOCAL struct heap_cache heap_cache[HEAP_CLASSES];
+
+/* the reserved range, set by heap_init() before main() and only read
+ * afterwards, so bu_free() can test pointers against it unlocked */
+static char *heap_base = NULL;
+static char *heap_end = NULL;
+static int heap_state = 0;	/* 0 untried, 1 reserved, -1 unavailable */
+
+/* slabs carved so far, released slabs kept ready, and slabs given
+ * back to the system */
+static size_t heap_used = 0;
+static struct heap_slab *heap_ready = NULL;
+static size_t heap_nready = 0;
+static struct heap_slab *heap_unused = NULL;
+static size_t heap_nunused = 0;
+
+static size_t heap_misses = 0;
+
 
 /* Need a function signature that matches bu_heap_func_t, so wrap bu_log in
  * order to allow it to act as the default bu_heap_log function. */
@@ -126,12 +176,9 @@ heap_print(void)
 {
     static int printed = 0;
 
-    size_t h, i;
+    size_t i;
     size_t allocs = 0;
-    size_t misses = 0;
-    size_t got = 0;
     size_t total_pages = 0;
-    size_t ncpu = bu_avail_cpus();
 
     bu_heap_func_t log = bu_heap_log(NULL);
 
@@ -148,56 +195,353 @@ heap_print(void)
 	"Memory Heap Information\n"
 	"-----------------------\n", NULL);
 
-    for (h=0; h < ncpu; h++) {
-	for (i=0; i < HEAP_BINS; i++) {
-
-	    /* capacity across all pages */
-	    got = per_cpu[h].heap[i].count * (HEAP_PAGESIZE/(i+1));
-
-	    if (got > 0) {
-		/* last page is partial */
-		got -= (HEAP_PAGESIZE - per_cpu[h].heap[i].given)/(i+1);
-		bu_vls_sprintf(&str, "%04zu [%02zu] => %zu\n", i, per_cpu[h].heap[i].count, got);
-		log(bu_vls_addr(&str), NULL);
-		allocs += got;
-	    }
-	    total_pages += per_cpu[h].heap[i].count;
+    for (i=0; i < HEAP_CLASSES; i++) {
+	if (classes[i].nslabs > 0) {
+	    bu_vls_sprintf(&str, "%04zu [%02zu] => %zu (%zu free)\n", (i+1) * HEAP_ALIGN, classes[i].nslabs, classes[i].gets, classes[i].nfree);
+	    log(bu_vls_addr(&str), NULL);
+	    allocs += classes[i].gets;
 	}
-	misses += per_cpu[h].misses;
+	total_pages += classes[i].nslabs;
     }
     bu_vls_sprintf(&str, "-----------------------\n"
 		   "size [pages] => count\n"
 		   "Heap range: 1-%d bytes\n"
 		   "Page size: %d bytes\n"
-		   "Pages: %zu (%.2lfMB)\n"
+		   "Pages: %zu (%.2lfMB), %zu ready, %zu released\n"
 		   "%zu allocs, %zu misses\n"
 		   "=======================\n",
 		   HEAP_BINS,
 		   HEAP_PAGESIZE,
 		   total_pages,
 		   (double)(total_pages * HEAP_PAGESIZE) / (1024.0*1024.0),
+		   heap_nready,
+		   heap_nunused,
 		   allocs,
-		   misses);
+		   heap_misses);
     log(bu_vls_addr(&str), NULL);
     bu_vls_free(&str);
 }
 
 
-void *
-bu_heap_get(size_t sz)
+/**
+ * reserve address space for slabs.  nothing is committed until a slab
+ * is carved, but the reservation still counts against an address
+ * space limit (RLIMIT_AS, ulimit -v), so it is held to an eighth of
+ * any such limit.  BU_HEAP_RESERVE sets the size in megabytes instead,
+ * and 0 turns the slab allocator off, leaving BU_GET() to bu_calloc().
+ */
+void
+heap_init(void)
 {
+    size_t len = (sizeof(void *) >= 8) ? ((size_t)1 << 36) : ((size_t)1 << 28);
     char *ret;
-    register size_t smo = sz-1;
-    static int registered = 0;
-    int oncpu;
-    struct heap *heap;
+    char *str;
+
+    if (heap_state != 0)
+	return;
+    heap_state = -1;
+
+    str = getenv("BU_HEAP_RESERVE");
+    if (str) {
+	long mb = atol(str);
+	if (mb <= 0)
+	    return;
+	if ((size_t)mb < len >> 20)
+	    len = (size_t)mb << 20;
+    }
+#if defined(HAVE_SYS_RESOURCE_H) && defined(RLIMIT_AS)
+    {
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_AS, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY
+	    && (rlim_t)len > rl.rlim_cur / 8)
+	    len = (size_t)(rl.rlim_cur / 8);
+    }
+#endif
+
+    while (len >= 64 * HEAP_PAGESIZE) {
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+	ret = (char *)mmap(NULL, len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (ret == (char *)MAP_FAILED)
+	    ret = NULL;
+#elif defined(HAVE_WINDOWS_H)
+	ret = (char *)VirtualAlloc(NULL, len, MEM_RESERVE, PAGE_NOACCESS);
+#else
+	ret = NULL;
+	break;
+#endif
+	if (ret) {
+	    heap_base = ret;
+	    heap_end = ret + len;
+	    heap_state = 1;
+	    break;
+	}
+	len >>= 1;
+    }
+
+    if (heap_state == 1) {
+	str = getenv("BU_HEAP_PRINT");
+	if (str && atoi(str) > 0)
+	    atexit(heap_print);
+    }
+}
+
+
+/* make a slab's memory usable, returns 0 on failure */
+static int
+heap_commit(char *slab)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+    return mprotect(slab, HEAP_PAGESIZE, PROT_READ | PROT_WRITE) == 0;
+#elif defined(HAVE_WINDOWS_H)
+    return VirtualAlloc(slab, HEAP_PAGESIZE, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    (void)slab;
+    return 0;
+#endif
+}
+
+
+/* give a whole slab's memory back to the system.  the range stays
+ * mapped and reads back as zeros, so the caller can still chain the
+ * slab through its header, which just faults that page back in. */
+static void
+heap_decommit(char *slab)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS) && defined(MADV_DONTNEED)
+    (void)madvise(slab, HEAP_PAGESIZE, MADV_DONTNEED);
+#elif defined(HAVE_WINDOWS_H)
+    (void)VirtualFree(slab, HEAP_PAGESIZE, MEM_DECOMMIT);
+    (void)VirtualAlloc(slab, HEAP_PAGESIZE, MEM_COMMIT, PAGE_READWRITE);
+#else
+    (void)slab;
+#endif
+}
+
+
+static inline int
+heap_owns(const void *ptr)
+{
+    return (const char *)ptr >= heap_base && (const char *)ptr < heap_end;
+}
+
+
+static inline struct heap_slab *
+heap_slab_of(const void *ptr)
+{
+    size_t off = (size_t)((const char *)ptr - heap_base);
+    return (struct heap_slab *)(heap_base + (off - off % HEAP_PAGESIZE));
+}
+
+
+/**
+ * new slab for class cls, reusing one given back earlier if possible.
+ * called with BU_SEM_HEAP held, returns NULL when out of room.
+ */
+static struct heap_slab *
+heap_slab_new(size_t cls)
+{
+    struct heap_slab *slab;
+
+    if (heap_ready) {
+	slab = heap_ready;
+	heap_ready = slab->next;
+	heap_nready--;
+    } else if (heap_unused) {
+	slab = heap_unused;
+	heap_unused = slab->next;
+	heap_nunused--;
+    } else {
+	char *mem = heap_base + heap_used * HEAP_PAGESIZE;
+	if (mem + HEAP_PAGESIZE > heap_end || !heap_commit(mem))
+	    return NULL;
+	heap_used++;
+	slab = (struct heap_slab *)mem;
+    }
 
-    /* what thread are we? */
-    oncpu = bu_parallel_id();
+    slab->cls = cls;
+    slab->carved = 0;
+    slab->nfree = 0;
+    slab->next = classes[cls].slabs;
+    classes[cls].slabs = slab;
+    classes[cls].nslabs++;
+    return slab;
+}
+
+
+/**
+ * release every slab of class cls whose objects are all on the shared
+ * free list, keeping at most retain of them ready for reuse.  called
+ * with BU_SEM_HEAP held.
+ */
+static void
+heap_reclaim(size_t cls, size_t retain)
+{
+    struct heap_class *hc = &classes[cls];
+    struct heap_slab *slab;
+    struct heap_slab **sp;
+    struct heap_obj *obj;
+    struct heap_obj **op;
+
+    for (slab = hc->slabs; slab; slab = slab->next)
+	slab->nfree = 0;
+    for (obj = hc->free; obj; obj = obj->next)
+	heap_slab_of(obj)->nfree++;
+
+    /* mark empty slabs by zeroing carved, then drop their objects */
+    for (slab = hc->slabs; slab; slab = slab->next) {
+	if (slab->carved > 0 && slab->nfree == slab->carved)
+	    slab->carved = 0;
+    }
+    for (op = &hc->free; *op; ) {
+	if (heap_slab_of(*op)->carved == 0) {
+	    *op = (*op)->next;
+	    hc->nfree--;
+	} else {
+	    op = &(*op)->next;
+	}
+    }
+
+    for (sp = &hc->slabs; *sp; ) {
+	slab = *sp;
+	if (slab->carved == 0) {
+	    *sp = slab->next;
+	    hc->nslabs--;
+	    if (hc->carving == slab)
+		hc->carving = NULL;
+	    if (heap_nready < retain) {
+		slab->next = heap_ready;
+		heap_ready = slab;
+		heap_nready++;
+		continue;
+	    }
+	    heap_decommit((char *)slab);
+	    slab->next = heap_unused;
+	    heap_unused = slab;
+	    heap_nunused++;
+	} else {
+	    sp = &slab->next;
+	}
+    }
+
+    /* don't rescan until the free list has grown again */
+    hc->reclaim_at = 2 * hc->nfree;
+    if (hc->reclaim_at < HEAP_RECLAIM / ((cls + 1) * HEAP_ALIGN))
+	hc->reclaim_at = HEAP_RECLAIM / ((cls + 1) * HEAP_ALIGN);
+}
+
+
+/**
+ * move up to HEAP_BATCH objects of class cls into the calling
+ * thread's cache, from the shared list or from fresh slab space.
+ */
+static void
+heap_refill(size_t cls, struct heap_cache *hcache)
+{
+    struct heap_class *hc = &classes[cls];
+    size_t objsize = (cls + 1) * HEAP_ALIGN;
+    size_t per_slab = (HEAP_PAGESIZE - HEAP_HEADER) / objsize;
+    size_t n = 0;
+
+    bu_semaphore_acquire(BU_SEM_HEAP);
+
+    while (n < HEAP_BATCH && hc->free) {
+	struct heap_obj *obj = hc->free;
+	hc->free = obj->next;
+	hc->nfree--;
+	obj->next = hcache->head;
+	hcache->head = obj;
+	n++;
+    }
+
+    while (n < HEAP_BATCH && heap_state == 1) {
+	struct heap_slab *slab = hc->carving;
+	struct heap_obj *obj;
+
+	if (!slab || slab->carved >= per_slab) {
+	    slab = hc->carving = heap_slab_new(cls);
+	    if (!slab)
+		break;
+	}
+	obj = (struct heap_obj *)((char *)slab + HEAP_HEADER + slab->carved * objsize);
+	slab->carved++;
+	obj->next = hcache->head;
+	hcache->head = obj;
+	n++;
+    }
+
+    hc->gets += n;
+    hcache->count += n;
+
+    bu_semaphore_release(BU_SEM_HEAP);
+}
+
+
+/**
+ * hand n objects from the head of a thread cache back to the shared
+ * list of class cls.
+ */
+static void
+heap_release(size_t cls, struct heap_cache *hcache, size_t n)
+{
+    struct heap_class *hc = &classes[cls];
+    struct heap_obj *first = hcache->head;
+    struct heap_obj *last = first;
+    size_t i;
 
-#ifdef DEBUG
-    if (sz > HEAP_BINS || sz == 0) {
-	per_cpu[oncpu].misses++;
+    if (!first || !n)
+	return;
+
+    for (i = 1; i < n && last->next; i++)
+	last = last->next;
+    hcache->head = last->next;
+    hcache->count -= i;
+
+    bu_semaphore_acquire(BU_SEM_HEAP);
+    last->next = hc->free;
+    hc->free = first;
+    hc->nfree += i;
+    hc->gets -= i;
+    if (hc->nfree > hc->reclaim_at && hc->nfree * (cls + 1) * HEAP_ALIGN > HEAP_RECLAIM)
+	heap_reclaim(cls, HEAP_RETAIN);
+    bu_semaphore_release(BU_SEM_HEAP);
+}
+
+
+void
+heap_thread_flush(void)
+{
+    size_t i;
+
+    for (i = 0; i < HEAP_CLASSES; i++) {
+	if (heap_cache[i].count)
+	    heap_release(i, &heap_cache[i], heap_cache[i].count);
+    }
+}
+
+
+int
+heap_owns_ptr(const void *ptr)
+{
+    return heap_owns(ptr);
+}
+
+
+size_t
+heap_ptr_size(const void *ptr)
+{
+    return (heap_slab_of(ptr)->cls + 1) * HEAP_ALIGN;
+}
+
+
+void *
+bu_heap_get(size_t sz)
+{
+    struct heap_cache *hcache;
+    struct heap_obj *obj;
+    size_t cls;
+
+    if (UNLIKELY(sz > HEAP_BINS || sz == 0)) {
+	heap_misses++;
 
 	if (bu_debug) {
 	    bu_log("DEBUG: heap size %zd out of range\n", sz);
@@ -206,55 +550,78 @@ bu_heap_get(size_t sz)
 		bu_bomb("Intentionally bombing due to BU_DEBUG_COREDUMP\n");
 	    }
 	}
-	return bu_calloc(1, sz, "heap calloc");
+	return bu_calloc(1, sz ? sz : 1, "heap calloc");
     }
-#endif
 
-    heap = &per_cpu[oncpu].heap[smo];
+    cls = (sz - 1) / HEAP_ALIGN;
+    hcache = &heap_cache[cls];
 
-    /* init */
-    if (heap->count == 0) {
-
-	if (registered++ == 0) {
-	    ret = getenv("BU_HEAP_PRINT");
-	    if ((++registered == 2) && (ret && atoi(ret) > 0)) {
-		atexit(heap_print);
-	    }
+    if (UNLIKELY(!hcache->head)) {
+	heap_refill(cls, hcache);
+	if (!hcache->head) {
+	    /* out of reserved space */
+	    heap_misses++;
+	    return bu_calloc(1, sz, "heap calloc");
 	}
-
-	heap->count++;
-	heap->pages = (char **)bu_malloc(1 * sizeof(char *), "heap malloc pages[]");
-	heap->pages[0] = (char *)bu_calloc(1, HEAP_PAGESIZE, "heap calloc pages[][0]");
-	heap->given = 0;
     }
 
-    /* grow */
-    if (heap->given+sz > HEAP_PAGESIZE) {
-	heap->count++;
-	heap->pages = (char **)bu_realloc(heap->pages, heap->count * sizeof(char *), "heap realloc pages[]");
-	heap->pages[heap->count-1] = (char *)bu_calloc(1, HEAP_PAGESIZE, "heap calloc pages[][]");
-	heap->given = 0;
-    }
+    obj = hcache->head;
+    hcache->head = obj->next;
+    hcache->count--;
 
-    /* give */
-    ret = &(heap->pages[heap->count-1][heap->given]);
-    heap->given += sz;
+    /* callers count on zeroed memory, same as bu_calloc() */
+    memset(obj, 0, (cls + 1) * HEAP_ALIGN);
 
-    return (void *)ret;
+    return (void *)obj;
 }
 
 
 void
-bu_heap_put(void *ptr, size_t sz)
+bu_heap_put(void *ptr, size_t UNUSED(sz))
 {
-    if (sz > HEAP_BINS || sz == 0) {
+    struct heap_cache *hcache;
+    struct heap_obj *obj;
+    size_t cls;
+    size_t i;
+
+    /* NULL means give back everything that can be */
+    if (!ptr) {
+	heap_thread_flush();
+	bu_semaphore_acquire(BU_SEM_HEAP);
+	for (i = 0; i < HEAP_CLASSES; i++) {
+	    if (classes[i].nfree)
+		heap_reclaim(i, 0);
+	}
+	while (heap_ready) {
+	    struct heap_slab *slab = heap_ready;
+	    heap_ready = slab->next;
+	    heap_nready--;
+	    heap_decommit((char *)slab);
+	    slab->next = heap_unused;
+	    heap_unused = slab;
+	    heap_nunused++;
+	}
+	bu_semaphore_release(BU_SEM_HEAP);
+	return;
+    }
+
+    /* anything else came from bu_calloc(), whatever its size */
+    if (!heap_owns(ptr)) {
 	bu_free(ptr, "heap free");
 	return;
     }
 
-    /* TODO: actually do something useful :) */
+    /* the slab knows the real size, so a mismatched size is harmless */
+    cls = heap_slab_of(ptr)->cls;
+    hcache = &heap_cache[cls];
 
-    return;
+    obj = (struct heap_obj *)ptr;
+    obj->next = hcache->head;
+    hcache->head = obj;
+    hcache->count++;
+
+    if (UNLIKELY(hcache->count > 2 * HEAP_BATCH))
+	heap_release(cls, hcache, HEAP_BATCH);
 }
 
 
@@ -262,6 +629,9 @@ bu_heap_put(void *ptr, size_t sz)
 #if HEAP_PAGESIZE < HEAP_BINS
 #  error "ERROR: heap page size cannot be smaller than bin range"
 #endif
+#if HEAP_BINS % HEAP_ALIGN || HEAP_HEADER % HEAP_ALIGN
+#  error "ERROR: heap bin range and slab header must be multiples of the alignment"
+#endif
 
 
 /*
@@ -38,6 +38,8 @@
 #include "bu/exit.h"
 #include "bu/log.h"
 
+#include "./parallel.h"
+
 /* strict c89 doesn't declare posix_memalign */
 #ifndef HAVE_DECL_POSIX_MEMALIGN
 extern int posix_memalign(void **, size_t, size_t);
@@ -193,6 +195,12 @@ bu_free(void *ptr, const char *str)
 	return;
     }
 
+    /* BU_GET() memory released with bu_free() */
+    if (heap_owns_ptr(ptr)) {
+	bu_heap_put(ptr, 0);
+	return;
+    }
+
 #if defined(MALLOC_NOT_MP_SAFE)
     bu_semaphore_acquire(BU_SEM_MALLOC);
 #endif
@@ -253,6 +261,15 @@ bu_realloc(register void *ptr, size_t siz, const char *str)
 	siz = MINSIZE;
     }
 
+    /* heap memory can't be resized in place, so move it out */
+    if (UNLIKELY(heap_owns_ptr(ptr))) {
+	size_t oldsiz = heap_ptr_size(ptr);
+	void *newptr = bu_malloc(siz, str);
+	memcpy(newptr, ptr, oldsiz < siz ? oldsiz : siz);
+	bu_heap_put(ptr, oldsiz);
+	return newptr;
+    }
+
 #if defined(MALLOC_NOT_MP_SAFE)
     bu_semaphore_acquire(BU_SEM_MALLOC);
 #endif
@@ -394,6 +411,161 @@ bu_pool_delete(struct bu_pool *pool)
 }
 
 
+struct bu_arena_chunk {
+    struct bu_arena_chunk *next;
+    size_t size;	/* including this header */
+    size_t seq;		/* creation order, for marks */
+};
+
+#define ARENA_CHUNK_DEFAULT (256 * 1024)
+
+static THREADLOCAL struct bu_arena *arena_thread = NULL;
+
+
+struct bu_arena *
+bu_arena_create(size_t chunk_size, size_t align)
+{
+    struct bu_arena *arena;
+
+    if (!align)
+	align = 16;
+    if (align & (align - 1))
+	bu_bomb("bu_arena_create(): alignment is not a power of two\n");
+    if (!chunk_size)
+	chunk_size = ARENA_CHUNK_DEFAULT;
+    if (chunk_size < sizeof(struct bu_arena_chunk) + 2 * align)
+	chunk_size = sizeof(struct bu_arena_chunk) + 2 * align;
+
+    arena = (struct bu_arena *)bu_malloc(sizeof(struct bu_arena), "bu_arena_create");
+    arena->chunks = NULL;
+    arena->spare = NULL;
+    arena->chunk_size = chunk_size;
+    arena->align = align;
+    arena->pos = 0;
+    arena->seq = 0;
+    return arena;
+}
+
+
+void *
+bu_arena_alloc(struct bu_arena *arena, size_t nelem, size_t elsize)
+{
+    struct bu_arena_chunk *c = arena->chunks;
+    const size_t mask = arena->align - 1;
+    size_t n_bytes;
+    size_t need;
+    uintptr_t addr;
+
+    if (elsize && nelem > SIZE_MAX / elsize)
+	bu_bomb("bu_arena_alloc(): allocation size overflow\n");
+    n_bytes = nelem * elsize;
+    if (!n_bytes)
+	n_bytes = 1;
+
+    if (LIKELY(c != NULL)) {
+	addr = ((uintptr_t)c + arena->pos + mask) & ~(uintptr_t)mask;
+	if (addr + n_bytes <= (uintptr_t)c + c->size) {
+	    arena->pos = addr + n_bytes - (uintptr_t)c;
+	    return (void *)addr;
+	}
+    }
+
+    need = sizeof(struct bu_arena_chunk) + mask + n_bytes;
+    if (need > arena->chunk_size) {
+	/* a chunk of its own, slotted behind the one being filled so
+	 * that chunk's free space isn't abandoned */
+	c = (struct bu_arena_chunk *)bu_malloc(need, "bu_arena chunk");
+	c->size = need;
+	c->seq = ++arena->seq;
+	if (arena->chunks) {
+	    c->next = arena->chunks->next;
+	    arena->chunks->next = c;
+	} else {
+	    c->next = NULL;
+	    arena->chunks = c;
+	}
+    } else {
+	if (arena->spare) {
+	    c = arena->spare;
+	    arena->spare = NULL;
+	} else {
+	    c = (struct bu_arena_chunk *)bu_malloc(arena->chunk_size, "bu_arena chunk");
+	}
+	c->size = arena->chunk_size;
+	c->seq = ++arena->seq;
+	c->next = arena->chunks;
+	arena->chunks = c;
+    }
+
+    addr = ((uintptr_t)c + sizeof(struct bu_arena_chunk) + mask) & ~(uintptr_t)mask;
+    if (c == arena->chunks)
+	arena->pos = addr + n_bytes - (uintptr_t)c;
+    return (void *)addr;
+}
+
+
+void
+bu_arena_mark(struct bu_arena *arena, struct bu_arena_mark *mark)
+{
+    mark->seq = arena->seq;
+    mark->pos = arena->pos;
+}
+
+
+void
+bu_arena_reset(struct bu_arena *arena, const struct bu_arena_mark *mark)
+{
+    struct bu_arena_chunk **cp = &arena->chunks;
+    size_t seq = mark ? mark->seq : 0;
+
+    /* chunks created since the mark can be anywhere near the front */
+    while (*cp) {
+	struct bu_arena_chunk *c = *cp;
+	if (c->seq <= seq) {
+	    cp = &c->next;
+	    continue;
+	}
+	*cp = c->next;
+	if (!arena->spare && c->size == arena->chunk_size)
+	    arena->spare = c;
+	else
+	    bu_free(c, "bu_arena chunk");
+    }
+
+    arena->pos = mark ? mark->pos : 0;
+}
+
+
+void
+bu_arena_delete(struct bu_arena *arena)
+{
+    if (!arena)
+	return;
+
+    bu_arena_reset(arena, NULL);
+    if (arena->spare)
+	bu_free(arena->spare, "bu_arena chunk");
+    bu_free(arena, "bu_arena_delete");
+}
+
+
+struct bu_arena *
+bu_arena_thread(void)
+{
+    if (UNLIKELY(!arena_thread))
+	arena_thread = bu_arena_create(0, 0);
+    return arena_thread;
+}
+
+
+void
+arena_thread_free(void)
+{
+    bu_arena_delete(arena_thread);
+    arena_thread = NULL;
+}
+
+
 /*
  * Local Variables:
  * mode: C
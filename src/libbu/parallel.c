@@ -467,6 +467,10 @@ parallel_interface_arg(void *utd)
 
     (*(user_thread_data->user_func))(user_thread_data->cpu_id, user_thread_data->user_arg);
 
+    /* objects cached by this thread would be lost when it exits */
+    heap_thread_flush();
+    arena_thread_free();
+
     bu_semaphore_acquire(BU_SEM_THREAD);
     user_thread_data->parent->finished++;
     bu_semaphore_release(BU_SEM_THREAD);
@@ -36,6 +36,33 @@ extern int parallel_set_affinity(int cpu);
 extern void thread_set_cpu(int cpu);
 extern int thread_get_cpu(void);
 
+/**
+ * Reserve the address range bu_heap_get() carves its slabs from.
+ * Called once from the libbu initializer, before any other thread can
+ * be using libbu, so that the range can be read without locking.
+ */
+extern void heap_init(void);
+
+/**
+ * Return the calling thread's cached bu_heap_get() objects to the
+ * shared lists.  Called as each bu_parallel() worker thread exits so
+ * its cache isn't stranded.
+ */
+extern void heap_thread_flush(void);
+
+/**
+ * Whether ptr lies in the bu_heap_get() slab range, and if so the size
+ * of its slab's objects.  Lets bu_free() and bu_realloc() accept
+ * memory from BU_GET().
+ */
+extern int heap_owns_ptr(const void *ptr);
+extern size_t heap_ptr_size(const void *ptr);
+
+/**
+ * Delete the calling thread's bu_arena_thread() arena, if it has one.
+ */
+extern void arena_thread_free(void);
+
 #endif /* LIBBU_PARALLEL_H */
 
 /*
@@ -24,6 +24,19 @@
 #include <vector>
 #include <stddef.h>
 
+extern "C" void heap_thread_flush(void);
+extern "C" void arena_thread_free(void);
+
+
+static void
+parallel_cpp11thread_run(void (*func)(int, void *), int cpu, void *arg)
+{
+    func(cpu, arg);
+
+    /* objects cached by this thread would be lost when it exits */
+    heap_thread_flush();
+    arena_thread_free();
+}
 
 extern "C" void
 parallel_cpp11thread(void (*func)(int, void *), size_t ncpu, void *arg)
@@ -43,7 +56,7 @@ parallel_cpp11thread(void (*func)(int, void *), size_t ncpu, void *arg)
 
     /* Create and run threads. */
     for (size_t i = 0; i < ncpu; ++i)
-	threads.emplace_back(func, i, arg);
+	threads.emplace_back(parallel_cpp11thread_run, func, (int)i, arg);
 
     /* Wait for the parallel task to complete. */
     for (size_t i = 0; i < threads.size(); ++i)
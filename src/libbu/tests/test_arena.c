@@ -0,0 +1,215 @@
+/*                    T E S T _ A R E N A . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *
+ * 3. The name of the author may not be used to endorse or promote
+ * products derived from this software without specific prior written
+ * permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bu.h"
+
+
+#define ARENA_COUNT 100000
+
+
+static int
+check_aligned(const void *ptr, size_t align)
+{
+    if ((uintptr_t)ptr % align) {
+	bu_log("ERROR: %p is not %zu byte aligned\n", ptr, align);
+	return 0;
+    }
+    return 1;
+}
+
+
+/* earlier allocations must keep their place and contents as the arena grows */
+static int
+test_arena_stable(size_t align)
+{
+    struct bu_arena *arena = bu_arena_create(4096, align);
+    unsigned char **ptrs = (unsigned char **)bu_calloc(ARENA_COUNT, sizeof(unsigned char *), "ptrs");
+    int ret = BRLCAD_OK;
+    size_t i;
+
+    for (i = 0; i < ARENA_COUNT; i++) {
+	/* mostly small, with the occasional one bigger than a chunk */
+	size_t sz = (i % 1000 == 999) ? 10000 : (i % 61) + 1;
+	ptrs[i] = (unsigned char *)bu_arena_alloc(arena, sz, 1);
+	if (!check_aligned(ptrs[i], align ? align : 16))
+	    ret = BRLCAD_ERROR;
+	memset(ptrs[i], (int)(i & 0xff), sz);
+    }
+    for (i = 0; i < ARENA_COUNT; i++) {
+	size_t sz = (i % 1000 == 999) ? 10000 : (i % 61) + 1;
+	if (ptrs[i][0] != (i & 0xff) || ptrs[i][sz - 1] != (i & 0xff)) {
+	    bu_log("ERROR: allocation %zu was overwritten\n", i);
+	    ret = BRLCAD_ERROR;
+	    break;
+	}
+    }
+
+    bu_free(ptrs, "ptrs");
+    bu_arena_delete(arena);
+    return ret;
+}
+
+
+/* resetting to a mark hands the same memory out again */
+static int
+test_arena_mark(void)
+{
+    struct bu_arena *arena = bu_arena_create(4096, 0);
+    struct bu_arena_mark mark;
+    unsigned char *keep, *first, *again;
+    int ret = BRLCAD_OK;
+    int i;
+
+    keep = (unsigned char *)bu_arena_alloc(arena, 100, 1);
+    memset(keep, 0x5a, 100);
+
+    bu_arena_mark(arena, &mark);
+    for (i = 0; i < 10; i++) {
+	size_t j;
+	first = (unsigned char *)bu_arena_alloc(arena, 16, 1);
+	for (j = 0; j < 1000; j++) {
+	    /* fill several chunks, and some big ones */
+	    (void)bu_arena_alloc(arena, (j % 10 == 0) ? 8192 : 64, 1);
+	}
+	bu_arena_reset(arena, &mark);
+	again = (unsigned char *)bu_arena_alloc(arena, 16, 1);
+	if (again != first) {
+	    bu_log("ERROR: reset did not reuse memory (%p != %p)\n", (void *)again, (void *)first);
+	    ret = BRLCAD_ERROR;
+	}
+	bu_arena_reset(arena, &mark);
+    }
+    for (i = 0; i < 100; i++) {
+	if (keep[i] != 0x5a) {
+	    bu_log("ERROR: memory from before the mark was released\n");
+	    ret = BRLCAD_ERROR;
+	    break;
+	}
+    }
+
+    /* a full reset and starting over */
+    bu_arena_reset(arena, NULL);
+    (void)bu_arena_alloc(arena, 10000, 1);
+    (void)bu_arena_alloc(arena, 10, 1);
+
+    bu_arena_delete(arena);
+    return ret;
+}
+
+
+static void
+arena_thread_worker(int UNUSED(cpu), void *data)
+{
+    int *failed = (int *)data;
+    struct bu_arena *arena = bu_arena_thread();
+    int round;
+
+    for (round = 0; round < 100; round++) {
+	struct bu_arena_mark mark;
+	size_t i;
+	size_t *vals;
+
+	bu_arena_mark(arena, &mark);
+	vals = (size_t *)bu_arena_alloc(arena, 1000, sizeof(size_t));
+	for (i = 0; i < 1000; i++)
+	    vals[i] = i * (size_t)round;
+	for (i = 0; i < 100; i++)
+	    (void)bu_arena_alloc(arena, 1, 1000);
+	for (i = 0; i < 1000; i++) {
+	    if (vals[i] != i * (size_t)round)
+		*failed = 1;
+	}
+	bu_arena_reset(arena, &mark);
+    }
+}
+
+
+/* each thread gets an arena of its own */
+static int
+test_arena_thread(void)
+{
+    int failed = 0;
+
+    bu_parallel(arena_thread_worker, 0, &failed);
+    if (failed)
+	bu_log("ERROR: thread arenas overlapped\n");
+
+    return failed ? BRLCAD_ERROR : BRLCAD_OK;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    int ret = BRLCAD_ERROR;
+
+    // Normally this file is part of bu_test, so only set this if it looks like
+    // the program name is still unset.
+    if (bu_getprogname()[0] == '\0')
+	bu_setprogname(argv[0]);
+
+    if (argc < 2) {
+	bu_exit(1, "Usage: %s (stable|mark|thread) [test_args...]\n", argv[0]);
+    }
+
+    if (BU_STR_EQUAL(argv[1], "stable")) {
+	size_t align = 0;
+	if (argc > 2)
+	    align = (size_t)atoi(argv[2]);
+	ret = test_arena_stable(align);
+    } else if (BU_STR_EQUAL(argv[1], "mark")) {
+	ret = test_arena_mark();
+    } else if (BU_STR_EQUAL(argv[1], "thread")) {
+	ret = test_arena_thread();
+    }
+
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -44,15 +44,149 @@
 
 
 /* this should match what is in heap.c */
-#define HEAP_BINS 512
+#define HEAP_BINS 256
 
 #define CNTCALLS
 
+#define THREAD_OBJS 20000
+#define THREAD_ROUNDS 20
+
+
+struct heap_thread_data {
+    size_t ncpu;
+    int use_malloc;
+    void **objs[MAX_PSW];	/* objects allocated by each thread */
+    size_t next;		/* next unclaimed slot in objs */
+    int failed;
+};
+
+
+/* bu_parallel() cpu ids don't necessarily run 0..ncpu-1, so each
+ * thread claims a slot of its own.
+ */
+static size_t
+thread_slot(struct heap_thread_data *td)
+{
+    size_t slot;
+
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    slot = td->next++;
+    bu_semaphore_release(BU_SEM_GENERAL);
+
+    return slot;
+}
+
+
+static size_t
+thread_obj_size(size_t cpu, size_t i)
+{
+    return ((cpu * 7 + i * 13) % HEAP_BINS) + 1;
+}
+
+
+static void
+thread_alloc(int UNUSED(cpu), void *data)
+{
+    struct heap_thread_data *td = (struct heap_thread_data *)data;
+    size_t slot = thread_slot(td);
+    void **objs = td->objs[slot];
+    size_t i;
+
+    for (i = 0; i < THREAD_OBJS; i++) {
+	size_t sz = thread_obj_size(slot, i);
+	unsigned char *ptr;
+
+	/* both zero the memory */
+	if (td->use_malloc) {
+	    ptr = (unsigned char *)calloc(1, sz);
+	} else {
+	    ptr = (unsigned char *)bu_heap_get(sz);
+	    if ((uintptr_t)ptr % 16) {
+		bu_log("ERROR: thread %zu got misaligned %p\n", slot, (void *)ptr);
+		td->failed = 1;
+	    }
+	}
+	if (ptr[0] || ptr[sz - 1]) {
+	    bu_log("ERROR: thread %zu got unzeroed memory\n", slot);
+	    td->failed = 1;
+	}
+	memset(ptr, (int)(slot + i) & 0xff, sz);
+	objs[i] = ptr;
+    }
+}
+
+
+/* free the objects of the next thread over, checking nothing overlapped */
+static void
+thread_free(int UNUSED(cpu), void *data)
+{
+    struct heap_thread_data *td = (struct heap_thread_data *)data;
+    size_t owner = (thread_slot(td) + 1) % td->ncpu;
+    void **objs = td->objs[owner];
+    size_t i;
+
+    for (i = 0; i < THREAD_OBJS; i++) {
+	size_t sz = thread_obj_size(owner, i);
+	unsigned char *ptr = (unsigned char *)objs[i];
+
+	if (ptr[0] != ((owner + i) & 0xff) || ptr[sz - 1] != ((owner + i) & 0xff)) {
+	    bu_log("ERROR: object %zu of thread %zu was overwritten\n", i, owner);
+	    td->failed = 1;
+	}
+	if (td->use_malloc)
+	    free(ptr);
+	else
+	    bu_heap_put(ptr, sz);
+    }
+}
+
 
 /*
- * FIXME: this routine should compare heap with malloc and make sure
- * it's always faster.
+ * objects allocated by one thread and released by another, compared
+ * against malloc.  returns nonzero on failure.
  */
+static int
+heap_threads(void)
+{
+    struct heap_thread_data td;
+    int64_t start, heap_time = 0, malloc_time = 0;
+    size_t i, round;
+
+    memset(&td, 0, sizeof(td));
+    td.ncpu = bu_avail_cpus();
+    if (td.ncpu < 2)
+	td.ncpu = 2;
+    if (td.ncpu > 16)
+	td.ncpu = 16;
+    for (i = 0; i < td.ncpu; i++)
+	td.objs[i] = (void **)bu_calloc(THREAD_OBJS, sizeof(void *), "objs");
+
+    for (td.use_malloc = 1; td.use_malloc >= 0; td.use_malloc--) {
+	start = bu_gettime();
+	for (round = 0; round < THREAD_ROUNDS; round++) {
+	    td.next = 0;
+	    bu_parallel(thread_alloc, td.ncpu, &td);
+	    td.next = 0;
+	    bu_parallel(thread_free, td.ncpu, &td);
+	}
+	if (td.use_malloc)
+	    malloc_time = bu_gettime() - start;
+	else
+	    heap_time = bu_gettime() - start;
+    }
+
+    /* everything was released, so this should give back all slabs */
+    bu_heap_put(NULL, 0);
+
+    bu_log("%zu threads: heap %.3fs, malloc %.3fs\n", td.ncpu, (double)heap_time / 1.0e6, (double)malloc_time / 1.0e6);
+
+    for (i = 0; i < td.ncpu; i++)
+	bu_free(td.objs[i], "objs");
+
+    return td.failed;
+}
+
+
 int
 main(int ac, char *av[])
 {
@@ -68,11 +202,14 @@ main(int ac, char *av[])
     if (bu_getprogname()[0] == '\0')
 	bu_setprogname(av[0]);
 
-    if (ac > 1) {
-	fprintf(stderr, "Usage: %s\n", av[0]);
+    if (ac > 2 || (ac == 2 && !BU_STR_EQUAL(av[1], "threads"))) {
+	fprintf(stderr, "Usage: %s [threads]\n", av[0]);
 	return 1;
     }
 
+    if (ac == 2)
+	return heap_threads();
+
     srand(time(0));
 
     for (i=0; i<1024*1024*10; i++) {
@@ -67,6 +67,18 @@ _fbs_conn_fb(struct pkg_conn *pcp)
     return fbscp->fbsc_fbsp->fbs_fbp;
 }
 
+static void
+_fbs_client_shm_release(struct fbserv_client *fbscp)
+{
+    struct fbserv_shm *shm = (struct fbserv_shm *)fbscp->fbsc_shm;
+
+    if (!shm)
+	return;
+    fbs_shm_release(shm);
+    BU_PUT(shm, struct fbserv_shm);
+    fbscp->fbsc_shm = NULL;
+}
+
 static void
 drop_client(struct fbserv_obj *fbsp, int sub)
 {
@@ -88,6 +100,7 @@ drop_client(struct fbserv_obj *fbsp, int sub)
     fbsp->fbs_clients[sub].fbsc_auth_ok = 0;
     fbsp->fbs_clients[sub].fbsc_pending_drop = 0;
     fbsp->fbs_clients[sub].fbsc_is_ipc = 0;
+    _fbs_client_shm_release(&fbsp->fbs_clients[sub]);
 }
 
 
@@ -880,6 +893,144 @@ fbs_rfbhelp(struct pkg_conn *pcp, char *buf)
 }
 
 
+/*
+ * Create a shared pixel mirror for this client, sized to the current
+ * framebuffer.  Replies with ret, segment key, cookie, width, height.
+ */
+static void
+fbs_rfbshmopen(struct pkg_conn *pcp, char *buf)
+{
+    struct fbserv_client *fbscp;
+    struct fbserv_shm *shm;
+    char rbuf[5*NET_LONG_LEN+1] = {0};
+    struct fb *curr_fbp;
+
+    if (!buf) {
+	bu_log("fbs_rfbshmopen: null buffer\n");
+	return;
+    }
+    if (fbs_data_guard(pcp, buf) < 0) return;
+    curr_fbp = _fbs_conn_fb(pcp);
+    fbscp = (struct fbserv_client *)pcp->pkc_server_data;
+
+    _fbs_client_shm_release(fbscp);
+
+    BU_GET(shm, struct fbserv_shm);
+    if (fbs_shm_create(shm, fb_getwidth(curr_fbp), fb_getheight(curr_fbp)) < 0) {
+	BU_PUT(shm, struct fbserv_shm);
+	(void)pkg_plong(&rbuf[0*NET_LONG_LEN], -1);
+    } else {
+	fbscp->fbsc_shm = (void *)shm;
+	(void)pkg_plong(&rbuf[0*NET_LONG_LEN], 0);
+	(void)pkg_plong(&rbuf[1*NET_LONG_LEN], shm->fbsh_key);
+	(void)pkg_plong(&rbuf[2*NET_LONG_LEN], shm->fbsh_cookie);
+	(void)pkg_plong(&rbuf[3*NET_LONG_LEN], shm->fbsh_width);
+	(void)pkg_plong(&rbuf[4*NET_LONG_LEN], shm->fbsh_height);
+    }
+    pkg_send(MSG_RETURN, rbuf, 5*NET_LONG_LEN, pcp);
+    (void)free(buf);
+}
+
+
+/*
+ * The client has attached to the mirror (or failed to).  Either way
+ * nobody else needs the segment key any more.
+ */
+static void
+fbs_rfbshmready(struct pkg_conn *pcp, char *buf)
+{
+    struct fbserv_client *fbscp;
+    struct fbserv_shm *shm;
+
+    if (!buf) {
+	bu_log("fbs_rfbshmready: null buffer\n");
+	return;
+    }
+    if (!pcp || !pcp->pkc_server_data) {
+	(void)free(buf);
+	return;
+    }
+    fbscp = (struct fbserv_client *)pcp->pkc_server_data;
+    shm = (struct fbserv_shm *)fbscp->fbsc_shm;
+
+    if (shm) {
+	if (pkg_glong(&buf[0*NET_LONG_LEN]))
+	    fbs_shm_unlink(shm);
+	else
+	    _fbs_client_shm_release(fbscp);
+    }
+    (void)free(buf);
+}
+
+
+/*
+ * Pixels for a span (MSG_FBSHMWRITE) or rectangle (MSG_FBSHMWRITERECT)
+ * are already in the mirror; copy them to the framebuffer.
+ */
+static void
+fbs_rfbshmwrite(struct pkg_conn *pcp, char *buf)
+{
+    int x, y, w, h;
+    char rbuf[NET_LONG_LEN+1] = {0};
+    int ret;
+    int type;
+    struct fbserv_shm *shm;
+
+    if (!buf) {
+	bu_log("fbs_rfbshmwrite: null buffer\n");
+	return;
+    }
+    if (fbs_data_guard(pcp, buf) < 0) return;
+    shm = (struct fbserv_shm *)((struct fbserv_client *)pcp->pkc_server_data)->fbsc_shm;
+
+    type = pcp->pkc_type;
+    x = pkg_glong(&buf[0*NET_LONG_LEN]);
+    y = pkg_glong(&buf[1*NET_LONG_LEN]);
+    w = pkg_glong(&buf[2*NET_LONG_LEN]);
+    h = (type % MSG_NORETURN == MSG_FBSHMWRITERECT) ? (int)pkg_glong(&buf[3*NET_LONG_LEN]) : 0;
+
+    ret = shm ? fbs_shm_push(shm, _fbs_conn_fb(pcp), x, y, w, h) : -1;
+
+    if (type < MSG_NORETURN) {
+	(void)pkg_plong(&rbuf[0*NET_LONG_LEN], ret);
+	pkg_send(MSG_RETURN, rbuf, NET_LONG_LEN, pcp);
+    }
+    (void)free(buf);
+}
+
+
+/*
+ * Refresh a span (MSG_FBSHMREAD) or rectangle (MSG_FBSHMREADRECT) of
+ * the mirror from the framebuffer and return the pixel count.
+ */
+static void
+fbs_rfbshmread(struct pkg_conn *pcp, char *buf)
+{
+    int x, y, w, h;
+    char rbuf[NET_LONG_LEN+1] = {0};
+    int ret;
+    struct fbserv_shm *shm;
+
+    if (!buf) {
+	bu_log("fbs_rfbshmread: null buffer\n");
+	return;
+    }
+    if (fbs_data_guard(pcp, buf) < 0) return;
+    shm = (struct fbserv_shm *)((struct fbserv_client *)pcp->pkc_server_data)->fbsc_shm;
+
+    x = pkg_glong(&buf[0*NET_LONG_LEN]);
+    y = pkg_glong(&buf[1*NET_LONG_LEN]);
+    w = pkg_glong(&buf[2*NET_LONG_LEN]);
+    h = (pcp->pkc_type == MSG_FBSHMREADRECT) ? (int)pkg_glong(&buf[3*NET_LONG_LEN]) : 0;
+
+    ret = shm ? fbs_shm_pull(shm, _fbs_conn_fb(pcp), x, y, w, h) : -1;
+
+    (void)pkg_plong(&rbuf[0*NET_LONG_LEN], ret);
+    pkg_send(MSG_RETURN, rbuf, NET_LONG_LEN, pcp);
+    (void)free(buf);
+}
+
+
 /**
  * Initialise fbsp->fbs_auth_token for session authentication.
  *
@@ -1021,6 +1172,14 @@ fbs_pkg_switch(void)
 	{ MSG_FBPOLL, fbs_rfbpoll, "Handle Events", NULL },
 	{ MSG_FBSETCURSOR, fbs_rfbsetcursor, "Set Cursor Shape", NULL },
 	{ MSG_FBSETCURSOR + MSG_NORETURN, fbs_rfbsetcursor, "Set Cursor Shape", NULL },
+	{ MSG_FBSHMOPEN, fbs_rfbshmopen, "Open Shared Pixels", NULL },
+	{ MSG_FBSHMREADY, fbs_rfbshmready, "Shared Pixels Attached", NULL },
+	{ MSG_FBSHMWRITE, fbs_rfbshmwrite, "Write Shared Pixels", NULL },
+	{ MSG_FBSHMWRITE + MSG_NORETURN, fbs_rfbshmwrite, "Write Shared Pixels", NULL },
+	{ MSG_FBSHMWRITERECT, fbs_rfbshmwrite, "Write Shared Rectangle", NULL },
+	{ MSG_FBSHMWRITERECT + MSG_NORETURN, fbs_rfbshmwrite, "Write Shared Rectangle", NULL },
+	{ MSG_FBSHMREAD, fbs_rfbshmread, "Read Shared Pixels", NULL },
+	{ MSG_FBSHMREADRECT, fbs_rfbshmread, "Read Shared Rectangle", NULL },
 	{ 0, NULL, NULL, NULL }
     };
 
@@ -0,0 +1,323 @@
+/*                    F B S E R V _ S H M . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libdm/fbserv_shm.c
+ *
+ * Shared-memory pixel transport for the remote framebuffer protocol.
+ *
+ * A client that opens "shm:<spec>" (e.g. "shm:0" or "shm:ipc:<addr>")
+ * connects to fbserv over the usual libpkg channel and, after
+ * MSG_FBOPEN, asks for a shared pixel buffer with MSG_FBSHMOPEN.  The
+ * server creates a SysV segment holding a small header and a width x
+ * height RGB mirror of the framebuffer laid out exactly like if_mem
+ * (row 0 at the bottom, scanlines contiguous), and replies with the
+ * segment key, a cookie and the mirror dimensions.  The client
+ * attaches with bu_shmget() on the same key, checks the cookie in the
+ * header, and confirms with MSG_FBSHMREADY, at which point the server
+ * marks the segment for removal so it disappears with the last detach.
+ *
+ * From then on pixel data never crosses the socket.  Writes are copied
+ * into the mirror and announced with a 12 or 16 byte MSG_FBSHMWRITE or
+ * MSG_FBSHMWRITERECT (no return), which the server turns into
+ * fb_write()/fb_writerect() calls straight out of the mirror.  Reads
+ * send MSG_FBSHMREAD or MSG_FBSHMREADRECT; the server refreshes that
+ * region of the mirror from the framebuffer and replies with the pixel
+ * count only.  Because requests on one connection are handled in order,
+ * a read always sees the client's own earlier writes.
+ *
+ * The server creates the segment itself with IPC_CREAT|IPC_EXCL and
+ * mode 0600 rather than through bu_shmget() (which uses 0666), so only
+ * processes of the same user can attach and an existing segment under
+ * a guessed key is never adopted.  When SysV shared memory is
+ * unavailable on either side, or the server is on another host, the
+ * server's error reply or the failed attach makes the client fall back
+ * to the normal pkg transport.  Servers predating these messages ignore MSG_FBSHMOPEN
+ * without a reply, so "shm:" must only be used with a current fbserv.
+ */
+
+#include "common.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#ifdef HAVE_SYS_SHM_H
+#  include <sys/types.h>
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#endif
+
+#include "bu/malloc.h"
+#include "bu/process.h"
+#include "dm.h"
+
+
+#define FBSERV_SHM_MAGIC 0x46425348	/* "FBSH" */
+
+/* Segment keys are tried from a per-process base, skipping keys already
+ * in use by other segments */
+#define FBSERV_SHM_KEY 0x46420000	/* "FB" */
+#define FBSERV_SHM_TRIES 16
+
+struct fbserv_shm_hdr {
+    uint32_t magic;
+    uint32_t cookie;
+    uint32_t width;
+    uint32_t height;
+};
+
+
+void
+fbs_shm_init(struct fbserv_shm *s)
+{
+    memset(s, 0, sizeof(struct fbserv_shm));
+    s->fbsh_id = -1;
+}
+
+
+void
+fbs_shm_unlink(struct fbserv_shm *s)
+{
+#ifdef HAVE_SYS_SHM_H
+    if (s->fbsh_owner && s->fbsh_linked && s->fbsh_id >= 0)
+	(void)shmctl(s->fbsh_id, IPC_RMID, NULL);
+#endif
+    s->fbsh_linked = 0;
+}
+
+
+void
+fbs_shm_release(struct fbserv_shm *s)
+{
+    fbs_shm_unlink(s);
+#ifdef HAVE_SYS_SHM_H
+    if (s->fbsh_base)
+	(void)shmdt((void *)s->fbsh_base);
+#endif
+    fbs_shm_init(s);
+}
+
+
+int
+fbs_shm_span_ok(const struct fbserv_shm *s, int x, int y, size_t num)
+{
+    size_t off;
+
+    if (!s->fbsh_pix || x < 0 || y < 0 || x >= s->fbsh_width || y >= s->fbsh_height)
+	return 0;
+    off = (size_t)y * s->fbsh_width + x;
+    return (num <= (size_t)s->fbsh_width * s->fbsh_height - off);
+}
+
+
+int
+fbs_shm_rect_ok(const struct fbserv_shm *s, int x, int y, int w, int h)
+{
+    if (!s->fbsh_pix || x < 0 || y < 0 || w <= 0 || h <= 0)
+	return 0;
+    return (w <= s->fbsh_width - x && h <= s->fbsh_height - y);
+}
+
+
+unsigned char *
+fbs_shm_pixel(const struct fbserv_shm *s, int x, int y)
+{
+    return s->fbsh_pix + ((size_t)y * s->fbsh_width + x) * sizeof(RGBpixel);
+}
+
+
+int
+fbs_shm_create(struct fbserv_shm *s, int width, int height)
+{
+#ifdef HAVE_SYS_SHM_H
+    struct fbserv_shm_hdr *hdr;
+    size_t size;
+    void *addr;
+    int key = 0;
+    int id = -1;
+    int i;
+
+    fbs_shm_init(s);
+    if (width <= 0 || height <= 0)
+	return -1;
+
+    /* Created exclusive and 0600 up front, so the segment is never
+     * visible to other users and never one somebody else made first
+     * under a key we guessed. */
+    size = FBSERV_SHM_HDRLEN + (size_t)width * height * sizeof(RGBpixel);
+    for (i = 0; i < FBSERV_SHM_TRIES; i++) {
+	key = FBSERV_SHM_KEY + (((int)bu_pid() & 0xfff) << 4) + i;
+	id = shmget((key_t)key, size, IPC_CREAT|IPC_EXCL|0600);
+	if (id >= 0 || errno != EEXIST)
+	    break;		/* ours, or a real failure */
+    }
+    if (id < 0)
+	return -1;
+
+    addr = shmat(id, NULL, 0);
+    if (addr == (void *)-1) {
+	(void)shmctl(id, IPC_RMID, NULL);
+	return -1;
+    }
+    s->fbsh_id = id;
+    s->fbsh_key = key;
+    s->fbsh_base = (unsigned char *)addr;
+    s->fbsh_owner = 1;
+    s->fbsh_linked = 1;
+
+    s->fbsh_pix = s->fbsh_base + FBSERV_SHM_HDRLEN;
+    s->fbsh_width = width;
+    s->fbsh_height = height;
+
+    /* Not a secret (the 0600 mode is the access control), just enough
+     * to keep a client from mistaking an unrelated segment for ours. */
+    s->fbsh_cookie = (uint32_t)bu_pid() ^ (uint32_t)time(NULL)
+	^ ((uint32_t)s->fbsh_id * 2654435761U);
+
+    hdr = (struct fbserv_shm_hdr *)s->fbsh_base;
+    hdr->magic = FBSERV_SHM_MAGIC;
+    hdr->cookie = s->fbsh_cookie;
+    hdr->width = (uint32_t)width;
+    hdr->height = (uint32_t)height;
+
+    return 0;
+#else
+    fbs_shm_init(s);
+    (void)width;
+    (void)height;
+    return -1;
+#endif
+}
+
+
+int
+fbs_shm_push(const struct fbserv_shm *s, struct fb *fbp, int x, int y, int w, int h)
+{
+    int row;
+    int ret = 0;
+
+    if (h == 0) {
+	if (!fbs_shm_span_ok(s, x, y, (size_t)w))
+	    return -1;
+	return (int)fb_write(fbp, x, y, fbs_shm_pixel(s, x, y), (size_t)w);
+    }
+    if (!fbs_shm_rect_ok(s, x, y, w, h))
+	return -1;
+
+    /* Full-width rectangles are contiguous in the mirror. */
+    if (x == 0 && w == s->fbsh_width)
+	return fb_writerect(fbp, 0, y, w, h, fbs_shm_pixel(s, 0, y));
+
+    for (row = 0; row < h; row++) {
+	ssize_t got = fb_write(fbp, x, y + row, fbs_shm_pixel(s, x, y + row), (size_t)w);
+	if (got < 0)
+	    return (int)got;
+	ret += (int)got;
+    }
+    return ret;
+}
+
+
+int
+fbs_shm_pull(const struct fbserv_shm *s, struct fb *fbp, int x, int y, int w, int h)
+{
+    int row;
+    int ret = 0;
+
+    if (h == 0) {
+	if (!fbs_shm_span_ok(s, x, y, (size_t)w))
+	    return -1;
+	return (int)fb_read(fbp, x, y, fbs_shm_pixel(s, x, y), (size_t)w);
+    }
+    if (!fbs_shm_rect_ok(s, x, y, w, h))
+	return -1;
+
+    if (x == 0 && w == s->fbsh_width)
+	return fb_readrect(fbp, 0, y, w, h, fbs_shm_pixel(s, 0, y));
+
+    for (row = 0; row < h; row++) {
+	ssize_t got = fb_read(fbp, x, y + row, fbs_shm_pixel(s, x, y + row), (size_t)w);
+	if (got < 0)
+	    return (int)got;
+	ret += (int)got;
+    }
+    return ret;
+}
+
+
+int
+fbs_shm_attach(struct fbserv_shm *s, int key, uint32_t cookie, int width, int height)
+{
+#ifdef HAVE_SYS_SHM_H
+    struct fbserv_shm_hdr *hdr;
+    size_t size;
+    char *addr = NULL;
+    int id = -1;
+    int ret;
+
+    fbs_shm_init(s);
+    if (key == 0 || width <= 0 || height <= 0)
+	return -1;
+
+    size = FBSERV_SHM_HDRLEN + (size_t)width * height * sizeof(RGBpixel);
+    ret = bu_shmget(&id, &addr, key, size);
+    if (ret == 1)
+	return -1;
+    if (ret == -1) {
+	/* No such segment here (the server is on another host), so
+	 * bu_shmget made one - don't leave it behind */
+	(void)shmdt((void *)addr);
+	(void)shmctl(id, IPC_RMID, NULL);
+	return -1;
+    }
+
+    hdr = (struct fbserv_shm_hdr *)addr;
+    if (hdr->magic != FBSERV_SHM_MAGIC || hdr->cookie != cookie
+	|| hdr->width != (uint32_t)width || hdr->height != (uint32_t)height) {
+	(void)shmdt((void *)addr);
+	return -1;
+    }
+
+    s->fbsh_id = id;
+    s->fbsh_key = key;
+    s->fbsh_base = (unsigned char *)addr;
+    s->fbsh_pix = s->fbsh_base + FBSERV_SHM_HDRLEN;
+    s->fbsh_width = width;
+    s->fbsh_height = height;
+    s->fbsh_cookie = cookie;
+    return 0;
+#else
+    fbs_shm_init(s);
+    (void)key;
+    (void)cookie;
+    (void)width;
+    (void)height;
+    return -1;
+#endif
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -49,6 +49,7 @@
 
 #include "bu/color.h"
 #include "bu/log.h"
+#include "bu/malloc.h"
 #include "bu/str.h"
 #include "bu/log.h"
 #include "pkg.h"
@@ -66,6 +67,7 @@
 #define MAX_HOSTNAME 128
 #define PCP(ptr)	((struct pkg_conn *)((ptr)->i->u1.p))
 #define PCPL(ptr)	((ptr)->i->u1.p)	/* left hand side version */
+#define SHMP(ptr)	((struct fbserv_shm *)((ptr)->i->u2.p))
 
 
 /* Package Handlers. */
@@ -204,6 +206,68 @@ rem_log(const char *msg)
 }
 
 
+/*
+ * Ask the server for a shared pixel mirror and attach to it.  Any
+ * refusal leaves SHMP(ifp) NULL and the connection on the ordinary
+ * pkg transport; only a broken connection is reported as an error.
+ */
+static int
+rem_shm_open(struct fb *ifp)
+{
+    struct fbserv_shm *shm;
+    unsigned char buf[5*NET_LONG_LEN+1];
+    int width, height;
+    int ok;
+
+    *(uint32_t *)&buf[0*NET_LONG_LEN] = htonl(0);	/* flags, reserved */
+    if (pkg_send(MSG_FBSHMOPEN, (const char *)buf, NET_LONG_LEN, PCP(ifp)) < NET_LONG_LEN)
+	return -1;
+
+    /* return code, segment key, cookie, width, height as longs */
+    if (pkg_waitfor(MSG_RETURN, (char *)buf, sizeof(buf), PCP(ifp)) < 5*NET_LONG_LEN)
+	return -1;
+    if (ntohl(*(uint32_t *)&buf[0*NET_LONG_LEN]) != 0) {
+	fb_log("rem_open: server has no shared pixel buffer, using the socket\n");
+	return 0;
+    }
+    width = ntohl(*(uint32_t *)&buf[3*NET_LONG_LEN]);
+    height = ntohl(*(uint32_t *)&buf[4*NET_LONG_LEN]);
+
+    BU_GET(shm, struct fbserv_shm);
+    ok = (fbs_shm_attach(shm,
+			    (int)ntohl(*(uint32_t *)&buf[1*NET_LONG_LEN]),
+			    ntohl(*(uint32_t *)&buf[2*NET_LONG_LEN]),
+			    width, height) == 0);
+
+    /* Either way the server may now retire the segment key. */
+    *(uint32_t *)&buf[0*NET_LONG_LEN] = htonl(ok);
+    if (pkg_send(MSG_FBSHMREADY, (const char *)buf, NET_LONG_LEN, PCP(ifp)) < NET_LONG_LEN)
+	ok = 0;
+
+    if (!ok) {
+	fb_log("rem_open: can't attach the server's shared pixel buffer, using the socket\n");
+	fbs_shm_release(shm);
+	BU_PUT(shm, struct fbserv_shm);
+	return 0;
+    }
+    ifp->i->u2.p = (char *)shm;
+    return 0;
+}
+
+
+static void
+rem_shm_close(struct fb *ifp)
+{
+    struct fbserv_shm *shm = SHMP(ifp);
+
+    if (!shm)
+	return;
+    fbs_shm_release(shm);
+    BU_PUT(shm, struct fbserv_shm);
+    ifp->i->u2.p = NULL;
+}
+
+
 /*
  * Open a connection to the remotefb.
  *
@@ -216,6 +280,10 @@ rem_log(const char *msg)
  *
  * If FBSERV_TLS=1 is set (and OpenSSL is available), we attempt a
  * TLS handshake immediately after the TCP connection is established.
+ *
+ * A "shm:" prefix on the name (e.g. "shm:0") additionally requests a
+ * shared-memory pixel buffer once the framebuffer is open, see
+ * libdm/fbserv_shm.c.
  */
 static int
 rem_open(register struct fb *ifp, const char *file, int width, int height)
@@ -227,10 +295,16 @@ rem_open(register struct fb *ifp, const char *file, int width, int height)
     char portname[MAX_HOSTNAME] = {0};
     char device[MAX_HOSTNAME] = {0};
     int port = 0;
+    int want_shm = 0;
     const char *auth_token;
 
     FB_CK_FB(ifp->i);
 
+    if (file && bu_strncmp(file, FBSERV_SHM_PREFIX, strlen(FBSERV_SHM_PREFIX)) == 0) {
+	want_shm = 1;
+	file += strlen(FBSERV_SHM_PREFIX);
+    }
+
     /* Explicit IPC path: if framebuffer spec is "ipc:<addr>", connect
      * directly to that libpkg address and skip TCP parsing. */
     if (file && bu_strncmp(file, "ipc:", 4) == 0 && file[4] != '\0') {
@@ -347,6 +421,9 @@ ipc_connected:
     if (ntohl(*(uint32_t *)&buf[0*NET_LONG_LEN]) != 0)
 	return -7;		/* fail */
 
+    if (want_shm && rem_shm_open(ifp) < 0)
+	return -9;
+
     return 0;		/* OK */
 }
 
@@ -393,6 +470,8 @@ rem_close(struct fb *ifp)
 {
     unsigned char buf[NET_LONG_LEN+1];
 
+    rem_shm_close(ifp);
+
     /* send a close package to remote */
     if (pkg_send(MSG_FBCLOSE, (const char *)0, 0, PCP(ifp)) < 0)
 	return -2;
@@ -418,6 +497,8 @@ rem_free(struct fb *ifp)
 {
     unsigned char buf[NET_LONG_LEN+1];
 
+    rem_shm_close(ifp);
+
     /* send a free package to remote */
     if (pkg_send(MSG_FBFREE, (const char *)0, 0, PCP(ifp)) < 0)
 	return -2;
@@ -464,6 +545,25 @@ rem_read(register struct fb *ifp, int x, int y, unsigned char *pixelp, size_t nu
     *(uint32_t *)&buf[0*NET_LONG_LEN] = htonl(x);
     *(uint32_t *)&buf[1*NET_LONG_LEN] = htonl(y);
     *(uint32_t *)&buf[2*NET_LONG_LEN] = htonl((long)num);
+
+    if (SHMP(ifp) && fbs_shm_span_ok(SHMP(ifp), x, y, num)) {
+	/* Server refreshes the mirror, we only get the count back */
+	if (pkg_send(MSG_FBSHMREAD, (const char *)buf, 3*NET_LONG_LEN, PCP(ifp)) < 3*NET_LONG_LEN)
+	    return -2;
+	if (pkg_waitfor(MSG_RETURN, (char *)buf, NET_LONG_LEN, PCP(ifp)) < 1*NET_LONG_LEN)
+	    return -3;
+	ret = (int32_t)ntohl(*(uint32_t *)&buf[0*NET_LONG_LEN]);
+	if (ret <= 0) {
+	    fb_log("rem_read: read %zu at <%d, %d> failed, ret=%zd.\n",
+		   num, x, y, ret);
+	    return -3;
+	}
+	if ((size_t)ret > num)
+	    ret = num;
+	memcpy(pixelp, fbs_shm_pixel(SHMP(ifp), x, y), ret*sizeof(RGBpixel));
+	return ret;
+    }
+
     if (pkg_send(MSG_FBREAD, (const char *)buf, 3*NET_LONG_LEN, PCP(ifp)) < 3*NET_LONG_LEN)
 	return -2;
 
@@ -493,6 +593,16 @@ rem_write(register struct fb *ifp, int x, int y, const unsigned char *pixelp, si
     *(uint32_t *)&buf[0*NET_LONG_LEN] = htonl(x);
     *(uint32_t *)&buf[1*NET_LONG_LEN] = htonl(y);
     *(uint32_t *)&buf[2*NET_LONG_LEN] = htonl((long)num);
+
+    if (SHMP(ifp) && fbs_shm_span_ok(SHMP(ifp), x, y, num)) {
+	/* Pixels go through the mirror, only the span crosses the wire */
+	memcpy(fbs_shm_pixel(SHMP(ifp), x, y), pixelp, num*sizeof(RGBpixel));
+	if (pkg_send(MSG_FBSHMWRITE+MSG_NORETURN,
+		     (const char *)buf, 3*NET_LONG_LEN, PCP(ifp)) < 3*NET_LONG_LEN)
+	    return -1;
+	return num;
+    }
+
     ret = pkg_2send(MSG_FBWRITE+MSG_NORETURN,
 		    (const char *)buf, 3*NET_LONG_LEN,
 		    (const char *)pixelp, num*sizeof(RGBpixel),
@@ -520,6 +630,30 @@ rem_readrect(struct fb *ifp, int xmin, int ymin, int width, int height, unsigned
     *(uint32_t *)&buf[1*NET_LONG_LEN] = htonl(ymin);
     *(uint32_t *)&buf[2*NET_LONG_LEN] = htonl(width);
     *(uint32_t *)&buf[3*NET_LONG_LEN] = htonl(height);
+
+    if (SHMP(ifp) && fbs_shm_rect_ok(SHMP(ifp), xmin, ymin, width, height)) {
+	int y;
+	int left;
+	if (pkg_send(MSG_FBSHMREADRECT, (const char *)buf, 4*NET_LONG_LEN, PCP(ifp)) < 4*NET_LONG_LEN)
+	    return -2;
+	if (pkg_waitfor(MSG_RETURN, (char *)buf, NET_LONG_LEN, PCP(ifp)) < 1*NET_LONG_LEN)
+	    return -3;
+	ret = (int32_t)ntohl(*(uint32_t *)&buf[0*NET_LONG_LEN]);
+	if (ret <= 0) {
+	    fb_log("rem_rectread: read %d at <%d, %d> failed, ret=%d.\n",
+		   num, xmin, ymin, ret);
+	    return -3;
+	}
+	if (ret > num)
+	    ret = num;
+	for (y = 0, left = ret; left > 0; y++, left -= width) {
+	    size_t n = (left < width) ? left : width;
+	    memcpy(pp + (size_t)y*width*sizeof(RGBpixel),
+		   fbs_shm_pixel(SHMP(ifp), xmin, ymin + y), n*sizeof(RGBpixel));
+	}
+	return ret;
+    }
+
     if (pkg_send(MSG_FBREADRECT, (const char *)buf, 4*NET_LONG_LEN, PCP(ifp)) < 4*NET_LONG_LEN)
 	return -2;
 
@@ -551,6 +685,18 @@ rem_writerect(struct fb *ifp, int xmin, int ymin, int width, int height, const u
     *(uint32_t *)&buf[1*NET_LONG_LEN] = htonl(ymin);
     *(uint32_t *)&buf[2*NET_LONG_LEN] = htonl(width);
     *(uint32_t *)&buf[3*NET_LONG_LEN] = htonl(height);
+
+    if (SHMP(ifp) && fbs_shm_rect_ok(SHMP(ifp), xmin, ymin, width, height)) {
+	int y;
+	for (y = 0; y < height; y++)
+	    memcpy(fbs_shm_pixel(SHMP(ifp), xmin, ymin + y),
+		   pp + (size_t)y*width*sizeof(RGBpixel), width*sizeof(RGBpixel));
+	if (pkg_send(MSG_FBSHMWRITERECT+MSG_NORETURN,
+		     (const char *)buf, 4*NET_LONG_LEN, PCP(ifp)) < 4*NET_LONG_LEN)
+	    return -4;
+	return num;
+    }
+
     ret = pkg_2send(MSG_FBWRITERECT+MSG_NORETURN,
 		    (const char *)buf, 4*NET_LONG_LEN,
 		    (const char *)pp, num*sizeof(RGBpixel),
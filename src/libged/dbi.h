@@ -297,6 +297,11 @@ class GED_EXPORT DbiState {
 	bool get_bbox(point_t *bbmin, point_t *bbmax, matp_t curr_mat, unsigned long long hash);
 	bool get_path_bbox(point_t *bbmin, point_t *bbmax, std::vector<unsigned long long> &elements);
 
+	// Generate the view independent wireframes of objs (or their children)
+	// as a parallel batch, reusing cached vlists where available.
+	// Anything not handled here is left for draw_scene.
+	void draw_wireframes(std::unordered_set<struct bv_scene_obj *> &objs);
+
 	bool valid_hash(unsigned long long phash);
 	bool valid_hash_path(std::vector<unsigned long long> &phashes);
 	bool print_hash(struct bu_vls *opath, unsigned long long phash);
@@ -64,7 +64,7 @@ extern "C" {
 
 // Define what format of the cache is current - if it doesn't match, we need
 // to wipe and redo.
-#define CACHE_CURRENT_FORMAT 1
+#define CACHE_CURRENT_FORMAT 2
 
 /* There are various individual pieces of data in the cache associated with
  * each object key.  For lookup they use short suffix strings to distinguish
@@ -77,6 +77,14 @@ extern "C" {
 #define CACHE_REGION_FLAG "rf"
 #define CACHE_INHERIT_FLAG "if"
 #define CACHE_COLOR "c"
+#define CACHE_VLIST "vl"
+
+// Wireframes larger than this aren't worth the cache space
+#define CACHE_VLIST_MAX_BYTES 16777216
+
+// Bounds on the number of wireframes generated between display refreshes
+#define DRAW_CHUNK_MIN 512
+#define DRAW_CHUNK_MAX 16384
 
 struct ged_draw_cache {
     MDB_env *env;
@@ -1358,6 +1366,75 @@ DbiState::get_path_bbox(point_t *bbmin, point_t *bbmax, std::vector<unsigned lon
     return get_bbox(bbmin, bbmax, NULL, elements[elements.size() - 1]);
 }
 
+void
+DbiState::draw_wireframes(std::unordered_set<struct bv_scene_obj *> &objs)
+{
+    struct bu_ptbl jobs = BU_PTBL_INIT_ZERO;
+    bu_ptbl_init(&jobs, 64, "draw jobs");
+    std::unordered_set<struct bv_scene_obj *>::iterator o_it;
+    for (o_it = objs.begin(); o_it != objs.end(); o_it++)
+	draw_jobs_gather(&jobs, *o_it);
+    if (!BU_PTBL_LEN(&jobs)) {
+	bu_ptbl_free(&jobs);
+	return;
+    }
+
+    // Work through the jobs in chunks, publishing each chunk's wireframes
+    // and refreshing the display before starting the next, so a large
+    // assembly shows up progressively rather than all at once at the end.
+    // Chunks start small so the first results appear quickly and grow so
+    // the per chunk overhead stays negligible.
+    struct bu_vls vname = BU_VLS_INIT_ZERO;
+    struct bu_ptbl chunk = BU_PTBL_INIT_ZERO;
+    bu_ptbl_init(&chunk, DRAW_CHUNK_MIN, "draw job chunk");
+    size_t csize = DRAW_CHUNK_MIN;
+    size_t i = 0;
+    while (i < BU_PTBL_LEN(&jobs)) {
+	bu_ptbl_reset(&chunk);
+	for (; i < BU_PTBL_LEN(&jobs) && BU_PTBL_LEN(&chunk) < csize; i++)
+	    bu_ptbl_ins(&chunk, BU_PTBL_GET(&jobs, i));
+
+	// Vlists are keyed on object content rather than name, so anything
+	// we find is current - no invalidation is needed when objects change.
+	for (size_t k = 0; k < BU_PTBL_LEN(&chunk); k++) {
+	    struct draw_job_t *j = (struct draw_job_t *)BU_PTBL_GET(&chunk, k);
+	    if (!j->cacheable)
+		continue;
+	    const unsigned char *b = NULL;
+	    size_t bsize = cache_get(dcache, (void **)&b, j->key, CACHE_VLIST);
+	    if (bsize) {
+		bv_vlist_import(&rt_vlfree, &j->vhead, &vname, b);
+		j->ret = 2;
+	    }
+	    cache_done(dcache);
+	}
+
+	draw_jobs_run(&chunk);
+
+	for (size_t k = 0; k < BU_PTBL_LEN(&chunk); k++) {
+	    struct draw_job_t *j = (struct draw_job_t *)BU_PTBL_GET(&chunk, k);
+	    if (j->ret == 1 && j->cacheable) {
+		bv_vlist_export(&vname, &j->vhead, "");
+		if (bu_vls_strlen(&vname) <= CACHE_VLIST_MAX_BYTES) {
+		    std::stringstream s;
+		    s.write(bu_vls_cstr(&vname), bu_vls_strlen(&vname));
+		    cache_write(dcache, j->key, CACHE_VLIST, s);
+		}
+	    }
+	    draw_job_publish(j);
+	    draw_job_free(j);
+	}
+
+	if (i < BU_PTBL_LEN(&jobs) && gedp)
+	    ged_refresh_cb(gedp);
+	if (csize < DRAW_CHUNK_MAX)
+	    csize *= 2;
+    }
+    bu_ptbl_free(&chunk);
+    bu_vls_free(&vname);
+    bu_ptbl_free(&jobs);
+}
+
 BViewState *
 DbiState::get_view_state(struct bview *v)
 {
@@ -2927,6 +3004,16 @@ BViewState::redraw(struct bv_obj_settings *vs, std::unordered_set<struct bview *
     // work for the "top level" object used for adaptive cases, since shared
     // views will be using a shared object pool for anything other than their
     // view specific geometry sub-objects.
+    //
+    // When none of the views are adaptive, the wireframes don't depend on
+    // the views at all and can be generated up front as a parallel batch.
+    bool adaptive = false;
+    for (v_it = views.begin(); v_it != views.end(); v_it++) {
+	if ((*v_it)->gv_s->adaptive_plot_csg || (*v_it)->gv_s->adaptive_plot_mesh)
+	    adaptive = true;
+    }
+    if (!adaptive)
+	dbis->draw_wireframes(objs);
     for (v_it = views.begin(); v_it != views.end(); v_it++) {
 	std::unordered_set<struct bv_scene_obj *>::iterator o_it;
 	for (o_it = objs.begin(); o_it != objs.end(); o_it++) {
@@ -37,6 +37,7 @@
 #include "bu/cmd.h"
 #include "bu/hash.h"
 #include "bu/opt.h"
+#include "bu/parallel.h"
 #include "bu/sort.h"
 #include "bu/str.h"
 #include "bv/defines.h"
@@ -594,6 +595,18 @@ wireframe_plot(struct bv_scene_obj *s, struct bview *v, struct rt_db_internal *i
 }
 
 
+/* Record the view settings the geometry of s was generated against, in case
+ * of adaptive plotting */
+static void
+draw_stash_view_info(struct bv_scene_obj *s)
+{
+    s->adaptive_wireframe = s->s_v->gv_s->adaptive_plot_csg;
+    s->view_scale = s->s_v->gv_scale;
+    s->bot_threshold= s->s_v->gv_s->bot_threshold;
+    s->curve_scale = s->s_v->gv_s->curve_scale;
+    s->point_scale = s->s_v->gv_s->point_scale;
+}
+
 extern "C" int draw_m3(struct bv_scene_obj *s);
 extern "C" int draw_points(struct bv_scene_obj *s);
 
@@ -775,13 +788,217 @@ geom_done:
     bv_scene_obj_bound(s, v);
 
     // Store current view info, in case of adaptive plotting
-    s->adaptive_wireframe = s->s_v->gv_s->adaptive_plot_csg;
-    s->view_scale = s->s_v->gv_scale;
-    s->bot_threshold= s->s_v->gv_s->bot_threshold;
-    s->curve_scale = s->s_v->gv_s->curve_scale;
-    s->point_scale = s->s_v->gv_s->point_scale;
+    draw_stash_view_info(s);
+
+    rt_db_free_internal(&dbintern);
+}
+
+/* Batched generation of view independent wireframes.
+ *
+ * For a non-adaptive wireframe, the expensive part of drawing - cracking the
+ * internal and running the primitive's ft_plot - touches no scene state, so
+ * a batch of them can be generated on worker threads and handed to their
+ * scene objects afterwards.  The one shared resource is rt_vlfree, which the
+ * plot routines pull vlist chunks from without locking.  Plot routines only
+ * ever take from that list, never return to it, so for the duration of the
+ * parallel pass we park its contents - with the list empty every
+ * BV_GET_VLIST falls through to BU_ALLOC - and restore it afterwards. */
+
+// Below this many jobs the thread startup isn't worth it
+#define DRAW_PARALLEL_MIN_JOBS 8
+
+static int draw_jobs_sem = 0;
+
+struct draw_jobs_ctx {
+    struct bu_ptbl *jobs;
+    size_t next;
+};
+
+/* The vlists of these types depend on data outside the object itself - a
+ * sketch, a binunif or data file, or another database - so its content hash
+ * doesn't identify their wireframe and they must not be cached. */
+static int
+draw_job_cacheable(struct directory *dp)
+{
+    switch (dp->d_minor_type) {
+	case DB5_MINORTYPE_BRLCAD_EXTRUDE:
+	case DB5_MINORTYPE_BRLCAD_REVOLVE:
+	case DB5_MINORTYPE_BRLCAD_DSP:
+	case DB5_MINORTYPE_BRLCAD_EBM:
+	case DB5_MINORTYPE_BRLCAD_VOL:
+	case DB5_MINORTYPE_BRLCAD_SUBMODEL:
+	    return 0;
+	default:
+	    return 1;
+    }
+}
+
+extern "C" void
+draw_jobs_gather(struct bu_ptbl *jobs, struct bv_scene_obj *s)
+{
+    if (!jobs || !s || s->current)
+	return;
+
+    // Containers - gather their children
+    struct draw_update_data_t *d = (struct draw_update_data_t *)s->s_i_data;
+    if (!d) {
+	for (size_t i = 0; i < BU_PTBL_LEN(&s->children); i++) {
+	    struct bv_scene_obj *c = (struct bv_scene_obj *)BU_PTBL_GET(&s->children, i);
+	    draw_jobs_gather(jobs, c);
+	}
+	return;
+    }
+
+    // Only the modes that end up in a plain ft_plot wireframe are batched -
+    // everything else is left to draw_scene.
+    if (!s->s_os || !s->s_v || (s->s_os->s_dmode != 0 && s->s_os->s_dmode != 1))
+	return;
+    struct db_full_path *fp = (struct db_full_path *)s->s_path;
+    if (fp && fp->fp_len <= 0)
+	return;
+    struct directory *dp = (fp) ? DB_FULL_PATH_CUR_DIR(fp) : (struct directory *)s->dp;
+    if (!dp || (dp->d_flags & RT_DIR_COMB) || dp->d_major_type != DB5_MAJORTYPE_BRLCAD)
+	return;
+    if (s->s_os->s_dmode == 1 && (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BOT ||
+		dp->d_minor_type == DB5_MINORTYPE_BRLCAD_POLY ||
+		dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BREP))
+	return;
+
+    // The vlist is a function of the object's content, its placement and the
+    // tolerances - hash all of them to key the result.
+    struct bu_external ext = BU_EXTERNAL_INIT_ZERO;
+    if (db_borrow_external(&ext, dp, d->dbip) < 0)
+	return;
+    struct {
+	unsigned long long chash;
+	mat_t mat;
+	double tols[4];
+    } kdata;
+    memset(&kdata, 0, sizeof(kdata));
+    kdata.chash = bu_data_hash(ext.ext_buf, ext.ext_nbytes);
+    db_release_external(&ext, d->dbip);
+    MAT_COPY(kdata.mat, s->s_mat);
+    kdata.tols[0] = d->ttol->abs;
+    kdata.tols[1] = d->ttol->rel;
+    kdata.tols[2] = d->ttol->norm;
+    kdata.tols[3] = d->tol->dist;
+
+    struct draw_job_t *j;
+    BU_GET(j, struct draw_job_t);
+    j->s = s;
+    j->key = bu_data_hash(&kdata, sizeof(kdata));
+    j->cacheable = draw_job_cacheable(dp);
+    BU_LIST_INIT(&j->vhead);
+    j->ret = 0;
+    bu_ptbl_ins(jobs, (long *)j);
+}
+
+static void
+draw_job_plot(struct draw_job_t *j)
+{
+    struct bv_scene_obj *s = j->s;
+    struct draw_update_data_t *d = (struct draw_update_data_t *)s->s_i_data;
+    struct db_full_path *fp = (struct db_full_path *)s->s_path;
+    struct directory *dp = (fp) ? DB_FULL_PATH_CUR_DIR(fp) : (struct directory *)s->dp;
 
+    struct rt_db_internal dbintern;
+    RT_DB_INTERNAL_INIT(&dbintern);
+    if (rt_db_get_internal(&dbintern, dp, d->dbip, s->s_mat) < 0) {
+	j->ret = -1;
+	return;
+    }
+    if (!dbintern.idb_meth || !dbintern.idb_meth->ft_plot) {
+	rt_db_free_internal(&dbintern);
+	j->ret = -1;
+	return;
+    }
+    dbintern.idb_meth->ft_plot(&j->vhead, &dbintern, d->ttol, d->tol, s->s_v);
     rt_db_free_internal(&dbintern);
+    j->ret = 1;
+}
+
+static void
+draw_jobs_worker(int UNUSED(cpu), void *data)
+{
+    struct draw_jobs_ctx *ctx = (struct draw_jobs_ctx *)data;
+    while (1) {
+	bu_semaphore_acquire(draw_jobs_sem);
+	size_t i = ctx->next++;
+	bu_semaphore_release(draw_jobs_sem);
+	if (i >= BU_PTBL_LEN(ctx->jobs))
+	    return;
+	struct draw_job_t *j = (struct draw_job_t *)BU_PTBL_GET(ctx->jobs, i);
+	if (j->ret)
+	    continue;
+	draw_job_plot(j);
+    }
+}
+
+extern "C" void
+draw_jobs_run(struct bu_ptbl *jobs)
+{
+    if (!jobs)
+	return;
+
+    size_t todo = 0;
+    for (size_t i = 0; i < BU_PTBL_LEN(jobs); i++) {
+	struct draw_job_t *j = (struct draw_job_t *)BU_PTBL_GET(jobs, i);
+	if (!j->ret)
+	    todo++;
+    }
+    size_t ncpu = bu_avail_cpus();
+    if (ncpu < 2 || todo < DRAW_PARALLEL_MIN_JOBS) {
+	// Not worth going parallel - leave these to the serial draw_scene
+	return;
+    }
+    if (ncpu > todo)
+	ncpu = todo;
+
+    if (!draw_jobs_sem)
+	draw_jobs_sem = bu_semaphore_register("GED_SEM_DRAW_JOBS");
+
+    struct bu_list parked;
+    BU_LIST_INIT(&parked);
+    if (BU_LIST_IS_INITIALIZED(&rt_vlfree)) {
+	BU_LIST_APPEND_LIST(&parked, &rt_vlfree);
+    } else {
+	BU_LIST_INIT(&rt_vlfree);
+    }
+
+    struct draw_jobs_ctx ctx;
+    ctx.jobs = jobs;
+    ctx.next = 0;
+    bu_parallel(draw_jobs_worker, ncpu, &ctx);
+
+    BU_LIST_APPEND_LIST(&rt_vlfree, &parked);
+}
+
+extern "C" void
+draw_job_publish(struct draw_job_t *j)
+{
+    if (!j || j->ret <= 0)
+	return;
+
+    struct bv_scene_obj *s = j->s;
+    BU_LIST_APPEND_LIST(&s->s_vlist, &j->vhead);
+    s->csg_obj = 1;
+    s->mesh_obj = 0;
+    s->s_os->s_dmode = 0;
+    // Because this data is view independent, it only needs to be
+    // generated once rather than per-view.
+    s->current = 1;
+    bv_scene_obj_bound(s, NULL);
+    draw_stash_view_info(s);
+}
+
+extern "C" void
+draw_job_free(struct draw_job_t *j)
+{
+    if (!j)
+	return;
+    if (BU_LIST_NON_EMPTY(&j->vhead))
+	BV_FREE_VLIST(&rt_vlfree, &j->vhead);
+    BU_PUT(j, struct draw_job_t);
 }
 
 static void
@@ -42,7 +42,7 @@
 
 void print_help_msg(struct bu_vls *str)
 {
-    bu_vls_printf(str, "Usage: garbage_collect [-c|--confirm] [-h|--help]\n");
+    bu_vls_printf(str, "Usage: garbage_collect [-c|--confirm] [-z|--compress] [-h|--help]\n");
     bu_vls_printf(str, "\n");
     bu_vls_printf(str, "garbage_collect reclaims any available free space in the currently\n");
     bu_vls_printf(str, "open geometry database file.  As objects are deleted and created,\n");
@@ -53,6 +53,9 @@ void print_help_msg(struct bu_vls *str)
     bu_vls_printf(str, "verifying that all objects were successfully saved, will replace\n");
     bu_vls_printf(str, "the currently open geometry database with the new file.\n");
     bu_vls_printf(str, "\n");
+    bu_vls_printf(str, "With -z, object bodies and attributes are also LZ4 compressed in\n");
+    bu_vls_printf(str, "the new file.  Without it, any compressed objects are expanded.\n");
+    bu_vls_printf(str, "\n");
     bu_vls_printf(str, "DUE TO THE POTENTIAL FOR DATA CORRUPTION, PLEASE MANUALLY BACK UP\n");
     bu_vls_printf(str, "YOUR GEOMETRY FILE BEFORE RUNNING 'garbage_collect'.\n");
 }
@@ -62,6 +65,7 @@ ged_garbage_collect_core(struct ged *gedp, int argc, const char *argv[])
 {
     const char *av[10] = {NULL};
     fastf_t fs_percent = 0.0;
+    int compress = 0;
     int confirmed = 0;
     int new_file_size = 0;
     int old_file_size = 0;
@@ -90,10 +94,11 @@ ged_garbage_collect_core(struct ged *gedp, int argc, const char *argv[])
     std::ifstream cfile;
     std::ofstream ofile;
 
-    struct bu_opt_desc d[3];
+    struct bu_opt_desc d[4];
     BU_OPT(d[0], "h", "help",      "",             NULL,        &print_help,   "Print help and exit");
     BU_OPT(d[1], "c", "confirm",   "",             NULL,        &confirmed,    "Execute garbage collect operation");
-    BU_OPT_NULL(d[2]);
+    BU_OPT(d[2], "z", "compress",  "",             NULL,        &compress,     "Compress objects in the new file");
+    BU_OPT_NULL(d[3]);
 
     GED_CHECK_DATABASE_OPEN(gedp, BRLCAD_ERROR);
     GED_CHECK_READ_ONLY(gedp, BRLCAD_ERROR);
@@ -122,7 +127,7 @@ ged_garbage_collect_core(struct ged *gedp, int argc, const char *argv[])
     }
 
     if (!confirmed || opt_ret) {
-	bu_vls_printf(gedp->ged_result_str, "Usage: garbage_collect [-c|--confirm] [-h|--help]");
+	bu_vls_printf(gedp->ged_result_str, "Usage: garbage_collect [-c|--confirm] [-z|--compress] [-h|--help]");
 	return BRLCAD_ERROR;
     }
 
@@ -224,6 +229,13 @@ ged_garbage_collect_core(struct ged *gedp, int argc, const char *argv[])
 		}
 	    }
 	    int flags = (dp->d_flags & RT_DIR_COMB) ? ((dp->d_flags & RT_DIR_REGION) ? RT_DIR_COMB | RT_DIR_REGION : RT_DIR_COMB) : RT_DIR_SOLID;
+	    if (compress) {
+		struct bu_external zext;
+		if (db5_compress_external(&zext, &ext, DB5_ZZZ_LZ4) == 0) {
+		    bu_free_external(&ext);
+		    ext = zext;	/* struct copy */
+		}
+	    }
 	    wdb_export_external(gc_wdbp, &ext, dp->d_namep, flags, id);
     FOR_ALL_DIRECTORY_END;
     db_close(gc_wdbp->dbip);
@@ -244,6 +244,31 @@ struct draw_data_t {
 
 GED_EXPORT void draw_gather_paths(struct db_full_path *path, mat_t *curr_mat, void *client_data);
 
+/* A view independent wireframe to be generated off the main thread.  key
+ * hashes the object's content, matrix and tolerances.  When cacheable is set
+ * that fully determines the wireframe and key also serves as a cache key for
+ * the generated vlist; it is clear for objects whose geometry comes from
+ * other objects or files.  ret is 0 while pending, 1 once vhead holds a
+ * freshly plotted wireframe, 2 if vhead was filled from a cache and -1 on
+ * failure. */
+struct draw_job_t {
+    struct bv_scene_obj *s;
+    unsigned long long key;
+    int cacheable;
+    struct bu_list vhead;
+    int ret;
+};
+
+/* Append jobs for any of s (or its children) not yet drawn whose geometry is
+ * a plain wireframe */
+GED_EXPORT void draw_jobs_gather(struct bu_ptbl *jobs, struct bv_scene_obj *s);
+/* Generate the vlists of all pending jobs in parallel.  If the batch is too
+ * small to benefit, the jobs are left pending for draw_scene to handle. */
+GED_EXPORT void draw_jobs_run(struct bu_ptbl *jobs);
+/* Hand a finished job's vlist to its scene object */
+GED_EXPORT void draw_job_publish(struct draw_job_t *j);
+GED_EXPORT void draw_job_free(struct draw_job_t *j);
+
 GED_EXPORT void vls_col_item(struct bu_vls *str, const char *cp);
 GED_EXPORT void vls_col_eol(struct bu_vls *str);
 
@@ -886,7 +886,7 @@ classify_seg(struct seg *segp, struct soltab *shoot, struct xray *rp, struct big
     rd.hitmiss = (struct hitmiss **)NULL;
     rd.stp = shoot;
 
-    if (OBJ[shoot->st_id].ft_shot && OBJ[shoot->st_id].ft_shot(shoot, &new_rp, dgcdp->ap, rd.seghead)) {
+    if (shoot->st_meth->ft_shot && shoot->st_meth->ft_shot(shoot, &new_rp, dgcdp->ap, rd.seghead)) {
 	struct seg *seg;
 
 	while (BU_LIST_WHILE (seg, seg, &rd.seghead->l)) {
@@ -911,7 +911,7 @@ classify_seg(struct seg *segp, struct soltab *shoot, struct xray *rp, struct big
 	/* Compute the inverse of the direction cosines */
 	VINVDIR(rd.rd_invdir, new_rp.r_dir);
 
-	if (OBJ[shoot->st_id].ft_shot && OBJ[shoot->st_id].ft_shot(shoot, &new_rp, dgcdp->ap, rd.seghead)) {
+	if (shoot->st_meth->ft_shot && shoot->st_meth->ft_shot(shoot, &new_rp, dgcdp->ap, rd.seghead)) {
 	    struct seg *seg;
 
 	    while (BU_LIST_WHILE (seg, seg, &rd.seghead->l)) {
@@ -1070,7 +1070,7 @@ shoot_and_plot(point_t start_pt,
 	 * mark them as IN_SOL.
 	 */
 	if (rt_in_rpp(&rp, rd.rd_invdir, shoot->l.stp->st_min, shoot->l.stp->st_max)) {
-	    if (OBJ[shoot->l.stp->st_id].ft_shot && OBJ[shoot->l.stp->st_id].ft_shot(shoot->l.stp, &rp, dgcdp->ap, rd.seghead)) {
+	    if (shoot->l.stp->st_meth->ft_shot && shoot->l.stp->st_meth->ft_shot(shoot->l.stp, &rp, dgcdp->ap, rd.seghead)) {
 		struct seg *seg;
 
 		/* put the segments in the lead solid structure */
@@ -1509,8 +1509,8 @@ free_etree(union E_tree *eptr,
 		bu_ptbl_free(&eptr->l.edge_list);
 	    }
 	    if (eptr->l.stp) {
-		if (eptr->l.stp->st_specific && OBJ[eptr->l.stp->st_id].ft_free)
-		    OBJ[eptr->l.stp->st_id].ft_free(eptr->l.stp);
+		if (eptr->l.stp->st_specific && eptr->l.stp->st_meth->ft_free)
+		    eptr->l.stp->st_meth->ft_free(eptr->l.stp);
 		bu_free((char *)eptr->l.stp, "struct soltab");
 	    }
 
@@ -1777,10 +1777,11 @@ fix_halfs(struct bigE_data *dgcdp)
 	    intern2.idb_type = ID_POLY;
 	    intern2.idb_meth = &OBJ[ID_POLY];
 	    intern2.idb_ptr = (void *)pg;
-	    if (OBJ[tp->l.stp->st_id].ft_free)
-		OBJ[tp->l.stp->st_id].ft_free(tp->l.stp);
+	    if (tp->l.stp->st_meth->ft_free)
+		tp->l.stp->st_meth->ft_free(tp->l.stp);
 	    tp->l.stp->st_specific = NULL;
 	    tp->l.stp->st_id = ID_POLY;
+	    tp->l.stp->st_meth = &OBJ[ID_POLY];
 	    VSETALL(tp->l.stp->st_max, -INFINITY);
 	    VSETALL(tp->l.stp->st_min,  INFINITY);
 	    rt_obj_prep(tp->l.stp, &intern2, dgcdp->rtip);
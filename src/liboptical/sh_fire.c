@@ -71,6 +71,9 @@
 #define fire_MAGIC 0x46697265   /* ``Fire'' */
 #define CK_fire_SP(_p) BU_CKMAG(_p, fire_MAGIC, "fire_specific")
 
+/* Number of samples along the ray handed to the noise routines at once */
+#define FIRE_NOISE_BATCH 32
+
 /*
  * the shader specific structure contains all variables which are unique
  * to any particular use of the shader.
@@ -315,11 +318,13 @@ fire_render(struct application *ap, const struct partition *pp, struct shadework
     point_t m_i_pt, m_o_pt;	/* model space in/out points */
     point_t sh_i_pt, sh_o_pt;	/* shader space in/out points */
     point_t noise_i_pt, noise_o_pt;	/* shader space in/out points */
-    point_t noise_pt;
+    fastf_t noise_x[FIRE_NOISE_BATCH], noise_y[FIRE_NOISE_BATCH], noise_z[FIRE_NOISE_BATCH];
+    double noise_vals[FIRE_NOISE_BATCH];
+    double shader_z[FIRE_NOISE_BATCH];
     double color[3];
     vect_t noise_r_dir;
     double noise_r_thick;
-    int i;
+    int i, j, batch;
     double samples_per_unit_noise;
     double noise_dist_per_sample;
     point_t shader_pt;
@@ -330,7 +335,6 @@ fire_render(struct application *ap, const struct partition *pp, struct shadework
 
     int samples;
     double dist;
-    double noise_val;
     double lumens;
 
     /* check the validity of the arguments we got */
@@ -418,45 +422,65 @@ fire_render(struct application *ap, const struct partition *pp, struct shadework
 
     shader_dist_per_sample = shader_r_thick / samples;
 
+    /* The noise samples don't depend on each other, so they are
+     * generated a batch at a time and then accumulated in order.
+     */
     lumens = 0.0;
-    for (i = 0; i < samples; i++) {
-	dist = (double)i * shader_dist_per_sample;
-	VJOIN1(shader_pt, sh_i_pt, dist, shader_r_dir);
-
-	SHADER_TO_NOISE(noise_pt, shader_pt, fire_sp, noise_zdelta);
-
-	noise_val = bn_noise_turb(noise_pt, fire_sp->noise_h_val,
-				  fire_sp->noise_lacunarity, fire_sp->noise_octaves);
-
-	if (optical_debug&OPTICAL_DEBUG_SHADE || fire_sp->fire_debug)
-	    bu_log("bn_noise_turb(%g %g %g) = %g\n",
-		   V3ARGS(noise_pt),
-		   noise_val);
-
-	/* XXX
-	 * When doing the exponential stretch, we scale the noise
-	 * value by the height in shader space
-	 */
-
-	if (NEAR_ZERO(fire_sp->fire_stretch, SQRT_SMALL_FASTF))
-	    lumens += noise_val * 0.025;
-	else {
-	    register double t;
-	    t = lumens;
-	    lumens += noise_val * 0.025 * (1.0 -shader_pt[Z]);
-	    if (optical_debug&OPTICAL_DEBUG_SHADE || fire_sp->fire_debug)
-		bu_log("lumens:%g = %g + %g * %g\n",
-		       lumens, t, noise_val,
-		       0.025 * (1.0 - shader_pt[Z]));
+    for (i = 0; i < samples && lumens < 1.0; i += batch) {
+	batch = samples - i;
+	if (batch > FIRE_NOISE_BATCH)
+	    batch = FIRE_NOISE_BATCH;
+
+	for (j = 0; j < batch; j++) {
+	    point_t noise_pt;
+
+	    dist = (double)(i + j) * shader_dist_per_sample;
+	    VJOIN1(shader_pt, sh_i_pt, dist, shader_r_dir);
 
+	    SHADER_TO_NOISE(noise_pt, shader_pt, fire_sp, noise_zdelta);
+
+	    noise_x[j] = noise_pt[X];
+	    noise_y[j] = noise_pt[Y];
+	    noise_z[j] = noise_pt[Z];
+	    shader_z[j] = shader_pt[Z];
 	}
-	if (lumens >= 1.0) {
-	    lumens = 1.0;
+
+	bn_noise_turb_n(noise_vals, (size_t)batch, noise_x, noise_y, noise_z,
+			fire_sp->noise_h_val, fire_sp->noise_lacunarity,
+			fire_sp->noise_octaves);
+
+	for (j = 0; j < batch; j++) {
+	    double noise_val = noise_vals[j];
+
 	    if (optical_debug&OPTICAL_DEBUG_SHADE || fire_sp->fire_debug)
-		bu_log("early exit from lumens loop\n");
-	    break;
+		bu_log("bn_noise_turb(%g %g %g) = %g\n",
+		       noise_x[j], noise_y[j], noise_z[j],
+		       noise_val);
+
+	    /* XXX
+	     * When doing the exponential stretch, we scale the noise
+	     * value by the height in shader space
+	     */
+
+	    if (NEAR_ZERO(fire_sp->fire_stretch, SQRT_SMALL_FASTF))
+		lumens += noise_val * 0.025;
+	    else {
+		register double t;
+		t = lumens;
+		lumens += noise_val * 0.025 * (1.0 -shader_z[j]);
+		if (optical_debug&OPTICAL_DEBUG_SHADE || fire_sp->fire_debug)
+		    bu_log("lumens:%g = %g + %g * %g\n",
+			   lumens, t, noise_val,
+			   0.025 * (1.0 - shader_z[j]));
+
+	    }
+	    if (lumens >= 1.0) {
+		lumens = 1.0;
+		if (optical_debug&OPTICAL_DEBUG_SHADE || fire_sp->fire_debug)
+		    bu_log("early exit from lumens loop\n");
+		break;
+	    }
 	}
-
     }
 
     if (optical_debug&OPTICAL_DEBUG_SHADE || fire_sp->fire_debug)
@@ -74,7 +74,7 @@
 #endif
 
 #ifdef HAVE_SYS_UIO_H
-#  include <sys/uio.h>		/* for struct iovec (writev) */
+#  include <sys/uio.h>		/* for struct iovec (writev, readv) */
 #endif
 
 #include <errno.h>
@@ -369,6 +369,90 @@ _pkg_io_write(struct pkg_conn *pc, const void *buf, size_t n)
 }
 
 
+/**
+ * Write all of a gathered list of buffers.  Where the transport can
+ * gather, the pieces go to writev() straight from the caller's
+ * memory.  Otherwise small pieces are coalesced through pkc_stream,
+ * so that a small message still goes out in one write, and large
+ * ones are written directly.  Short writes are resumed where they
+ * stopped.  The caller must have flushed pkc_stream first, and the
+ * contents of iov[] are consumed.
+ *
+ * Returns the number of bytes written, which is less than the total
+ * only if the connection failed, or -1 if nothing was written.
+ *
+ * This is a private implementation function.
+ */
+static ssize_t
+_pkg_io_writev(struct pkg_conn *pc, struct pkg_iovec *iov, int iovcnt)
+{
+    size_t done = 0;
+    ssize_t i;
+    int k = 0;
+
+#ifdef HAVE_WRITEV
+    if (!pc->pkc_tls_write) {
+	struct iovec vec[PKG_MAXIOV+1];
+	int fd = (pc->pkc_tx_kind == 1) ? pc->pkc_out_fd : pc->pkc_fd;
+	int n;
+
+	while (k < iovcnt) {
+	    for (n = 0; k + n < iovcnt; n++) {
+		vec[n].iov_base = (void *)iov[k+n].iov_base;
+		vec[n].iov_len = iov[k+n].iov_len;
+	    }
+	    /* Retry on EINTR: writev() may be interrupted before writing
+	     * any bytes (POSIX.1-2017 2.9.5). */
+	    do { i = writev(fd, vec, n); } while (i < 0 && errno == EINTR);
+	    if (i <= 0)
+		return (done > 0) ? (ssize_t)done : -1;
+	    done += (size_t)i;
+
+	    /* Skip over what went out, resuming within a piece */
+	    while (k < iovcnt && (size_t)i >= iov[k].iov_len) {
+		i -= (ssize_t)iov[k].iov_len;
+		k++;
+	    }
+	    if (k < iovcnt) {
+		iov[k].iov_base = (const char *)iov[k].iov_base + i;
+		iov[k].iov_len -= (size_t)i;
+	    }
+	}
+	return (ssize_t)done;
+    }
+#endif
+
+    while (k < iovcnt) {
+	const char *p;
+	size_t len;
+
+	if (iov[k].iov_len < PKG_STREAMLEN) {
+	    len = 0;
+	    while (k < iovcnt && len + iov[k].iov_len <= PKG_STREAMLEN) {
+		memcpy(pc->pkc_stream + len, iov[k].iov_base, iov[k].iov_len);
+		len += iov[k].iov_len;
+		k++;
+	    }
+	    p = pc->pkc_stream;
+	} else {
+	    p = (const char *)iov[k].iov_base;
+	    len = iov[k].iov_len;
+	    k++;
+	}
+	while (len > 0) {
+	    errno = 0;
+	    i = _pkg_io_write(pc, p, len);
+	    if (i <= 0)
+		return (done > 0) ? (ssize_t)done : -1;
+	    done += (size_t)i;
+	    p += i;
+	    len -= (size_t)i;
+	}
+    }
+    return (ssize_t)done;
+}
+
+
 /**
  * Malloc and initialize a pkg_conn structure.  We have already
  * connected to a client or server on the given file descriptor.
@@ -1126,27 +1210,49 @@ pkg_close(struct pkg_conn *pc)
  * This will block if the required number of bytes are not available.
  * The number of bytes actually transferred is returned.
  *
+ * When the ring is empty and much more is wanted, as for the body
+ * of a large message, the data is read straight into the caller's
+ * buffer instead of passing through the ring.
+ *
  * This is a private implementation function.
  */
 static size_t
 _pkg_inget(struct pkg_conn *pc, char *buf, size_t count)
 {
-    size_t len = 0;
-    int todo = (int)count;
+    size_t todo = count;
+    size_t len;
+    int pos;
+    ssize_t got;
 
     while (todo > 0) {
-
-	while ((len = pc->pkc_inend - pc->pkc_incur) <= 0) {
+	if (pc->pkc_inend - pc->pkc_incur <= 0) {
+	    if (todo >= PKG_RINGLEN / 2) {
+		/* This can block */
+		got = _pkg_io_read(pc, buf, todo);
+		if (got <= 0)
+		    return count - todo;
+		buf += got;
+		todo -= (size_t)got;
+		continue;
+	    }
 	    /* This can block */
 	    if (pkg_suckin(pc) < 1)
 		return count - todo;
+	    continue;
 	}
-	/* Input Buffer has some data in it, move to caller's buffer */
-	if ((int)len > todo)  len = todo;
-	memcpy(buf, &pc->pkc_inbuf[pc->pkc_incur], len);
+
+	/* Input Buffer has some data in it, move to caller's buffer,
+	 * stopping at the end of the ring if the data wraps. */
+	pos = (pc->pkc_incur >= pc->pkc_inlen) ? pc->pkc_incur - pc->pkc_inlen : pc->pkc_incur;
+	len = (size_t)(pc->pkc_inend - pc->pkc_incur);
+	if (len > todo)
+	    len = todo;
+	if (len > (size_t)(pc->pkc_inlen - pos))
+	    len = (size_t)(pc->pkc_inlen - pos);
+	memcpy(buf, &pc->pkc_inbuf[pos], len);
 	pc->pkc_incur += (int)len;
 	buf += len;
-	todo -= (int)len;
+	todo -= len;
     }
     return count;
 }
@@ -1220,21 +1326,31 @@ _pkg_checkin(struct pkg_conn *pc, int nodelay)
 
 
 int
-pkg_send(int type, const char *buf, size_t len, struct pkg_conn *pc)
+pkg_sendv(int type, const struct pkg_iovec *iov, int iovcnt, struct pkg_conn *pc)
 {
-#ifdef HAVE_WRITEV
-    static struct iovec cmdvec[2];
-#endif
-    static struct pkg_header hdr;
+    struct pkg_iovec vec[PKG_MAXIOV+1];
+    struct pkg_header hdr;
+    size_t len = 0;
     ssize_t i;
+    int k;
+    int n;
 
     PKG_CK(pc);
 
+    if (iovcnt < 0 || iovcnt > PKG_MAXIOV) {
+	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_sendv: %d pieces, at most %d\n",
+		 iovcnt, PKG_MAXIOV);
+	(pc->pkc_errlog)(_pkg_errbuf);
+	return -1;
+    }
+    for (k = 0; k < iovcnt; k++)
+	len += iov[k].iov_len;
+
     if (_pkg_debug) {
 	_pkg_timestamp();
 	fprintf(_pkg_debug,
-		"pkg_send(type=%d, buf=%p, len=%llu, pc=%p)\n",
-		type, (void *)buf, (unsigned long long)len, (void *)pc);
+		"pkg_sendv(type=%d, iovcnt=%d, len=%llu, pc=%p)\n",
+		type, iovcnt, (unsigned long long)len, (void *)pc);
 	fflush(_pkg_debug);
     }
 
@@ -1242,6 +1358,10 @@ pkg_send(int type, const char *buf, size_t len, struct pkg_conn *pc)
     /* Input may be read, but not acted upon, to prevent deep recursion */
     _pkg_checkin(pc, 1);
 
+    pkg_pshort((char *)hdr.pkh_magic, (unsigned short)PKG_MAGIC);
+    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
+    pkg_plong((char *)hdr.pkh_len, (unsigned long)len);
+
     /* Flush any queued stream output first. */
     if (pc->pkc_strpos > 0) {
 	/*
@@ -1252,328 +1372,67 @@ pkg_send(int type, const char *buf, size_t len, struct pkg_conn *pc)
 	 */
 	if (len <= MAXQLEN && len <= PKG_STREAMLEN -
 	    sizeof(struct pkg_header) - pc->pkc_strpos) {
-	    (void)pkg_stream(type, buf, len, pc);
+	    memcpy(&(pc->pkc_stream[pc->pkc_strpos]), (char *)&hdr, sizeof(hdr));
+	    pc->pkc_strpos += sizeof(hdr);
+	    for (k = 0; k < iovcnt; k++) {
+		memcpy(&(pc->pkc_stream[pc->pkc_strpos]), iov[k].iov_base, iov[k].iov_len);
+		pc->pkc_strpos += (int)iov[k].iov_len;
+	    }
 	    return (pkg_flush(pc) < 0) ? -1 : (int)len;
 	}
-	if (pkg_flush(pc) < 0)
+	if (pkg_flush(pc) < 0 || pc->pkc_strpos > 0)
 	    return -1;	/* assumes 2nd write would fail too */
     }
 
-    pkg_pshort((char *)hdr.pkh_magic, (unsigned long)PKG_MAGIC);
-    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
-    pkg_plong((char *)hdr.pkh_len, (unsigned long)len);
-
-#ifdef HAVE_WRITEV
-    cmdvec[0].iov_base = (void *)&hdr;
-    cmdvec[0].iov_len = sizeof(hdr);
-    cmdvec[1].iov_base = (void *)buf;
-    cmdvec[1].iov_len = len;
-
     /*
      * TODO: set this FD to NONBIO.  If not all output got sent, loop
      * in select() waiting for capacity to go out, and reading input
      * as well.  Prevents deadlocking.
      */
-    if (pc->pkc_tls_write) {
-	/* TLS does not support scatter-gather I/O.  Build a linear
-	 * buffer containing [header][data] and pass it to the TLS
-	 * write callback in one shot.
-	 * For small payloads reuse pkc_stream to avoid a malloc. */
-	char *tbuf;
-	int need_free = 0;
-	size_t total = sizeof(hdr) + len;
-	if (total <= PKG_STREAMLEN) {
-	    tbuf = pc->pkc_stream;
-	} else {
-	    tbuf = (char *)malloc(total);
-	    if (!tbuf) {
-		_pkg_perror(pc->pkc_errlog, "pkg_send: malloc for TLS buffer");
-		return -1;
-	    }
-	    need_free = 1;
-	}
-	memcpy(tbuf, (char *)&hdr, sizeof(hdr));
-	if (len > 0)
-	    memcpy(tbuf + sizeof(hdr), buf, len);
-	i = (ssize_t)pc->pkc_tls_write(pc->pkc_tls_ctx, tbuf, total);
-	if (need_free) free(tbuf);
-	if (i != (ssize_t)total) {
-	    if (i < 0) {
-		_pkg_perror(pc->pkc_errlog, "pkg_send: TLS write");
-		return -1;
-	    }
-	    return (int)(i > (ssize_t)sizeof(hdr) ? i - sizeof(hdr) : 0);
-	}
-    } else if (pc->pkc_tx_kind == 1) {
-	/* Retry on EINTR: writev() may be interrupted before writing any
-	 * bytes (POSIX.1-2017 §2.9.5).  Per libcurl Curl_send_plain
-	 * (lib/sendf.c), restart the syscall.  A short write (0 < i <
-	 * total) cannot be retried atomically and is handled below. */
-	do { i = writev(pc->pkc_out_fd, cmdvec, (len>0)?2:1); } while (i < 0 && errno == EINTR);
-    } else {
-	do { i = writev(pc->pkc_fd, cmdvec, (len>0)?2:1); } while (i < 0 && errno == EINTR);
-    }
-    if (!pc->pkc_tls_write && i != (ssize_t)(len+sizeof(hdr))) {
-	if (i < 0) {
-	    _pkg_perror(pc->pkc_errlog, "pkg_send: writev");
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send of %llu+%llu, wrote %d\n",
-		 (unsigned long long)sizeof(hdr), (unsigned long long)len, (int)i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return i-sizeof(hdr);	/* amount of user data sent */
-    }
-#else
-    /*
-     * On the assumption that buffer copying is less expensive than
-     * having this transmission broken into two network packets (with
-     * TCP, each with a "push" bit set), merge it all into one buffer
-     * here, unless size is enormous.
-     */
-    if (len + sizeof(hdr) <= 16*1024) {
-	char tbuf[16*1024] = {0};
-
-	memcpy(tbuf, (char *)&hdr, sizeof(hdr));
-	if (len > 0)
-	    memcpy(tbuf+sizeof(hdr), buf, len);
-
-	errno = 0;
-	i = (ssize_t)_pkg_io_write(pc, tbuf, len+sizeof(hdr));
-	if ((size_t)i != len+sizeof(hdr)) {
-	    if (i < 0) {
-		if (errno == EBADF)
-		    return -1;
-		_pkg_perror(pc->pkc_errlog, "pkg_send: tbuf write");
-		return -1;
-	    }
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send of %zu, wrote %zd\n",
-		     len, i-(ssize_t)sizeof(hdr));
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return (int)(i-sizeof(hdr));	/* amount of user data sent */
-	}
-	return (int)len;
-    }
-    /* Send them separately */
-    errno = 0;
-    i = (ssize_t)_pkg_io_write(pc, (char *)&hdr, sizeof(hdr));
-    if (i != sizeof(hdr)) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_send: header write");
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send header of %llu, wrote %zd\n",
-		 (unsigned long long)sizeof(hdr), i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return -1;		/* amount of user data sent */
-    }
-    if (len <= 0)
-	return 0;
-    errno = 0;
-    i = (ssize_t)_pkg_io_write(pc, buf, len);
-    if ((size_t)i != len) {
+    vec[0].iov_base = &hdr;
+    vec[0].iov_len = sizeof(hdr);
+    for (n = 1, k = 0; k < iovcnt; k++) {
+	if (iov[k].iov_len > 0)
+	    vec[n++] = iov[k];
+    }
+    i = _pkg_io_writev(pc, vec, n);
+    if (i != (ssize_t)(len+sizeof(hdr))) {
 	if (i < 0) {
 	    if (errno == EBADF)
 		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_send: write");
+	    _pkg_perror(pc->pkc_errlog, "pkg_sendv: write");
 	    return -1;
 	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send of %zu, wrote %zd\n", len, i);
+	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_sendv of %llu+%llu, wrote %ld\n",
+		 (unsigned long long)sizeof(hdr), (unsigned long long)len, (long int)i);
 	(pc->pkc_errlog)(_pkg_errbuf);
-	return i;		/* amount of user data sent */
+	return (int)(i-(ssize_t)sizeof(hdr));	/* amount of user data sent */
     }
-#endif
     return (int)len;
 }
 
 
 int
-pkg_2send(int type, const char *buf1, size_t len1, const char *buf2, size_t len2, struct pkg_conn *pc)
+pkg_send(int type, const char *buf, size_t len, struct pkg_conn *pc)
 {
-#ifdef HAVE_WRITEV
-    static struct iovec cmdvec[3];
-#endif
-    static struct pkg_header hdr;
-    ssize_t i;
-
-    PKG_CK(pc);
-
-    if (_pkg_debug) {
-	_pkg_timestamp();
-	fprintf(_pkg_debug,
-		"pkg_send2(type=%d, buf1=%p, len1=%llu, buf2=%p, len2=%llu, pc=%p)\n",
-		type, (void *)buf1, (unsigned long long)len1, (void *)buf2, (unsigned long long)len2, (void *)pc);
-	fflush(_pkg_debug);
-    }
-
-    /* Check for any pending input, no delay */
-    /* Input may be read, but not acted upon, to prevent deep recursion */
-    _pkg_checkin(pc, 1);
+    struct pkg_iovec iov;
 
-    /* Flush any queued stream output first. */
-    if (pc->pkc_strpos > 0) {
-	if (pkg_flush(pc) < 0)
-	    return -1;	/* assumes 2nd write would fail too */
-    }
-
-    pkg_pshort((char *)hdr.pkh_magic, (unsigned short)PKG_MAGIC);
-    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
-    pkg_plong((char *)hdr.pkh_len, (unsigned long)(len1+len2));
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    return pkg_sendv(type, &iov, 1, pc);
+}
 
-#ifdef HAVE_WRITEV
-    cmdvec[0].iov_base = (void *)&hdr;
-    cmdvec[0].iov_len = sizeof(hdr);
-    cmdvec[1].iov_base = (void *)buf1;
-    cmdvec[1].iov_len = len1;
-    cmdvec[2].iov_base = (void *)buf2;
-    cmdvec[2].iov_len = len2;
 
-    /*
-     * TODO: set this FD to NONBIO.  If not all output got sent, loop
-     * in select() waiting for capacity to go out, and reading input
-     * as well.  Prevents deadlocking.
-     */
-    if (pc->pkc_tls_write) {
-	/* TLS does not support scatter-gather.  Build a single linear
-	 * buffer [header][buf1][buf2] and send it with one call.
-	 * For small payloads reuse pkc_stream to avoid a malloc. */
-	char *tbuf;
-	int need_free = 0;
-	size_t total = sizeof(hdr) + len1 + len2;
-	if (total <= PKG_STREAMLEN) {
-	    tbuf = pc->pkc_stream;
-	} else {
-	    tbuf = (char *)malloc(total);
-	    if (!tbuf) {
-		_pkg_perror(pc->pkc_errlog, "pkg_2send: malloc for TLS buffer");
-		return -1;
-	    }
-	    need_free = 1;
-	}
-	memcpy(tbuf, (char *)&hdr, sizeof(hdr));
-	if (len1 > 0)
-	    memcpy(tbuf + sizeof(hdr), buf1, len1);
-	if (len2 > 0)
-	    memcpy(tbuf + sizeof(hdr) + len1, buf2, len2);
-	i = (ssize_t)pc->pkc_tls_write(pc->pkc_tls_ctx, tbuf, total);
-	if (need_free) free(tbuf);
-	if (i != (ssize_t)total) {
-	    if (i < 0) {
-		_pkg_perror(pc->pkc_errlog, "pkg_2send: TLS write");
-		return -1;
-	    }
-	    return (int)(i > (ssize_t)sizeof(hdr) ? i - sizeof(hdr) : 0);
-	}
-    } else if (pc->pkc_tx_kind == 1) {
-	do { i = writev(pc->pkc_out_fd, cmdvec, 3); } while (i < 0 && errno == EINTR);
-    } else {
-	do { i = writev(pc->pkc_fd, cmdvec, 3); } while (i < 0 && errno == EINTR);
-    }
-    if (!pc->pkc_tls_write && i != (ssize_t)(len1+len2+sizeof(hdr))) {
-	if (i < 0) {
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: writev");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
-		     "pkg_send2(type=%d, buf1=x%lx, len1=%ld, buf2=x%lx, len2=%ld, pc=x%lx)\n",
-		     type, (unsigned long int)buf1, (long)len1,
-		     (unsigned long int)buf2, (long)len2, (unsigned long int)pc);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %llu+%llu+%llu, wrote %ld\n",
-		 (unsigned long long)sizeof(hdr), (unsigned long long)len1, (unsigned long long)len2, (long int)i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return i-sizeof(hdr);	/* amount of user data sent */
-    }
-#else
-    /*
-     * On the assumption that buffer copying is less expensive than
-     * having this transmission broken into two network packets (with
-     * TCP, each with a "push" bit set), merge it all into one buffer
-     * here, unless size is enormous.
-     */
-    if (len1 + len2 + sizeof(hdr) <= 16*1024) {
-	char tbuf[16*1024] = {0};
-
-	memcpy(tbuf, (char *)&hdr, sizeof(hdr));
-	if (len1 > 0)
-	    memcpy(tbuf+sizeof(hdr), buf1, len1);
-	if (len2 > 0)
-	    memcpy(tbuf+sizeof(hdr)+len1, buf2, len2);
-	errno = 0;
-	i = (ssize_t)_pkg_io_write(pc, tbuf, len1+len2+sizeof(hdr));
-	if ((size_t)i != len1+len2+sizeof(hdr)) {
-	    if (i < 0) {
-		if (errno == EBADF)
-		    return -1;
-		_pkg_perror(pc->pkc_errlog, "pkg_2send: tbuf write");
-		return -1;
-	    }
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %llu+%llu, wrote %zd\n",
-		     (unsigned long long)len1, (unsigned long long)len2, i-(ssize_t)sizeof(hdr));
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return (int)(i-sizeof(hdr));	/* amount of user data sent */
-	}
-	return (int)(len1+len2);
-    }
-    /* Send it in three pieces */
-    errno = 0;
-    i = (ssize_t)_pkg_io_write(pc, (char *)&hdr, sizeof(hdr));
-    if (i != sizeof(hdr)) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: header write");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send write(%d, %p, %zu) ret=%zd\n",
-		     pc->pkc_fd, (void *)&hdr, sizeof(hdr), i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %zu+%zu+%zu, wrote header=%zd\n",
-		 sizeof(hdr), len1, len2, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return -1;		/* amount of user data sent */
-    }
-
-    errno = 0;
-    i = (ssize_t)_pkg_io_write(pc, buf1, len1);
-    if ((size_t)i != len1) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: write buf1");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send write(%d, %p, %zu) ret=%zd\n",
-		     pc->pkc_fd, (void *)buf1, len1, i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %zu+%zu+%zu, wrote len1=%zd\n",
-		 sizeof(hdr), len1, len2, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return i;		/* amount of user data sent */
-    }
-    if (len2 <= (size_t)0)
-	return i;
+int
+pkg_2send(int type, const char *buf1, size_t len1, const char *buf2, size_t len2, struct pkg_conn *pc)
+{
+    struct pkg_iovec iov[2];
 
-    errno = 0;
-    i = (ssize_t)_pkg_io_write(pc, buf2, len2);
-    if (i != (ssize_t)len2) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: write buf2");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send write(%d, %p, %zu) ret=%zd\n",
-		     pc->pkc_fd, (void *)buf2, len2, i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %zu+%zu+%zu, wrote len2=%zd\n",
-		 sizeof(hdr), len1, len2, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return (int)(len1+i);		/* amount of user data sent */
-    }
-#endif
-    return (int)(len1+len2);
+    iov[0].iov_base = buf1;
+    iov[0].iov_len = len1;
+    iov[1].iov_base = buf2;
+    iov[1].iov_len = len2;
+    return pkg_sendv(type, iov, 2, pc);
 }
 
 
@@ -2104,6 +1963,8 @@ int
 pkg_suckin(struct pkg_conn *pc)
 {
     size_t avail;
+    size_t room;
+    int wpos;
     int got;
     int ret;
 
@@ -2118,59 +1979,70 @@ pkg_suckin(struct pkg_conn *pc)
 	fflush(_pkg_debug);
     }
 
-    /* If no buffer allocated yet, get one */
-    if (pc->pkc_inbuf == (char *)0 || pc->pkc_inlen <= 0) {
-	pc->pkc_inlen = PKG_STREAMLEN;
-	if ((pc->pkc_inbuf = (char *)malloc((size_t)pc->pkc_inlen)) == (char *)0) {
+    /* Bring the read position back into the first lap of the ring */
+    if (pc->pkc_incur >= pc->pkc_inlen && pc->pkc_inlen > 0) {
+	pc->pkc_incur -= pc->pkc_inlen;
+	pc->pkc_inend -= pc->pkc_inlen;
+    }
+    if (pc->pkc_incur >= pc->pkc_inend) {
+	/* Empty, reset to beginning of ring for the longest read */
+	pc->pkc_incur = pc->pkc_inend = 0;
+    }
+
+    /* If no ring allocated yet, or it was left smaller by a caller
+     * filling pkc_inbuf by hand, get one */
+    if (pc->pkc_inbuf == (char *)0 || pc->pkc_inlen <= 0 ||
+	(pc->pkc_inlen < PKG_RINGLEN && pc->pkc_inend == 0)) {
+	char *nbuf;
+	if ((nbuf = (char *)realloc(pc->pkc_inbuf, (size_t)PKG_RINGLEN)) == (char *)0) {
 	    if (pc->pkc_errlog)
 		pc->pkc_errlog("pkg_suckin malloc failure\n");
-	    pc->pkc_inlen = 0;
 	    ret = -1;
 	    goto out;
 	}
+	pc->pkc_inbuf = nbuf;
+	pc->pkc_inlen = PKG_RINGLEN;
 	pc->pkc_incur = pc->pkc_inend = 0;
     }
 
-    if (pc->pkc_incur >= pc->pkc_inend) {
-	/* Reset to beginning of buffer */
-	pc->pkc_incur = pc->pkc_inend = 0;
+    /* Free space runs from inend to the end of the ring, then wraps
+     * around to the read position. */
+    avail = (size_t)(pc->pkc_inlen - (pc->pkc_inend - pc->pkc_incur));
+    if (avail == 0) {
+	/* Ring is full, what is there must be processed first */
+	ret = 1;
+	goto out;
     }
-
-    /* If cur point is near end of buffer, recopy data to buffer front */
-    if (pc->pkc_incur >= (pc->pkc_inlen * 7) / 8) {
-	size_t amount;
-
-	amount = pc->pkc_inend - pc->pkc_incur;
-	/* This copy can not overlap itself, because of 7/8 above */
-	memcpy(pc->pkc_inbuf, &pc->pkc_inbuf[pc->pkc_incur], amount);
-	pc->pkc_incur = 0;
-	pc->pkc_inend = (int)amount;
+    if (pc->pkc_inend < pc->pkc_inlen) {
+	wpos = pc->pkc_inend;
+	room = (size_t)(pc->pkc_inlen - pc->pkc_inend);
+    } else {
+	wpos = pc->pkc_inend - pc->pkc_inlen;
+	room = avail;
     }
+    if (room > avail)
+	room = avail;
 
-    /* If remaining buffer space is small, make buffer bigger */
-    avail = pc->pkc_inlen - pc->pkc_inend;
-    if (avail < 10 * sizeof(struct pkg_header)) {
-	pc->pkc_inlen <<= 1;
-	if (_pkg_debug) {
-	    _pkg_timestamp();
-	    fprintf(_pkg_debug,
-		    "pkg_suckin: realloc inbuf to %d\n",
-		    pc->pkc_inlen);
-	    fflush(_pkg_debug);
-	}
-	if ((pc->pkc_inbuf = (char *)realloc(pc->pkc_inbuf, (size_t)pc->pkc_inlen)) == (char *)0) {
-	    if (pc->pkc_errlog)
-		pc->pkc_errlog("pkg_suckin realloc failure\n");
-	    pc->pkc_inlen = 0;
-	    ret = -1;
-	    goto out;
-	}
-	/* since the input buffer has grown, lets update avail */
-	avail = (size_t)pc->pkc_inlen - (size_t)pc->pkc_inend;
+    /* Take as much as the system will give us, up to ring space */
+#ifdef HAVE_WRITEV
+    if (room < avail && !pc->pkc_tls_read) {
+	/* Free space wraps, fill both parts with one readv() */
+	struct iovec vec[2];
+	int fd = (pc->pkc_tx_kind == 1) ? pc->pkc_in_fd : pc->pkc_fd;
+	ssize_t r;
+
+	vec[0].iov_base = &pc->pkc_inbuf[wpos];
+	vec[0].iov_len = room;
+	vec[1].iov_base = pc->pkc_inbuf;
+	vec[1].iov_len = avail - room;
+	do { r = readv(fd, vec, 2); } while (r < 0 && errno == EINTR);
+	got = (int)r;
+    } else
+#endif
+    {
+	avail = room;
+	got = (int)_pkg_io_read(pc, &pc->pkc_inbuf[wpos], avail);
     }
-
-    /* Take as much as the system will give us, up to buffer size */
-    got = (int)_pkg_io_read(pc, &pc->pkc_inbuf[pc->pkc_inend], avail);
     if (got <= 0) {
 	if (got == 0) {
 	    if (_pkg_debug) {
@@ -2186,7 +2058,7 @@ pkg_suckin(struct pkg_conn *pc)
 #ifndef HAVE_WINSOCK_H
 	_pkg_perror(pc->pkc_errlog, "pkg_suckin: read");
 	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_suckin: read(%d, %p, %ld) ret=%d inbuf=%p, inend=%d\n",
-		 pc->pkc_fd, (void *)(&pc->pkc_inbuf[pc->pkc_inend]), (long)avail,
+		 pc->pkc_fd, (void *)(&pc->pkc_inbuf[wpos]), (long)avail,
 		 got, (void *)pc->pkc_inbuf, pc->pkc_inend);
 	if (pc->pkc_errlog) {
 	    (pc->pkc_errlog)(_pkg_errbuf);
@@ -22,6 +22,10 @@
  * Relatively simple example file transfer program using libpkg,
  * written in a ttcp style.
  *
+ * With -s, measures libpkg throughput instead, sending messages
+ * between two threads over a local socket pair and checking that
+ * they arrive intact.
+ *
  * To compile from an install:
  * gcc -I/usr/brlcad/include -L/usr/brlcad/lib -o tpkg tpkg.c -lpkg -lbu
  *
@@ -39,7 +43,9 @@
 #include "bu/interrupt.h"
 #include "bu/log.h"
 #include "bu/malloc.h"
+#include "bu/parallel.h"
 #include "bu/str.h"
+#include "bu/time.h"
 
 /* interface headers */
 #include "pkg.h"
@@ -77,6 +83,7 @@ usage(const char *msg, const char *argv0)
     }
     bu_log("Client Usage: %s [-t] [-p#] [-b#] host file\n\t-p#\tport number to send to (default 2000)\n\t-b#\tsize of the packages sent (default 2048)\n\thost\thostname or IP address of receiving server\n\tfile\tsome file to transfer\n", argv0 ? argv0 : MAGIC_ID);
     bu_log("Server Usage: %s -r [-p#]\n\t-p#\tport number to listen on (default 2000)\n", argv0 ? argv0 : MAGIC_ID);
+    bu_log("Benchmark Usage: %s -s [-b#] [-n#]\n\t-b#\tsize of the packages sent (default 2048)\n\t-n#\tmegabytes to send (default 256)\n", argv0 ? argv0 : MAGIC_ID);
 
     bu_log("\n%s", pkg_version());
 
@@ -307,6 +314,156 @@ run_client(const char *server, int port, const char *file, unsigned int tpkg_buf
 }
 
 
+/* state shared by the two benchmark threads */
+struct bench {
+    struct pkg_conn *send_end;
+    struct pkg_conn *recv_end;
+    char *pattern;	/* payload of every message */
+    size_t size;	/* payload bytes per message */
+    size_t count;	/* messages to send */
+    size_t received;	/* messages received intact */
+    size_t corrupt;	/* messages received damaged */
+    int done;
+    int roles;		/* threads started so far */
+};
+
+
+/**
+ * callback when a benchmark DATA message is received.  Each message
+ * is a sequence number followed by the shared pattern.
+ */
+static void
+bench_data(struct pkg_conn *connection, char *buf)
+{
+    struct bench *b = (struct bench *)connection->pkc_user_data;
+    unsigned long seq;
+
+    seq = pkg_glong(buf);
+    if (connection->pkc_len != b->size + 4 || seq != (unsigned long)b->received + b->corrupt ||
+	memcmp(buf + 4, b->pattern, b->size) != 0) {
+	b->corrupt++;
+    } else {
+	b->received++;
+    }
+    free(buf);
+}
+
+
+/**
+ * callback when a benchmark CIAO message is received
+ */
+static void
+bench_ciao(struct pkg_conn *connection, char *buf)
+{
+    struct bench *b = (struct bench *)connection->pkc_user_data;
+
+    b->done = 1;
+    free(buf);
+}
+
+
+/**
+ * benchmark thread body, the first thread to start sends and the
+ * second receives.  bu_parallel() cpu ids don't start at a fixed
+ * number, so the roles are claimed rather than keyed on cpu.
+ */
+static void
+bench_thread(int UNUSED(cpu), void *data)
+{
+    struct bench *b = (struct bench *)data;
+    char seq[4];
+    size_t i;
+    int role;
+
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    role = b->roles++;
+    bu_semaphore_release(BU_SEM_GENERAL);
+
+    if (role == 0) {
+	for (i = 0; i < b->count; i++) {
+	    (void)pkg_plong(seq, (unsigned long)i);
+	    if (pkg_2send(MSG_DATA, seq, 4, b->pattern, b->size, b->send_end) != (int)(b->size + 4)) {
+		bu_log("Benchmark send failed at message %zu\n", i);
+		break;
+	    }
+	}
+	(void)pkg_send(MSG_CIAO, "BYE", 4, b->send_end);
+	return;
+    }
+
+    while (!b->done) {
+	if (pkg_suckin(b->recv_end) < 1)
+	    break;
+	if (pkg_process(b->recv_end) < 0) {
+	    bu_log("Benchmark receive failed\n");
+	    break;
+	}
+    }
+}
+
+
+/**
+ * send megabytes of data in messages of size bytes from one thread
+ * to another over a local socket pair, and report the throughput.
+ */
+int
+run_benchmark(unsigned int size, unsigned int megabytes)
+{
+    struct bench b;
+    int64_t start;
+    double elapsed;
+    size_t i;
+
+    struct pkg_switch callbacks[] = {
+	{MSG_DATA, bench_data, "DATA", NULL},
+	{MSG_CIAO, bench_ciao, "CIAO", NULL},
+	{0, 0, (char *)0, (void*)0}
+    };
+
+    memset(&b, 0, sizeof(b));
+    callbacks[0].pks_user_data = &b;
+    callbacks[1].pks_user_data = &b;
+
+    if (size < 1)
+	size = 1;
+    b.size = size;
+    b.count = ((size_t)megabytes * 1024 * 1024) / size;
+    if (b.count < 1)
+	b.count = 1;
+    b.pattern = (char *)bu_malloc(size, "pattern");
+    for (i = 0; i < size; i++)
+	b.pattern[i] = (char)(i * 31 + 7);
+
+    if (pkg_pair_prefer(&b.send_end, &b.recv_end, callbacks, NULL, PKG_TRANSPORT_SOCKET) < 0) {
+	bu_free(b.pattern, "pattern");
+	bu_log("Unable to create a local connection\n");
+	return 1;
+    }
+
+    start = bu_gettime();
+    bu_parallel(bench_thread, 2, &b);
+    elapsed = (bu_gettime() - start) / 1.0e6;
+    if (elapsed <= 0.0)
+	elapsed = 1.0e-6;
+
+    bu_log("%zu messages of %u bytes in %.3f sec, %.1f MB/s, %.0f msgs/s\n",
+	   b.received, size, elapsed,
+	   (double)b.received * (size + 4) / (1024.0 * 1024.0) / elapsed,
+	   b.received / elapsed);
+
+    pkg_close(b.send_end);
+    pkg_close(b.recv_end);
+    bu_free(b.pattern, "pattern");
+
+    if (b.corrupt > 0 || b.received != b.count || !b.done) {
+	bu_log("ERROR: %zu of %zu messages arrived, %zu damaged\n",
+	       b.received, b.count, b.corrupt);
+	return 1;
+    }
+    return 0;
+}
+
+
 /**
  * main application for both the client and server
  */
@@ -315,8 +472,10 @@ main(int argc, char *argv[]) {
     const char * const argv0 = argv[0];
     int c;
     int server = 0; /* not a server by default */
+    int benchmark = 0;
     int port = 2000;
     unsigned int pkg_size = 2048;
+    unsigned int megabytes = 256;
     /* client stuff */
     const char *server_name = NULL;
     const char *file = NULL;
@@ -326,7 +485,7 @@ main(int argc, char *argv[]) {
     }
 
     /* process the command-line arguments after the application name */
-    while ((c = bu_getopt(argc, argv, "tTrRp:P:hH:b:B:")) != -1) {
+    while ((c = bu_getopt(argc, argv, "tTrRsSp:P:hH:b:B:n:N:")) != -1) {
 	switch (c) {
 	    case 't':
 	    case 'T':
@@ -338,10 +497,19 @@ main(int argc, char *argv[]) {
 		/* receiving */
 		server = 1;
 		break;
+	    case 's':
+	    case 'S':
+		/* local throughput benchmark */
+		benchmark = 1;
+		break;
 	    case 'p':
 	    case 'P':
 		port = atoi(bu_optarg);
 		break;
+	    case 'n':
+	    case 'N':
+		megabytes = (unsigned int)atoi(bu_optarg);
+		break;
 	    case 'b':
 	    case 'B':
 		/* Package size*/
@@ -359,6 +527,13 @@ main(int argc, char *argv[]) {
     argc -= bu_optind;
     argv += bu_optind;
 
+    if (benchmark) {
+	if (argc > 0) {
+	    usage("ERROR: Unexpected extra benchmark arguments\n", argv0);
+	}
+	return run_benchmark(pkg_size, megabytes);
+    }
+
     if (server) {
 	if (argc > 0) {
 	    usage("ERROR: Unexpected extra server arguments\n", argv0);
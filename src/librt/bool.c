@@ -144,6 +144,336 @@ bool_weave0seg(struct seg *segp, struct partition *PartHdp, struct application *
 }
 
 
+/**
+ * Move segp from the input to the output segment chain and apply the
+ * checks every segment gets before weaving.  Returns 1 if the segment
+ * is to be woven into the partitions, 0 if it is ignored.
+ */
+static int
+bool_weave_take(struct seg *segp, struct seg *out_hd, struct application *ap)
+{
+    struct rt_i *rtip = ap->a_rt_i;
+    struct soltab *stp;
+    fastf_t tol_dist = rtip->rti_tol.dist;
+
+    RT_CHECK_SEG(segp);
+    RT_CK_HIT(&(segp->seg_in));
+    RT_CK_HIT(&(segp->seg_out));
+    if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
+	point_t pt;
+
+	bu_log("************ Input segment:\n");
+	rt_pr_seg(segp);
+	rt_pr_hit(" In", &segp->seg_in);
+	VJOIN1(pt, ap->a_ray.r_pt, segp->seg_in.hit_dist, ap->a_ray.r_dir);
+	/* XXX needs indentation added here */
+	VPRINT(" IPoint", pt);
+
+	rt_pr_hit("Out", &segp->seg_out);
+	VJOIN1(pt, ap->a_ray.r_pt, segp->seg_out.hit_dist, ap->a_ray.r_dir);
+	/* XXX needs indentation added here */
+	VPRINT(" OPoint", pt);
+	bu_log("***********\n");
+    }
+    stp = segp->seg_stp;
+    if (stp)
+	RT_CK_SOLTAB(stp);
+
+    if (stp && (size_t)stp->st_bit >= rtip->stats.nsolids)
+	bu_bomb("rt_boolweave: st_bit greater than nsolids");
+
+    BU_LIST_DEQUEUE(&(segp->l));
+    BU_LIST_INSERT(&(out_hd->l), &(segp->l));
+
+    /* Make nearly zero be exactly zero */
+    if (NEAR_ZERO(segp->seg_in.hit_dist, tol_dist))
+	segp->seg_in.hit_dist = 0;
+    if (NEAR_ZERO(segp->seg_out.hit_dist, tol_dist))
+	segp->seg_out.hit_dist = 0;
+
+    /* Totally ignore things behind the start position */
+    if (segp->seg_out.hit_dist < -10.0)
+	return 0;
+
+    /* make sure we don't have infinite hits on non-infinite solids */
+    if ((stp && stp->st_aradius < INFINITY) &&
+	!(segp->seg_in.hit_dist >= -INFINITY && segp->seg_out.hit_dist <= INFINITY)) {
+	if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
+	    bu_log("rt_boolweave:  Defective %s segment %s (%.18e, %.18e) %d, %d\n",
+		   stp->st_meth->ft_name,
+		   stp->st_name,
+		   segp->seg_in.hit_dist,
+		   segp->seg_out.hit_dist,
+		   segp->seg_in.hit_surfno,
+		   segp->seg_out.hit_surfno);
+	}
+	return 0;
+    }
+
+    /* make sure in/out book-keeping is in order */
+    if (segp->seg_in.hit_dist > segp->seg_out.hit_dist) {
+	if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
+	    bu_log("rt_boolweave:  Inside-out %s segment %s (%.18e, %.18e) %d, %d\n",
+		   stp ? stp->st_meth->ft_name : "no-object",
+		   stp ? stp->st_name : "unnamed",
+		   segp->seg_in.hit_dist,
+		   segp->seg_out.hit_dist,
+		   segp->seg_in.hit_surfno,
+		   segp->seg_out.hit_surfno);
+	}
+	return 0;
+    }
+
+
+    return 1;
+}
+
+
+/* Under RT_WEAVE_AUTO, rays with at least this many segments to weave
+ * into an empty partition list use bool_weave_sweep().
+ */
+#define BOOL_WEAVE_SWEEP_MIN 32
+
+struct bool_weave_event {
+    fastf_t dist;
+    size_t seg;		/* index into the segment array */
+    int out;		/* 0 = seg_in, 1 = seg_out */
+};
+
+/* Marks a removed entry of the open segment list */
+#define BOOL_WEAVE_GONE ((size_t)-1)
+
+
+static int
+bool_weave_event_cmp(const void *a, const void *b)
+{
+    const struct bool_weave_event *ea = (const struct bool_weave_event *)a;
+    const struct bool_weave_event *eb = (const struct bool_weave_event *)b;
+
+    if (ea->dist < eb->dist)
+	return -1;
+    if (ea->dist > eb->dist)
+	return 1;
+    if (ea->seg != eb->seg)
+	return (ea->seg < eb->seg) ? -1 : 1;
+    return ea->out - eb->out;
+}
+
+
+static void
+bool_weave_new_pt(struct partition *PartHdp, struct seg *segp, struct application *ap)
+{
+    register struct partition *pp;
+
+    GET_PT_INIT(ap->a_rt_i, pp, ap->a_resource);
+    bu_ptbl_ins_unique(&pp->pt_seglist, (long *)segp);
+    pp->pt_inseg = segp;
+    pp->pt_inhit = &segp->seg_in;
+    pp->pt_outseg = segp;
+    pp->pt_outhit = &segp->seg_out;
+    APPEND_PT(pp, PartHdp->pt_back);
+}
+
+
+/**
+ * Weave all of in_hd into the empty partition list PartHdp at once.
+ *
+ * The segment endpoints are sorted into one array and swept in
+ * order.  Endpoints within tolerance of the first one in a run are
+ * fused into a single partition boundary, and every boundary with
+ * a segment still open starts a new partition holding the open
+ * segments.  As in the incremental weave, a partition begins at
+ * the closest entering hit on its boundary (pt_inflip 0), or at an
+ * exit hit (pt_inflip 1) when no segment enters there.  Partitions
+ * end the same way with exit and entering hits swapped.
+ * Zero-thickness segments are woven in afterwards with
+ * bool_weave0seg().  Besides the O(n log n) sort this costs time in
+ * proportion to the partitions' segment lists, however the segments
+ * arrive, where the incremental weave rescans the partition list for
+ * every segment.  The arrays come from the thread's scratch arena.
+ *
+ * The incremental weave's result depends on arrival order in two
+ * cases: a zero-thickness segment arriving before a thick one, and
+ * boundaries chained closer than tolerance over a run longer than
+ * tolerance.  Those rays are left to it, so both weaves always give
+ * the same partitions.  Returns 1 if the segments were woven, or 0
+ * with them put back on in_hd in their original order.
+ */
+static int
+bool_weave_sweep(struct seg *out_hd, struct seg *in_hd, struct partition *PartHdp, struct application *ap)
+{
+    struct rt_i *rtip = ap->a_rt_i;
+    struct bu_arena *arena;
+    struct bu_arena_mark mark;
+    struct seg **segs;
+    struct bool_weave_event *ev;
+    size_t *active;	/* open segments in start order, by index */
+    size_t *slot;	/* each open segment's place in active */
+    register struct partition *pp = PT_NULL;
+    register struct seg *segp;
+    fastf_t tol_dist = rtip->rti_tol.dist;
+    size_t total = 0;
+    size_t nsegs = 0;
+    size_t nthick = 0;
+    size_t nev = 0;
+    size_t nactive = 0;
+    size_t ngone = 0;
+    size_t i, j, k;
+
+    for (BU_LIST_FOR(segp, seg, &(in_hd->l)))
+	total++;
+    if (!total)
+	return 1;
+
+    arena = bu_arena_thread();
+    bu_arena_mark(arena, &mark);
+    segs = (struct seg **)bu_arena_alloc(arena, total, sizeof(struct seg *));
+    ev = (struct bool_weave_event *)bu_arena_alloc(arena, 2 * total, sizeof(struct bool_weave_event));
+    active = (size_t *)bu_arena_alloc(arena, total, sizeof(size_t));
+    slot = (size_t *)bu_arena_alloc(arena, total, sizeof(size_t));
+
+    /* Keep the segments in arrival order, counting up to the last
+     * thick one.
+     */
+    while (BU_LIST_NON_EMPTY(&(in_hd->l))) {
+	segp = BU_LIST_FIRST(seg, &(in_hd->l));
+	if (!bool_weave_take(segp, out_hd, ap))
+	    continue;
+	segs[nsegs++] = segp;
+	if (ap->a_no_booleans || !NEAR_ZERO(segp->seg_in.hit_dist - segp->seg_out.hit_dist, tol_dist))
+	    nthick = nsegs;
+    }
+
+    if (ap->a_no_booleans) {
+	/* Just sort in ascending in-dist order */
+	for (i = 0; i < nsegs; i++) {
+	    ev[i].dist = segs[i]->seg_in.hit_dist;
+	    ev[i].seg = i;
+	    ev[i].out = 0;
+	}
+	qsort(ev, nsegs, sizeof(struct bool_weave_event), bool_weave_event_cmp);
+	for (i = 0; i < nsegs; i++)
+	    bool_weave_new_pt(PartHdp, segs[ev[i].seg], ap);
+	bu_arena_reset(arena, &mark);
+	return 1;
+    }
+
+    for (i = 0; i < nthick; i++) {
+	if (NEAR_ZERO(segs[i]->seg_in.hit_dist - segs[i]->seg_out.hit_dist, tol_dist))
+	    goto incremental;
+	ev[nev].dist = segs[i]->seg_in.hit_dist;
+	ev[nev].seg = i;
+	ev[nev++].out = 0;
+	ev[nev].dist = segs[i]->seg_out.hit_dist;
+	ev[nev].seg = i;
+	ev[nev++].out = 1;
+    }
+    qsort(ev, nev, sizeof(struct bool_weave_event), bool_weave_event_cmp);
+
+    for (i = 0; i < nev; i = j) {
+	for (j = i; j < nev && ev[j].dist - ev[i].dist < tol_dist; j++)
+	    ;
+	if (j < nev && ev[j].dist - ev[j-1].dist < tol_dist)
+	    goto incremental;
+    }
+
+    for (i = 0; i < nev; i = j) {
+	fastf_t dist = ev[i].dist;
+	struct seg *inseg = RT_SEG_NULL;
+	struct seg *outseg = RT_SEG_NULL;
+
+	for (j = i; j < nev && ev[j].dist - dist < tol_dist; j++) {
+	    segp = segs[ev[j].seg];
+	    if (ev[j].out) {
+		if (!outseg)
+		    outseg = segp;
+	    } else if (!inseg) {
+		inseg = segp;
+	    }
+	}
+
+	/* End the open partition at this boundary */
+	if (pp) {
+	    if (outseg) {
+		pp->pt_outseg = outseg;
+		pp->pt_outhit = &outseg->seg_out;
+		pp->pt_outflip = 0;
+	    } else {
+		pp->pt_outseg = inseg;
+		pp->pt_outhit = &inseg->seg_in;
+		pp->pt_outflip = 1;
+	    }
+	    pp = PT_NULL;
+	}
+
+	/* Fuse the boundary and update the open segments, keeping
+	 * them in the order they started.  Closed segments are marked
+	 * and squeezed out below in one pass.
+	 */
+	for (k = i; k < j; k++) {
+	    size_t n = ev[k].seg;
+	    segp = segs[n];
+	    if (ev[k].out) {
+		segp->seg_out.hit_dist = dist;
+		active[slot[n]] = BOOL_WEAVE_GONE;
+		ngone++;
+	    } else {
+		segp->seg_in.hit_dist = dist;
+		slot[n] = nactive;
+		active[nactive++] = n;
+	    }
+	}
+	if (ngone) {
+	    size_t a = 0;
+	    for (k = 0; k < nactive; k++) {
+		if (active[k] == BOOL_WEAVE_GONE)
+		    continue;
+		slot[active[k]] = a;
+		active[a++] = active[k];
+	    }
+	    nactive = a;
+	    ngone = 0;
+	}
+
+	if (!nactive)
+	    continue;
+
+	GET_PT_INIT(rtip, pp, ap->a_resource);
+	for (k = 0; k < nactive; k++)
+	    bu_ptbl_ins(&pp->pt_seglist, (long *)segs[active[k]]);
+	if (inseg) {
+	    pp->pt_inseg = inseg;
+	    pp->pt_inhit = &inseg->seg_in;
+	    pp->pt_inflip = 0;
+	} else {
+	    pp->pt_inseg = outseg;
+	    pp->pt_inhit = &outseg->seg_out;
+	    pp->pt_inflip = 1;
+	}
+	APPEND_PT(pp, PartHdp->pt_back);
+    }
+
+    /* Zero-thickness segments, in the order they arrived */
+    for (k = nthick; k < nsegs; k++) {
+	segp = segs[k];
+	if (PartHdp->pt_forw == PartHdp)
+	    bool_weave_new_pt(PartHdp, segp, ap);
+	else
+	    bool_weave0seg(segp, PartHdp, ap);
+    }
+    bu_arena_reset(arena, &mark);
+    return 1;
+
+incremental:
+    for (i = 0; i < nsegs; i++) {
+	BU_LIST_DEQUEUE(&(segs[i]->l));
+	BU_LIST_INSERT(&(in_hd->l), &(segs[i]->l));
+    }
+    bu_arena_reset(arena, &mark);
+    return 0;
+}
+
+
 _BU_ATTR_FLATTEN void
 rt_boolweave(struct seg *out_hd, struct seg *in_hd, struct partition *PartHdp, struct application *ap)
 {
@@ -167,81 +497,33 @@ rt_boolweave(struct seg *out_hd, struct seg *in_hd, struct partition *PartHdp, s
 	rt_pr_partitions(rtip, PartHdp, "-----------------BOOL_WEAVE");
     }
 
+    if (PartHdp->pt_forw == PartHdp && rtip->rti_weave != RT_WEAVE_LIST) {
+	size_t nsegs = 0;
+	if (rtip->rti_weave == RT_WEAVE_AUTO) {
+	    for (BU_LIST_FOR(segp, seg, &(in_hd->l))) {
+		if (++nsegs >= BOOL_WEAVE_SWEEP_MIN)
+		    break;
+	    }
+	}
+	if ((rtip->rti_weave == RT_WEAVE_SWEEP || nsegs >= BOOL_WEAVE_SWEEP_MIN)
+	    && bool_weave_sweep(out_hd, in_hd, PartHdp, ap)) {
+	    if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
+		rt_pr_partitions(rtip, PartHdp, "After sweep weave");
+		bu_log("--------------------Leaving Booleweave\n");
+	    }
+	    return;
+	}
+    }
+
     while (BU_LIST_NON_EMPTY(&(in_hd->l))) {
 	register struct partition *newpp = PT_NULL;
 	register struct seg *lastseg = RT_SEG_NULL;
 	register struct hit *lasthit = HIT_NULL;
-	register struct soltab *stp = NULL;
 	int lastflip = 0;
 
 	segp = BU_LIST_FIRST(seg, &(in_hd->l));
-	RT_CHECK_SEG(segp);
-	RT_CK_HIT(&(segp->seg_in));
-	RT_CK_HIT(&(segp->seg_out));
-	if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
-	    point_t pt;
-
-	    bu_log("************ Input segment:\n");
-	    rt_pr_seg(segp);
-	    rt_pr_hit(" In", &segp->seg_in);
-	    VJOIN1(pt, ap->a_ray.r_pt, segp->seg_in.hit_dist, ap->a_ray.r_dir);
-	    /* XXX needs indentation added here */
-	    VPRINT(" IPoint", pt);
-
-	    rt_pr_hit("Out", &segp->seg_out);
-	    VJOIN1(pt, ap->a_ray.r_pt, segp->seg_out.hit_dist, ap->a_ray.r_dir);
-	    /* XXX needs indentation added here */
-	    VPRINT(" OPoint", pt);
-	    bu_log("***********\n");
-	}
-	stp = segp->seg_stp;
-	if (stp)
-	    RT_CK_SOLTAB(stp);
-
-	if (stp && (size_t)stp->st_bit >= rtip->stats.nsolids)
-	    bu_bomb("rt_boolweave: st_bit greater than nsolids");
-
-	BU_LIST_DEQUEUE(&(segp->l));
-	BU_LIST_INSERT(&(out_hd->l), &(segp->l));
-
-	/* Make nearly zero be exactly zero */
-	if (NEAR_ZERO(segp->seg_in.hit_dist, tol_dist))
-	    segp->seg_in.hit_dist = 0;
-	if (NEAR_ZERO(segp->seg_out.hit_dist, tol_dist))
-	    segp->seg_out.hit_dist = 0;
-
-	/* Totally ignore things behind the start position */
-	if (segp->seg_out.hit_dist < -10.0)
-	    continue;
-
-	/* make sure we don't have infinite hits on non-infinite solids */
-	if ((stp && stp->st_aradius < INFINITY) &&
-	    !(segp->seg_in.hit_dist >= -INFINITY && segp->seg_out.hit_dist <= INFINITY)) {
-	    if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
-		bu_log("rt_boolweave:  Defective %s segment %s (%.18e, %.18e) %d, %d\n",
-		       OBJ[stp->st_id].ft_name,
-		       stp->st_name,
-		       segp->seg_in.hit_dist,
-		       segp->seg_out.hit_dist,
-		       segp->seg_in.hit_surfno,
-		       segp->seg_out.hit_surfno);
-	    }
+	if (!bool_weave_take(segp, out_hd, ap))
 	    continue;
-	}
-
-	/* make sure in/out book-keeping is in order */
-	if (segp->seg_in.hit_dist > segp->seg_out.hit_dist) {
-	    if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
-		bu_log("rt_boolweave:  Inside-out %s segment %s (%.18e, %.18e) %d, %d\n",
-		       stp ? OBJ[stp->st_id].ft_name : "no-object",
-		       stp ? stp->st_name : "unnamed",
-		       segp->seg_in.hit_dist,
-		       segp->seg_out.hit_dist,
-		       segp->seg_in.hit_surfno,
-		       segp->seg_out.hit_surfno);
-	    }
-	    continue;
-	}
 
 	diff = segp->seg_in.hit_dist - segp->seg_out.hit_dist;
 
@@ -1410,6 +1692,370 @@ pop:
 }
 
 
+/*
+ * Region trees are lowered at prep time by rt_bool_compile() into one
+ * of two flat forms, so that rt_boolfinal() does not have to walk the
+ * tree for every partition.  Both forms refer to the region's distinct
+ * leaf solids through a table sorted by address, so the leaves present
+ * in a partition are found with one binary search per segment.
+ *
+ * BOOL_PROG_MASK covers the common "X - (A u B u ...)" shape, where X
+ * is a single leaf or a pure union or intersection of leaves, when
+ * there are at most BOOL_PROG_MAXLEAF leaves.  The tree collapses to
+ * three mask tests against the leaves present.
+ *
+ * BOOL_PROG_CODE is a straight-line program that leaves its result in
+ * a single register, with forward jumps for the same short-circuit
+ * cases bool_eval() takes.  XOR keeps its lhs on a small value stack.
+ */
+#define BOOL_PROG_MASK 1
+#define BOOL_PROG_CODE 2
+
+#define BOOL_I_SOLID 0	/* ret = leaf[arg] is present */
+#define BOOL_I_FALSE 1	/* ret = BOOL_FALSE */
+#define BOOL_I_JT 2	/* if (ret) goto arg */
+#define BOOL_I_JF 3	/* if (!ret) goto arg */
+#define BOOL_I_NOT 4	/* ret = !ret */
+#define BOOL_I_PUSH 5	/* push ret */
+#define BOOL_I_XOR 6	/* pop lhs, both true is a GUARD error */
+
+#define BOOL_PROG_MAXLEAF 64	/* leaves that fit a uint64_t mask */
+#define BOOL_PROG_MAXSTACK 32	/* nesting depth of XOR nodes */
+#define BOOL_PROG_MAXDEPTH 8192	/* tree depth, bounds the recursion */
+
+struct bool_insn {
+    int op;
+    int arg;
+};
+
+struct rt_bool_prog {
+    int mode;			/* BOOL_PROG_MASK or BOOL_PROG_CODE */
+    size_t nleaf;
+    struct soltab **leaf;	/* distinct leaf solids, sorted by address */
+    uint64_t all;		/* MASK: all of these must be present */
+    uint64_t any;		/* MASK: one of these must be, if non-zero */
+    uint64_t none;		/* MASK: none of these may be present */
+    size_t ncode;
+    size_t maxcode;
+    struct bool_insn *code;	/* CODE: the program */
+};
+
+
+static int
+bool_prog_stp_cmp(const void *a, const void *b)
+{
+    uintptr_t pa = (uintptr_t)*(struct soltab * const *)a;
+    uintptr_t pb = (uintptr_t)*(struct soltab * const *)b;
+
+    if (pa < pb)
+	return -1;
+    return pa > pb;
+}
+
+
+/**
+ * Returns the index of stp in the leaf table, or -1.
+ */
+static inline int
+bool_prog_leaf(const struct rt_bool_prog *prog, const struct soltab *stp)
+{
+    size_t lo = 0;
+    size_t hi = prog->nleaf;
+
+    while (lo < hi) {
+	size_t mid = (lo + hi) >> 1;
+	if ((uintptr_t)prog->leaf[mid] < (uintptr_t)stp)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    if (lo < prog->nleaf && prog->leaf[lo] == stp)
+	return (int)lo;
+    return -1;
+}
+
+
+/**
+ * Gathers the leaf solids of the tree into prog->leaf (unsorted, with
+ * duplicates).  Returns -1 for trees the compiler does not handle.
+ */
+static int
+bool_prog_leaves(struct rt_bool_prog *prog, size_t *cap, const union tree *tp, int depth)
+{
+    if (depth > BOOL_PROG_MAXDEPTH)
+	return -1;
+
+    switch (tp->tr_op) {
+	case OP_NOP:
+	    return 0;
+	case OP_SOLID:
+	    if (prog->nleaf >= *cap) {
+		*cap = (*cap) ? (*cap) << 1 : 16;
+		prog->leaf = (struct soltab **)bu_realloc(prog->leaf, *cap * sizeof(struct soltab *), "bool_prog leaf");
+	    }
+	    prog->leaf[prog->nleaf++] = tp->tr_a.tu_stp;
+	    return 0;
+	case OP_UNION:
+	case OP_INTERSECT:
+	case OP_SUBTRACT:
+	case OP_XOR:
+	    if (bool_prog_leaves(prog, cap, tp->tr_b.tb_left, depth + 1) < 0)
+		return -1;
+	    return bool_prog_leaves(prog, cap, tp->tr_b.tb_right, depth + 1);
+	default:
+	    return -1;
+    }
+}
+
+
+/**
+ * If the tree is a single leaf or is built only from 'op' nodes over
+ * leaves, sets the leaves' bits in 'mask' and returns 1.
+ */
+static int
+bool_prog_leafset(const struct rt_bool_prog *prog, const union tree *tp, int op, uint64_t *mask)
+{
+    if (tp->tr_op == OP_SOLID) {
+	*mask |= (uint64_t)1 << bool_prog_leaf(prog, tp->tr_a.tu_stp);
+	return 1;
+    }
+    if (tp->tr_op != op)
+	return 0;
+    return bool_prog_leafset(prog, tp->tr_b.tb_left, op, mask)
+	&& bool_prog_leafset(prog, tp->tr_b.tb_right, op, mask);
+}
+
+
+static int
+bool_prog_mask(struct rt_bool_prog *prog, const union tree *tp)
+{
+    uint64_t set = 0;
+
+    if (prog->nleaf > BOOL_PROG_MAXLEAF)
+	return 0;
+
+    if (tp->tr_op == OP_SUBTRACT) {
+	if (!bool_prog_leafset(prog, tp->tr_b.tb_right, OP_UNION, &prog->none))
+	    return 0;
+	tp = tp->tr_b.tb_left;
+    }
+    if (tp->tr_op == OP_SOLID || tp->tr_op == OP_INTERSECT) {
+	if (!bool_prog_leafset(prog, tp, OP_INTERSECT, &set))
+	    return 0;
+	prog->all = set;
+    } else {
+	if (!bool_prog_leafset(prog, tp, OP_UNION, &set))
+	    return 0;
+	prog->any = set;
+    }
+    prog->mode = BOOL_PROG_MASK;
+    return 1;
+}
+
+
+static size_t
+bool_prog_op(struct rt_bool_prog *prog, int op, int arg)
+{
+    if (prog->ncode >= prog->maxcode) {
+	prog->maxcode = (prog->maxcode) ? prog->maxcode << 1 : 32;
+	prog->code = (struct bool_insn *)bu_realloc(prog->code, prog->maxcode * sizeof(struct bool_insn), "bool_prog code");
+    }
+    prog->code[prog->ncode].op = op;
+    prog->code[prog->ncode].arg = arg;
+    return prog->ncode++;
+}
+
+
+/**
+ * Emits the program for one subtree.  Every jump lands on the end of
+ * the subtree that issued it, so the XOR value stack stays balanced.
+ */
+static int
+bool_prog_emit(struct rt_bool_prog *prog, const union tree *tp, int stack)
+{
+    size_t j;
+
+    switch (tp->tr_op) {
+	case OP_NOP:
+	    bool_prog_op(prog, BOOL_I_FALSE, 0);
+	    return 0;
+	case OP_SOLID:
+	    bool_prog_op(prog, BOOL_I_SOLID, bool_prog_leaf(prog, tp->tr_a.tu_stp));
+	    return 0;
+	case OP_UNION:
+	case OP_INTERSECT:
+	case OP_SUBTRACT:
+	    if (bool_prog_emit(prog, tp->tr_b.tb_left, stack) < 0)
+		return -1;
+	    j = bool_prog_op(prog, (tp->tr_op == OP_UNION) ? BOOL_I_JT : BOOL_I_JF, 0);
+	    if (bool_prog_emit(prog, tp->tr_b.tb_right, stack) < 0)
+		return -1;
+	    if (tp->tr_op == OP_SUBTRACT)
+		bool_prog_op(prog, BOOL_I_NOT, 0);
+	    prog->code[j].arg = (int)prog->ncode;
+	    return 0;
+	case OP_XOR:
+	    if (stack >= BOOL_PROG_MAXSTACK)
+		return -1;
+	    if (bool_prog_emit(prog, tp->tr_b.tb_left, stack) < 0)
+		return -1;
+	    bool_prog_op(prog, BOOL_I_PUSH, 0);
+	    if (bool_prog_emit(prog, tp->tr_b.tb_right, stack + 1) < 0)
+		return -1;
+	    bool_prog_op(prog, BOOL_I_XOR, 0);
+	    return 0;
+	default:
+	    return -1;
+    }
+}
+
+
+void
+rt_bool_prog_free(struct region *regp)
+{
+    struct rt_bool_prog *prog = regp->reg_bool;
+
+    if (!prog)
+	return;
+    if (prog->leaf)
+	bu_free(prog->leaf, "bool_prog leaf");
+    if (prog->code)
+	bu_free(prog->code, "bool_prog code");
+    bu_free(prog, "struct rt_bool_prog");
+    regp->reg_bool = NULL;
+}
+
+
+void
+rt_bool_compile(struct region *regp)
+{
+    struct rt_bool_prog *prog;
+    size_t cap = 0;
+    size_t i, n;
+
+    RT_CK_REGION(regp);
+    rt_bool_prog_free(regp);
+
+    /* all-union regions never evaluate their tree */
+    if (!regp->reg_treetop || regp->reg_all_unions)
+	return;
+    RT_CK_TREE(regp->reg_treetop);
+
+    BU_ALLOC(prog, struct rt_bool_prog);
+    if (bool_prog_leaves(prog, &cap, regp->reg_treetop, 0) < 0)
+	goto fail;
+
+    if (prog->nleaf > 1) {
+	qsort(prog->leaf, prog->nleaf, sizeof(struct soltab *), bool_prog_stp_cmp);
+	for (i = n = 1; i < prog->nleaf; i++) {
+	    if (prog->leaf[i] != prog->leaf[n-1])
+		prog->leaf[n++] = prog->leaf[i];
+	}
+	prog->nleaf = n;
+    }
+
+    if (!bool_prog_mask(prog, regp->reg_treetop)) {
+	prog->mode = BOOL_PROG_CODE;
+	if (bool_prog_emit(prog, regp->reg_treetop, 0) < 0)
+	    goto fail;
+    }
+
+    if (RT_G_DEBUG&RT_DEBUG_REGIONS)
+	bu_log("rt_bool_compile(%s): %zu leaves, %s\n", regp->reg_name, prog->nleaf,
+	       (prog->mode == BOOL_PROG_MASK) ? "mask" : "code");
+
+    regp->reg_bool = prog;
+    return;
+
+fail:
+    /* left to bool_eval() */
+    regp->reg_bool = prog;
+    rt_bool_prog_free(regp);
+}
+
+
+/**
+ * Evaluates a compiled region tree against a partition, with the same
+ * results as bool_eval().
+ */
+static int
+bool_prog_eval(const struct rt_bool_prog *prog, const struct partition *partp)
+{
+    const struct bool_insn *ip;
+    const struct bool_insn *end;
+    struct seg **segpp;
+    uint64_t present = 0;
+    int stack[BOOL_PROG_MAXSTACK];
+    int sp = 0;
+    int ret = BOOL_FALSE;
+    int idx;
+
+    if (prog->nleaf <= BOOL_PROG_MAXLEAF) {
+	for (BU_PTBL_FOR(segpp, (struct seg **), &partp->pt_seglist)) {
+	    idx = bool_prog_leaf(prog, (*segpp)->seg_stp);
+	    if (idx >= 0)
+		present |= (uint64_t)1 << idx;
+	}
+    }
+
+    if (prog->mode == BOOL_PROG_MASK)
+	return (present & prog->all) == prog->all
+	    && (!prog->any || (present & prog->any))
+	    && !(present & prog->none);
+
+    ip = prog->code;
+    end = ip + prog->ncode;
+    while (ip < end) {
+	switch (ip->op) {
+	    case BOOL_I_SOLID:
+		if (prog->nleaf <= BOOL_PROG_MAXLEAF) {
+		    ret = (int)((present >> ip->arg) & 1);
+		} else {
+		    const struct soltab *seek_stp = prog->leaf[ip->arg];
+		    ret = BOOL_FALSE;
+		    for (BU_PTBL_FOR(segpp, (struct seg **), &partp->pt_seglist)) {
+			if ((*segpp)->seg_stp == seek_stp) {
+			    ret = BOOL_TRUE;
+			    break;
+			}
+		    }
+		}
+		break;
+	    case BOOL_I_FALSE:
+		ret = BOOL_FALSE;
+		break;
+	    case BOOL_I_JT:
+		if (ret) {
+		    ip = prog->code + ip->arg;
+		    continue;
+		}
+		break;
+	    case BOOL_I_JF:
+		if (!ret) {
+		    ip = prog->code + ip->arg;
+		    continue;
+		}
+		break;
+	    case BOOL_I_NOT:
+		ret = !ret;
+		break;
+	    case BOOL_I_PUSH:
+		stack[sp++] = ret;
+		break;
+	    case BOOL_I_XOR:
+		if (stack[--sp]) {
+		    if (ret)
+			return -1;	/* GUARD error */
+		    ret = BOOL_TRUE;
+		}
+		break;
+	}
+	ip++;
+    }
+    return ret;
+}
+
+
 _BU_ATTR_FLATTEN int
 rt_boolfinal(struct partition *InputHdp, struct partition *FinalHdp, fastf_t startdist, fastf_t enddist, struct bu_ptbl *regiontable, struct application *ap, const struct bu_bitv *solidbits)
 {
@@ -1651,6 +2297,7 @@ rt_boolfinal(struct partition *InputHdp, struct partition *FinalHdp, fastf_t sta
 	    struct region **regpp;
 	    for (BU_PTBL_FOR(regpp, (struct region **), regiontable)) {
 		register struct region *regp;
+		int eval;
 
 		regp = *regpp;
 		RT_CK_REGION(regp);
@@ -1667,7 +2314,11 @@ rt_boolfinal(struct partition *InputHdp, struct partition *FinalHdp, fastf_t sta
 		    lastregion = regp;
 		    continue;
 		}
-		if (bool_eval(regp->reg_treetop, pp, ap->a_resource) == BOOL_FALSE) {
+		if (regp->reg_bool)
+		    eval = bool_prog_eval(regp->reg_bool, pp);
+		else
+		    eval = bool_eval(regp->reg_treetop, pp, ap->a_resource);
+		if (eval == BOOL_FALSE) {
 		    if (RT_G_DEBUG&RT_DEBUG_PARTITION)
 			bu_log("BOOL_FALSE\n");
 		    /* Null out non-claiming region's pointer */
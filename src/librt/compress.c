@@ -0,0 +1,132 @@
+/*                      C O M P R E S S . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/compress.c
+ *
+ * LZ4 compression of bu_external buffers, using the same codec and
+ * block layout as the prep cache: a 4-byte network order count of
+ * uncompressed bytes followed by the compressed data.
+ */
+
+#include "common.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include "bnetwork.h"
+#include "bu/cv.h"
+#include "bu/malloc.h"
+#include "bu/parse.h"
+#include "rt/misc.h"
+
+
+/* Defined in cache_lz4.c */
+extern int brl_LZ4_compress_default(const char *source, char *dest, int sourceSize, int maxDestSize);
+extern int brl_LZ4_compressBound(int inputSize);
+extern int brl_LZ4_decompress_safe(const char *source, char *dest, int compressedSize, int maxDecompressedSize);
+
+/* LZ4 cannot expand a block by more than this factor, so a header
+ * claiming more is corrupt and must not size the allocation */
+#define LZ4_MAX_RATIO 255
+
+
+int
+rt_compress_external(struct bu_external *dest, const struct bu_external *src)
+{
+    int bound;
+    int ret;
+    uint32_t nbytes;
+    uint8_t *buffer;
+
+    BU_CK_EXTERNAL(src);
+    BU_EXTERNAL_INIT(dest);
+
+    if (src->ext_nbytes >= (size_t)INT_MAX)
+	return -1;
+
+    bound = brl_LZ4_compressBound((int)src->ext_nbytes);
+    if (bound <= 0)
+	return -1;
+
+    buffer = (uint8_t *)bu_malloc((size_t)bound + SIZEOF_NETWORK_LONG, "rt_compress_external");
+    nbytes = htonl((uint32_t)src->ext_nbytes);
+    memcpy(buffer, &nbytes, SIZEOF_NETWORK_LONG);
+
+    ret = brl_LZ4_compress_default((const char *)src->ext_buf, (char *)(buffer + SIZEOF_NETWORK_LONG),
+				   (int)src->ext_nbytes, bound);
+    if (ret <= 0 && src->ext_nbytes > 0) {
+	bu_free(buffer, "rt_compress_external");
+	return -1;
+    }
+
+    dest->ext_nbytes = (size_t)ret + SIZEOF_NETWORK_LONG;
+    dest->ext_buf = buffer;
+    return 0;
+}
+
+
+int
+rt_uncompress_external(struct bu_external *dest, const struct bu_external *src)
+{
+    size_t nbytes;
+    size_t zbytes;
+    uint32_t header;
+    int ret;
+    uint8_t *buffer;
+
+    BU_CK_EXTERNAL(src);
+    BU_EXTERNAL_INIT(dest);
+
+    if (src->ext_nbytes < SIZEOF_NETWORK_LONG)
+	return -1;
+
+    /* the header need not be aligned */
+    memcpy(&header, src->ext_buf, SIZEOF_NETWORK_LONG);
+    nbytes = ntohl(header);
+    zbytes = src->ext_nbytes - SIZEOF_NETWORK_LONG;
+    if (nbytes >= (size_t)INT_MAX || zbytes >= (size_t)INT_MAX)
+	return -1;
+    if (nbytes > zbytes * LZ4_MAX_RATIO)
+	return -1;
+
+    /* never a zero-length allocation */
+    buffer = (uint8_t *)bu_malloc(nbytes + 1, "rt_uncompress_external");
+
+    ret = brl_LZ4_decompress_safe((const char *)(src->ext_buf + SIZEOF_NETWORK_LONG), (char *)buffer,
+				  (int)zbytes, (int)nbytes);
+    if (ret < 0 || (size_t)ret != nbytes) {
+	bu_free(buffer, "rt_uncompress_external");
+	return -1;
+    }
+
+    dest->ext_nbytes = nbytes;
+    dest->ext_buf = buffer;
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -96,18 +96,21 @@ init_interior(struct bvh_build_node *node, uint8_t axis, struct bvh_build_node *
     node->n_primitives = 0;
 }
 
-struct bu_pool *
+struct bu_arena *
 hlbvh_init_pool(size_t n_primatives) {
     /*
-     * This pool must have enough size to fit the whole tree or the
-     * algorithm will fail. It stores pointers to itself and a
-     * realloc would make the pointers invalid.
+     * The tree stores pointers to its own nodes, so they come from an
+     * arena, which never moves them.  Treelet node arrays bigger than
+     * a chunk get a chunk of their own.
      *
      * total_nodes = treelets_size + upper_sah_size,  where:
      *  treelets_size < 2*n_primitives
      *  upper_sah_size < 2*2^popcnt(0x3ffc0000)   i.e. 2*4096
      */
-    return bu_pool_create(sizeof(struct bvh_build_node)*(2*n_primatives+2*4096));
+    size_t nodes = 2*n_primatives+2*4096;
+    if (nodes > 64*1024)
+	nodes = 64*1024;
+    return bu_arena_create(sizeof(struct bvh_build_node)*nodes, 0);
 }
 
 /* utility functions */
@@ -315,7 +318,7 @@ pred(const struct bvh_build_node *node, fastf_t *centroid_bounds,
 }
 
 static struct bvh_build_node *
-build_upper_sah(struct bu_pool *pool, struct bvh_build_node **treelet_roots,
+build_upper_sah(struct bu_arena *pool, struct bvh_build_node **treelet_roots,
 	long start, long end, long *total_nodes)
 {
     long n_nodes;
@@ -350,7 +353,7 @@ build_upper_sah(struct bu_pool *pool, struct bvh_build_node **treelet_roots,
 	struct bvh_build_node *lbvh[2];
 	long mid;
 
-	node = (struct bvh_build_node*)bu_pool_alloc(pool, 1, sizeof(*node));
+	node = (struct bvh_build_node*)bu_arena_alloc(pool, 1, sizeof(*node));
 
 	for (i = 0; i<n_buckets; i++) {
 	    buckets[i].count = 0;
@@ -467,7 +470,7 @@ out:
 
 
 struct bvh_build_node *
-hlbvh_create(long max_prims_in_node, struct bu_pool *pool, const fastf_t *centroids_prims,
+hlbvh_create(long max_prims_in_node, struct bu_arena *pool, const fastf_t *centroids_prims,
 	const fastf_t *bounds_prims, long *total_nodes,
 	const long n_primitives, long **ordered_prims)
 {
@@ -534,7 +537,7 @@ hlbvh_create(long max_prims_in_node, struct bu_pool *pool, const fastf_t *centro
 	    long n_prims = end - start;
 	    long max_bvh_nodes = 2 * n_prims;
 	    struct bvh_build_node *nodes;
-	    nodes = (struct bvh_build_node*)bu_pool_alloc(pool, max_bvh_nodes,
+	    nodes = (struct bvh_build_node*)bu_arena_alloc(pool, max_bvh_nodes,
 		    sizeof(struct bvh_build_node));
 	    treelets_to_build_end->start_index = start;
 	    treelets_to_build_end->n_primitives = n_prims;
@@ -876,11 +879,11 @@ clt_linear_bvh_create(long n_primitives, struct clt_linear_bvh_node **nodes_p,
     nodes = NULL;
     if (n_primitives != 0) {
 	/* Build BVH tree for primitives */
-	struct bu_pool *pool;
+	struct bu_arena *pool;
 	long nodes_created = 0;
 	struct bvh_build_node *root;
 
-	pool = hlbvh_init_pool(n_primatives);
+	pool = hlbvh_init_pool(n_primitives);
 	root = hlbvh_create(4, pool, centroids_prims, bounds_prims, &nodes_created,
 		n_primitives, ordered_prims);
 
@@ -888,7 +891,7 @@ clt_linear_bvh_create(long n_primitives, struct clt_linear_bvh_node **nodes_p,
 	nodes = (struct clt_linear_bvh_node*)bu_calloc(nodes_created, sizeof(*nodes),
 		"bvh create");
 	flatten_bvh_tree(&lnodes_created, nodes, nodes_created, root, 0);
-	bu_pool_delete(pool);
+	bu_arena_delete(pool);
 
 	if (RT_G_DEBUG&RT_DEBUG_CUT) {
 	    bu_log("HLBVH: %ld nodes, %ld primitives (%.2f KB)\n",
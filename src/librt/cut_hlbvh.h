@@ -36,11 +36,11 @@ struct bvh_flat_node {
 
 #ifndef HLBVH_IMPLEMENTATION
 
-extern struct bu_pool *
+extern struct bu_arena *
 hlbvh_init_pool(size_t n_primatives);
 
 extern struct bvh_build_node *
-hlbvh_create(long max_prims_in_node, struct bu_pool *pool, const fastf_t *centroids_prims,
+hlbvh_create(long max_prims_in_node, struct bu_arena *pool, const fastf_t *centroids_prims,
 	     const fastf_t *bounds_prims, long *total_nodes,
 	     const long n_primitives, long **ordered_prims);
 
@@ -410,6 +410,51 @@ db5_get_raw_internal_fp(struct db5_raw_internal *rip, FILE *fp)
 }
 
 
+int
+db5_uncompress_part(struct bu_external *dest, const struct bu_external *src, int zzz)
+{
+    BU_CK_EXTERNAL(src);
+    BU_EXTERNAL_INIT(dest);
+
+    switch (zzz) {
+	case DB5_ZZZ_LZ4:
+	    return rt_uncompress_external(dest, src);
+	default:
+	    bu_log("db5_uncompress_part: unsupported compression type %d\n", zzz);
+	    return -1;
+    }
+}
+
+
+/**
+ * Compress src with compression code zzz into a newly allocated dest.
+ * Returns 0 if dest holds the compressed form, or -1 if the code is
+ * not supported or compressing would not make the section smaller, in
+ * which case the caller stores src as is.
+ */
+static int
+db5_compress_part(struct bu_external *dest, const struct bu_external *src, int zzz)
+{
+    BU_EXTERNAL_INIT(dest);
+
+    switch (zzz) {
+	case DB5_ZZZ_LZ4:
+	    if (rt_compress_external(dest, src) < 0)
+		return -1;
+	    break;
+	default:
+	    bu_log("db5_compress_part: unsupported compression type %d, storing uncompressed\n", zzz);
+	    return -1;
+    }
+
+    if (dest->ext_nbytes >= src->ext_nbytes) {
+	bu_free_external(dest);
+	return -1;
+    }
+    return 0;
+}
+
+
 void
 db5_export_object3(
     struct bu_external *out,
@@ -429,6 +474,8 @@ db5_export_object3(
     size_t need;
     int h_width, n_width, a_width, b_width;
     long togo;
+    struct bu_external zattrib = BU_EXTERNAL_INIT_ZERO;
+    struct bu_external zbody = BU_EXTERNAL_INIT_ZERO;
 
     /*
      * First, compute an upper bound on the size buffer needed.
@@ -451,6 +498,12 @@ db5_export_object3(
     }
     if (attrib) {
 	BU_CK_EXTERNAL(attrib);
+	if (attrib->ext_nbytes > 0 && a_zzz != DB5_ZZZ_UNCOMPRESSED) {
+	    if (db5_compress_part(&zattrib, attrib, a_zzz) < 0)
+		a_zzz = DB5_ZZZ_UNCOMPRESSED;
+	    else
+		attrib = &zattrib;
+	}
 	if (attrib->ext_nbytes > 0) {
 	    a_width = db5_select_length_encoding(attrib->ext_nbytes);
 	    need += attrib->ext_nbytes + ENCODE_LEN(a_width);
@@ -461,8 +514,16 @@ db5_export_object3(
     } else {
 	a_width = 0;
     }
+    if (!attrib)
+	a_zzz = DB5_ZZZ_UNCOMPRESSED;
     if (body) {
 	BU_CK_EXTERNAL(body);
+	if (body->ext_nbytes > 0 && b_zzz != DB5_ZZZ_UNCOMPRESSED) {
+	    if (db5_compress_part(&zbody, body, b_zzz) < 0)
+		b_zzz = DB5_ZZZ_UNCOMPRESSED;
+	    else
+		body = &zbody;
+	}
 	if (body->ext_nbytes > 0) {
 	    b_width = db5_select_length_encoding(body->ext_nbytes);
 	    need += body->ext_nbytes + ENCODE_LEN(b_width);
@@ -473,6 +534,8 @@ db5_export_object3(
     } else {
 	b_width = 0;
     }
+    if (!body)
+	b_zzz = DB5_ZZZ_UNCOMPRESSED;
     need += 8;	/* pad and magic2 */
 
     /* Allocate the buffer for the combined external representation */
@@ -509,8 +572,6 @@ db5_export_object3(
     if (body) odp->db5h_bflags |= DB5HDR_BFLAGS_PRESENT;
     odp->db5h_bflags |= b_zzz & DB5HDR_BFLAGS_ZZZ_MASK;
 
-    if (a_zzz || b_zzz) bu_bomb("db5_export_object3: compression not supported yet\n");
-
     /* Object_Type */
     odp->db5h_major_type = major;
     odp->db5h_minor_type = minor;
@@ -560,6 +621,57 @@ db5_export_object3(
 
     out->ext_nbytes = togo;
     BU_ASSERT(out->ext_nbytes >= 8);
+
+    bu_free_external(&zattrib);
+    bu_free_external(&zbody);
+}
+
+
+int
+db5_compress_external(struct bu_external *out, const struct bu_external *in, int zzz)
+{
+    struct db5_raw_internal raw;
+    struct bu_external attrib = BU_EXTERNAL_INIT_ZERO;
+    struct bu_external body = BU_EXTERNAL_INIT_ZERO;
+    const struct bu_external *ap;
+    const struct bu_external *bp;
+
+    BU_CK_EXTERNAL(in);
+    BU_EXTERNAL_INIT(out);
+
+    if (db5_get_raw_internal_ptr(&raw, in->ext_buf) == NULL)
+	return -1;
+
+    /* only real objects carry sections worth compressing */
+    if (raw.h_dli != DB5HDR_HFLAGS_DLI_APPLICATION_DATA_OBJECT ||
+	(raw.a_zzz == zzz && raw.b_zzz == zzz)) {
+	bu_copy_external(out, in);
+	return 0;
+    }
+
+    ap = &raw.attributes;
+    if (raw.a_present && raw.a_zzz != DB5_ZZZ_UNCOMPRESSED) {
+	if (db5_uncompress_part(&attrib, &raw.attributes, raw.a_zzz) < 0)
+	    return -1;
+	ap = &attrib;
+    }
+    bp = &raw.body;
+    if (raw.b_present && raw.b_zzz != DB5_ZZZ_UNCOMPRESSED) {
+	if (db5_uncompress_part(&body, &raw.body, raw.b_zzz) < 0) {
+	    bu_free_external(&attrib);
+	    return -1;
+	}
+	bp = &body;
+    }
+
+    db5_export_object3(out, raw.h_dli,
+		       raw.h_name_present ? (const char *)raw.name.ext_buf : NULL,
+		       raw.h_name_hidden, ap, bp,
+		       raw.major_type, raw.minor_type, zzz, zzz);
+
+    bu_free_external(&attrib);
+    bu_free_external(&body);
+    return 0;
 }
 
 
@@ -716,6 +828,22 @@ db_wrap_v5_external(struct bu_external *ep, const char *name)
 
     /* See if name needs to be changed */
     if (raw.name.ext_buf == NULL || !BU_STR_EQUAL(name, (const char *)raw.name.ext_buf)) {
+	struct bu_external plain = BU_EXTERNAL_INIT_ZERO;
+	int a_zzz = raw.a_zzz;
+	int b_zzz = raw.b_zzz;
+
+	/* Compressed sections are expanded here and compressed again
+	 * by the export below.
+	 */
+	if (a_zzz || b_zzz) {
+	    if (db5_compress_external(&plain, ep, DB5_ZZZ_UNCOMPRESSED) < 0 ||
+		db5_get_raw_internal_ptr(&raw, plain.ext_buf) == NULL) {
+		bu_log("db_put_external5(%s) unable to expand compressed object\n", name);
+		bu_free_external(&plain);
+		return -1;
+	    }
+	}
+
 	/* Name needs to be changed.  Create new external form.
 	 * Make temporary copy so input isn't smashed
 	 * as new external object is constructed.
@@ -730,9 +858,10 @@ db_wrap_v5_external(struct bu_external *ep, const char *name)
 			   &raw.attributes,
 			   &raw.body,
 			   raw.major_type, raw.minor_type,
-			   raw.a_zzz, raw.b_zzz);
+			   a_zzz, b_zzz);
 	/* 'raw' is invalid now, 'ep' has new external form. */
 	bu_free_external(&tmp);
+	bu_free_external(&plain);
 	return 0;
     }
 
@@ -891,6 +1020,19 @@ rt_db_external5_to_internal5(
 
     BU_ASSERT(dbip->i->dbi_version == 5);
 
+    /* Import from the expanded form of a compressed object */
+    if (ep->ext_nbytes >= sizeof(struct db5_ondisk_header) && DB5_OBJECT_IS_COMPRESSED(ep->ext_buf)) {
+	struct bu_external plain;
+	if (db5_compress_external(&plain, ep, DB5_ZZZ_UNCOMPRESSED) < 0) {
+	    bu_log("rt_db_external5_to_internal5(%s):  unable to expand compressed object\n",
+		   name);
+	    return -3;
+	}
+	ret = rt_db_external5_to_internal5(ip, &plain, name, dbip, mat);
+	bu_free_external(&plain);
+	return ret;
+    }
+
     if (db5_get_raw_internal_ptr(&raw, ep->ext_buf) == NULL) {
 	bu_log("rt_db_external5_to_internal5(%s):  import failure\n",
 	       name);
@@ -995,11 +1137,12 @@ rt_db_get_internal5(
 
     BU_ASSERT(dbip->i->dbi_version == 5);
 
-    if (db_get_external(&ext, dp, dbip) < 0)
+    /* importers only read the external form, so use it in place */
+    if (db_borrow_external(&ext, dp, dbip) < 0)
 	return -2;		/* FAIL */
 
     ret = rt_db_external5_to_internal5(ip, &ext, dp->d_namep, dbip, mat);
-    bu_free_external(&ext);
+    db_release_external(&ext, dbip);
     return ret;
 }
 
@@ -274,20 +274,32 @@ db5_diradd(struct db_i *dbip,
 	case DB5_MAJORTYPE_BRLCAD:
 	    if (rip->minor_type == ID_COMBINATION) {
 		struct bu_attribute_value_set avs;
+		struct bu_external attrib = BU_EXTERNAL_INIT_ZERO;
+		const struct bu_external *ap = &rip->attributes;
 
 		bu_avs_init_empty(&avs);
 
 		dp->d_flags = RT_DIR_COMB;
 		if (rip->attributes.ext_nbytes == 0) break;
+		if (rip->a_zzz != DB5_ZZZ_UNCOMPRESSED) {
+		    if (db5_uncompress_part(&attrib, &rip->attributes, rip->a_zzz) < 0) {
+			bu_log("db5_diradd_handler: Bad compressed attributes on combination '%s'\n",
+			       rip->name.ext_buf);
+			break;
+		    }
+		    ap = &attrib;
+		}
 		/*
 		 * Crack open the attributes to
 		 * check for the "region=" attribute.
 		 */
-		if (db5_import_attributes(&avs, &rip->attributes) < 0) {
+		if (db5_import_attributes(&avs, ap) < 0) {
 		    bu_log("db5_diradd_handler: Bad attributes on combination '%s'\n",
 			   rip->name.ext_buf);
+		    bu_free_external(&attrib);
 		    break;
 		}
+		bu_free_external(&attrib);
 		if (bu_avs_get(&avs, "region") != NULL)
 		    dp->d_flags = RT_DIR_COMB|RT_DIR_REGION;
 		bu_avs_free(&avs);
@@ -85,6 +85,18 @@ db_get_external_reuse(struct bu_external *ep, const struct directory *dp, const
     return 0;
 }
 
+/* If the body is compressed, expand it into zbody and point raw->body there */
+static int
+_db5_plain_body(struct db5_raw_internal *raw, struct bu_external *zbody)
+{
+    if (raw->b_zzz == DB5_ZZZ_UNCOMPRESSED)
+	return 0;
+    if (db5_uncompress_part(zbody, &raw->body, raw->b_zzz) < 0)
+	return -1;
+    raw->body = *zbody;	/* struct copy, zbody still owns the buffer */
+    return 0;
+}
+
 // TODO - figure out what to do about submodel...
 #define DB5COMB_TOKEN_LEAF 1
 static int
@@ -96,6 +108,7 @@ _db5_children(
        	struct directory ***children)
 {
     struct db5_raw_internal raw;
+    struct bu_external zbody = BU_EXTERNAL_INIT_ZERO;
     struct directory **c = NULL;
     int dpcnt = 0;
 
@@ -113,7 +126,7 @@ _db5_children(
 	    if (db_get_external_reuse(ext, dp, dbip) < 0) return 0;
 	}
 	if (db5_get_raw_internal_ptr(&raw, ext->ext_buf) == NULL) return 0;
-	if (!raw.body.ext_buf) return 0;
+	if (!raw.body.ext_buf || _db5_plain_body(&raw, &zbody) < 0) return 0;
 
 	//bu_log("children of: %s\n", dp->d_namep);
 
@@ -171,6 +184,7 @@ _db5_children(
 	    c[dpcnt] = RT_DIR_NULL;
 	    (*children) = c;
 	}
+	bu_free_external(&zbody);
 	return dpcnt;
 
     } else  if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_EXTRUDE || dp->d_minor_type == DB5_MINORTYPE_BRLCAD_REVOLVE) {
@@ -182,7 +196,7 @@ _db5_children(
 	    if (db_get_external_reuse(ext, dp, dbip) < 0) return 0;
 	}
 	if (db5_get_raw_internal_ptr(&raw, ext->ext_buf) == NULL) return 0;
-	if (!raw.body.ext_buf) return 0;
+	if (!raw.body.ext_buf || _db5_plain_body(&raw, &zbody) < 0) return 0;
 
 	ptr = (unsigned char *)raw.body.ext_buf;
 	if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_EXTRUDE) {
@@ -191,7 +205,10 @@ _db5_children(
 	if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_REVOLVE) {
 	    sketch_name = (char *)ptr + (ELEMENTS_PER_VECT*3 + 1)*SIZEOF_NETWORK_DOUBLE;
 	}
-	if (!sketch_name) return 0;
+	if (!sketch_name) {
+	    bu_free_external(&zbody);
+	    return 0;
+	}
 
 	if (db_lookup(dbip, sketch_name, LOOKUP_QUIET) != RT_DIR_NULL) {
 	    c = (struct directory **)bu_calloc(dpcnt + 1, sizeof(struct directory *), "children");
@@ -199,6 +216,7 @@ _db5_children(
 	    c[1] = RT_DIR_NULL;
 	    dpcnt++;
 	}
+	bu_free_external(&zbody);
 	return dpcnt;
     } else if (dp->d_minor_type ==  DB5_MINORTYPE_BRLCAD_DSP) {
 	struct directory *ndp = RT_DIR_NULL;
@@ -209,7 +227,7 @@ _db5_children(
 	    if (db_get_external_reuse(ext, dp, dbip) < 0) return 0;
 	}
 	if (db5_get_raw_internal_ptr(&raw, ext->ext_buf) == NULL) return 0;
-	if (!raw.body.ext_buf) return 0;
+	if (!raw.body.ext_buf || _db5_plain_body(&raw, &zbody) < 0) return 0;
 
 	cp = (unsigned char *)raw.body.ext_buf;
 	cp += 2*SIZEOF_NETWORK_LONG + SIZEOF_NETWORK_DOUBLE * ELEMENTS_PER_MAT + SIZEOF_NETWORK_SHORT;
@@ -236,6 +254,7 @@ _db5_children(
 	    c[1] = RT_DIR_NULL;
 	    dpcnt++;
 	}
+	bu_free_external(&zbody);
 	return dpcnt;
     }
 
@@ -28,6 +28,7 @@
 #include "common.h"
 
 #include <string.h>
+#include <errno.h>
 #ifdef HAVE_SYS_TYPES_H
 #  include <sys/types.h>
 #endif
@@ -46,7 +47,10 @@
 /**
  * Reads 'count' bytes at file offset 'offset' into buffer at 'addr'.
  * A wrapper for the UNIX read() sys-call that takes into account
- * syscall semaphores, stdio-only machines, and in-memory buffering.
+ * stdio-only machines and in-memory buffering.  Where pread() is
+ * available it is used so that concurrent reads don't serialize on a
+ * shared file position; otherwise the seek and read are done under
+ * the syscall semaphore.
  *
  * Returns -
  * 0 OK
@@ -58,7 +62,9 @@ db_read(const struct db_i *dbip, void *addr, size_t count, b_off_t offset)
 /* byte offset from start of file */
 {
     size_t got;
+#ifndef HAVE_PREAD
     int ret;
+#endif
 
     RT_CK_DBI(dbip);
 
@@ -81,6 +87,23 @@ db_read(const struct db_i *dbip, void *addr, size_t count, b_off_t offset)
 	memcpy(addr, ((char *)dbip->i->dbi_inmem) + offset, count);
 	return 0;
     }
+
+#ifdef HAVE_PREAD
+    /* db_write() has always fflush()ed each write, so reading the
+     * descriptor directly sees everything written through stdio */
+    {
+	int fd = fileno(dbip->i->dbi_fp);
+	got = 0;
+	while (got < count) {
+	    ssize_t n = pread(fd, (char *)addr + got, count - got, (off_t)(offset + got));
+	    if (n < 0 && errno == EINTR)
+		continue;
+	    if (n <= 0)
+		break;
+	    got += (size_t)n;
+	}
+    }
+#else
     bu_semaphore_acquire(BU_SEM_SYSCALL);
 
     ret = bu_fseek(dbip->i->dbi_fp, offset, 0);
@@ -89,6 +112,7 @@ db_read(const struct db_i *dbip, void *addr, size_t count, b_off_t offset)
     got = (size_t)fread(addr, 1, count, dbip->i->dbi_fp);
 
     bu_semaphore_release(BU_SEM_SYSCALL);
+#endif
 
     if (got != count) {
 	perror(dbip->dbi_filename);
@@ -275,19 +299,84 @@ db_get_external(register struct bu_external *ep, const struct directory *dp, con
 
     if (dp->d_flags & RT_DIR_INMEM) {
 	memcpy((char *)ep->ext_buf, dp->d_un.ptr, ep->ext_nbytes);
-	return 0;
-    }
-
-    if (db_read(dbip, (char *)ep->ext_buf, ep->ext_nbytes, dp->d_addr) < 0) {
+    } else if (db_read(dbip, (char *)ep->ext_buf, ep->ext_nbytes, dp->d_addr) < 0) {
 	bu_free(ep->ext_buf, "db_get_ext ext_buf");
 	ep->ext_buf = (uint8_t *)NULL;
 	ep->ext_nbytes = 0;
 	return -1;	/* VERY BAD */
     }
+
+    /* Callers get compressed v5 objects in their plain form */
+    if (db_version(dbip) >= 5 && ep->ext_nbytes >= sizeof(struct db5_ondisk_header)
+	&& DB5_OBJECT_IS_COMPRESSED(ep->ext_buf)) {
+	struct bu_external plain;
+	int ret = db5_compress_external(&plain, ep, DB5_ZZZ_UNCOMPRESSED);
+	bu_free_external(ep);
+	if (ret < 0) {
+	    bu_log("db_get_external(%s): unable to expand compressed object\n", dp->d_namep);
+	    ep->ext_nbytes = 0;
+	    return -1;
+	}
+	*ep = plain;	/* struct copy */
+    }
     return 0;
 }
 
 
+int
+db_borrow_external(struct bu_external *ep, const struct directory *dp, const struct db_i *dbip)
+{
+    size_t nbytes;
+
+    RT_CK_DBI(dbip);
+    RT_CK_DIR(dp);
+
+    /* only a mapped database can lend out its bytes; it is never
+     * written to, so they stay put until it is closed */
+    if (!dbip->i->dbi_inmem || (dp->d_flags & RT_DIR_INMEM) || dp->d_addr == RT_DIR_PHONY_ADDR)
+	return db_get_external(ep, dp, dbip);
+
+    if (db_version(dbip) < 5)
+	nbytes = dp->d_len * sizeof(union record);
+    else
+	nbytes = dp->d_len;
+    if (dp->d_addr < 0 || nbytes == 0 || dp->d_addr + nbytes > (size_t)dbip->i->dbi_eof)
+	return db_get_external(ep, dp, dbip);
+
+    /* compressed objects have to be expanded into a buffer of their own */
+    if (db_version(dbip) >= 5 && nbytes >= sizeof(struct db5_ondisk_header)
+	&& DB5_OBJECT_IS_COMPRESSED((const uint8_t *)dbip->i->dbi_inmem + dp->d_addr))
+	return db_get_external(ep, dp, dbip);
+
+    if (RT_G_DEBUG&RT_DEBUG_DB) bu_log("db_borrow_external(%s) ep=%p, dbip=%p, dp=%p\n",
+				    dp->d_namep, (void *)ep, (void *)dbip, (void *)dp);
+
+    BU_EXTERNAL_INIT(ep);
+    ep->ext_nbytes = nbytes;
+    ep->ext_buf = (uint8_t *)dbip->i->dbi_inmem + dp->d_addr;
+    return 0;
+}
+
+
+void
+db_release_external(struct bu_external *ep, const struct db_i *dbip)
+{
+    const uint8_t *base;
+
+    BU_CK_EXTERNAL(ep);
+    RT_CK_DBI(dbip);
+
+    base = (const uint8_t *)dbip->i->dbi_inmem;
+    if (base && ep->ext_buf >= base && ep->ext_buf < base + dbip->i->dbi_eof) {
+	/* borrowed, nothing to free */
+	ep->ext_buf = NULL;
+	ep->ext_nbytes = 0;
+	return;
+    }
+    bu_free_external(ep);
+}
+
+
 int
 db_put_external(struct bu_external *ep, struct directory *dp, struct db_i *dbip)
 {
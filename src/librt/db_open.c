@@ -90,6 +90,7 @@ db_open(const char *name, const char *mode)
 	RT_SEM_TREE2 = bu_semaphore_register("RT_SEM_TREE2");
     if (!RT_SEM_TREE3)
 	RT_SEM_TREE3 = bu_semaphore_register("RT_SEM_TREE3");
+    rt_tree_semaphores_init();
 
     if (name == NULL)
 	return DBI_NULL;
@@ -461,6 +462,7 @@ db_close(register struct db_i *dbip)
     dbip->i->dbi_inmem = NULL;		/* sanity */
 
     bu_ptbl_free(&dbip->i->dbi_clients);
+    db_search_index_free(dbip);
     if (BU_PTBL_IS_INITIALIZED(&dbip->i->dbi_changed_clbks))
 	bu_ptbl_free(&dbip->i->dbi_changed_clbks);
     if (BU_PTBL_IS_INITIALIZED(&dbip->i->dbi_update_nref_clbks))
@@ -632,6 +634,7 @@ db_i_internal_create(void)
     i->dbi_magic = DBI_MAGIC;
     i->material_head = MATER_NULL;
     i->dbi_directory_hd = NULL;
+    i->dbi_search_index = NULL;
     bu_ptbl_init(&i->dbi_directory_blocks, 8, "dbi_directory_blocks");
 
     return i;
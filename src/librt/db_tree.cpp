@@ -28,8 +28,10 @@
 
 #include "common.h"
 
+#include <deque>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <math.h>
 #include <string.h>
@@ -39,6 +41,7 @@
 
 #include "bu/parallel.h"
 #include "bu/path.h"
+#include "bu/snooze.h"
 #include "vmath.h"
 #include "bn.h"
 #include "nmg.h"
@@ -1831,6 +1834,177 @@ _db_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
 }
 
 
+/*
+ * Parallel region discovery.
+ *
+ * The first pass of db_walk_tree() walks the combination hierarchy
+ * above the regions.  Rather than one serial db_recurse(), member
+ * references found under a boolean node are queued as tasks, and
+ * worker threads expand them concurrently, each task queueing the
+ * members it finds in turn.  Every thread owns a deque: it takes work
+ * from the back of its own and, when that is empty, steals from the
+ * front of another's, so that deep subtrees stay on one thread while
+ * wide levels spread out.
+ *
+ * A task grafts its result into the very OP_DB_LEAF node it was
+ * queued for, so the finished tree has exactly the shape the serial
+ * walk produces and region ordering does not depend on scheduling.
+ * Only leaves hanging off a binary node are queued; such nodes never
+ * move while a graft above them copies the parent's node.
+ */
+struct db_walk_expand_task {
+    union tree *tp;			/* OP_DB_LEAF to replace */
+    struct db_tree_state ts;		/* state for the member */
+    struct db_full_path path;		/* path down to the member */
+};
+
+struct db_walk_expand {
+    uint32_t magic;
+    std::vector<std::deque<struct db_walk_expand_task *> > queues;
+    size_t queued;			/* tasks waiting in queues, semaphored */
+    size_t pending;			/* tasks waiting or running, semaphored */
+    int (*reg_start_func)(struct db_tree_state *, const struct db_full_path *, const struct rt_comb_internal *, void *);
+    void *client_data;
+};
+#define DB_WALK_EXPAND_MAGIC 0x64776578	/* dwex */
+#define DB_CK_WX(_p) BU_CKMAG(_p, DB_WALK_EXPAND_MAGIC, "db_walk_expand")
+
+/* Serializes the caller's region start function, which has never
+ * been required to be thread-safe.
+ */
+static int db_walk_start_sem = 0;
+
+static union tree *_db_recurse_old(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data, struct db_walk_expand *wx);
+
+
+static void
+_db_walk_expand_defer(struct db_walk_expand *wx, union tree *tp, const struct db_tree_state *tsp, const struct db_full_path *pathp)
+{
+    struct db_walk_expand_task *task;
+    size_t q;
+
+    DB_CK_WX(wx);
+    BU_ALLOC(task, struct db_walk_expand_task);
+    task->tp = tp;
+    db_dup_db_tree_state(&task->ts, tsp);
+    db_full_path_init(&task->path);
+    db_dup_full_path(&task->path, pathp);
+
+    q = (size_t)bu_parallel_id() % wx->queues.size();
+    bu_semaphore_acquire(RT_SEM_WORKER);
+    wx->queues[q].push_back(task);
+    wx->queued++;
+    wx->pending++;
+    bu_semaphore_release(RT_SEM_WORKER);
+}
+
+
+/* In parallel mode the region start callback sees a wrapped client_data */
+static int
+_db_walk_expand_region_start(struct db_tree_state *tsp, const struct db_full_path *pathp, const struct rt_comb_internal *combp, void *client_data)
+{
+    struct db_walk_expand *wx = (struct db_walk_expand *)client_data;
+    int ret;
+
+    DB_CK_WX(wx);
+    bu_semaphore_acquire(db_walk_start_sem);
+    ret = wx->reg_start_func(tsp, pathp, combp, wx->client_data);
+    bu_semaphore_release(db_walk_start_sem);
+    return ret;
+}
+
+
+static void
+_db_walk_expand_run(struct db_walk_expand *wx, struct db_walk_expand_task *task)
+{
+    struct combined_tree_state *region_start_statep = (struct combined_tree_state *)0;
+    union tree *tp = task->tp;
+    union tree *subtree;
+
+    subtree = _db_recurse_old(&task->ts, &task->path, &region_start_statep, (void *)wx, wx);
+    if (region_start_statep)
+	db_free_combined_tree_state(region_start_statep);
+
+    RT_CK_TREE(tp);
+    if (subtree != TREE_NULL) {
+	union tree *tmp;
+
+	/* graft subtree on in place of 'tp' leaf node */
+	BU_GET(tmp, union tree);
+	RT_TREE_INIT(tmp);
+	RT_CK_TREE(subtree);
+	*tmp = *tp;	/* struct copy */
+	*tp = *subtree;	/* struct copy */
+	BU_PUT(subtree, union tree);
+	db_free_tree(tmp);
+    } else {
+	/* Processing of this leaf failed, NOP it out. */
+	if (tp->tr_l.tl_mat) {
+	    bu_free((char *)tp->tr_l.tl_mat, "tl_mat");
+	    tp->tr_l.tl_mat = NULL;
+	}
+	bu_free(tp->tr_l.tl_name, "tl_name");
+	tp->tr_l.tl_name = NULL;
+	tp->tr_op = OP_NOP;
+    }
+
+    db_free_db_tree_state(&task->ts);
+    db_free_full_path(&task->path);
+    bu_free(task, "db_walk_expand_task");
+}
+
+
+static void
+_db_walk_expander(int UNUSED(cpu), void *arg)
+{
+    struct db_walk_expand *wx = (struct db_walk_expand *)arg;
+    size_t nq, self, i;
+
+    DB_CK_WX(wx);
+    nq = wx->queues.size();
+    self = (size_t)bu_parallel_id() % nq;
+
+    while (1) {
+	struct db_walk_expand_task *task = NULL;
+	int done = 0;
+
+	bu_semaphore_acquire(RT_SEM_WORKER);
+	if (!wx->queues[self].empty()) {
+	    task = wx->queues[self].back();
+	    wx->queues[self].pop_back();
+	} else if (wx->queued) {
+	    for (i = 1; i < nq; i++) {
+		std::deque<struct db_walk_expand_task *> &victim = wx->queues[(self + i) % nq];
+		if (!victim.empty()) {
+		    task = victim.front();
+		    victim.pop_front();
+		    break;
+		}
+	    }
+	}
+	if (task)
+	    wx->queued--;
+	else if (!wx->pending)
+	    done = 1;
+	bu_semaphore_release(RT_SEM_WORKER);
+
+	if (done)
+	    break;
+	if (!task) {
+	    /* Others are still expanding; more work may appear */
+	    bu_snooze(50);
+	    continue;
+	}
+
+	_db_walk_expand_run(wx, task);
+
+	bu_semaphore_acquire(RT_SEM_WORKER);
+	wx->pending--;
+	bu_semaphore_release(RT_SEM_WORKER);
+    }
+}
+
+
 struct db_walk_parallel_state {
     uint32_t magic;
     union tree **reg_trees;
@@ -2047,11 +2221,30 @@ db_walk_tree(struct db_i *dbip,
     int something_not_found = 0;
     union tree **reg_trees;	/* (*reg_trees)[] */
     struct db_walk_parallel_state wps;
+    struct db_walk_expand *wx = NULL;
     struct resource *resp;
 
     RT_CK_DBTS(init_state);
     RT_CHECK_DBI(dbip);
 
+    /* Comb instance numbering depends on visiting order, so that mode
+     * keeps the serial first pass.
+     */
+    if (ncpu != 1 && !dbip->i->dbi_use_comb_instance_ids) {
+	size_t nq = (ncpu > 0) ? (size_t)ncpu : bu_avail_cpus();
+
+	if (!db_walk_start_sem)
+	    db_walk_start_sem = bu_semaphore_register("RT_SEM_WALK_START");
+
+	wx = new db_walk_expand;
+	wx->magic = DB_WALK_EXPAND_MAGIC;
+	wx->queues.resize(nq > 0 ? nq : 1);
+	wx->queued = 0;
+	wx->pending = 0;
+	wx->reg_start_func = reg_start_func;
+	wx->client_data = client_data;
+    }
+
     if (init_state->ts_rtip == NULL || ncpu == 1) {
 	resp = &rt_uniresource;
     } else {
@@ -2100,6 +2293,11 @@ db_walk_tree(struct db_i *dbip,
 	if (UNLIKELY(dbip->i->dbi_use_comb_instance_ids)) {
 	    std::unordered_map<std::string, int> c_inst_map;
 	    curtree = db_recurse2(&ts, &path, &region_start_statep, client_data, (void *)&c_inst_map);
+	} else if (wx) {
+	    /* Expands this level only; members are queued on wx */
+	    if (reg_start_func)
+		ts.ts_region_start_func = _db_walk_expand_region_start;
+	    curtree = _db_recurse_old(&ts, &path, &region_start_statep, (void *)wx, wx);
 	} else {
 	    curtree = db_recurse(&ts, &path, &region_start_statep, client_data);
 	}
@@ -2110,7 +2308,7 @@ db_walk_tree(struct db_i *dbip,
 	    continue;	/* ERROR */
 
 	RT_CK_TREE(curtree);
-	if (RT_G_DEBUG&RT_DEBUG_TREEWALK) {
+	if (!wx && RT_G_DEBUG&RT_DEBUG_TREEWALK) {
 	    bu_log("tree after db_recurse():\n");
 	    rt_pr_tree(curtree, 0);
 	}
@@ -2129,6 +2327,19 @@ db_walk_tree(struct db_i *dbip,
 	}
     }
 
+    if (wx) {
+	/* Finish the region discovery started above */
+	if (wx->pending)
+	    bu_parallel(_db_walk_expander, ncpu, (void *)wx);
+	delete wx;
+	wx = NULL;
+
+	if (whole_tree != TREE_NULL && RT_G_DEBUG&RT_DEBUG_TREEWALK) {
+	    bu_log("tree after parallel db_recurse():\n");
+	    rt_pr_tree(whole_tree, 0);
+	}
+    }
+
     if (whole_tree == TREE_NULL)
 	return -1;	/* ERROR, nothing worked */
 
@@ -2831,9 +3042,13 @@ db_apply_state_from_one_member(
 
 /**
  * Helper routine for db_recurse()
+ *
+ * With a non-null wx, member references below a boolean node
+ * (defer_ok) are queued for parallel expansion instead of being
+ * recursed into here.
  */
 static void
-_db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data)
+_db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data, struct db_walk_expand *wx, int defer_ok)
 {
     struct db_tree_state memb_state;
     union tree *subtree;
@@ -2880,8 +3095,14 @@ _db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_ful
 		goto out;
 	    }
 
+	    if (wx && defer_ok) {
+		_db_walk_expand_defer(wx, tp, &memb_state, pathp);
+		DB_FULL_PATH_POP(pathp);
+		break;
+	    }
+
 	    /* Recursive call */
-	    if ((subtree = db_recurse(&memb_state, pathp, region_start_statepp, client_data)) != TREE_NULL) {
+	    if ((subtree = _db_recurse_old(&memb_state, pathp, region_start_statepp, client_data, wx)) != TREE_NULL) {
 		union tree *tmp;
 
 		/* graft subtree on in place of 'tp' leaf node */
@@ -2912,12 +3133,12 @@ _db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_ful
 	case OP_INTERSECT:
 	case OP_SUBTRACT:
 	case OP_XOR:
-	    _db_recurse_subtree_old(tp->tr_b.tb_left, &memb_state, pathp, region_start_statepp, client_data);
+	    _db_recurse_subtree_old(tp->tr_b.tb_left, &memb_state, pathp, region_start_statepp, client_data, wx, 1);
 	    if (tp->tr_op == OP_SUBTRACT)
 		memb_state.ts_sofar |= TS_SOFAR_MINUS;
 	    else if (tp->tr_op == OP_INTERSECT)
 		memb_state.ts_sofar |= TS_SOFAR_INTER;
-	    _db_recurse_subtree_old(tp->tr_b.tb_right, &memb_state, pathp, region_start_statepp, client_data);
+	    _db_recurse_subtree_old(tp->tr_b.tb_right, &memb_state, pathp, region_start_statepp, client_data, wx, 1);
 	    break;
 
 	default:
@@ -2930,8 +3151,8 @@ out:
     return;
 }
 
-union tree *
-db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data)
+static union tree *
+_db_recurse_old(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data, struct db_walk_expand *wx)
 {
     struct directory *dp;
     struct rt_db_internal intern;
@@ -3043,7 +3264,7 @@ db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combine
 	    rt_db_free_internal(&intern);
 	    comb = NULL;
 
-	    _db_recurse_subtree_old(curtree, &nts, pathp, region_start_statepp, client_data);
+	    _db_recurse_subtree_old(curtree, &nts, pathp, region_start_statepp, client_data, wx, 0);
 	    if (curtree)
 		RT_CK_TREE(curtree);
 	} else {
@@ -3151,6 +3372,13 @@ out:
 }
 
 
+union tree *
+db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data)
+{
+    return _db_recurse_old(tsp, pathp, region_start_statepp, client_data, NULL);
+}
+
+
 /** @} */
 
 
@@ -0,0 +1,478 @@
+/*                      I N S T A N C E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup ray */
+/** @{ */
+/** @file librt/instance.c
+ *
+ * Instanced primitives.
+ *
+ * When the same primitive is placed many times under different
+ * matrices (fasteners, track links, tree submodels), every placement
+ * normally gets its own soltab, prepped in model space.  For the
+ * heavier primitive types this module instead preps one "master"
+ * soltab per directory entry in the primitive's own coordinate frame,
+ * and gives each placement a light-weight instance soltab that holds
+ * only the placement matrix, its inverse and a world-space bounding
+ * box.  The instance's methods map the ray into the master's frame,
+ * call the master's methods, and map the results back.
+ *
+ * Only proper similarity transforms (rotation, translation and
+ * uniform scale) are instanced, so that distances along the ray scale
+ * by a single constant.  Reflections are left to ordinary prep, which
+ * sees the reversed winding of oriented faces that the master, in its
+ * own frame, would not.  Instances are filed under ID_NULL in the
+ * per-type solid tables, since their st_specific is not the private
+ * structure of their st_id.
+ */
+
+#include "common.h"
+
+#include <math.h>
+
+#include "vmath.h"
+#include "bu/hash.h"
+#include "bu/parallel.h"
+#include "raytrace.h"
+#include "librt_private.h"
+#include "cache.h"
+
+
+struct instance_specific {
+    struct soltab *inst_master;	/**< @brief prepped in its own frame */
+    mat_t inst_inv;		/**< @brief model space to master frame */
+    fastf_t inst_scale;		/**< @brief model distance per master distance */
+};
+
+
+/**
+ * Primitive types worth instancing: their prep is expensive or their
+ * prepped form is large compared to the cost of transforming a ray.
+ * Types whose private data is read by code outside their own methods
+ * (half, rec, particle, dsp) or which are infinite are left out.
+ */
+static int
+instance_type_ok(int type)
+{
+    switch (type) {
+	case ID_BOT:
+	case ID_ARS:
+	case ID_NMG:
+	case ID_BREP:
+	case ID_ARBN:
+	case ID_PIPE:
+	case ID_EXTRUDE:
+	case ID_REVOLVE:
+	case ID_EBM:
+	case ID_VOL:
+	case ID_METABALL:
+	    return 1;
+	default:
+	    return 0;
+    }
+}
+
+
+/**
+ * Test that mat is a similarity transform without a reflection and
+ * return its scale.
+ */
+static int
+instance_mat_ok(const mat_t mat, fastf_t *scale, const struct bn_tol *tol)
+{
+    vect_t col[3];
+    vect_t cross;
+    fastf_t s;
+    int i;
+
+    if (!ZERO(mat[12]) || !ZERO(mat[13]) || !ZERO(mat[14]) || mat[15] < SMALL_FASTF)
+	return 0;
+
+    for (i = 0; i < 3; i++)
+	VSET(col[i], mat[i], mat[4+i], mat[8+i]);
+
+    s = MAGNITUDE(col[0]);
+    if (s < SMALL_FASTF)
+	return 0;
+    for (i = 1; i < 3; i++) {
+	if (fabs(MAGNITUDE(col[i]) / s - 1.0) > tol->perp)
+	    return 0;
+    }
+    if (fabs(VDOT(col[0], col[1])) > tol->perp * s * s
+	|| fabs(VDOT(col[0], col[2])) > tol->perp * s * s
+	|| fabs(VDOT(col[1], col[2])) > tol->perp * s * s)
+	return 0;
+    VCROSS(cross, col[0], col[1]);
+    if (VDOT(cross, col[2]) < 0.0)
+	return 0;
+
+    *scale = s / mat[15];
+    return 1;
+}
+
+
+static void
+instance_ray(const struct instance_specific *isp, const struct xray *rp, struct xray *lrp)
+{
+    lrp->magic = RT_RAY_MAGIC;
+    lrp->index = rp->index;
+    MAT4X3PNT(lrp->r_pt, isp->inst_inv, rp->r_pt);
+    /* inst_inv shrinks every vector by 1/inst_scale, so this is unit */
+    MAT4X3VEC(lrp->r_dir, isp->inst_inv, rp->r_dir);
+    VSCALE(lrp->r_dir, lrp->r_dir, isp->inst_scale);
+    lrp->r_min = rp->r_min / isp->inst_scale;
+    lrp->r_max = rp->r_max / isp->inst_scale;
+}
+
+
+/* Move a hit that has model-space point and normal into the master's frame. */
+static void
+instance_hit_to_local(const struct instance_specific *isp, struct hit *hitp)
+{
+    point_t pt;
+    vect_t n;
+
+    hitp->hit_dist /= isp->inst_scale;
+    MAT4X3PNT(pt, isp->inst_inv, hitp->hit_point);
+    VMOVE(hitp->hit_point, pt);
+    MAT4X3VEC(n, isp->inst_inv, hitp->hit_normal);
+    VSCALE(hitp->hit_normal, n, isp->inst_scale);
+}
+
+
+static int
+instance_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *mstp = isp->inst_master;
+    struct xray lray;
+    struct seg *last;
+    struct seg *segp;
+    int ret;
+
+    instance_ray(isp, rp, &lray);
+
+    /* The master appends to seghead; everything after "last" is new */
+    last = BU_LIST_LAST(seg, &(seghead->l));
+    ret = mstp->st_meth->ft_shot(mstp, &lray, ap, seghead);
+    if (ret <= 0)
+	return ret;
+
+    for (segp = BU_LIST_NEXT(seg, &(last->l));
+	 BU_LIST_NOT_HEAD(segp, &(seghead->l));
+	 segp = BU_LIST_NEXT(seg, &(segp->l))) {
+	segp->seg_stp = stp;
+	segp->seg_in.hit_dist *= isp->inst_scale;
+	segp->seg_out.hit_dist *= isp->inst_scale;
+    }
+    return ret;
+}
+
+
+static void
+instance_norm(struct hit *hitp, struct soltab *stp, struct xray *rp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *mstp = isp->inst_master;
+    struct xray lray;
+    fastf_t dist = hitp->hit_dist;
+    point_t pt;
+    vect_t n;
+
+    if (!mstp->st_meth->ft_norm)
+	return;
+
+    instance_ray(isp, rp, &lray);
+    hitp->hit_dist = dist / isp->inst_scale;
+    mstp->st_meth->ft_norm(hitp, mstp, &lray);
+    hitp->hit_dist = dist;
+
+    MAT4X3PNT(pt, stp->st_matp, hitp->hit_point);
+    VMOVE(hitp->hit_point, pt);
+    MAT4X3VEC(n, stp->st_matp, hitp->hit_normal);
+    VUNITIZE(n);
+    VMOVE(hitp->hit_normal, n);
+}
+
+
+static void
+instance_curve(struct curvature *cvp, struct hit *hitp, struct soltab *stp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *mstp = isp->inst_master;
+    struct hit saved = *hitp;
+    vect_t pdir;
+
+    if (!mstp->st_meth->ft_curve) {
+	/* same default as a primitive without a curvature method */
+	bn_vec_ortho(cvp->crv_pdir, hitp->hit_normal);
+	cvp->crv_c1 = cvp->crv_c2 = 0;
+	return;
+    }
+
+    instance_hit_to_local(isp, hitp);
+    mstp->st_meth->ft_curve(cvp, hitp, mstp);
+    *hitp = saved;
+
+    MAT4X3VEC(pdir, stp->st_matp, cvp->crv_pdir);
+    VUNITIZE(pdir);
+    VMOVE(cvp->crv_pdir, pdir);
+    cvp->crv_c1 /= isp->inst_scale;
+    cvp->crv_c2 /= isp->inst_scale;
+}
+
+
+static void
+instance_uv(struct application *ap, struct soltab *stp, struct hit *hitp, struct uvcoord *uvp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *mstp = isp->inst_master;
+    struct hit saved = *hitp;
+
+    if (!mstp->st_meth->ft_uv)
+	return;
+
+    instance_hit_to_local(isp, hitp);
+    mstp->st_meth->ft_uv(ap, mstp, hitp, uvp);
+    *hitp = saved;
+}
+
+
+static void
+instance_print(const struct soltab *stp)
+{
+    const struct instance_specific *isp = (const struct instance_specific *)stp->st_specific;
+
+    bu_log("instance of %s (scale %g)\n", isp->inst_master->st_meth->ft_name, isp->inst_scale);
+    bn_mat_print("model to primitive", isp->inst_inv);
+    if (isp->inst_master->st_meth->ft_print)
+	isp->inst_master->st_meth->ft_print(isp->inst_master);
+}
+
+
+static void
+instance_master_put(struct rt_i *rtip, struct soltab *mstp)
+{
+    const struct directory *dp = mstp->st_dp;
+
+    bu_semaphore_acquire(RT_SEM_MODEL);
+    if (--mstp->st_uses > 0) {
+	bu_semaphore_release(RT_SEM_MODEL);
+	return;
+    }
+    if (rtip->i->rti_inst_masters)
+	bu_hash_rm(rtip->i->rti_inst_masters, (const uint8_t *)&dp, sizeof(dp));
+    bu_semaphore_release(RT_SEM_MODEL);
+
+    if (mstp->st_aradius > 0 && mstp->st_meth->ft_free)
+	mstp->st_meth->ft_free(mstp);
+    bu_ptbl_free(&mstp->st_regions);
+    bu_free(mstp, "instance master soltab");
+}
+
+
+static void
+instance_free(struct soltab *stp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+
+    if (!isp)
+	return;
+    instance_master_put(stp->st_rtip, isp->inst_master);
+    BU_PUT(isp, struct instance_specific);
+    stp->st_specific = NULL;
+}
+
+
+const struct rt_functab rt_instance_functab = {
+    .magic = RT_FUNCTAB_MAGIC,
+    .ft_name = "ID_INSTANCE",
+    .ft_label = "instance",
+    .ft_use_rpp = 1,
+    .ft_shot = instance_shot,
+    .ft_print = instance_print,
+    .ft_norm = instance_norm,
+    .ft_uv = instance_uv,
+    .ft_curve = instance_curve,
+    .ft_free = instance_free
+};
+
+
+/**
+ * Find or create the master soltab for dp, taking a reference on it.
+ * The master is prepped from the unplaced (identity matrix) internal
+ * form, outside of any lock; if two threads race to create the same
+ * master the loser's copy is thrown away.
+ */
+static struct soltab *
+instance_master_get(struct rt_i *rtip, struct directory *dp, struct rt_cache *cache)
+{
+    struct rt_db_internal intern;
+    struct soltab *mstp;
+    struct soltab *other;
+    int ret;
+
+    bu_semaphore_acquire(RT_SEM_MODEL);
+    if (!rtip->i->rti_inst_masters)
+	rtip->i->rti_inst_masters = bu_hash_create(64);
+    mstp = (struct soltab *)bu_hash_get(rtip->i->rti_inst_masters, (const uint8_t *)&dp, sizeof(dp));
+    if (mstp)
+	mstp->st_uses++;
+    bu_semaphore_release(RT_SEM_MODEL);
+    if (mstp)
+	return (mstp->st_aradius > 0) ? mstp : NULL;
+
+    if (rt_db_get_internal(&intern, dp, rtip->rti_dbip, NULL) < 0)
+	return NULL;
+
+    BU_ALLOC(mstp, struct soltab);
+    mstp->l.magic = RT_SOLTAB_MAGIC;
+    mstp->l2.magic = RT_SOLTAB2_MAGIC;
+    mstp->st_rtip = rtip;
+    mstp->st_dp = dp;
+    mstp->st_uses = 1;
+    mstp->st_matp = (matp_t)0;
+    mstp->st_id = intern.idb_type;
+    mstp->st_meth = &OBJ[intern.idb_type];
+    VSETALL(mstp->st_max, -INFINITY);
+    VSETALL(mstp->st_min,  INFINITY);
+    bu_ptbl_init(&mstp->st_regions, 1, "instance master st_regions");
+
+    if (rtip->rti_dbip->i->dbi_version > 4)
+	ret = rt_cache_prep(cache, mstp, &intern);
+    else
+	ret = rt_obj_prep(mstp, &intern, rtip);
+    rt_db_free_internal(&intern);
+
+    if (ret || mstp->st_aradius <= 0) {
+	/* Leave it to the caller to prep this placement the usual way */
+	if (!ret && mstp->st_meth->ft_free)
+	    mstp->st_meth->ft_free(mstp);
+	bu_ptbl_free(&mstp->st_regions);
+	bu_free(mstp, "instance master soltab");
+	return NULL;
+    }
+
+    bu_semaphore_acquire(RT_SEM_MODEL);
+    other = (struct soltab *)bu_hash_get(rtip->i->rti_inst_masters, (const uint8_t *)&dp, sizeof(dp));
+    if (other) {
+	other->st_uses++;
+    } else {
+	(void)bu_hash_set(rtip->i->rti_inst_masters, (const uint8_t *)&dp, sizeof(dp), mstp);
+    }
+    bu_semaphore_release(RT_SEM_MODEL);
+
+    if (other) {
+	if (mstp->st_meth->ft_free)
+	    mstp->st_meth->ft_free(mstp);
+	bu_ptbl_free(&mstp->st_regions);
+	bu_free(mstp, "instance master soltab");
+	return other;
+    }
+    return mstp;
+}
+
+
+int
+rt_instance_wanted(const struct rt_i *rtip, const struct directory *dp, int type, const matp_t mat)
+{
+#ifdef USE_OPENCL
+    /* the OpenCL kernels only know the built-in primitive layouts */
+    return 0;
+#else
+    if (!mat || rtip->rti_dont_instance)
+	return 0;
+    if (dp->d_uses <= RT_INSTANCE_MIN_USES)
+	return 0;
+    return instance_type_ok(type);
+#endif
+}
+
+
+int
+rt_instance_prep(struct soltab *stp, struct rt_cache *cache)
+{
+    struct rt_i *rtip = stp->st_rtip;
+    struct instance_specific *isp;
+    struct soltab *mstp;
+    fastf_t scale;
+    mat_t inv;
+    int i;
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_RTI(rtip);
+
+    if (!stp->st_matp || !instance_mat_ok(stp->st_matp, &scale, &rtip->rti_tol))
+	return -1;
+    bn_mat_inv(inv, stp->st_matp);
+
+    mstp = instance_master_get(rtip, (struct directory *)stp->st_dp, cache);
+    if (!mstp)
+	return -1;
+
+    BU_GET(isp, struct instance_specific);
+    isp->inst_master = mstp;
+    MAT_COPY(isp->inst_inv, inv);
+    isp->inst_scale = scale;
+
+    stp->st_specific = (void *)isp;
+    stp->st_meth = &rt_instance_functab;
+    stp->st_id = mstp->st_id;
+
+    /* World-space bounds: the box around the placed master box */
+    VSETALL(stp->st_max, -INFINITY);
+    VSETALL(stp->st_min,  INFINITY);
+    for (i = 0; i < 8; i++) {
+	point_t corner, wpt;
+	VSET(corner,
+	     (i & 1) ? mstp->st_max[X] : mstp->st_min[X],
+	     (i & 2) ? mstp->st_max[Y] : mstp->st_min[Y],
+	     (i & 4) ? mstp->st_max[Z] : mstp->st_min[Z]);
+	MAT4X3PNT(wpt, stp->st_matp, corner);
+	VMINMAX(stp->st_min, stp->st_max, wpt);
+    }
+    MAT4X3PNT(stp->st_center, stp->st_matp, mstp->st_center);
+    stp->st_aradius = mstp->st_aradius * scale;
+    stp->st_bradius = mstp->st_bradius * scale;
+
+    return 0;
+}
+
+
+void
+rt_instance_masters_free(struct rt_i_internal *i)
+{
+    if (!i || !i->rti_inst_masters)
+	return;
+    /* Masters go away with their last instance; only the table is left */
+    bu_hash_destroy(i->rti_inst_masters);
+    i->rti_inst_masters = NULL;
+}
+
+
+/** @} */
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -101,6 +101,7 @@ struct db_i_internal {
     struct bu_ptbl dbi_changed_clbks;     /**< @brief dbi_changed_t callbacks */
     struct bu_ptbl dbi_update_nref_clbks; /**< @brief dbi_update_nref_t callbacks */
     int dbi_use_comb_instance_ids;        /**< @brief flag for comb instance tracking */
+    void *dbi_search_index;               /**< @brief db_search() attribute/type cache */
 
     struct directory *dbi_directory_hd;         /**< @brief directory entry freelist */
     struct bu_ptbl   dbi_directory_blocks;      /**< @brief Table of malloc'ed blocks */
@@ -156,12 +157,58 @@ struct rt_i_internal {
     struct region **    Regions;        	/**< @brief  ptrs to regions [reg_bit] */
     struct bu_ptbl      delete_regs;    /**< @brief  list of region pointers to delete after light_init() */
 
+    /* Instanced primitives (instance.c) */
+    struct bu_hash_tbl *rti_inst_masters;       /**< @brief  directory * -> master soltab */
+
+    /* Ray cost accounting (profile.cpp) */
+    int                 rti_profile;            /**< @brief  !0 => rt_shootray() records per-solid costs */
+
 };
 
+/**
+ * Semaphores guarding the active solid lists and directory use lists
+ * while rt_gettrees() runs in parallel (see tree.c).  Must be a power
+ * of two.
+ */
+#define RT_SEM_TREE_SHARDS 16
+extern int rt_sem_tree_shard[RT_SEM_TREE_SHARDS];
+extern void rt_tree_semaphores_init(void);
+
 struct rt_i_internal * rt_i_internal_create(void);
 void rt_i_internal_destroy(struct rt_i_internal *i);
 
 
+/* instance.c */
+
+/**
+ * Placements of one primitive beyond this count may share a single
+ * prepped master instead of each being prepped in model space.
+ */
+#define RT_INSTANCE_MIN_USES 2
+
+extern const struct rt_functab rt_instance_functab;
+
+#define RT_SOLTAB_IS_INSTANCE(_stp) ((_stp)->st_meth == &rt_instance_functab)
+
+/**
+ * Return non-zero if a new soltab for dp of the given type placed
+ * with mat should be tried as an instance.
+ */
+extern int rt_instance_wanted(const struct rt_i *rtip, const struct directory *dp, int type, const matp_t mat);
+
+/**
+ * Turn a new, unprepped soltab with st_matp set into an instance of
+ * a shared master prepped in the primitive's own frame.  Returns 0
+ * on success, or -1 (leaving stp untouched) if the placement matrix
+ * is not a similarity transform or the master cannot be prepped.
+ */
+struct rt_cache;
+extern int rt_instance_prep(struct soltab *stp, struct rt_cache *cache);
+
+/** Release the master table of an rt_i being destroyed. */
+extern void rt_instance_masters_free(struct rt_i_internal *i);
+
+
 /* Used by sketch extrude revolve */
 extern int curve_to_vlist(struct bu_list              *vlfree,
                          struct bu_list              *vhead,
@@ -234,6 +281,15 @@ extern void rt_plot_cell(const union cutter *cutp, const struct rt_shootray_stat
 extern int cyclic_path(const struct db_full_path *fp, const char *test_name, long int depth);
 
 
+/* search.cpp */
+
+/**
+ * Release the attribute and type cache db_search() keeps for dbip.
+ * Called from db_close().
+ */
+extern void db_search_index_free(struct db_i *dbip);
+
+
 /* db_diff.c */
 
 /**
@@ -256,6 +312,22 @@ struct dbi_update_nref_clbk {
 
 
 /* db5_io.c */
+
+/**
+ * True if the serialized v5 object at _ip has a compressed attribute
+ * or body section, read straight from its header flags.
+ */
+#define DB5_OBJECT_IS_COMPRESSED(_ip) \
+    ((((const unsigned char *)(_ip))[2] & DB5HDR_AFLAGS_ZZZ_MASK) || \
+     (((const unsigned char *)(_ip))[3] & DB5HDR_BFLAGS_ZZZ_MASK))
+
+/**
+ * Expand one attribute or body section stored with compression code
+ * zzz into a newly allocated dest.  Returns 0 on success, -1 on an
+ * unknown code or corrupt data.
+ */
+extern int db5_uncompress_part(struct bu_external *dest, const struct bu_external *src, int zzz);
+
 #define DB_SIZE_OBJ 0x1
 #define DB_SIZE_TREE_INSTANCED 0x2
 #define DB_SIZE_TREE_DEINSTANCED 0x4
@@ -370,6 +442,48 @@ extern void plot_ellipse(
 	const vect_t b,
 	int num_points);
 
+/**
+ * Occupancy pyramid over a 2-D or 3-D cell grid, used by the voxel
+ * primitives (vol, ebm) to step their DDA over empty space.  A level
+ * 0 brick covers PRIM_OCC_BRICK cells per axis and each level above
+ * doubles that.  Fill level 0 with PRIM_OCC_MARK() for every full
+ * cell, then call prim_occ_finish().
+ */
+#define PRIM_OCC_SHIFT 3
+#define PRIM_OCC_BRICK (1 << PRIM_OCC_SHIFT)
+#define PRIM_OCC_MAXLEVELS 16
+struct prim_occ {
+    int nlevels;
+    size_t cells[3];				/**< @brief grid size in cells */
+    size_t dim[PRIM_OCC_MAXLEVELS][3];		/**< @brief bricks per axis */
+    unsigned char *occ[PRIM_OCC_MAXLEVELS];	/**< @brief !0 = brick holds a full cell */
+};
+#define PRIM_OCC_MARK(_o, _x, _y, _z) \
+    ((_o)->occ[0][(((_z) >> PRIM_OCC_SHIFT) * (_o)->dim[0][Y] + ((_y) >> PRIM_OCC_SHIFT)) * (_o)->dim[0][X] + ((_x) >> PRIM_OCC_SHIFT)] = 1)
+
+extern void prim_occ_init(struct prim_occ *o, size_t xdim, size_t ydim, size_t zdim);
+extern void prim_occ_finish(struct prim_occ *o);
+extern void prim_occ_free(struct prim_occ *o);
+
+/**
+ * Returns the highest level whose brick holding cell is empty, or -1
+ * if the cell's level 0 brick is occupied or the cell is off the
+ * grid.
+ */
+extern int prim_occ_empty_level(const struct prim_occ *o, const int cell[3]);
+
+/**
+ * Move a cell-stepping DDA (the vol/ebm style, with t[] holding the
+ * next exit distance per axis) across the empty level "level" brick
+ * holding cell.  Only the first naxes axes take part.  On success
+ * cell, t and *t0 describe the first cell past the brick and its exit
+ * axis is returned; -1 means no progress could be made and the
+ * caller should take an ordinary step.
+ */
+extern int prim_occ_skip(int level, int naxes, int cell[3], vect_t t, double *t0,
+			 const vect_t delta, const vect_t r_pt, const vect_t r_dir,
+			 const vect_t invdir, const vect_t origin, const vect_t cellsize);
+
 extern int _rt_tcl_list_to_int_array(const char *list, int **array, int *array_len);
 extern int _rt_tcl_list_to_fastf_array(const char *list, fastf_t **array, int *array_len);
 
@@ -416,6 +530,18 @@ extern size_t clt_bot_pack(struct bu_pool *pool, struct soltab *stp);
  */
 RT_EXPORT extern void _bool_growstack(struct resource *res);
 
+/**
+ * Compile a region's (optimized) boolean tree into the flat form
+ * rt_boolfinal() evaluates, replacing any previous one.  Trees the
+ * compiler does not handle are left to be interpreted.
+ */
+RT_EXPORT extern void rt_bool_compile(struct region *regp);
+
+/**
+ * Release the compiled form of a region's boolean tree.
+ */
+RT_EXPORT extern void rt_bool_prog_free(struct region *regp);
+
 /**
  * Release the per-processor state variables needed to support
  * rt_shootray()'s use of 'solid pieces'.
@@ -430,6 +556,21 @@ RT_EXPORT extern void _res_pieces_clean(struct resource *resp,
 RT_EXPORT extern void _res_pieces_init(struct resource *resp,
 					 struct rt_i *rtip);
 
+/**
+ * Monotonic clock used for ray cost accounting, in nanoseconds.
+ */
+extern int64_t _rt_profile_clock(void);
+
+/**
+ * Size the per-processor ray cost table to cover every solid in rtip.
+ */
+extern void _rt_profile_res_init(struct resource *resp, struct rt_i *rtip);
+
+/**
+ * Release the per-processor ray cost table.
+ */
+extern void _rt_profile_res_clean(struct resource *resp);
+
 
 __END_DECLS
 
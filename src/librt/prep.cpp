@@ -62,6 +62,29 @@ int RT_SEM_TREE1 = 0;
 int RT_SEM_TREE2 = 0;
 int RT_SEM_TREE3 = 0;
 
+/* The first four shards share their names, and so their ids, with
+ * RT_SEM_TREE0..3.
+ */
+int rt_sem_tree_shard[RT_SEM_TREE_SHARDS] = {0};
+static const char *rt_sem_tree_shard_names[RT_SEM_TREE_SHARDS] = {
+    "RT_SEM_TREE0", "RT_SEM_TREE1", "RT_SEM_TREE2", "RT_SEM_TREE3",
+    "RT_SEM_TREE4", "RT_SEM_TREE5", "RT_SEM_TREE6", "RT_SEM_TREE7",
+    "RT_SEM_TREE8", "RT_SEM_TREE9", "RT_SEM_TREE10", "RT_SEM_TREE11",
+    "RT_SEM_TREE12", "RT_SEM_TREE13", "RT_SEM_TREE14", "RT_SEM_TREE15"
+};
+
+
+void
+rt_tree_semaphores_init(void)
+{
+    int i;
+
+    for (i = 0; i < RT_SEM_TREE_SHARDS; i++) {
+	if (!rt_sem_tree_shard[i])
+	    rt_sem_tree_shard[i] = bu_semaphore_register(rt_sem_tree_shard_names[i]);
+    }
+}
+
 
 /* XXX Need rt_init_rtg(), rt_clean_rtg() */
 
@@ -101,6 +124,7 @@ rt_i_internal_destroy(struct rt_i_internal *i)
 	return;
 
     bu_ptbl_free(&i->delete_regs);
+    rt_instance_masters_free(i);
 
     BU_PUT(i, struct rt_i_internal);
 }
@@ -172,6 +196,7 @@ rt_new_rti(struct db_i *dbip)
      * (in shoot.c), to handle the different algorithm -JRA
      */
     rtip->rti_space_partition = RT_PART_NUBSPT;
+    rtip->rti_weave = RT_WEAVE_AUTO;
 
     /*
      * Zero the solid instancing counters in dbip database instance.
@@ -333,6 +358,7 @@ rt_prep_parallel(struct rt_i *rtip, int ncpu)
 	rtip->i->Regions[regp->reg_bit] = regp;
 	rt_optim_tree(regp->reg_treetop, resp);
 	rt_solid_bitfinder(regp->reg_treetop, regp, resp);
+	rt_bool_compile(regp);
 
 	if (RT_G_DEBUG&RT_DEBUG_REGIONS) {
 	    db_ck_tree(regp->reg_treetop);
@@ -359,7 +385,9 @@ rt_prep_parallel(struct rt_i *rtip, int ncpu)
     /*
      * Build array of solid table pointers indexed by solid ID.  Last
      * element for each kind will be found in
-     * rti_sol_by_type[id][rti_nsol_by_type[id]-1]
+     * rti_sol_by_type[id][rti_nsol_by_type[id]-1].  Instanced solids
+     * do not carry their type's private data, so they are all filed
+     * under ID_NULL.
      */
     RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
 	/* Ensure bit numbers are unique */
@@ -373,7 +401,7 @@ rt_prep_parallel(struct rt_i *rtip, int ncpu)
 	}
 	BU_ASSERT(*ssp == SOLTAB_NULL);
 	*ssp = stp;
-	rtip->i->rti_nsol_by_type[stp->st_id]++;
+	rtip->i->rti_nsol_by_type[RT_SOLTAB_IS_INSTANCE(stp) ? ID_NULL : stp->st_id]++;
     } RT_VISIT_ALL_SOLTABS_END;
 
     /* Find solid type with maximum length (for rt_shootray) */
@@ -393,7 +421,7 @@ rt_prep_parallel(struct rt_i *rtip, int ncpu)
     /* Fill in the array and rebuild the count (aka index) */
     RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
 	int id;
-	id = stp->st_id;
+	id = RT_SOLTAB_IS_INSTANCE(stp) ? ID_NULL : stp->st_id;
 	rtip->i->rti_sol_by_type[id][rtip->i->rti_nsol_by_type[id]++] = stp;
     } RT_VISIT_ALL_SOLTABS_END;
     if (RT_G_DEBUG & (RT_DEBUG_DB|RT_DEBUG_SOLIDS)) {
@@ -880,6 +908,7 @@ rt_init_resource(struct resource *resp, int cpu_num, struct rt_i *rtip)
 	RT_SEM_TREE2 = bu_semaphore_register("RT_SEM_TREE2");
     if (!RT_SEM_TREE3)
 	RT_SEM_TREE3 = bu_semaphore_register("RT_SEM_TREE3");
+    rt_tree_semaphores_init();
 
     if (rtip)
 	RT_CK_RTI(rtip);
@@ -1042,6 +1071,9 @@ rt_clean_resource_basic(struct rt_i *rtip, struct resource *resp)
     /* Release the state variables for 'solid pieces' */
     _res_pieces_clean(resp, rtip);
 
+    /* Release the ray cost table */
+    _rt_profile_res_clean(resp);
+
     /* invalidate the resource */
     if (resp != &rt_uniresource)
 	resp->re_magic = 0;
@@ -1158,6 +1190,7 @@ rt_clean(struct rt_i *rtip)
     while (BU_LIST_WHILE(regp, region, &rtip->HeadRegion)) {
 	RT_CK_REGION(regp);
 	BU_LIST_DEQUEUE(&(regp->l));
+	rt_bool_prog_free(regp);
 	db_free_tree(regp->reg_treetop);
 	bu_free((void *)regp->reg_name, "region name str");
 	regp->reg_name = (char *)0;
@@ -1313,6 +1346,7 @@ rt_del_regtree(struct rt_i *rtip, struct region *delregp)
 
     BU_LIST_DEQUEUE(&(delregp->l));
 
+    rt_bool_prog_free(delregp);
     db_free_tree(delregp->reg_treetop);
     delregp->reg_treetop = TREE_NULL;
     bu_free((char *)delregp->reg_name, "region name str");
@@ -1358,6 +1392,7 @@ rt_solid_bitfinder(union tree *treep, struct region *regp, struct resource *resp
 	    case OP_UNION:
 	    case OP_INTERSECT:
 	    case OP_SUBTRACT:
+	    case OP_XOR:
 		/* BINARY type */
 		/* push both nodes - search left first */
 		*sp++ = treep->tr_b.tb_right;
@@ -1958,6 +1993,7 @@ rt_reprep(struct rt_i *rtip, struct rt_reprep_obj_list *objs, struct resource *r
 		VMINMAX(rtip->mdl_min, rtip->mdl_max, region_max);
 	    }
 	    rt_solid_bitfinder(rp->reg_treetop, rp, resp);
+	    rt_bool_compile(rp);
 	}
 	bitno++;
     }
@@ -353,6 +353,7 @@ struct spatial_partition_s {
     triangle_s *tris;
     fastf_t *vertex_normals; /* for deallocation, access normals
 				through triangle_s */
+    long nnodes;	     /* number of flat bvh nodes at root */
 };
 
 static int
@@ -457,6 +458,73 @@ copy_bot_tri(triangle_s* tris, fastf_t* tri_norms, const struct rt_bot_internal
     tris[i].face_id = bot_ip_index;
 }
 
+static struct bot_specific *
+bot_specific_setup(struct soltab *stp, const struct rt_bot_internal *bot_ip)
+{
+    // Copy settings over to bot, because we won't have access to
+    // bot_ip in the shot function
+    struct bot_specific *bot;
+    BU_GET(bot, struct bot_specific);
+    stp->st_specific = (void *)bot;
+    bot->bot_mode = bot_ip->mode;
+    bot->bot_orientation = bot_ip->orientation;
+    bot->bot_flags = bot_ip->bot_flags;
+    bot->bot_ntri = 0;	    // set after validating faces
+
+    // set up thickness if requested
+    if (bot_ip->thickness) {
+	bot->bot_thickness = (fastf_t *)bu_calloc(bot_ip->num_faces, sizeof(fastf_t), "bot_thickness");
+	for (size_t bot_ip_index = 0; bot_ip_index < bot_ip->num_faces; bot_ip_index++)
+	    bot->bot_thickness[bot_ip_index] = bot_ip->thickness[bot_ip_index];
+    } else {
+	bot->bot_thickness = NULL;
+    }
+
+    // set up face_mode and facelist
+    if (bot_ip->face_mode) {
+	bot->bot_facemode = bu_bitv_dup(bot_ip->face_mode);
+    } else {
+	bot->bot_facemode = BU_BITV_NULL;
+    }
+    bot->bot_facelist = NULL;
+
+    return bot;
+}
+
+
+/* look for a requested bundle size */
+static size_t
+bot_max_prims(void)
+{
+    size_t bot_max_prims_in_node = RT_DEFAULT_MAX_PRIMS_IN_NODE;
+    const char *bmintie = getenv("LIBRT_BOT_MINTIE");
+    if (bmintie)
+	bot_max_prims_in_node = atoi(bmintie);
+    return bot_max_prims_in_node;
+}
+
+
+static void
+bot_prep_bounds(struct soltab *stp, const struct spatial_partition_s *sps, const struct bn_tol *tolp)
+{
+    // struct bvh_build_node and struct bvh_flat_node are puns for fastf_t[6] which are the bounds
+    const fastf_t *min = (const fastf_t *)sps->root;
+    const fastf_t *max = &min[3];
+
+    VMOVE(stp->st_min, min);
+    VMOVE(stp->st_max, max);
+
+    /* zero thickness will get missed by the raytracer */
+    BBOX_NONDEGEN(stp->st_min, stp->st_max, tolp->dist);
+
+    VADD2SCALE(stp->st_center, min, max, 0.5);
+    point_t dist_vec;
+    VSUB2SCALE(dist_vec, max, min, 0.5);
+    stp->st_aradius = FMAX(dist_vec[0], FMAX(dist_vec[1], dist_vec[2]));
+    stp->st_bradius = MAGNITUDE(dist_vec);
+}
+
+
 /**
  * Given a pointer to a GED database record, and a transformation
  * matrix, determine if this is a valid BOT, and if so, precompute
@@ -489,38 +557,8 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 	tolp = &defaults;
     }
 
-    // Copy settings over to bot, because we won't have access to
-    // bot_ip in the shot function
-    struct bot_specific *bot;
-    BU_GET(bot, struct bot_specific);
-    stp->st_specific = (void *)bot;
-    bot->bot_mode = bot_ip->mode;
-    bot->bot_orientation = bot_ip->orientation;
-    bot->bot_flags = bot_ip->bot_flags;
-    bot->bot_ntri = 0;	    // set after validating faces
-
-    // set up thickness if requested
-    if (bot_ip->thickness) {
-	bot->bot_thickness = (fastf_t *)bu_calloc(bot_ip->num_faces, sizeof(fastf_t), "bot_thickness");
-	for (size_t bot_ip_index = 0; bot_ip_index < bot_ip->num_faces; bot_ip_index++)
-	    bot->bot_thickness[bot_ip_index] = bot_ip->thickness[bot_ip_index];
-    } else {
-	bot->bot_thickness = NULL;
-    }
-
-    // set up face_mode and facelist
-    if (bot_ip->face_mode) {
-	bot->bot_facemode = bu_bitv_dup(bot_ip->face_mode);
-    } else {
-	bot->bot_facemode = BU_BITV_NULL;
-    }
-    bot->bot_facelist = NULL;
-
-    // look for a requested bundle size
-    size_t bot_max_prims_in_node = RT_DEFAULT_MAX_PRIMS_IN_NODE ;
-    const char *bmintie = getenv("LIBRT_BOT_MINTIE");
-    if (bmintie)
-	bot_max_prims_in_node = atoi(bmintie);
+    struct bot_specific *bot = bot_specific_setup(stp, bot_ip);
+    size_t bot_max_prims_in_node = bot_max_prims();
 
     // set up for hlbvh call
     fastf_t *centroids   = (fastf_t*)bu_malloc(bot_ip->num_faces * sizeof(fastf_t)*3, "bot centroids");
@@ -610,7 +648,7 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     // we have valid triangles, update our bot struct count
     bot->bot_ntri = nvalid;
 
-    struct bu_pool *pool = hlbvh_init_pool(nvalid);
+    struct bu_arena *pool = hlbvh_init_pool(nvalid);
     // implicit return values
     long nodes_created = 0;
     long *ordered_faces = NULL;
@@ -621,7 +659,7 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     bu_free(bounds, "bot bounds");
 
     struct bvh_flat_node *flat_root = hlbvh_flatten(build_root, nodes_created);
-    bu_pool_delete(pool);
+    bu_arena_delete(pool);
 
     int do_normals = (bot_ip->bot_flags & RT_BOT_HAS_SURFACE_NORMALS)
 		  && (bot_ip->bot_flags & RT_BOT_USE_NORMALS)
@@ -659,29 +697,219 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     sps->root = flat_root;
     sps->tris = tris;
     sps->vertex_normals = tri_norms;
+    sps->nnodes = nodes_created;
 
     bot->tie = (void *)sps;
 
-    // struct bvh_build_node and struct bvh_flat_node are puns for fastf_t[6] which are the bounds
-    fastf_t *min = (fastf_t *)sps->root;
-    fastf_t *max = &min[3];
+    bot_prep_bounds(stp, sps, tolp);
 
-    VMOVE(stp->st_min, min);
-    VMOVE(stp->st_max, max);
+#ifdef USE_OPENCL
+    clt_bot_prep(stp, bot_ip, rtip);
+#endif
+    return 0;
+}
 
-    /* zero thickness will get missed by the raytracer */
-    BBOX_NONDEGEN(stp->st_min, stp->st_max, tolp->dist);
 
-    VADD2SCALE(stp->st_center, min, max, 0.5);
-    point_t dist_vec;
-    VSUB2SCALE(dist_vec, max, min, 0.5);
-    stp->st_aradius = FMAX(dist_vec[0], FMAX(dist_vec[1], dist_vec[2]));
-    stp->st_bradius = MAGNITUDE(dist_vec);
+/*
+ * Serialized BoT prep, for the prep cache (see cache.c).  The flat
+ * bvh and the reordered triangles are written in native layout, so
+ * loading them is a copy plus a pointer fixup instead of validating
+ * every face and rebuilding the bvh.  The header pins down everything
+ * else the result depends on; a mismatch sends the caller back to
+ * rt_bot_prep().
+ *
+ * Small meshes prep faster than a cache object can be found and read,
+ * so only BoTs with at least LIBRT_BOT_CACHE_MIN triangles are stored.
+ */
+#define BOT_PREP_SERIALIZE_TAG 0x626f7470	/* "botp", native byte order */
+#define BOT_PREP_SERIALIZE_MIN 1024
+
+struct bot_prep_header {
+    uint32_t tag;
+    uint32_t sizes;		/* fastf_t, node and triangle sizes */
+    uint64_t max_prims;		/* LIBRT_BOT_MINTIE the bvh was built with */
+    double dist_sq;		/* tolerance faces were validated with */
+    uint64_t ntri;
+    uint64_t nnodes;
+    uint64_t has_normals;	/* vertex normals follow, one flag per tri */
+};
+#define BOT_PREP_SIZES ((uint32_t)((sizeof(fastf_t) << 24) | (sizeof(struct bvh_flat_node) << 12) | sizeof(triangle_s)))
+
+
+int
+rt_bot_prep_serialize(struct soltab *stp, const struct rt_db_internal *ip, struct bu_external *external, size_t *version)
+{
+    const size_t current_version = 0;
+    struct bot_prep_header hdr;
+    struct bn_tol defaults = BN_TOL_INIT_TOL;
+    const struct bn_tol *tolp;
+    uint8_t *cp;
+    size_t i;
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_DB_INTERNAL(ip);
+    BU_CK_EXTERNAL(external);
+
+    if (stp->st_rtip) {
+	tolp = &stp->st_rtip->rti_tol;
+    } else {
+	rt_tol_default(&defaults);
+	tolp = &defaults;
+    }
+
+    if (stp->st_specific) {
+	/* export to external */
+	const struct bot_specific *bot = (const struct bot_specific *)stp->st_specific;
+	const struct spatial_partition_s *sps = (const struct spatial_partition_s *)bot->tie;
+	struct bvh_flat_node *node;
+	triangle_s *tri;
+	size_t nbytes;
+
+	size_t min_tri = BOT_PREP_SERIALIZE_MIN;
+	const char *bcachemin = getenv("LIBRT_BOT_CACHE_MIN");
+	if (bcachemin)
+	    min_tri = (size_t)atol(bcachemin);
+
+	if (!sps || sps->nnodes <= 0 || bot->bot_ntri < min_tri)
+	    return 1;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.tag = BOT_PREP_SERIALIZE_TAG;
+	hdr.sizes = BOT_PREP_SIZES;
+	hdr.max_prims = bot_max_prims();
+	hdr.dist_sq = tolp->dist_sq;
+	hdr.ntri = bot->bot_ntri;
+	hdr.nnodes = (uint64_t)sps->nnodes;
+	hdr.has_normals = (sps->vertex_normals != NULL);
+
+	nbytes = sizeof(hdr) + hdr.nnodes * sizeof(struct bvh_flat_node) + hdr.ntri * sizeof(triangle_s);
+	if (hdr.has_normals)
+	    nbytes += hdr.ntri * (9 * sizeof(fastf_t) + 1);
+
+	external->ext_nbytes = nbytes;
+	external->ext_buf = (uint8_t *)bu_malloc(nbytes, "bot prep serialize");
+	cp = external->ext_buf;
+
+	memcpy(cp, &hdr, sizeof(hdr));
+	cp += sizeof(hdr);
+
+	/* interior nodes point at their second child, store its index */
+	node = (struct bvh_flat_node *)cp;
+	memcpy(node, sps->root, hdr.nnodes * sizeof(struct bvh_flat_node));
+	for (i = 0; i < hdr.nnodes; i++) {
+	    if (node[i].n_primitives == 0)
+		node[i].data.first_prim_offset = (long)(sps->root[i].data.other_child - sps->root);
+	}
+	cp += hdr.nnodes * sizeof(struct bvh_flat_node);
+
+	tri = (triangle_s *)cp;
+	memcpy(tri, sps->tris, hdr.ntri * sizeof(triangle_s));
+	for (i = 0; i < hdr.ntri; i++)
+	    tri[i].norms = NULL;
+	cp += hdr.ntri * sizeof(triangle_s);
+
+	if (hdr.has_normals) {
+	    memcpy(cp, sps->vertex_normals, hdr.ntri * 9 * sizeof(fastf_t));
+	    cp += hdr.ntri * 9 * sizeof(fastf_t);
+	    for (i = 0; i < hdr.ntri; i++)
+		*cp++ = (sps->tris[i].norms != NULL);
+	}
+
+	*version = current_version;
+	return 0;
+    } else {
+	/* load from external */
+	const struct rt_bot_internal *bot_ip = (const struct rt_bot_internal *)ip->idb_ptr;
+	struct spatial_partition_s *sps;
+	struct bot_specific *bot;
+	size_t nbytes;
+
+	RT_BOT_CK_MAGIC(bot_ip);
+
+	if (*version != current_version || external->ext_nbytes < sizeof(hdr))
+	    return 1;
+
+	cp = external->ext_buf;
+	memcpy(&hdr, cp, sizeof(hdr));
+	cp += sizeof(hdr);
+
+	if (hdr.tag != BOT_PREP_SERIALIZE_TAG || hdr.sizes != BOT_PREP_SIZES
+	    || hdr.max_prims != bot_max_prims() || !EQUAL(hdr.dist_sq, tolp->dist_sq)
+	    || hdr.nnodes == 0 || hdr.ntri == 0 || hdr.ntri > bot_ip->num_faces)
+	    return 1;
+
+	nbytes = sizeof(hdr) + hdr.nnodes * sizeof(struct bvh_flat_node) + hdr.ntri * sizeof(triangle_s);
+	if (hdr.has_normals)
+	    nbytes += hdr.ntri * (9 * sizeof(fastf_t) + 1);
+	if (external->ext_nbytes != nbytes)
+	    return 1;
+
+	BU_GET(sps, struct spatial_partition_s);
+	sps->nnodes = (long)hdr.nnodes;
+	sps->root = (struct bvh_flat_node *)bu_malloc(hdr.nnodes * sizeof(struct bvh_flat_node), "bvh flat nodes");
+	memcpy(sps->root, cp, hdr.nnodes * sizeof(struct bvh_flat_node));
+	cp += hdr.nnodes * sizeof(struct bvh_flat_node);
+
+	/* A stale or damaged object must not index outside the nodes,
+	 * triangles or faces; rt_bot_prep() is the fallback.  Interior
+	 * nodes have their first child next to them and the second one
+	 * further on, leaves a range of the ordered triangles.
+	 */
+	for (i = 0; i < hdr.nnodes; i++) {
+	    long first = sps->root[i].data.first_prim_offset;
+	    long n = sps->root[i].n_primitives;
+
+	    if (n == 0) {
+		if (first <= (long)i + 1 || (uint64_t)first >= hdr.nnodes)
+		    break;
+	    } else if (n < 0 || first < 0 || (uint64_t)n > hdr.ntri || (uint64_t)first > hdr.ntri - (uint64_t)n) {
+		break;
+	    }
+	}
+	if (i < hdr.nnodes) {
+	    bu_free(sps->root, "bvh flat nodes");
+	    BU_PUT(sps, struct spatial_partition_s);
+	    return 1;
+	}
+	for (i = 0; i < hdr.nnodes; i++) {
+	    if (sps->root[i].n_primitives == 0)
+		sps->root[i].data.other_child = &sps->root[sps->root[i].data.first_prim_offset];
+	}
+
+	sps->tris = (triangle_s *)bu_malloc(hdr.ntri * sizeof(triangle_s), "ordered triangles");
+	memcpy(sps->tris, cp, hdr.ntri * sizeof(triangle_s));
+	cp += hdr.ntri * sizeof(triangle_s);
+	for (i = 0; i < hdr.ntri; i++) {
+	    if (sps->tris[i].face_id >= bot_ip->num_faces) {
+		bu_free(sps->tris, "ordered triangles");
+		bu_free(sps->root, "bvh flat nodes");
+		BU_PUT(sps, struct spatial_partition_s);
+		return 1;
+	    }
+	}
+
+	sps->vertex_normals = NULL;
+	if (hdr.has_normals) {
+	    sps->vertex_normals = (fastf_t *)bu_malloc(hdr.ntri * 9 * sizeof(fastf_t), "bot norms");
+	    memcpy(sps->vertex_normals, cp, hdr.ntri * 9 * sizeof(fastf_t));
+	    cp += hdr.ntri * 9 * sizeof(fastf_t);
+	    for (i = 0; i < hdr.ntri; i++) {
+		if (*cp++)
+		    sps->tris[i].norms = &sps->vertex_normals[i*9];
+	    }
+	}
+
+	bot = bot_specific_setup(stp, bot_ip);
+	bot->bot_ntri = hdr.ntri;
+	bot->tie = (void *)sps;
+
+	bot_prep_bounds(stp, sps, tolp);
 
 #ifdef USE_OPENCL
-    clt_bot_prep(stp, bot_ip, rtip);
+	clt_bot_prep(stp, (struct rt_bot_internal *)bot_ip, stp->st_rtip);
 #endif
-    return 0;
+	return 0;
+    }
 }
 
 
@@ -130,13 +130,14 @@ TIE_VAL(tri_prep)(struct tie_s *tie)
  * @param tie pointer to a struct tie_t
  * @param tri_num initial number of triangles to allocate for.
  *                tie_push may expand the buffer, if needed.
- * @param kdmethod Either TIE_KDTREE_FAST or TIE_KDTREE_OPTIMAL
+ * @param kdmethod TIE_KDTREE_FAST, TIE_KDTREE_OPTIMAL or TIE_KDTREE_SAH
  * @return void
  */
 void
 TIE_VAL(tie_init)(struct tie_s *tie, unsigned int tri_num, unsigned int kdmethod)
 {
     tie->kdtree = NULL;
+    tie->kdstore = NULL;
     tie->kdmethod = kdmethod;
     tie->tri_num = 0;
     tie->tri_num_alloc = tri_num;
@@ -448,10 +449,14 @@ TIE_VAL(tie_push)(struct tie_s *tie, TIE_3 **tlist, unsigned int tnum, void *pli
 {
     unsigned int i;
 
-    /* expand the tri buffer if needed */
+    /* expand the tri buffer if needed, geometrically so that many
+     * small pushes do not each pay for a full copy */
     if (tnum + tie->tri_num > tie->tri_num_alloc) {
-	tie->tri_list = (struct tie_tri_s *)bu_realloc(tie->tri_list, sizeof(struct tie_tri_s) * (tie->tri_num + tnum), "tri_list during tie_push");
-	tie->tri_num_alloc += tnum;
+	unsigned int want = tie->tri_num + tnum;
+	if (want < tie->tri_num_alloc + tie->tri_num_alloc / 2)
+	    want = tie->tri_num_alloc + tie->tri_num_alloc / 2;
+	tie->tri_list = (struct tie_tri_s *)bu_realloc(tie->tri_list, sizeof(struct tie_tri_s) * want, "tri_list during tie_push");
+	tie->tri_num_alloc = want;
     }
 
     for (i = 0; i < tnum; i++) {
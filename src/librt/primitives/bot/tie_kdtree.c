@@ -30,6 +30,8 @@
 
 #include "bio.h"
 
+#include "bu/parallel.h"
+#include "bu/snooze.h"
 #include "vmath.h"
 #include "rt/geom.h"
 #include "raytrace.h"
@@ -687,6 +689,487 @@ tie_kdtree_build(struct tie_s *tie, struct tie_kdtree_s *node, unsigned int dept
     node->b = TIE_SET_HAS_CHILDREN(node->b) + split;
 }
 
+/*************************************************************
+ **************** BINNED SAH BUILDER *************************
+ *************************************************************/
+
+/*
+ * TIE_KDTREE_SAH builds the same kind of tree as the other methods,
+ * but picks each split by binning the triangles' bounding boxes
+ * (clipped to the node) along all three axes and minimizing the
+ * surface area heuristic over the bin boundaries.  That costs one
+ * pass over the node's triangles instead of a box-overlap test per
+ * triangle per candidate plane.
+ *
+ * Nodes with many triangles are queued so that their subtrees are
+ * built by different threads; smaller nodes are finished on the
+ * thread that split them.  Each task builds its subtree out of the
+ * thread's scratch arena, then copies it into one block of three flat
+ * arrays (child pairs, leaves and triangle pointers) in depth-first
+ * order and releases the scratch memory.  Children big enough to be
+ * queued are copied as leaves and split in place by the task that
+ * picks them up.
+ */
+
+#define TIE_SAH_BINS		32	/* bins per axis; bins-1 candidate planes */
+#define TIE_SAH_TRAVERSE	1.0	/* relative cost of stepping through a node */
+#define TIE_SAH_INTERSECT	1.5	/* relative cost of one triangle test */
+#define TIE_SAH_EMPTY_BONUS	0.2	/* discount for cutting off empty space */
+#define TIE_SAH_TASK_MIN	4096	/* smaller subtrees stay on one thread */
+
+struct tie_sah_task {
+    struct tie_kdtree_s *node;
+    unsigned int depth;
+    TIE_3 min, max;
+};
+
+/* A child left for another task, kept in the scratch arena */
+struct tie_sah_defer {
+    struct tie_sah_defer *next;
+    struct tie_sah_task task;
+};
+
+/* One task's finished subtree, in a single allocation */
+struct tie_sah_block {
+    struct tie_sah_block *next;
+    struct tie_kdtree_s *nodes;	/* child pairs */
+    struct tie_geom_s *leaves;
+    struct tie_tri_s **tris;
+};
+#define TIE_SAH_BLOCK_HDR ((sizeof(struct tie_sah_block) + 15) & ~(size_t)15)
+
+struct tie_sah_build {
+    struct tie_s *tie;
+    struct tie_sah_task *tasks;	/* stack, semaphored */
+    size_t task_num;
+    size_t task_alloc;
+    size_t pending;		/* queued or being built, semaphored */
+    struct tie_sah_block *blocks;	/* semaphored */
+};
+
+struct tie_sah_store {
+    struct tie_sah_block *blocks;
+};
+
+static int tie_sah_sem = 0;
+
+
+static TFLOAT
+tie_sah_area(const TFLOAT ext[3])
+{
+    return 2.0 * (ext[0]*ext[1] + ext[1]*ext[2] + ext[0]*ext[2]);
+}
+
+
+/*
+ * Split one node if the SAH says it pays.  On success node->data
+ * points at a pair of leaf children, each with its own bu_malloc()ed
+ * triangle list, and the node's own list has been freed.
+ */
+static int
+tie_sah_split(struct tie_s *tie, struct bu_arena *arena, struct tie_kdtree_s *node, unsigned int depth, const TIE_3 *min, const TIE_3 *max, TIE_3 cmin[2], TIE_3 cmax[2])
+{
+    unsigned int lo_cnt[3][TIE_SAH_BINS], hi_cnt[3][TIE_SAH_BINS];
+    struct tie_geom_s *g = (struct tie_geom_s *)node->data;
+    struct tie_geom_s *child[2];
+    struct tie_kdtree_s *kids;
+    TFLOAT ext[3], area, best_cost, split_pos = 0.0;
+    unsigned int i, k, n, nl, nr, cnt[2];
+    int d, axis = -1;
+    uint8_t *side;
+
+    if (!g || g->tri_num <= TIE_KDTREE_NODE_MAX || depth > tie->max_depth)
+	return 0;
+
+    VSUB2(ext, max->v, min->v);
+    area = tie_sah_area(ext);
+    if (area <= 0.0)
+	return 0;
+
+    memset(lo_cnt, 0, sizeof(lo_cnt));
+    memset(hi_cnt, 0, sizeof(hi_cnt));
+    for (i = 0; i < g->tri_num; i++) {
+	struct tie_tri_s *tri = g->tri_list[i];
+	for (d = 0; d < 3; d++) {
+	    TFLOAT lo, hi;
+	    int b0, b1;
+
+	    if (ext[d] <= 0.0)
+		continue;
+	    MATH_MIN3(lo, tri->data[0].v[d], tri->data[1].v[d], tri->data[2].v[d]);
+	    MATH_MAX3(hi, tri->data[0].v[d], tri->data[1].v[d], tri->data[2].v[d]);
+	    b0 = (int)((lo - min->v[d]) * TIE_SAH_BINS / ext[d]);
+	    b1 = (int)((hi - min->v[d]) * TIE_SAH_BINS / ext[d]);
+	    b0 = b0 < 0 ? 0 : (b0 >= TIE_SAH_BINS ? TIE_SAH_BINS - 1 : b0);
+	    b1 = b1 < 0 ? 0 : (b1 >= TIE_SAH_BINS ? TIE_SAH_BINS - 1 : b1);
+	    lo_cnt[d][b0]++;
+	    hi_cnt[d][b1]++;
+	}
+    }
+
+    /* Sweep the bin boundaries; leaving the node a leaf is the cost to beat */
+    best_cost = TIE_SAH_INTERSECT * g->tri_num;
+    for (d = 0; d < 3; d++) {
+	if (ext[d] <= 0.0)
+	    continue;
+	nl = 0;
+	nr = g->tri_num;
+	for (k = 1; k < TIE_SAH_BINS; k++) {
+	    TFLOAT lext[3], rext[3], pos, cost;
+
+	    nl += lo_cnt[d][k-1];	/* starting left of the plane */
+	    nr -= hi_cnt[d][k-1];	/* ending left of the plane */
+	    pos = min->v[d] + ext[d] * (TFLOAT)k / (TFLOAT)TIE_SAH_BINS;
+
+	    VMOVE(lext, ext);
+	    VMOVE(rext, ext);
+	    lext[d] = pos - min->v[d];
+	    rext[d] = max->v[d] - pos;
+	    cost = TIE_SAH_TRAVERSE + TIE_SAH_INTERSECT * (tie_sah_area(lext) * nl + tie_sah_area(rext) * nr) / area;
+	    if (nl == 0 || nr == 0)
+		cost *= (1.0 - TIE_SAH_EMPTY_BONUS);
+	    if (cost < best_cost) {
+		best_cost = cost;
+		axis = d;
+		split_pos = pos;
+	    }
+	}
+    }
+    if (axis < 0)
+	return 0;
+
+    VMOVE(cmin[0].v, min->v);
+    VMOVE(cmax[0].v, max->v);
+    VMOVE(cmin[1].v, min->v);
+    VMOVE(cmax[1].v, max->v);
+    cmax[0].v[axis] = split_pos;
+    cmin[1].v[axis] = split_pos;
+
+    /*
+     * Classify: bit 0 for the low child, bit 1 for the high child.
+     * Triangles whose extent straddles the plane get the exact
+     * box-overlap test, and keep both sides if it finds neither.
+     */
+    side = (uint8_t *)bu_malloc(g->tri_num, "tie_sah side");
+    cnt[0] = cnt[1] = 0;
+    for (i = 0; i < g->tri_num; i++) {
+	struct tie_tri_s *tri = g->tri_list[i];
+	TFLOAT lo, hi;
+
+	MATH_MIN3(lo, tri->data[0].v[axis], tri->data[1].v[axis], tri->data[2].v[axis]);
+	MATH_MAX3(hi, tri->data[0].v[axis], tri->data[1].v[axis], tri->data[2].v[axis]);
+	side[i] = 0;
+	if (lo <= split_pos)
+	    side[i] |= 1;
+	if (hi >= split_pos)
+	    side[i] |= 2;
+	if (side[i] == 3 && lo < split_pos && hi > split_pos) {
+	    uint8_t s = 0;
+	    for (n = 0; n < 2; n++) {
+		TIE_3 center, half_size;
+		VADD2SCALE(center.v, cmax[n].v, cmin[n].v, 0.5);
+		VSUB2SCALE(half_size.v, cmax[n].v, cmin[n].v, 0.5);
+		if (tie_kdtree_tri_box_overlap(&center, &half_size, tri->data))
+		    s |= (uint8_t)(1 << n);
+	    }
+	    if (s)
+		side[i] = s;
+	}
+	if (side[i] & 1)
+	    cnt[0]++;
+	if (side[i] & 2)
+	    cnt[1]++;
+    }
+
+    /* No progress, e.g. every triangle spans the plane */
+    if (cnt[0] == g->tri_num && cnt[1] == g->tri_num) {
+	bu_free(side, "tie_sah side");
+	return 0;
+    }
+
+    kids = (struct tie_kdtree_s *)bu_arena_alloc(arena, 2, sizeof(struct tie_kdtree_s));
+    for (n = 0; n < 2; n++) {
+	kids[n].axis = 0.0;
+	kids[n].b = 0;
+	child[n] = (struct tie_geom_s *)bu_arena_alloc(arena, 1, sizeof(struct tie_geom_s));
+	child[n]->tri_num = 0;
+	child[n]->tri_list = cnt[n] ? (struct tie_tri_s **)bu_malloc(cnt[n] * sizeof(struct tie_tri_s *), "tie_sah tri_list") : NULL;
+	kids[n].data = child[n];
+    }
+    for (i = 0; i < g->tri_num; i++) {
+	for (n = 0; n < 2; n++) {
+	    if (side[i] & (1 << n))
+		child[n]->tri_list[child[n]->tri_num++] = g->tri_list[i];
+	}
+    }
+    bu_free(side, "tie_sah side");
+
+    /* The head node's geometry came from the heap, the others from
+     * an arena or a parent task's block */
+    if (g->tri_list)
+	bu_free(g->tri_list, "tri_list");
+    if (depth == 0)
+	bu_free(g, "data");
+
+    node->axis = split_pos;
+    node->data = kids;
+    node->b = TIE_SET_HAS_CHILDREN(0) + (uint32_t)axis;
+    return 1;
+}
+
+
+static void
+tie_sah_push(struct tie_sah_build *bs, struct tie_kdtree_s *node, unsigned int depth, const TIE_3 *min, const TIE_3 *max)
+{
+    bu_semaphore_acquire(tie_sah_sem);
+    if (bs->task_num == bs->task_alloc) {
+	bs->task_alloc = bs->task_alloc ? bs->task_alloc * 2 : 64;
+	bs->tasks = (struct tie_sah_task *)bu_realloc(bs->tasks, bs->task_alloc * sizeof(struct tie_sah_task), "tie_sah tasks");
+    }
+    bs->tasks[bs->task_num].node = node;
+    bs->tasks[bs->task_num].depth = depth;
+    bs->tasks[bs->task_num].min = *min;
+    bs->tasks[bs->task_num].max = *max;
+    bs->task_num++;
+    bs->pending++;
+    bu_semaphore_release(tie_sah_sem);
+}
+
+
+/*
+ * Build node's subtree out of arena.  Children with enough triangles
+ * for a task of their own are left unsplit on *defer; they can't be
+ * queued until the subtree has been copied out of the arena.
+ */
+static void
+tie_sah_build_node(struct tie_sah_build *bs, struct bu_arena *arena, struct tie_sah_defer **defer, struct tie_kdtree_s *node, unsigned int depth, TIE_3 min, TIE_3 max)
+{
+    TIE_3 cmin[2], cmax[2];
+    struct tie_kdtree_s *kids;
+    int n;
+
+    if (!tie_sah_split(bs->tie, arena, node, depth, &min, &max, cmin, cmax))
+	return;
+
+    kids = (struct tie_kdtree_s *)node->data;
+    for (n = 0; n < 2; n++) {
+	if (((struct tie_geom_s *)kids[n].data)->tri_num >= TIE_SAH_TASK_MIN) {
+	    struct tie_sah_defer *d = (struct tie_sah_defer *)bu_arena_alloc(arena, 1, sizeof(struct tie_sah_defer));
+	    d->task.node = &kids[n];
+	    d->task.depth = depth + 1;
+	    d->task.min = cmin[n];
+	    d->task.max = cmax[n];
+	    d->next = *defer;
+	    *defer = d;
+	} else {
+	    tie_sah_build_node(bs, arena, defer, &kids[n], depth + 1, cmin[n], cmax[n]);
+	}
+    }
+}
+
+
+/* A leaf below a task's root that is waiting for a task of its own */
+static int
+tie_sah_deferred(const struct tie_kdtree_s *node, int top)
+{
+    const struct tie_geom_s *g = (const struct tie_geom_s *)node->data;
+    return !top && !TIE_HAS_CHILDREN(node->b) && g && g->tri_num >= TIE_SAH_TASK_MIN;
+}
+
+
+static void
+tie_sah_count(const struct tie_kdtree_s *node, int top, size_t cnt[3])
+{
+    if (TIE_HAS_CHILDREN(node->b)) {
+	cnt[0] += 2;
+	tie_sah_count(&((struct tie_kdtree_s *)node->data)[0], 0, cnt);
+	tie_sah_count(&((struct tie_kdtree_s *)node->data)[1], 0, cnt);
+    } else if (node->data && ((struct tie_geom_s *)node->data)->tri_num) {
+	cnt[1]++;
+	/* a deferred leaf keeps its own list until its task splits it */
+	if (!tie_sah_deferred(node, top))
+	    cnt[2] += ((struct tie_geom_s *)node->data)->tri_num;
+    }
+}
+
+
+/*
+ * Copy src's subtree into blk, depth-first, freeing leaf lists.
+ * Deferred leaves are copied with their lists and queued at their
+ * new address.
+ */
+static void
+tie_sah_emit(struct tie_sah_build *bs, struct tie_sah_block *blk, size_t *used, const struct tie_sah_defer *defer, struct tie_kdtree_s *dst, const struct tie_kdtree_s *src, int top)
+{
+    dst->axis = src->axis;
+    dst->b = src->b;
+
+    if (TIE_HAS_CHILDREN(src->b)) {
+	struct tie_kdtree_s *pair = &blk->nodes[used[0]];
+	const struct tie_kdtree_s *kids = (const struct tie_kdtree_s *)src->data;
+
+	used[0] += 2;
+	dst->data = pair;
+	tie_sah_emit(bs, blk, used, defer, &pair[0], &kids[0], 0);
+	tie_sah_emit(bs, blk, used, defer, &pair[1], &kids[1], 0);
+    } else {
+	struct tie_geom_s *g = (struct tie_geom_s *)src->data;
+	struct tie_geom_s *leaf;
+
+	if (!g || !g->tri_num) {
+	    /* empty leaves need no storage; traversal skips a NULL data */
+	    dst->data = NULL;
+	    if (g && g->tri_list)
+		bu_free(g->tri_list, "tri_list");
+	    return;
+	}
+	leaf = &blk->leaves[used[1]++];
+	dst->data = leaf;
+	if (tie_sah_deferred(src, top)) {
+	    *leaf = *g;
+	    for (; defer; defer = defer->next) {
+		if (defer->task.node == src) {
+		    tie_sah_push(bs, dst, defer->task.depth, &defer->task.min, &defer->task.max);
+		    break;
+		}
+	    }
+	    return;
+	}
+	leaf->tri_list = &blk->tris[used[2]];
+	leaf->tri_num = g->tri_num;
+	memcpy(leaf->tri_list, g->tri_list, g->tri_num * sizeof(struct tie_tri_s *));
+	used[2] += g->tri_num;
+	bu_free(g->tri_list, "tri_list");
+    }
+}
+
+
+/*
+ * Move a task's finished subtree out of the scratch arena into a
+ * block of its own, rooted at node, and queue its deferred children.
+ */
+static void
+tie_sah_seal(struct tie_sah_build *bs, const struct tie_sah_defer *defer, struct tie_kdtree_s *node)
+{
+    struct tie_kdtree_s src = *node;
+    struct tie_sah_block *blk;
+    size_t cnt[3] = {0, 0, 0};
+    size_t used[3] = {0, 0, 0};
+    uint8_t *mem;
+
+    tie_sah_count(&src, 1, cnt);
+    mem = (uint8_t *)bu_malloc(TIE_SAH_BLOCK_HDR
+			       + cnt[0] * sizeof(struct tie_kdtree_s)
+			       + cnt[1] * sizeof(struct tie_geom_s)
+			       + cnt[2] * sizeof(struct tie_tri_s *), "tie_sah block");
+    blk = (struct tie_sah_block *)mem;
+    blk->nodes = (struct tie_kdtree_s *)(mem + TIE_SAH_BLOCK_HDR);
+    blk->leaves = (struct tie_geom_s *)(blk->nodes + cnt[0]);
+    blk->tris = (struct tie_tri_s **)(blk->leaves + cnt[1]);
+
+    tie_sah_emit(bs, blk, used, defer, node, &src, 1);
+
+    bu_semaphore_acquire(tie_sah_sem);
+    blk->next = bs->blocks;
+    bs->blocks = blk;
+    bu_semaphore_release(tie_sah_sem);
+}
+
+
+static void
+tie_sah_worker(int UNUSED(cpu), void *arg)
+{
+    struct tie_sah_build *bs = (struct tie_sah_build *)arg;
+    struct bu_arena *arena = bu_arena_thread();
+
+    while (1) {
+	struct tie_sah_task task;
+	struct tie_sah_defer *defer = NULL;
+	struct bu_arena_mark mark;
+	int have = 0, done = 0;
+
+	bu_semaphore_acquire(tie_sah_sem);
+	if (bs->task_num) {
+	    task = bs->tasks[--bs->task_num];
+	    have = 1;
+	} else if (!bs->pending) {
+	    done = 1;
+	}
+	bu_semaphore_release(tie_sah_sem);
+
+	if (done)
+	    break;
+	if (!have) {
+	    /* another thread is splitting a big node; its halves are coming */
+	    bu_snooze(100);
+	    continue;
+	}
+
+	bu_arena_mark(arena, &mark);
+	tie_sah_build_node(bs, arena, &defer, task.node, task.depth, task.min, task.max);
+	tie_sah_seal(bs, defer, task.node);
+	bu_arena_reset(arena, &mark);
+
+	/* after the seal, so deferred children are already queued */
+	bu_semaphore_acquire(tie_sah_sem);
+	bs->pending--;
+	bu_semaphore_release(tie_sah_sem);
+    }
+}
+
+
+static void
+tie_sah_build(struct tie_s *tie)
+{
+    struct tie_sah_build bs;
+    struct tie_sah_store *st;
+    struct tie_geom_s *root_geom;
+    TIE_3 min, max;
+    size_t ncpu;
+
+    if (!tie_sah_sem)
+	tie_sah_sem = bu_semaphore_register("TIE_SEM_SAH");
+
+    ncpu = bu_avail_cpus();
+    if (ncpu < 1)
+	ncpu = 1;
+
+    memset(&bs, 0, sizeof(bs));
+    bs.tie = tie;
+
+    root_geom = (struct tie_geom_s *)tie->kdtree->data;
+    VMOVE(min.v, tie->min);
+    VMOVE(max.v, tie->max);
+    tie_sah_push(&bs, tie->kdtree, 0, &min, &max);
+    if (ncpu > 1 && root_geom && root_geom->tri_num >= TIE_SAH_TASK_MIN)
+	bu_parallel(tie_sah_worker, ncpu, &bs);
+    else
+	tie_sah_worker(0, &bs);
+    bu_free(bs.tasks, "tie_sah tasks");
+
+    if (!TIE_HAS_CHILDREN(tie->kdtree->b) && root_geom)
+	bu_free(root_geom, "data");	/* head was never split */
+
+    BU_ALLOC(st, struct tie_sah_store);
+    st->blocks = bs.blocks;
+    tie->kdstore = st;
+}
+
+
+static void
+tie_sah_free(struct tie_s *tie)
+{
+    struct tie_sah_store *st = (struct tie_sah_store *)tie->kdstore;
+
+    while (st->blocks) {
+	struct tie_sah_block *next = st->blocks->next;
+	bu_free(st->blocks, "tie_sah block");
+	st->blocks = next;
+    }
+    bu_free(st, "tie_sah store");
+    tie->kdstore = NULL;
+}
+
 /*************************************************************
  **************** EXPORTED FUNCTIONS *************************
  *************************************************************/
@@ -697,7 +1180,10 @@ TIE_VAL(tie_kdtree_free)(struct tie_s *tie)
     /* Free KDTREE Nodes */
     /* prevent tie from crashing when a tie_free() is called right after a tie_init() */
     if (tie->kdtree) {
-	tie_kdtree_free_node(tie->kdtree);
+	if (tie->kdstore)
+	    tie_sah_free(tie);
+	else
+	    tie_kdtree_free_node(tie->kdtree);
 	bu_free(tie->kdtree, "kdtree");
     }
 }
@@ -727,7 +1213,7 @@ TIE_VAL(tie_kdtree_prep)(struct tie_s *tie)
     if (!already_built) {
 	if (g->tri_num)
 	    g->tri_list = (struct tie_tri_s **)bu_realloc(g->tri_list, sizeof(struct tie_tri_s *) * g->tri_num, "prep tri_list");
-    } else {
+    } else if (!tie->kdstore) {
 	bu_free(g->tri_list, "tri_list");
     }
 
@@ -754,8 +1240,12 @@ TIE_VAL(tie_kdtree_prep)(struct tie_s *tie)
     tie->max_depth = (int)(TIE_KDTREE_DEPTH_K1 * (log(tie->tri_num) / log(2)) + TIE_KDTREE_DEPTH_K2);
 
     /* Build the KDTREE */
-    if (!already_built)
-	tie_kdtree_build(tie, tie->kdtree, 0, tie->min, tie->max);
+    if (!already_built) {
+	if (tie->kdmethod == TIE_KDTREE_SAH)
+	    tie_sah_build(tie);
+	else
+	    tie_kdtree_build(tie, tie->kdtree, 0, tie->min, tie->max);
+    }
 
     tie->stat = 0;
 }
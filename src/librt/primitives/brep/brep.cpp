@@ -28,6 +28,7 @@
 
 #include "common.h"
 
+#include <new>
 #include <vector>
 #include <list>
 #include <map>
@@ -233,6 +234,123 @@ public:
 };
 
 
+/**
+ * Scratch space for one rt_brep_shot() call, allocated from the
+ * thread's arena so that shooting does not touch the heap.  Arrays
+ * grow by doubling into fresh arena memory; the old copies are
+ * released with everything else when the shot resets the arena.  The
+ * hit store holds hits constructed in place; the hits array orders
+ * pointers into it.
+ */
+struct brep_scratch {
+    struct bu_arena *arena;
+    const BBNode **inters;
+    size_t ninters;
+    size_t inters_cap;
+    brep_hit *store;
+    size_t nstore;
+    size_t store_cap;
+    brep_hit **hits;
+};
+
+
+static void
+brep_scratch_add_inter(struct brep_scratch *s, const BBNode *node)
+{
+    if (UNLIKELY(s->ninters == s->inters_cap)) {
+	size_t cap = s->inters_cap ? s->inters_cap * 2 : 64;
+	const BBNode **inters = (const BBNode **)bu_arena_alloc(s->arena, cap, sizeof(const BBNode *));
+	if (s->ninters)
+	    memcpy((void *)inters, (const void *)s->inters, s->ninters * sizeof(const BBNode *));
+	s->inters = inters;
+	s->inters_cap = cap;
+    }
+    s->inters[s->ninters++] = node;
+}
+
+
+static void
+brep_scratch_add_hit(struct brep_scratch *s, const brep_hit &h)
+{
+    if (UNLIKELY(s->nstore == s->store_cap)) {
+	/* brep_hit holds a reference, so move the old entries by copy
+	 * construction rather than memcpy */
+	size_t cap = s->store_cap ? s->store_cap * 2 : 32;
+	brep_hit *store = (brep_hit *)bu_arena_alloc(s->arena, cap, sizeof(brep_hit));
+	for (size_t i = 0; i < s->nstore; i++)
+	    new (&store[i]) brep_hit(s->store[i]);
+	s->store = store;
+	s->store_cap = cap;
+    }
+    new (&s->store[s->nstore++]) brep_hit(h);
+}
+
+
+static bool
+brep_hit_ptr_less(const brep_hit *a, const brep_hit *b)
+{
+    return *a < *b;
+}
+
+
+/**
+ * The hits of one ray in order, as an array of pointers into the
+ * thread's hit store.  Provides the part of the std::list interface
+ * the hit filtering in rt_brep_shot() needs.  Unlike std::list,
+ * erase() shifts the later entries down, so an iterator past the
+ * erased position refers to a different hit afterwards.
+ */
+class brep_hit_list
+{
+public:
+    class iterator
+    {
+    public:
+	iterator() : p(NULL) {}
+	explicit iterator(brep_hit **ptr) : p(ptr) {}
+
+	brep_hit &operator*() const { return **p; }
+	brep_hit *operator->() const { return *p; }
+	iterator &operator++() { ++p; return *this; }
+	iterator operator++(int) { iterator t(*this); ++p; return t; }
+	iterator &operator--() { --p; return *this; }
+	iterator operator--(int) { iterator t(*this); --p; return t; }
+	bool operator==(const iterator &o) const { return p == o.p; }
+	bool operator!=(const iterator &o) const { return p != o.p; }
+
+	brep_hit **p;
+    };
+    typedef iterator const_iterator;
+
+    brep_hit_list(brep_hit **items, size_t count) : m_items(items), m_count(count) {}
+
+    iterator begin() const { return iterator(m_items); }
+    iterator end() const { return iterator(m_items + m_count); }
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    brep_hit &front() const { return *m_items[0]; }
+    brep_hit &back() const { return *m_items[m_count - 1]; }
+    void pop_back() { m_count--; }
+    void pop_front() { (void)erase(begin()); }
+
+    iterator erase(iterator pos)
+    {
+	size_t after = (size_t)(end().p - pos.p) - 1;
+	if (after)
+	    memmove(pos.p, pos.p + 1, after * sizeof(brep_hit *));
+	m_count--;
+	return pos;
+    }
+
+    /* stable, as std::list::sort() is */
+    void sort() { std::stable_sort(m_items, m_items + m_count, brep_hit_ptr_less); }
+
+private:
+    brep_hit **m_items;
+    size_t m_count;
+};
+
+
 #ifdef RT_DEBUG_HITS
 
 
@@ -270,11 +388,11 @@ log_key(struct bu_vls *logstr)
 
 
 static void
-log_hits(std::list<brep_hit> &hits, int UNUSED(verbosity))
+log_hits(brep_hit_list &hits, int UNUSED(verbosity))
 {
     struct bu_vls logstr = BU_VLS_INIT_ZERO;
     log_key(&logstr);
-    for (std::list<brep_hit>::iterator i = hits.begin(); i != hits.end(); ++i) {
+    for (brep_hit_list::iterator i = hits.begin(); i != hits.end(); ++i) {
 	point_t prev = VINIT_ZERO;
 
 	const brep_hit &out = *i;
@@ -346,6 +464,8 @@ brep_specific_delete(struct brep_specific* bs)
     if (bs != NULL) {
 	delete bs->brep;
 	delete bs->bvh;
+	if (bs->flat)
+	    bu_free(bs->flat, "brep_flat_node");
 	bu_free(bs, "brep_specific_delete");
     }
 }
@@ -457,6 +577,64 @@ brep_build_bvh(struct brep_specific* bs)
 }
 
 
+static bool
+brep_flatten_node(const BBNode *node, std::vector<struct brep_flat_node> &out)
+{
+    const std::vector<BBNode *> &children = node->get_children();
+    size_t idx = out.size();
+
+    /* intersectedBy() never reports a trimmed leaf */
+    if (children.empty() && node->m_trimmed)
+	return false;
+
+    struct brep_flat_node fn;
+    VMOVE(fn.min, node->m_node.m_min);
+    VMOVE(fn.max, node->m_node.m_max);
+    fn.leaf = children.empty();
+    fn.node = node;
+    fn.skip = idx + 1;
+    out.push_back(fn);
+    if (fn.leaf)
+	return true;
+
+    bool live = false;
+    for (size_t i = 0; i < children.size(); i++) {
+	if (brep_flatten_node(children[i], out))
+	    live = true;
+    }
+    if (!live) {
+	out.resize(idx);
+	return false;
+    }
+    out[idx].skip = out.size();
+    return true;
+}
+
+
+/**
+ * Lay the bounding volume hierarchy out as a depth-first array for
+ * rt_brep_shot().  The node order matches the recursion order of
+ * BBNode::intersectsHierarchy(), so candidates come out the same.
+ */
+static void
+brep_flatten_bvh(struct brep_specific *bs)
+{
+    std::vector<struct brep_flat_node> nodes;
+
+    if (bs->flat)
+	bu_free(bs->flat, "brep_flat_node");
+    bs->flat = NULL;
+    bs->flat_count = 0;
+
+    if (!bs->bvh || !brep_flatten_node(bs->bvh, nodes))
+	return;
+
+    bs->flat = (struct brep_flat_node *)bu_malloc(nodes.size() * sizeof(struct brep_flat_node), "brep_flat_node");
+    std::copy(nodes.begin(), nodes.end(), bs->flat);
+    bs->flat_count = nodes.size();
+}
+
+
 /********************************************************************************
  * BRL-CAD Primitive interface
  ********************************************************************************/
@@ -540,6 +718,7 @@ rt_brep_prep(struct soltab *stp, struct rt_db_internal* ip, struct rt_i* rtip)
     if (brep_build_bvh(bs) < 0) {
 	return -1;
     }
+    brep_flatten_bvh(bs);
     //bu_log("!!! BUILD BVH: %.2f sec\n", (bu_gettime() - start) / 1000000.0);
 
     /* Once a proper SurfaceTree is built, finalize the bounding
@@ -846,7 +1025,7 @@ utah_newton_4corner_solver(const BBNode* sbv, const ON_Surface* surf, const ON_R
 
 
 static int
-utah_brep_intersect(const BBNode* sbv, const ON_BrepFace* face, const ON_Surface* surf, pt2d_t& uv, const ON_Ray& ray, std::list<brep_hit>& hits)
+utah_brep_intersect(const BBNode* sbv, const ON_BrepFace* face, const ON_Surface* surf, pt2d_t& uv, const ON_Ray& ray, struct brep_scratch *scratch)
 {
 #define MAX_BREP_SUBDIVISION_INTERSECTS 5
     ON_3dVector N[MAX_BREP_SUBDIVISION_INTERSECTS];
@@ -902,7 +1081,7 @@ utah_brep_intersect(const BBNode* sbv, const ON_BrepFace* face, const ON_Surface
 		else
 		    bh.direction = brep_hit::LEAVING;
 		bh.sbv = sbv;
-		hits.push_back(bh);
+		brep_scratch_add_hit(scratch, bh);
 		found = BREP_INTERSECT_FOUND;
 	    } else if (fabs(closesttrim) < BREP_EDGE_MISS_TOLERANCE) {
 		ON_3dPoint _pt;
@@ -932,7 +1111,7 @@ utah_brep_intersect(const BBNode* sbv, const ON_BrepFace* face, const ON_Surface
 		else
 		    bh.direction = brep_hit::LEAVING;
 		bh.sbv = sbv;
-		hits.push_back(bh);
+		brep_scratch_add_hit(scratch, bh);
 		found = BREP_INTERSECT_FOUND;
 	    }
 	}
@@ -941,9 +1120,6 @@ utah_brep_intersect(const BBNode* sbv, const ON_BrepFace* face, const ON_Surface
 }
 
 
-typedef std::pair<int, int> ip_t;
-typedef std::list<ip_t> MissList;
-
 static int
 sign(double val)
 {
@@ -951,10 +1127,61 @@ sign(double val)
 }
 
 
+/**
+ * Collect the leaves of the flattened hierarchy whose boxes the ray
+ * passes through, using the same slab test as BBNode::intersectedBy().
+ */
+static void
+brep_flat_intersect(const struct brep_specific *bs, const ON_Ray &ray, struct brep_scratch *scratch)
+{
+    const struct brep_flat_node *flat = bs->flat;
+    bool nearzero[3];
+    size_t i = 0;
+
+    scratch->ninters = 0;
+    for (int k = 0; k < 3; k++)
+	nearzero[k] = ON_NearZero(ray.m_dir[k]);
+
+    while (i < bs->flat_count) {
+	const struct brep_flat_node *n = &flat[i];
+	double tnear = -DBL_MAX;
+	double tfar = DBL_MAX;
+	bool hit = true;
+
+	for (int k = 0; k < 3 && hit; k++) {
+	    if (UNLIKELY(nearzero[k])) {
+		if (ray.m_origin[k] < n->min[k] || ray.m_origin[k] > n->max[k])
+		    hit = false;
+	    } else {
+		double t1 = (n->min[k] - ray.m_origin[k]) / ray.m_dir[k];
+		double t2 = (n->max[k] - ray.m_origin[k]) / ray.m_dir[k];
+		if (t1 > t2) {
+		    double tmp = t1;
+		    t1 = t2;
+		    t2 = tmp;
+		}
+		V_MAX(tnear, t1);
+		V_MIN(tfar, t2);
+		if (tnear > tfar)
+		    hit = false;
+	    }
+	}
+
+	if (!hit) {
+	    i = n->skip;
+	    continue;
+	}
+	if (n->leaf)
+	    brep_scratch_add_inter(scratch, n->node);
+	i++;
+    }
+}
+
+
 static bool
-containsNearMiss(const std::list<brep_hit> *hits)
+containsNearMiss(const brep_hit_list *hits)
 {
-    for (std::list<brep_hit>::const_iterator i = hits->begin(); i != hits->end(); ++i) {
+    for (brep_hit_list::const_iterator i = hits->begin(); i != hits->end(); ++i) {
 	const brep_hit&out = *i;
 	if (out.hit == brep_hit::NEAR_MISS) {
 	    return true;
@@ -965,9 +1192,9 @@ containsNearMiss(const std::list<brep_hit> *hits)
 
 
 static bool
-containsNearHit(const std::list<brep_hit> *hits)
+containsNearHit(const brep_hit_list *hits)
 {
-    for (std::list<brep_hit>::const_iterator i = hits->begin(); i != hits->end(); ++i) {
+    for (brep_hit_list::const_iterator i = hits->begin(); i != hits->end(); ++i) {
 	const brep_hit&out = *i;
 	if (out.hit == brep_hit::NEAR_HIT) {
 	    return true;
@@ -1044,16 +1271,8 @@ brep_platemode_thickness(const struct xray& ray, const brep_hit& hit, const stru
 }
 
 
-/**
- * Intersect a ray with a brep.  If an intersection occurs, a struct
- * seg will be acquired and filled in.
- *
- * Returns -
- * 0 MISS
- * >0 HIT
- */
-int
-rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead)
+static int
+brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead, struct brep_scratch *scratch)
 {
     struct brep_specific* bs;
 
@@ -1069,36 +1288,40 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
      * intersected, there is potentially a hit and more evaluation is
      * needed.  Otherwise, return a miss.
      */
-    std::list<const BBNode*> inters;
     ON_Ray r = toXRay(rp);
-    bs->bvh->intersectsHierarchy(r, inters);
-    if (inters.empty())
+    brep_flat_intersect(bs, r, scratch);
+    if (scratch->ninters == 0)
 	return 0; // MISS
 
-    // find all the hits (XXX very inefficient right now!)
-    std::list<brep_hit> hits;
-    MissList misses;
-    for (std::list<const BBNode*>::const_iterator i = inters.begin(); i != inters.end(); i++) {
-	const BBNode* sbv = (*i);
+    // find all the hits
+    scratch->nstore = 0;
+    for (size_t i = 0; i < scratch->ninters; i++) {
+	const BBNode* sbv = scratch->inters[i];
 	const ON_BrepFace* f = &sbv->get_face();
 	const ON_Surface* surf = f->SurfaceOf();
 	pt2d_t uv = {sbv->m_u.Mid(), sbv->m_v.Mid()};
-	utah_brep_intersect(sbv, f, surf, uv, r, hits);
+	utah_brep_intersect(sbv, f, surf, uv, r, scratch);
     }
 
+    scratch->hits = (brep_hit **)bu_arena_alloc(scratch->arena, scratch->nstore, sizeof(brep_hit *));
+    for (size_t i = 0; i < scratch->nstore; i++)
+	scratch->hits[i] = &scratch->store[i];
+    brep_hit_list hits(scratch->hits, scratch->nstore);
+
     // sort the hits
     hits.sort();
 
 #ifdef RT_DEBUG_HITS
-    std::list<brep_hit> orig = hits;
+    std::vector<brep_hit *> orig_items(hits.begin().p, hits.end().p);
+    brep_hit_list orig(orig_items.data(), orig_items.size());
 #endif
 
     ////////////////////////
     if ((hits.size() > 1) && containsNearMiss(&hits)) { //&& ((hits.size() % 2) != 0)) {
 
-	std::list<brep_hit>::iterator prev;
-	std::list<brep_hit>::const_iterator next;
-	std::list<brep_hit>::iterator curr = hits.begin();
+	brep_hit_list::iterator prev;
+	brep_hit_list::const_iterator next;
+	brep_hit_list::iterator curr = hits.begin();
 
 	while (curr != hits.end()) {
 	    const brep_hit &curr_hit = *curr;
@@ -1147,13 +1370,13 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 				continue;
 			    } else {
 				//remove both edge near misses
-				(void)hits.erase(prev);
+				curr = hits.erase(prev);
 				curr = hits.erase(curr);
 				continue;
 			    }
 			} else {
 			    // not adjacent faces so remove first miss
-			    (void)hits.erase(prev);
+			    curr = hits.erase(prev);
 			}
 		    }
 		} else {
@@ -1162,7 +1385,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 		    brep_hit &prev_hit = (*prev);
 		    if ((curr_hit.hit == brep_hit::CLEAN_HIT || curr_hit.hit == brep_hit::NEAR_HIT) && prev_hit.hit == brep_hit::NEAR_MISS) {
 			if (curr_hit.direction == brep_hit::ENTERING) {
-			    (void)hits.erase(prev);
+			    curr = hits.erase(prev);
 			} else {
 			    prev_hit.hit = brep_hit::CRACK_HIT;
 			}
@@ -1190,7 +1413,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 			// good solids with known normal directions
 			// assume first hit direction is "entering"
 			// todo check solid status and normals
-			std::list<brep_hit>::const_iterator first = hits.begin();
+			brep_hit_list::const_iterator first = hits.begin();
 			const brep_hit &first_hit = *first;
 			if (first_hit.direction == curr_hit.direction) { // assume "entering"
 			    curr = hits.erase(prev);
@@ -1222,9 +1445,9 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 
     ///////////// handle near hit
     if ((hits.size() > 1) && containsNearHit(&hits)) { //&& ((hits.size() % 2) != 0)) {
-	std::list<brep_hit>::iterator prev;
-	std::list<brep_hit>::const_iterator next;
-	std::list<brep_hit>::iterator curr = hits.begin();
+	brep_hit_list::iterator prev;
+	brep_hit_list::const_iterator next;
+	brep_hit_list::iterator curr = hits.begin();
 	while (curr != hits.end()) {
 	    const brep_hit &curr_hit = *curr;
 	    if (curr_hit.hit == brep_hit::NEAR_HIT) {
@@ -1276,7 +1499,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	// BREP_GRAZING_DOT_TOL (>= 89.999 degrees obliq)
 	TRACE("-- Remove grazing hits --");
 	//int num = 0;
-	for (std::list<brep_hit>::iterator i = hits.begin(); i != hits.end(); ++i) {
+	for (brep_hit_list::iterator i = hits.begin(); i != hits.end(); ++i) {
 	    const brep_hit &curr_hit = *i;
 	    if ((curr_hit.trimmed && !curr_hit.closeToEdge) || curr_hit.oob || NEAR_ZERO(VDOT(curr_hit.normal, rp->r_dir), BREP_GRAZING_DOT_TOL)) {
 		// remove what we were removing earlier
@@ -1288,6 +1511,8 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 
 		if (i != hits.begin())
 		    --i;
+		else if (i == hits.end())
+		    break;
 
 		continue;
 	    }
@@ -1299,8 +1524,8 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     if (!hits.empty()) {
 	// we should have "valid" points now, remove duplicates or
 	// grazes(same point with in/out sign change)
-	std::list<brep_hit>::iterator last = hits.begin();
-	std::list<brep_hit>::iterator i = hits.begin();
+	brep_hit_list::iterator last = hits.begin();
+	brep_hit_list::iterator i = hits.begin();
 	++i;
 	while (i != hits.end()) {
 	    if ((*i) == (*last)) {
@@ -1334,8 +1559,8 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     //if (!hits.empty() && ((hits.size() % 2) != 0)) {
     if (!hits.empty()) {
 	// we should have "valid" points now, remove duplicates or grazes
-	std::list<brep_hit>::iterator last = hits.begin();
-	std::list<brep_hit>::iterator i = hits.begin();
+	brep_hit_list::iterator last = hits.begin();
+	brep_hit_list::iterator i = hits.begin();
 	++i;
 	int entering = 1;
 	while (i != hits.end()) {
@@ -1387,7 +1612,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	    /* PLATE MODE case */
 
 	    /* iterate over all hit points assuming a plate-mode shell */
-	    for (std::list<brep_hit>::const_iterator i = hits.begin(); i != hits.end(); ++i) {
+	    for (brep_hit_list::const_iterator i = hits.begin(); i != hits.end(); ++i) {
 		const brep_hit& in = *i;
 		const brep_hit& out = *i;
 
@@ -1450,7 +1675,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	    bool hit_it = hits.size() % 2 == 0;
 	    if (hit_it) {
 		// take each pair as a segment
-		for (std::list<brep_hit>::const_iterator i = hits.begin(); i != hits.end(); ++i) {
+		for (brep_hit_list::const_iterator i = hits.begin(); i != hits.end(); ++i) {
 		    const brep_hit& in = *i;
 		    i++;
 		    const brep_hit& out = *i;
@@ -1484,6 +1709,31 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 }
 
 
+/**
+ * Intersect a ray with a brep.  If an intersection occurs, a struct
+ * seg will be acquired and filled in.
+ *
+ * Returns -
+ * 0 MISS
+ * >0 HIT
+ */
+int
+rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead)
+{
+    struct brep_scratch scratch;
+    struct bu_arena_mark mark;
+    int ret;
+
+    memset(&scratch, 0, sizeof(struct brep_scratch));
+    scratch.arena = bu_arena_thread();
+    bu_arena_mark(scratch.arena, &mark);
+    ret = brep_shot(stp, rp, ap, seghead, &scratch);
+    bu_arena_reset(scratch.arena, &mark);
+
+    return ret;
+}
+
+
 /**
  * Given ONE ray distance, return the normal and entry/exit point.
  */
@@ -3009,6 +3259,7 @@ rt_brep_prep_serialize(struct soltab *stp, const struct rt_db_internal *ip, stru
 	}
 
 	specific->bvh->BuildBBox();
+	brep_flatten_bvh(specific);
 
 	{
 	    /* Once a proper SurfaceTree is built, finalize the bounding
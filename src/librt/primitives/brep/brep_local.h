@@ -26,6 +26,23 @@
 #define LIBRT_PRIMITIVES_BREP_BREP_LOCAL_H
 
 
+/**
+ * One node of the bounding volume hierarchy flattened into a
+ * contiguous depth-first array, so each face's surface tree occupies
+ * a single run of the array.  A ray that misses the node continues at
+ * index skip (the first node past its subtree); a ray that hits it
+ * continues with the next node.  Leaves that can never be hit (fully
+ * trimmed) and subtrees without any other leaves are left out.
+ */
+struct brep_flat_node {
+    double min[3];
+    double max[3];
+    size_t skip;
+    int leaf;
+    const BrepBoundingVolume* node;
+};
+
+
 /**
  * The b-rep specific data structure for caching the prepared
  * acceleration data structure.
@@ -33,6 +50,8 @@
 struct brep_specific {
     ON_Brep* brep;
     BrepBoundingVolume* bvh;
+    struct brep_flat_node* flat;	/**< @brief bvh in depth-first order */
+    size_t flat_count;
     int is_solid;
     int plate_mode;
     int plate_mode_nocos;
@@ -55,6 +55,7 @@ struct rt_ebm_specific {
     vect_t ebm_origin;	/* local coords of grid origin (0, 0, 0) for now */
     vect_t ebm_large;	/* local coords of XYZ max */
     mat_t ebm_mat;	/* model to ideal space */
+    struct prim_occ ebm_occ;	/* bricks holding set bits */
 };
 
 
@@ -342,6 +343,7 @@ rt_ebm_dda(register struct xray *rp, struct soltab *stp, struct application *ap,
     int in_index;
     int out_index;
     int j;
+    int level;
 
     /* Compute inverse of the direction cosines */
     VINVDIR(invdir, rp->r_dir);
@@ -471,6 +473,25 @@ rt_ebm_dda(register struct xray *rp, struct soltab *stp, struct application *ap,
 	int val;
 	struct seg *segp;
 
+	/* Outside the solid, jump over whole empty bricks at once */
+	if (!inside) {
+	    int cell[3];
+
+	    cell[X] = (int)igrid[X];
+	    cell[Y] = (int)igrid[Y];
+	    cell[Z] = 0;
+	    if ((level = prim_occ_empty_level(&ebmp->ebm_occ, cell)) >= 0
+		&& (j = prim_occ_skip(level, 2, cell, t, &t0, delta, rp->r_pt, rp->r_dir,
+				      invdir, ebmp->ebm_origin, ebmp->ebm_cellsize)) >= 0) {
+		if (RT_G_DEBUG&RT_DEBUG_EBM)bu_log("skipped level %d brick to [%d %d] at %g\n",
+						level, cell[X], cell[Y], t0);
+		igrid[X] = (size_t)cell[X];
+		igrid[Y] = (size_t)cell[Y];
+		in_index = j;
+		continue;
+	    }
+	}
+
 	/* find minimum exit t value */
 	out_index = t[X] < t[Y] ? X : Y;
 
@@ -1156,12 +1177,20 @@ rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     vect_t norm;
     vect_t radvec;
     vect_t diam;
+    size_t x, y;
 
     if (rtip) RT_CK_RTI(rtip);
 
     eip = (struct rt_ebm_internal *)ip->idb_ptr;
     RT_EBM_CK_MAGIC(eip);
 
+    /* Nothing to shoot without the bitmap */
+    if (!(eip->datasrc == RT_EBM_SRC_FILE && eip->mp && eip->mp->apbuf)
+	&& !(eip->datasrc == RT_EBM_SRC_OBJ && eip->buf)) {
+	bu_log("rt_ebm_prep(%s): no bitmap data\n", stp->st_name);
+	return 1;
+    }
+
     BU_GET(ebmp, struct rt_ebm_specific);
     ebmp->ebm_i = *eip;		/* struct copy */
 
@@ -1192,6 +1221,17 @@ rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     /* for now, EBM cell size in ideal coordinates is one unit/cell */
     VSETALL(ebmp->ebm_cellsize, 1);
 
+    /* Note which bricks of the bitmap hold any set bit */
+    prim_occ_init(&ebmp->ebm_occ, ebmp->ebm_i.xdim, ebmp->ebm_i.ydim, 1);
+    for (y = 0; y < ebmp->ebm_i.ydim; y++) {
+	const unsigned char *row = bit(&ebmp->ebm_i, 0, y);
+	for (x = 0; x < ebmp->ebm_i.xdim; x++) {
+	    if (row[x] > 0)
+		PRIM_OCC_MARK(&ebmp->ebm_occ, x, y, 0);
+	}
+    }
+    prim_occ_finish(&ebmp->ebm_occ);
+
     VSUB2(diam, stp->st_max, stp->st_min);
     VADD2SCALE(stp->st_center, stp->st_min, stp->st_max, 0.5);
     VSCALE(radvec, diam, 0.5);
@@ -1334,6 +1374,7 @@ rt_ebm_free(struct soltab *stp)
 	(struct rt_ebm_specific *)stp->st_specific;
 
     bu_close_mapped_file(ebmp->ebm_i.mp);
+    prim_occ_free(&ebmp->ebm_occ);
 
     BU_PUT(ebmp, struct rt_ebm_specific);
 }
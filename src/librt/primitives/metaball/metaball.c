@@ -39,6 +39,17 @@
  * value, then a basic binary search is done to refine the
  * approximated hit point.
  *
+ * For isopotential and blob metaballs, prep also builds a bounding
+ * sphere hierarchy over the control points.  Each ray first gathers
+ * the points that matter along it: distant isopotential clusters are
+ * lumped into a single point at their weighted centroid (the
+ * Barnes-Hut approximation, controlled by METABALL_THETA), and blob
+ * points whose contribution anywhere on the ray is below a small
+ * budget (METABALL_CULL_TOL) are dropped.  The walk then steps as far
+ * as a bound on the field gradient allows the field to change without
+ * crossing the threshold, but never less than the initial step, so it
+ * resolves at least the detail the fixed-step walk did.
+ *
  * THIS PRIMITIVE IS INCOMPLETE AND SHOULD BE CONSIDERED EXPERIMENTAL.
  *
  */
@@ -67,6 +78,45 @@
 
 #define PLOT_THE_BIG_BOUNDING_SPHERE 0
 
+/* accuracy and layout of the shooting acceleration */
+#define METABALL_LEAF_SIZE 4	/* control points per hierarchy leaf */
+#define METABALL_THETA 0.1	/* lump iso nodes with radius < THETA * distance to the ray */
+#define METABALL_CULL_TOL 1.0e-4	/* blob field, as a fraction of threshold, culled per ray */
+#define METABALL_CAND_STACK 64	/* per-ray candidates kept on the stack */
+#define METABALL_NODE_STACK 128	/* traversal stack depth */
+
+/* a control point as used by the shooting code */
+struct metaball_pt {
+    point_t coord;
+    fastf_t w;			/* iso: f*|f|, blob: e^b */
+    fastf_t k;			/* blob: b/f^2 */
+};
+
+struct metaball_node {
+    point_t center;		/* |w| weighted centroid of the points below */
+    fastf_t radius;		/* of the sphere about center holding them */
+    fastf_t w;			/* sum of w below */
+    fastf_t wabs;		/* sum of |w| below */
+    fastf_t kmin;		/* smallest k below */
+    int mixed;			/* !0 if w changes sign below */
+    size_t first;		/* first point in ms->pts */
+    size_t count;
+    size_t right;		/* right child, left is the next node; 0 for leaves */
+};
+
+/*
+ * The prepped form.  The internal is first so that st_specific can
+ * still be read as a struct rt_metaball_internal.
+ */
+struct metaball_specific {
+    struct rt_metaball_internal mb;
+    struct metaball_pt *pts;	/* in hierarchy order */
+    size_t npts;
+    struct metaball_node *nodes;	/* NULL when the method is not accelerated */
+    size_t nnodes;
+    fastf_t cull;		/* blob field the culled points may add up to */
+};
+
 const char *metaballnames[] =
 {
     "Metaball",
@@ -179,6 +229,153 @@ rt_metaball_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const st
 }
 
 
+static int
+metaball_pt_cmp_x(const void *a, const void *b)
+{
+    fastf_t d = ((const struct metaball_pt *)a)->coord[X] - ((const struct metaball_pt *)b)->coord[X];
+    return (d > 0) - (d < 0);
+}
+
+
+static int
+metaball_pt_cmp_y(const void *a, const void *b)
+{
+    fastf_t d = ((const struct metaball_pt *)a)->coord[Y] - ((const struct metaball_pt *)b)->coord[Y];
+    return (d > 0) - (d < 0);
+}
+
+
+static int
+metaball_pt_cmp_z(const void *a, const void *b)
+{
+    fastf_t d = ((const struct metaball_pt *)a)->coord[Z] - ((const struct metaball_pt *)b)->coord[Z];
+    return (d > 0) - (d < 0);
+}
+
+
+/*
+ * Build the node covering pts[first, first+count) and everything
+ * below it, returning its index.  Points are split at the median of
+ * the longest axis of their bounding box.
+ */
+static size_t
+metaball_build_node(struct metaball_specific *ms, size_t first, size_t count)
+{
+    static int (*cmp[3])(const void *, const void *) = {metaball_pt_cmp_x, metaball_pt_cmp_y, metaball_pt_cmp_z};
+    size_t idx = ms->nnodes++;
+    struct metaball_node *node = &ms->nodes[idx];
+    struct metaball_pt *pts = &ms->pts[first];
+    point_t min, max;
+    vect_t diag;
+    size_t i, half;
+    int axis = X;
+
+    VSETALL(node->center, 0.0);
+    VSETALL(min, INFINITY);
+    VSETALL(max, -INFINITY);
+    node->w = node->wabs = node->radius = 0.0;
+    node->kmin = INFINITY;
+    node->mixed = 0;
+    node->first = first;
+    node->count = count;
+    node->right = 0;
+
+    for (i = 0; i < count; i++) {
+	VMINMAX(min, max, pts[i].coord);
+	VJOIN1(node->center, node->center, fabs(pts[i].w), pts[i].coord);
+	if (i && (pts[i].w < 0.0) != (pts[0].w < 0.0))
+	    node->mixed = 1;
+	node->w += pts[i].w;
+	node->wabs += fabs(pts[i].w);
+	if (pts[i].k < node->kmin)
+	    node->kmin = pts[i].k;
+    }
+    if (node->wabs > 0.0)
+	VSCALE(node->center, node->center, 1.0 / node->wabs);
+    else
+	VBLEND2(node->center, 0.5, min, 0.5, max);
+    for (i = 0; i < count; i++) {
+	fastf_t d = DIST_PNT_PNT(node->center, pts[i].coord);
+	if (d > node->radius)
+	    node->radius = d;
+    }
+
+    if (count <= METABALL_LEAF_SIZE)
+	return idx;
+
+    VSUB2(diag, max, min);
+    if (diag[Y] > diag[axis])
+	axis = Y;
+    if (diag[Z] > diag[axis])
+	axis = Z;
+    qsort(pts, count, sizeof(struct metaball_pt), cmp[axis]);
+
+    half = count / 2;
+    (void)metaball_build_node(ms, first, half);
+    i = metaball_build_node(ms, first + half, count - half);
+    ms->nodes[idx].right = i;
+
+    return idx;
+}
+
+
+static void
+metaball_specific_free(struct metaball_specific *ms)
+{
+    struct wdb_metaball_pnt *mbpt;
+
+    while (BU_LIST_WHILE(mbpt, wdb_metaball_pnt, &ms->mb.metaball_ctrl_head)) {
+	BU_LIST_DEQUEUE(&mbpt->l);
+	bu_free(mbpt, "metaball ctrl pnt");
+    }
+    if (ms->pts)
+	bu_free(ms->pts, "metaball pts");
+    if (ms->nodes)
+	bu_free(ms->nodes, "metaball nodes");
+    bu_free(ms, "metaball_specific");
+}
+
+
+/*
+ * Flatten the control points of ms->mb and build the hierarchy over
+ * them.  Methods without a closed form field are left unaccelerated.
+ */
+static void
+metaball_build(struct metaball_specific *ms)
+{
+    struct wdb_metaball_pnt *mbpt;
+    size_t n = 0;
+
+    if (ms->mb.method != METABALL_ISOPOTENTIAL && ms->mb.method != METABALL_BLOB)
+	return;
+
+    for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &ms->mb.metaball_ctrl_head))
+	n++;
+    if (!n)
+	return;
+
+    ms->pts = (struct metaball_pt *)bu_calloc(n, sizeof(struct metaball_pt), "metaball pts");
+    for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &ms->mb.metaball_ctrl_head)) {
+	struct metaball_pt *pt = &ms->pts[ms->npts++];
+
+	VMOVE(pt->coord, mbpt->coord);
+	if (ms->mb.method == METABALL_ISOPOTENTIAL) {
+	    pt->w = fabs(mbpt->field_strength) * mbpt->field_strength;
+	    pt->k = 0.0;
+	} else {
+	    pt->w = exp(mbpt->blobbiness);
+	    pt->k = mbpt->blobbiness / SQ(mbpt->field_strength);
+	}
+    }
+
+    /* a binary tree with at most one point per leaf has < 2n nodes */
+    ms->nodes = (struct metaball_node *)bu_calloc(2 * n, sizeof(struct metaball_node), "metaball nodes");
+    (void)metaball_build_node(ms, 0, n);
+
+    ms->cull = METABALL_CULL_TOL * ms->mb.threshold;
+}
+
+
 /**
  * prep and build bounding volumes... unfortunately, generating the
  * bounding sphere is too 'loose' (I think) and O(n^2).
@@ -187,6 +384,7 @@ int
 rt_metaball_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 {
     struct rt_metaball_internal *mb, *nmb;
+    struct metaball_specific *ms;
     struct wdb_metaball_pnt *mbpt, *nmbpt;
     fastf_t minfstr = +INFINITY;
 
@@ -196,7 +394,8 @@ rt_metaball_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rti
     RT_METABALL_CK_MAGIC(mb);
 
     /* generate a copy of the metaball */
-    BU_ALLOC(nmb, struct rt_metaball_internal);
+    BU_ALLOC(ms, struct metaball_specific);
+    nmb = &ms->mb;
     nmb->magic = RT_METABALL_INTERNAL_MAGIC;
     BU_LIST_INIT(&nmb->metaball_ctrl_head);
     nmb->threshold = mb->threshold;
@@ -227,8 +426,13 @@ rt_metaball_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rti
 
     /* generate a bounding box around the sphere...
      * XXX this can be optimized greatly to reduce the BSP presence... */
-    if (rt_metaball_bbox(ip, &(stp->st_min), &(stp->st_max), &rtip->rti_tol)) return 1;
-    stp->st_specific = (void *)nmb;
+    if (rt_metaball_bbox(ip, &(stp->st_min), &(stp->st_max), &rtip->rti_tol)) {
+	metaball_specific_free(ms);
+	return 1;
+    }
+
+    metaball_build(ms);
+    stp->st_specific = (void *)ms;
     return 0;
 }
 
@@ -361,6 +565,280 @@ rt_metaball_find_intersection(point_t *intersect, const struct rt_metaball_inter
 }
 
 
+/* distance from p to the line of the ray */
+static fastf_t
+metaball_ray_dist(const struct xray *rp, const point_t p)
+{
+    vect_t v;
+    fastf_t t, d2;
+
+    VSUB2(v, p, rp->r_pt);
+    t = VDOT(v, rp->r_dir);
+    d2 = MAGSQ(v) - t * t;
+    return d2 > 0.0 ? sqrt(d2) : 0.0;
+}
+
+
+/*
+ * Collect into cand the points (real or lumped) that the field along
+ * this ray is evaluated from.  At most ms->npts are returned.
+ */
+static size_t
+metaball_gather(const struct metaball_specific *ms, const struct xray *rp, struct metaball_pt *cand)
+{
+    size_t stack[METABALL_NODE_STACK];
+    size_t sp = 0, n = 0, i;
+    fastf_t budget = ms->cull;
+    int iso = (ms->mb.method == METABALL_ISOPOTENTIAL);
+
+    stack[sp++] = 0;
+    while (sp) {
+	size_t idx = stack[--sp];
+	const struct metaball_node *node = &ms->nodes[idx];
+	fastf_t d = metaball_ray_dist(rp, node->center);
+
+	if (iso) {
+	    /* far enough that the cluster looks like one point */
+	    if (!node->mixed && node->radius < METABALL_THETA * d) {
+		VMOVE(cand[n].coord, node->center);
+		cand[n].w = node->w;
+		cand[n].k = 0.0;
+		n++;
+		continue;
+	    }
+	} else if (d > node->radius && node->kmin > 0.0) {
+	    fastf_t b = node->wabs * exp(-node->kmin * SQ(d - node->radius));
+	    if (b <= budget) {
+		budget -= b;
+		continue;
+	    }
+	}
+
+	if (node->right && sp + 2 <= METABALL_NODE_STACK) {
+	    stack[sp++] = node->right;
+	    stack[sp++] = idx + 1;
+	    continue;
+	}
+
+	for (i = node->first; i < node->first + node->count; i++) {
+	    const struct metaball_pt *pt = &ms->pts[i];
+	    if (!iso && pt->k > 0.0) {
+		fastf_t b = pt->w * exp(-pt->k * SQ(metaball_ray_dist(rp, pt->coord)));
+		if (b <= budget) {
+		    budget -= b;
+		    continue;
+		}
+	    }
+	    cand[n++] = *pt;
+	}
+    }
+    return n;
+}
+
+
+/*
+ * Field value at p from the gathered points.  If lip is non-NULL it
+ * is set to an upper bound on the field gradient magnitude at p.
+ */
+static fastf_t
+metaball_value(int method, const struct metaball_pt *cand, size_t n, const point_t p, fastf_t *lip)
+{
+    fastf_t val = 0.0, l = 0.0;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	vect_t v;
+	fastf_t r2;
+
+	VSUB2(v, cand[i].coord, p);
+	r2 = MAGSQ(v);
+	if (method == METABALL_ISOPOTENTIAL) {
+	    fastf_t c = cand[i].w / r2;		/* f/r^2 */
+	    val += c;
+	    if (lip)
+		l += 2.0 * fabs(c) / sqrt(r2);
+	} else {
+	    fastf_t c = cand[i].w * exp(-cand[i].k * r2);
+	    val += c;
+	    if (lip)
+		l += (cand[i].k > 0.0) ? 2.0 * cand[i].k * sqrt(r2) * c : INFINITY;
+	}
+    }
+    if (lip)
+	*lip = l;
+    return val;
+}
+
+
+/*
+ * Upper bound on the field gradient magnitude anywhere within s of p.
+ */
+static fastf_t
+metaball_lipschitz(int method, const struct metaball_pt *cand, size_t n, const point_t p, fastf_t s)
+{
+    fastf_t l = 0.0;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	fastf_t r = DIST_PNT_PNT(cand[i].coord, p) - s;
+
+	if (method == METABALL_ISOPOTENTIAL) {
+	    if (r <= 0.0)
+		return INFINITY;
+	    l += 2.0 * fabs(cand[i].w) / (r * r * r);
+	} else {
+	    /* 2kr e^(-kr^2) peaks at r = 1/sqrt(2k) */
+	    fastf_t rmax;
+	    if (cand[i].k <= 0.0)
+		return INFINITY;
+	    rmax = 1.0 / sqrt(2.0 * cand[i].k);
+	    if (r < rmax)
+		r = rmax;
+	    l += 2.0 * cand[i].k * r * cand[i].w * exp(-cand[i].k * r * r);
+	}
+    }
+    return l;
+}
+
+
+/*
+ * How far the walk may advance from p, where the field is gap away
+ * from the threshold and its gradient is bounded by lip, without
+ * stepping over a crossing.  Clamped to [minstep, maxstep].
+ */
+static fastf_t
+metaball_step(int method, const struct metaball_pt *cand, size_t n, const point_t p, fastf_t gap, fastf_t lip, fastf_t minstep, fastf_t maxstep)
+{
+    fastf_t s, l;
+    int i;
+
+    if (!(gap < INFINITY))
+	return minstep;
+    s = (lip > 0.0) ? gap / lip : maxstep;
+    if (s > maxstep)
+	s = maxstep;
+
+    /* The bound at p alone is not enough, check the whole step.  If
+     * the bound over s is finite, gap/l is safe since the bound only
+     * shrinks with s; if it is not, s reaches a point, so back off. */
+    for (i = 0; i < 8 && s > minstep; i++) {
+	l = metaball_lipschitz(method, cand, n, p, s);
+	if (s * l <= gap)
+	    return s;
+	if (l < INFINITY)
+	    return (gap / l < minstep) ? minstep : gap / l;
+	s *= 0.5;
+    }
+    return minstep;
+}
+
+
+/* rt_metaball_find_intersection() on the gathered points */
+static void
+metaball_bisect(point_t intersect, const struct rt_metaball_internal *mb, const struct metaball_pt *cand, size_t n, const point_t a, const point_t b, fastf_t step)
+{
+    point_t lo, hi, mid;
+    int lo_in;
+
+    VMOVE(lo, a);
+    VMOVE(hi, b);
+    lo_in = metaball_value(mb->method, cand, n, lo, NULL) >= mb->threshold;
+
+    while (step >= mb->finalstep) {
+	VBLEND2(mid, 0.5, lo, 0.5, hi);
+	if ((metaball_value(mb->method, cand, n, mid, NULL) >= mb->threshold) == lo_in)
+	    VMOVE(lo, mid);
+	else
+	    VMOVE(hi, mid);
+	step *= 0.5;
+    }
+    VBLEND2(intersect, 0.5, lo, 0.5, hi);
+}
+
+
+/*
+ * The walk of rt_metaball_shot() (SHOOTALGO 3) over the gathered
+ * points, with gradient bounded steps.
+ */
+static int
+metaball_shot_fast(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead)
+{
+    struct metaball_specific *ms = (struct metaball_specific *)stp->st_specific;
+    struct rt_metaball_internal *mb = &ms->mb;
+    struct metaball_pt cand_buf[METABALL_CAND_STACK];
+    struct metaball_pt *cand = cand_buf;
+    struct seg *segp = NULL;
+    int retval = 0, mb_stat = 0, segsleft = abs(ap->a_onehit);
+    fastf_t step, distleft, val, lip;
+    fastf_t maxstep = stp->st_aradius;
+    size_t ncand;
+    point_t p, lastpoint;
+
+    if (ms->npts > METABALL_CAND_STACK)
+	cand = (struct metaball_pt *)bu_malloc(ms->npts * sizeof(struct metaball_pt), "metaball cand");
+    ncand = metaball_gather(ms, rp, cand);
+    if (!ncand)
+	goto done;
+
+    step = mb->initstep;
+    distleft = (rp->r_max-rp->r_min) + step * 3.0;
+    if (maxstep < step)
+	maxstep = step;
+
+    VMOVE(p, rp->r_pt);
+
+    /* walk back out of the solid */
+    while (metaball_value(mb->method, cand, ncand, p, NULL) >= mb->threshold) {
+	distleft += step;
+	VJOIN1(p, p, -step, rp->r_dir);
+    }
+
+    val = metaball_value(mb->method, cand, ncand, p, &lip);
+    while (distleft >= 0.0 || mb_stat == 1) {
+	point_t intersect, delta;
+
+	/* advance to the next point */
+	step = metaball_step(mb->method, cand, ncand, p, fabs(val - mb->threshold), lip, mb->initstep, maxstep);
+	distleft -= step;
+	VMOVE(lastpoint, p);
+	VJOIN1(p, p, step, rp->r_dir);
+	val = metaball_value(mb->method, cand, ncand, p, &lip);
+
+	if (mb_stat == 1) {
+	    if (val < mb->threshold) {
+		metaball_bisect(intersect, mb, cand, ncand, lastpoint, p, step);
+		VMOVE(segp->seg_out.hit_point, intersect);
+		--segsleft;
+		++retval;
+		VSUB2(delta, intersect, rp->r_pt);
+		segp->seg_out.hit_dist = MAGNITUDE(delta);
+		segp->seg_out.hit_surfno = 0;
+		mb_stat = 0;
+		if (ap->a_onehit != 0 && segsleft <= 0)
+		    goto done;
+	    }
+	} else if (val > mb->threshold) {
+	    metaball_bisect(intersect, mb, cand, ncand, lastpoint, p, step);
+	    RT_GET_SEG(segp, ap->a_resource);
+	    segp->seg_stp = stp;
+	    --segsleft;
+	    ++retval;
+	    VMOVE(segp->seg_in.hit_point, intersect);
+	    VSUB2(delta, intersect, rp->r_pt);
+	    segp->seg_in.hit_dist = MAGNITUDE(delta);
+	    segp->seg_in.hit_surfno = 0;
+	    BU_LIST_INSERT(&(seghead->l), &(segp->l));
+	    mb_stat = 1;
+	}
+    }
+
+done:
+    if (cand != cand_buf)
+	bu_free(cand, "metaball cand");
+    return retval;
+}
+
+
 int
 rt_metaball_shot(struct soltab *stp, register struct xray *rp, struct application *ap, struct seg *seghead)
 {
@@ -379,6 +857,9 @@ rt_metaball_shot(struct soltab *stp, register struct xray *rp, struct applicatio
     int fhin = 1;
 #endif
 
+    if (((struct metaball_specific *)stp->st_specific)->nodes)
+	return metaball_shot_fast(stp, rp, ap, seghead);
+
     step = mb->initstep;
     distleft = (rp->r_max-rp->r_min) + step * 3.0;
 
@@ -611,9 +1092,7 @@ rt_metaball_uv(struct application *ap, struct soltab *stp, struct hit *hitp, str
 void
 rt_metaball_free(register struct soltab *stp)
 {
-    struct rt_metaball_internal *metaball = (struct rt_metaball_internal *)stp->st_specific;
-
-    bu_free((char *)metaball, "rt_metaball_internal");
+    metaball_specific_free((struct metaball_specific *)stp->st_specific);
 }
 
 
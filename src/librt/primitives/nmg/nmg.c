@@ -1317,6 +1317,8 @@ rt_nmg_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     struct bu_list *vlfree = &rt_vlfree;
     struct ray_data rd;
     int status;
+    struct bu_arena *arena;
+    struct bu_arena_mark mark;
     struct nmg_specific *nmg =
 	(struct nmg_specific *)stp->st_specific;
 
@@ -1366,10 +1368,15 @@ rt_nmg_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     /* create a table to keep track of which elements have been
      * processed before and which haven't.  Elements in this table
      * will either be (NULL) if item not previously processed or a
-     * hitmiss ptr if item was previously processed
+     * hitmiss ptr if item was previously processed.  It is scratch
+     * space needed for every ray, so it comes from this thread's
+     * arena rather than the heap.
      */
-    rd.hitmiss = (struct hitmiss **)bu_calloc(rd.rd_m->maxindex,
-					      sizeof(struct hitmiss *), "nmg geom hit list");
+    arena = bu_arena_thread();
+    bu_arena_mark(arena, &mark);
+    rd.hitmiss = (struct hitmiss **)bu_arena_alloc(arena, rd.rd_m->maxindex,
+						  sizeof(struct hitmiss *));
+    memset(rd.hitmiss, 0, rd.rd_m->maxindex * sizeof(struct hitmiss *));
 
     /* initialize the lists of things that have been hit/missed */
     BU_LIST_INIT(&rd.rd_hit);
@@ -1383,7 +1390,7 @@ rt_nmg_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     status = nmg_ray_segs(&rd, vlfree);
 
     /* free the hitmiss table */
-    bu_free((char *)rd.hitmiss, "free nmg geom hit list");
+    bu_arena_reset(arena, &mark);
 
     return status;
 }
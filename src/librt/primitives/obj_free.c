@@ -38,7 +38,8 @@ rt_obj_free(struct soltab *stp)
     if (id < 0)
 	return -2;
 
-    ft = &OBJ[id];
+    /* instanced solids carry their own methods */
+    ft = stp->st_meth ? stp->st_meth : &OBJ[id];
     if (!ft)
 	return -3;
     if (!ft->ft_free)
@@ -25,6 +25,8 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 #include "bu/log.h"
 #include "bu/malloc.h"
@@ -144,6 +146,139 @@ primitive_clamp_tess_tol(fastf_t *dtol, fastf_t *ntol, fastf_t bbox_diag)
 }
 
 
+void
+prim_occ_init(struct prim_occ *o, size_t xdim, size_t ydim, size_t zdim)
+{
+    int i;
+
+    memset(o, 0, sizeof(struct prim_occ));
+    VSET(o->cells, xdim, ydim, zdim);
+    for (i = 0; i < 3; i++)
+	o->dim[0][i] = (o->cells[i] + PRIM_OCC_BRICK - 1) >> PRIM_OCC_SHIFT;
+    o->occ[0] = (unsigned char *)bu_calloc(o->dim[0][X] * o->dim[0][Y] * o->dim[0][Z], 1, "prim_occ level 0");
+    o->nlevels = 1;
+}
+
+
+void
+prim_occ_finish(struct prim_occ *o)
+{
+    while (o->nlevels < PRIM_OCC_MAXLEVELS) {
+	int k = o->nlevels;
+	size_t *cd = o->dim[k-1];
+	size_t x, y, z;
+
+	if (cd[X] <= 1 && cd[Y] <= 1 && cd[Z] <= 1)
+	    break;
+
+	o->dim[k][X] = (cd[X] + 1) / 2;
+	o->dim[k][Y] = (cd[Y] + 1) / 2;
+	o->dim[k][Z] = (cd[Z] + 1) / 2;
+	o->occ[k] = (unsigned char *)bu_calloc(o->dim[k][X] * o->dim[k][Y] * o->dim[k][Z], 1, "prim_occ level");
+
+	for (z = 0; z < cd[Z]; z++)
+	    for (y = 0; y < cd[Y]; y++)
+		for (x = 0; x < cd[X]; x++)
+		    if (o->occ[k-1][(z * cd[Y] + y) * cd[X] + x])
+			o->occ[k][((z/2) * o->dim[k][Y] + y/2) * o->dim[k][X] + x/2] = 1;
+	o->nlevels++;
+    }
+}
+
+
+void
+prim_occ_free(struct prim_occ *o)
+{
+    int i;
+
+    for (i = 0; i < o->nlevels; i++)
+	if (o->occ[i])
+	    bu_free(o->occ[i], "prim_occ level");
+    memset(o, 0, sizeof(struct prim_occ));
+}
+
+
+int
+prim_occ_empty_level(const struct prim_occ *o, const int cell[3])
+{
+    int k, level = -1;
+
+    if (!o->nlevels)
+	return -1;
+    if (cell[X] < 0 || cell[Y] < 0 || cell[Z] < 0
+	|| (size_t)cell[X] >= o->cells[X] || (size_t)cell[Y] >= o->cells[Y] || (size_t)cell[Z] >= o->cells[Z])
+	return -1;
+
+    for (k = 0; k < o->nlevels; k++) {
+	int s = PRIM_OCC_SHIFT + k;
+	size_t idx = (((size_t)cell[Z] >> s) * o->dim[k][Y] + ((size_t)cell[Y] >> s)) * o->dim[k][X] + ((size_t)cell[X] >> s);
+	if (o->occ[k][idx])
+	    break;
+	level = k;
+    }
+    return level;
+}
+
+
+int
+prim_occ_skip(int level, int naxes, int cell[3], vect_t t, double *t0,
+	      const vect_t delta, const vect_t r_pt, const vect_t r_dir,
+	      const vect_t invdir, const vect_t origin, const vect_t cellsize)
+{
+    int size = PRIM_OCC_BRICK << level;
+    int lo[3];
+    double texit = INFINITY;
+    int out = -1;
+    int a;
+    point_t P;
+
+    for (a = 0; a < naxes; a++) {
+	double te;
+	int face;
+
+	lo[a] = (cell[a] / size) * size;
+	if (ZERO(r_dir[a]))
+	    continue;
+	face = (r_dir[a] > 0) ? lo[a] + size : lo[a];
+	te = (origin[a] + face * cellsize[a] - r_pt[a]) * invdir[a];
+	if (te < texit) {
+	    texit = te;
+	    out = a;
+	}
+    }
+    if (out < 0 || !(texit > *t0) || texit == INFINITY)
+	return -1;
+
+    VJOIN1(P, r_pt, texit, r_dir);
+    for (a = 0; a < naxes; a++) {
+	int c, j;
+
+	if (ZERO(r_dir[a]))
+	    continue;
+	if (a == out) {
+	    c = (r_dir[a] > 0) ? lo[a] + size : lo[a] - 1;
+	} else {
+	    c = (int)floor((P[a] - origin[a]) / cellsize[a]);
+	    if (c < lo[a])
+		c = lo[a];
+	    else if (c > lo[a] + size - 1)
+		c = lo[a] + size - 1;
+	}
+	j = (r_dir[a] > 0) ? c + 1 : c;
+	t[a] = (origin[a] + j * cellsize[a] - r_pt[a]) * invdir[a];
+
+	/* keep the next exit strictly ahead after rounding */
+	while (a != out && t[a] <= texit) {
+	    t[a] += delta[a];
+	    c += (r_dir[a] > 0) ? 1 : -1;
+	}
+	cell[a] = c;
+    }
+    *t0 = texit;
+    return out;
+}
+
+
 /**
  * Sort an array of hits into ascending order.
  */
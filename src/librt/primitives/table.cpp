@@ -1758,7 +1758,7 @@ const struct rt_functab OBJ[] = {
 	NULL, /* find_selections */
 	NULL, /* evaluate_selection */
 	NULL, /* process_selection */
-	NULL, /* serialize */
+	RTFUNCTAB_FUNC_PREP_SERIALIZE_CAST(rt_bot_prep_serialize),
 	NULL, /* label */
 	RTFUNCTAB_FUNC_KEYPOINT_CAST(rt_bot_keypoint), /* keypoint */
 	RTFUNCTAB_FUNC_MAT_CAST(rt_bot_mat),
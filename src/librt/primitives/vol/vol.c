@@ -43,6 +43,7 @@
 #include "raytrace.h"
 
 #include "../fixpt.h"
+#include "../../librt_private.h"
 
 
 /*
@@ -59,6 +60,7 @@ struct rt_vol_specific {
     mat_t vol_mat;	/* model to ideal space */
     vect_t vol_origin;	/* local coords of grid origin (0, 0, 0) for now */
     vect_t vol_large;	/* local coords of XYZ max */
+    struct prim_occ vol_occ;	/* bricks holding cells in [lo, hi] */
 };
 #define VOL_NULL ((struct rt_vol_specific *)0)
 
@@ -142,6 +144,7 @@ rt_vol_shot(struct soltab *stp, register struct xray *rp, struct application *ap
     int axis_set = 0;
     int out_axis = -INT_MAX;
     int j;
+    int level;
     struct xray ideal_ray;
 
     /* Transform actual ray into ideal space at origin in X-Y plane */
@@ -305,6 +308,18 @@ rt_vol_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 	int val;
 	struct seg *segp;
 
+	/* Outside the solid, jump over whole empty bricks at once */
+	if (!inside && (level = prim_occ_empty_level(&volp->vol_occ, igrid)) >= 0) {
+	    j = prim_occ_skip(level, 3, igrid, t, &t0, delta, rp->r_pt, rp->r_dir,
+			      invdir, volp->vol_origin, volp->vol_i.cellsize);
+	    if (j >= 0) {
+		if (RT_G_DEBUG&RT_DEBUG_VOL)bu_log("skipped level %d brick to [%d %d %d] at %g\n",
+						level, igrid[X], igrid[Y], igrid[Z], t0);
+		in_axis = j;
+		continue;
+	    }
+	}
+
 	/* find minimum exit t value */
 	if (t[X] < t[Y]) {
 	    if (t[Z] < t[X]) {
@@ -994,6 +1009,7 @@ rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     vect_t norm;
     vect_t radvec;
     vect_t diam;
+    size_t x, y, z;
 
     RT_CK_SOLTAB(stp);
     RT_CK_DB_INTERNAL(ip);
@@ -1002,6 +1018,12 @@ rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     vip = (struct rt_vol_internal *)ip->idb_ptr;
     RT_VOL_CK_MAGIC(vip);
 
+    /* Nothing to shoot without the bitmap */
+    if (!vip->map) {
+	bu_log("rt_vol_prep(%s): no bitmap data\n", stp->st_name);
+	return 1;
+    }
+
     BU_GET(volp, struct rt_vol_specific);
     volp->vol_i = *vip;		/* struct copy */
     vip->map = (unsigned char *)0;	/* "steal" the bitmap storage */
@@ -1021,6 +1043,19 @@ rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 
     /* Find bounding RPP of rotated local RPP */
     if (rt_vol_bbox(ip, &(stp->st_min), &(stp->st_max), &rtip->rti_tol)) return 1;
+
+    /* Note which bricks hold any cell in [lo, hi] */
+    prim_occ_init(&volp->vol_occ, volp->vol_i.xdim, volp->vol_i.ydim, volp->vol_i.zdim);
+    for (z = 0; z < volp->vol_i.zdim; z++) {
+	for (y = 0; y < volp->vol_i.ydim; y++) {
+	    const unsigned char *row = &VOL(&volp->vol_i, 0, y, z);
+	    for (x = 0; x < volp->vol_i.xdim; x++) {
+		if (OK(&volp->vol_i, row[x]))
+		    PRIM_OCC_MARK(&volp->vol_occ, x, y, z);
+	    }
+	}
+    }
+    prim_occ_finish(&volp->vol_occ);
     VSET(volp->vol_large,
 	 volp->vol_i.xdim*vip->cellsize[0], volp->vol_i.ydim*vip->cellsize[1], volp->vol_i.zdim*vip->cellsize[2]);/* type conversion */
 
@@ -1141,6 +1176,7 @@ rt_vol_free(struct soltab *stp)
 	bu_free((char *)volp->vol_i.map, "vol_map");
 	volp->vol_i.map = NULL; /* sanity */
     }
+    prim_occ_free(&volp->vol_occ);
     BU_PUT(volp, struct rt_vol_specific);
 }
 
@@ -0,0 +1,430 @@
+/*                     P R O F I L E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup rt_profile */
+/** @{ */
+/** @file librt/profile.cpp
+ *
+ * Ray cost accounting.  rt_shootray() charges each ft_shot() and
+ * ft_piece_shot() call to the calling processor's resource; the
+ * routines here merge, sort, report and store those counters.
+ *
+ */
+
+#include "common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include <string.h>
+
+#include "bu/avs.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "bu/vls.h"
+#include "raytrace.h"
+#include "librt_private.h"
+
+
+int64_t
+_rt_profile_clock(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void
+_rt_profile_res_init(struct resource *resp, struct rt_i *rtip)
+{
+    size_t nsolids;
+
+    RT_CK_RESOURCE(resp);
+    RT_CK_RTI(rtip);
+
+    nsolids = rtip->stats.nsolids;
+    if (resp->re_profile_len >= nsolids)
+	return;
+
+    resp->re_profile = (struct rt_profile_solid *)bu_realloc(resp->re_profile, nsolids * sizeof(struct rt_profile_solid), "re_profile[]");
+    memset(&resp->re_profile[resp->re_profile_len], 0, (nsolids - resp->re_profile_len) * sizeof(struct rt_profile_solid));
+    resp->re_profile_len = nsolids;
+}
+
+
+void
+_rt_profile_res_clean(struct resource *resp)
+{
+    if (resp->re_profile)
+	bu_free(resp->re_profile, "re_profile[]");
+    resp->re_profile = NULL;
+    resp->re_profile_len = 0;
+}
+
+
+/* Every resource that may have shot rays on rtip, including the
+ * default rt_uniresource used when a_resource is left unset. */
+static std::vector<struct resource *>
+profile_resources(struct rt_i *rtip)
+{
+    std::vector<struct resource *> res;
+    struct resource **rpp;
+
+    for (BU_PTBL_FOR(rpp, (struct resource **), &rtip->rti_resources)) {
+	if (*rpp && std::find(res.begin(), res.end(), *rpp) == res.end())
+	    res.push_back(*rpp);
+    }
+    if (std::find(res.begin(), res.end(), &rt_uniresource) == res.end())
+	res.push_back(&rt_uniresource);
+
+    return res;
+}
+
+
+/* Sum the per-processor tables into one row per st_bit. */
+static std::vector<struct rt_profile_solid>
+profile_merge(struct rt_i *rtip)
+{
+    std::vector<struct rt_profile_solid> totals(rtip->stats.nsolids);
+
+    memset(totals.data(), 0, totals.size() * sizeof(struct rt_profile_solid));
+    for (struct resource *resp : profile_resources(rtip)) {
+	size_t n = std::min(resp->re_profile_len, totals.size());
+	if (resp->re_magic != RESOURCE_MAGIC || !resp->re_profile)
+	    continue;
+	for (size_t i = 0; i < n; i++) {
+	    totals[i].shots += resp->re_profile[i].shots;
+	    totals[i].hits += resp->re_profile[i].hits;
+	    totals[i].nsec += resp->re_profile[i].nsec;
+	}
+    }
+
+    return totals;
+}
+
+
+static bool
+profile_costlier(const struct rt_profile_entry &a, const struct rt_profile_entry &b)
+{
+    if (a.cost.nsec != b.cost.nsec)
+	return a.cost.nsec > b.cost.nsec;
+    if (a.cost.shots != b.cost.shots)
+	return a.cost.shots > b.cost.shots;
+    return strcmp(a.name, b.name) < 0;
+}
+
+
+static size_t
+profile_export(std::vector<struct rt_profile_entry> &rows, struct rt_profile_entry **entries)
+{
+    std::sort(rows.begin(), rows.end(), profile_costlier);
+
+    *entries = NULL;
+    if (rows.empty())
+	return 0;
+
+    *entries = (struct rt_profile_entry *)bu_calloc(rows.size(), sizeof(struct rt_profile_entry), "rt_profile_entry[]");
+    std::copy(rows.begin(), rows.end(), *entries);
+    return rows.size();
+}
+
+
+void
+rt_profile_enable(struct rt_i *rtip, int enable)
+{
+    RT_CK_RTI(rtip);
+    rtip->i->rti_profile = enable ? 1 : 0;
+}
+
+
+int
+rt_profile_enabled(const struct rt_i *rtip)
+{
+    RT_CK_RTI(rtip);
+    return rtip->i->rti_profile;
+}
+
+
+void
+rt_profile_reset(struct rt_i *rtip)
+{
+    RT_CK_RTI(rtip);
+
+    for (struct resource *resp : profile_resources(rtip)) {
+	if (resp->re_magic == RESOURCE_MAGIC && resp->re_profile)
+	    memset(resp->re_profile, 0, resp->re_profile_len * sizeof(struct rt_profile_solid));
+    }
+}
+
+
+size_t
+rt_profile_solids(struct rt_i *rtip, struct rt_profile_entry **entries)
+{
+    std::vector<struct rt_profile_entry> rows;
+    struct soltab *stp;
+
+    RT_CK_RTI(rtip);
+    BU_ASSERT(entries != NULL);
+
+    std::vector<struct rt_profile_solid> totals = profile_merge(rtip);
+
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	struct rt_profile_entry e;
+	if (stp->st_bit < 0 || (size_t)stp->st_bit >= totals.size() || !totals[stp->st_bit].shots)
+	    continue;
+	e.name = stp->st_name;
+	e.stp = stp;
+	e.regp = NULL;
+	e.cost = totals[stp->st_bit];
+	rows.push_back(e);
+    } RT_VISIT_ALL_SOLTABS_END
+
+    return profile_export(rows, entries);
+}
+
+
+size_t
+rt_profile_regions(struct rt_i *rtip, struct rt_profile_entry **entries)
+{
+    std::vector<struct rt_profile_entry> rows;
+    std::map<const struct region *, struct rt_profile_solid> regs;
+    struct soltab *stp;
+
+    RT_CK_RTI(rtip);
+    BU_ASSERT(entries != NULL);
+
+    std::vector<struct rt_profile_solid> totals = profile_merge(rtip);
+
+    /* A primitive used by several regions is charged to each of them */
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_bit < 0 || (size_t)stp->st_bit >= totals.size() || !totals[stp->st_bit].shots)
+	    continue;
+	const struct rt_profile_solid &c = totals[stp->st_bit];
+	for (size_t i = 0; i < BU_PTBL_LEN(&stp->st_regions); i++) {
+	    const struct region *regp = (const struct region *)BU_PTBL_GET(&stp->st_regions, i);
+	    if (!regp)
+		continue;
+	    struct rt_profile_solid &r = regs[regp];
+	    r.shots += c.shots;
+	    r.hits += c.hits;
+	    r.nsec += c.nsec;
+	}
+    } RT_VISIT_ALL_SOLTABS_END
+
+    for (auto &rc : regs) {
+	struct rt_profile_entry e;
+	e.name = rc.first->reg_name;
+	e.stp = NULL;
+	e.regp = rc.first;
+	e.cost = rc.second;
+	rows.push_back(e);
+    }
+
+    return profile_export(rows, entries);
+}
+
+
+static void
+profile_report_rows(struct bu_vls *vls, const struct rt_profile_entry *rows, size_t cnt, size_t max, const char *what)
+{
+    int64_t total_nsec = 0;
+    size_t total_shots = 0;
+
+    for (size_t i = 0; i < cnt; i++) {
+	total_nsec += rows[i].cost.nsec;
+	total_shots += rows[i].cost.shots;
+    }
+
+    bu_vls_printf(vls, "%zu %s shot, %zu shots, %.3f ms\n", cnt, what, total_shots, (double)total_nsec * 1.0e-6);
+    if (!cnt)
+	return;
+
+    bu_vls_printf(vls, "  %%time          ms       shots        hits   ns/shot  type    name\n");
+    for (size_t i = 0; i < cnt && (!max || i < max); i++) {
+	const struct rt_profile_entry *e = &rows[i];
+	double pct = total_nsec > 0 ? 100.0 * (double)e->cost.nsec / (double)total_nsec : 0.0;
+	double per = (double)e->cost.nsec / (double)e->cost.shots;
+	const char *type = e->stp ? e->stp->st_meth->ft_label : "region";
+	bu_vls_printf(vls, "  %5.1f %11.3f %11zu %11zu %9.0f  %-6s  %s\n",
+		      pct, (double)e->cost.nsec * 1.0e-6, e->cost.shots, e->cost.hits, per, type, e->name);
+    }
+    if (max && cnt > max)
+	bu_vls_printf(vls, "  ... %zu more\n", cnt - max);
+}
+
+
+void
+rt_profile_report(struct bu_vls *vls, struct rt_i *rtip, size_t max)
+{
+    struct rt_profile_entry *rows = NULL;
+    size_t cnt;
+
+    BU_CK_VLS(vls);
+    RT_CK_RTI(rtip);
+
+    bu_vls_printf(vls, "Ray cost profile by primitive: ");
+    cnt = rt_profile_solids(rtip, &rows);
+    profile_report_rows(vls, rows, cnt, max, "primitives");
+    if (rows)
+	bu_free(rows, "rt_profile_entry[]");
+
+    bu_vls_printf(vls, "Ray cost profile by region: ");
+    cnt = rt_profile_regions(rtip, &rows);
+    profile_report_rows(vls, rows, cnt, max, "regions");
+    if (rows)
+	bu_free(rows, "rt_profile_entry[]");
+}
+
+
+/* Quote a CSV field, doubling any embedded quotes */
+static void
+profile_csv_name(FILE *fp, const char *name)
+{
+    fputc('"', fp);
+    for (const char *c = name; *c; c++) {
+	if (*c == '"')
+	    fputc('"', fp);
+	fputc(*c, fp);
+    }
+    fputc('"', fp);
+}
+
+
+static void
+profile_csv_rows(FILE *fp, const struct rt_profile_entry *rows, size_t cnt, const char *kind)
+{
+    for (size_t i = 0; i < cnt; i++) {
+	const struct rt_profile_entry *e = &rows[i];
+	fprintf(fp, "%s,", kind);
+	profile_csv_name(fp, e->name);
+	fprintf(fp, ",%s,%zu,%zu,%lld,%.1f\n",
+		e->stp ? e->stp->st_meth->ft_label : "region",
+		e->cost.shots, e->cost.hits, (long long)e->cost.nsec,
+		(double)e->cost.nsec / (double)e->cost.shots);
+    }
+}
+
+
+int
+rt_profile_csv(FILE *fp, struct rt_i *rtip)
+{
+    struct rt_profile_entry *rows = NULL;
+    size_t cnt;
+
+    RT_CK_RTI(rtip);
+    if (!fp)
+	return -1;
+
+    fprintf(fp, "kind,name,type,shots,hits,nsec,nsec_per_shot\n");
+
+    cnt = rt_profile_solids(rtip, &rows);
+    profile_csv_rows(fp, rows, cnt, "primitive");
+    if (rows)
+	bu_free(rows, "rt_profile_entry[]");
+
+    cnt = rt_profile_regions(rtip, &rows);
+    profile_csv_rows(fp, rows, cnt, "region");
+    if (rows)
+	bu_free(rows, "rt_profile_entry[]");
+
+    return ferror(fp) ? -1 : 0;
+}
+
+
+static void
+profile_sum(std::map<struct directory *, struct rt_profile_solid> &objs, struct directory *dp, const struct rt_profile_solid &c)
+{
+    struct rt_profile_solid &o = objs[dp];
+    o.shots += c.shots;
+    o.hits += c.hits;
+    o.nsec += c.nsec;
+}
+
+
+int
+rt_profile_write_attributes(struct rt_i *rtip)
+{
+    std::map<struct directory *, struct rt_profile_solid> objs;
+    struct rt_profile_entry *rows = NULL;
+    struct db_i *dbip;
+    size_t cnt;
+    int updated = 0;
+
+    RT_CK_RTI(rtip);
+    dbip = rtip->rti_dbip;
+    RT_CK_DBI(dbip);
+
+    if (dbip->dbi_read_only) {
+	bu_log("rt_profile_write_attributes: %s is read-only\n", dbip->dbi_filename);
+	return -1;
+    }
+
+    cnt = rt_profile_solids(rtip, &rows);
+    for (size_t i = 0; i < cnt; i++)
+	profile_sum(objs, (struct directory *)rows[i].stp->st_dp, rows[i].cost);
+    if (rows)
+	bu_free(rows, "rt_profile_entry[]");
+
+    /* Region names are full paths; the attributes go on the comb */
+    cnt = rt_profile_regions(rtip, &rows);
+    for (size_t i = 0; i < cnt; i++) {
+	struct db_full_path path;
+	db_full_path_init(&path);
+	if (db_string_to_path(&path, dbip, rows[i].name) == 0 && path.fp_len > 0)
+	    profile_sum(objs, DB_FULL_PATH_CUR_DIR(&path), rows[i].cost);
+	db_free_full_path(&path);
+    }
+    if (rows)
+	bu_free(rows, "rt_profile_entry[]");
+
+    for (auto &oc : objs) {
+	struct bu_attribute_value_set avs;
+	struct bu_vls val = BU_VLS_INIT_ZERO;
+
+	bu_avs_init_empty(&avs);
+	bu_vls_sprintf(&val, "%zu", oc.second.shots);
+	bu_avs_add(&avs, "rt_profile_shots", bu_vls_cstr(&val));
+	bu_vls_sprintf(&val, "%zu", oc.second.hits);
+	bu_avs_add(&avs, "rt_profile_hits", bu_vls_cstr(&val));
+	bu_vls_sprintf(&val, "%lld", (long long)oc.second.nsec);
+	bu_avs_add(&avs, "rt_profile_nsec", bu_vls_cstr(&val));
+	bu_vls_free(&val);
+
+	/* db5_update_attributes() frees the avs contents */
+	if (db5_update_attributes(oc.first, &avs, dbip) == 0)
+	    updated++;
+	else
+	    bu_log("rt_profile_write_attributes: unable to update %s\n", oc.first->d_namep);
+    }
+
+    return updated;
+}
+
+/** @} */
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
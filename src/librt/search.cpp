@@ -190,6 +190,7 @@ struct list_client_data_t {
 struct plan_analysis_t {
     int has_above;
     int has_below;
+    int has_exec;
     int has_maxdepth;
     int maxdepth;
 };
@@ -201,6 +202,7 @@ struct traversal_ctx_t {
     struct bu_ptbl *results;
     int flags;
     int result_cnt;
+    int has_exec;
     int has_maxdepth;
     int maxdepth;
 };
@@ -212,6 +214,30 @@ struct path_node_t {
 };
 
 
+/* Databases smaller than this are searched serially */
+#define SEARCH_PARALLEL_MIN_OBJS 512
+/* Comb levels below the start paths that may be split into work items */
+#define SEARCH_SPLIT_LEVELS 3
+#define SEARCH_ITEMS_PER_CPU 8
+
+
+/* One unit of parallel search work - either a single path to
+ * evaluate, or a path and everything beneath it */
+struct search_item_t {
+    struct path_node_t node;
+    int subtree;
+    struct bu_ptbl results;
+    int result_cnt;
+};
+
+
+struct search_parallel_t {
+    struct traversal_ctx_t *ctx;
+    std::vector<struct search_item_t> *items;
+    size_t next;			/* semaphored */
+};
+
+
 struct leaf_info_t {
     const char *name;
     int bool_op;
@@ -305,6 +331,7 @@ plan_analysis_init(struct plan_analysis_t *pa)
 	return;
     pa->has_above = 0;
     pa->has_below = 0;
+    pa->has_exec = 0;
     pa->has_maxdepth = 0;
     pa->maxdepth = INT_MAX;
 }
@@ -330,6 +357,9 @@ plan_analysis_update(const struct db_plan_t *plan, struct plan_analysis_t *pa)
 		if (p->p_un._bl_data[0])
 		    plan_analysis_update(p->p_un._bl_data[0], pa);
 		break;
+	    case N_EXEC:
+		pa->has_exec = 1;
+		break;
 	    case N_MAXDEPTH:
 		pa->has_maxdepth = 1;
 		if (p->p_un._max_data < pa->maxdepth)
@@ -395,6 +425,217 @@ collect_tree_leaves(union tree *tp, int curr_bool, std::vector<leaf_info_t> &lea
 }
 
 
+/*
+ * Per-database search index --
+ *
+ * -attr, -stdattr and -type need the attributes or the unpacked
+ * type of each object they visit, and a tree search visits shared
+ * objects once per path.  The index keeps both for each directory
+ * entry once they have been read.  It is created on first use, lives
+ * until the database is closed, and an object's entries are dropped
+ * whenever the database reports the object changed, added or
+ * removed.  In-memory (RT_DIR_INMEM) objects are updated without any
+ * such report, so they are always read directly.
+ */
+struct search_type_info_t {
+    int brlcad;			/* major type is DB5_MAJORTYPE_BRLCAD */
+    int minor_type;
+    int arb_type;		/* rt_arb_std_type() of an arb8 */
+    int is_sph;
+    int is_plate;		/* plate mode BoT or brep */
+    int is_solid;		/* encloses a volume */
+    const char *label;
+};
+
+
+struct search_index_t {
+    std::unordered_map<struct directory *, struct bu_attribute_value_set *> attrs;
+    std::unordered_map<struct directory *, struct search_type_info_t> types;
+};
+
+
+/* Guards the search index and the parallel work counter */
+static int search_sem = 0;
+
+
+static void
+search_index_changed(struct db_i *UNUSED(dbip), struct directory *dp, int UNUSED(mode), void *u_data)
+{
+    struct search_index_t *idx = (struct search_index_t *)u_data;
+
+    if (!idx || !dp)
+	return;
+
+    bu_semaphore_acquire(search_sem);
+    auto a_it = idx->attrs.find(dp);
+    if (a_it != idx->attrs.end()) {
+	bu_avs_free(a_it->second);
+	BU_FREE(a_it->second, struct bu_attribute_value_set);
+	idx->attrs.erase(a_it);
+    }
+    idx->types.erase(dp);
+    bu_semaphore_release(search_sem);
+}
+
+
+static void
+search_index_init(struct db_i *dbip)
+{
+    struct search_index_t *idx;
+
+    if (!search_sem)
+	search_sem = bu_semaphore_register("RT_SEM_SEARCH");
+
+    if (dbip->i->dbi_search_index)
+	return;
+
+    idx = new search_index_t;
+    dbip->i->dbi_search_index = (void *)idx;
+    db_add_changed_clbk(dbip, &search_index_changed, (void *)idx);
+}
+
+
+void
+db_search_index_free(struct db_i *dbip)
+{
+    struct search_index_t *idx;
+
+    if (!dbip || !dbip->i || !dbip->i->dbi_search_index)
+	return;
+
+    idx = (struct search_index_t *)dbip->i->dbi_search_index;
+    db_rm_changed_clbk(dbip, &search_index_changed, (void *)idx);
+    for (auto &a : idx->attrs) {
+	bu_avs_free(a.second);
+	BU_FREE(a.second, struct bu_attribute_value_set);
+    }
+    delete idx;
+    dbip->i->dbi_search_index = NULL;
+}
+
+
+/* Returns the attributes of dp, or NULL if they can't be read.
+ * Objects the index can't hold are read into scratch, which the
+ * caller must init empty beforehand and free afterwards.
+ */
+static struct bu_attribute_value_set *
+search_attrs(struct db_i *dbip, struct directory *dp, struct bu_attribute_value_set *scratch)
+{
+    struct search_index_t *idx = (struct search_index_t *)dbip->i->dbi_search_index;
+    struct bu_attribute_value_set *avs = NULL;
+
+    if (!idx || (dp->d_flags & RT_DIR_INMEM)) {
+	if (db5_get_attributes(dbip, scratch, dp) < 0)
+	    return NULL;
+	return scratch;
+    }
+
+    bu_semaphore_acquire(search_sem);
+    auto it = idx->attrs.find(dp);
+    if (it != idx->attrs.end())
+	avs = it->second;
+    bu_semaphore_release(search_sem);
+    if (avs)
+	return avs;
+
+    BU_ALLOC(avs, struct bu_attribute_value_set);
+    bu_avs_init_empty(avs);
+    if (db5_get_attributes(dbip, avs, dp) < 0) {
+	bu_avs_free(avs);
+	BU_FREE(avs, struct bu_attribute_value_set);
+	return NULL;
+    }
+
+    /* Another thread may have read the same object in the meantime */
+    bu_semaphore_acquire(search_sem);
+    auto ins = idx->attrs.insert(std::make_pair(dp, avs));
+    if (!ins.second) {
+	bu_avs_free(avs);
+	BU_FREE(avs, struct bu_attribute_value_set);
+	avs = ins.first->second;
+    }
+    bu_semaphore_release(search_sem);
+
+    return avs;
+}
+
+
+static int
+search_type_load(struct db_i *dbip, struct directory *dp, struct search_type_info_t *ti)
+{
+    struct rt_db_internal intern;
+    struct rt_bot_internal *bot_ip;
+    const struct bn_tol arb_tol = BN_TOL_INIT_TOL;
+
+    if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL) < 0)
+	return -1;
+
+    ti->brlcad = (intern.idb_major_type == DB5_MAJORTYPE_BRLCAD);
+    ti->minor_type = intern.idb_minor_type;
+    ti->arb_type = 0;
+    ti->is_sph = 0;
+    ti->is_plate = 0;
+    ti->is_solid = 1;
+    ti->label = (intern.idb_meth) ? intern.idb_meth->ft_label : NULL;
+
+    if (ti->brlcad) {
+	switch (intern.idb_minor_type) {
+	    case DB5_MINORTYPE_BRLCAD_ARB8:
+		ti->arb_type = rt_arb_std_type(&intern, &arb_tol);
+		break;
+	    case DB5_MINORTYPE_BRLCAD_ELL:
+		ti->is_sph = rt_ell_is_sph(&intern);
+		break;
+	    case DB5_MINORTYPE_BRLCAD_BOT:
+		bot_ip = (struct rt_bot_internal *)intern.idb_ptr;
+		ti->is_plate = (bot_ip->mode == RT_BOT_PLATE || bot_ip->mode == RT_BOT_PLATE_NOCOS);
+		ti->is_solid = (bot_ip->mode == RT_BOT_SOLID);
+		break;
+	    case DB5_MINORTYPE_BRLCAD_BREP:
+		ti->is_plate = rt_brep_plate_mode(&intern);
+		ti->is_solid = !ti->is_plate;
+		break;
+	    default:
+		break;
+	}
+    }
+
+    rt_db_free_internal(&intern);
+    return 0;
+}
+
+
+/* Fills in ti for dp.  Returns -1 if the object can't be read. */
+static int
+search_type(struct db_i *dbip, struct directory *dp, struct search_type_info_t *ti)
+{
+    struct search_index_t *idx = (struct search_index_t *)dbip->i->dbi_search_index;
+    int found = 0;
+
+    if (!idx || (dp->d_flags & RT_DIR_INMEM))
+	return search_type_load(dbip, dp, ti);
+
+    bu_semaphore_acquire(search_sem);
+    auto it = idx->types.find(dp);
+    if (it != idx->types.end()) {
+	*ti = it->second;
+	found = 1;
+    }
+    bu_semaphore_release(search_sem);
+    if (found)
+	return 0;
+
+    if (search_type_load(dbip, dp, ti) < 0)
+	return -1;
+
+    bu_semaphore_acquire(search_sem);
+    idx->types[dp] = *ti;
+    bu_semaphore_release(search_sem);
+
+    return 0;
+}
+
+
 static void
 evaluate_path(struct traversal_ctx_t *ctx, struct db_full_path *path)
 {
@@ -414,130 +655,293 @@ evaluate_path(struct traversal_ctx_t *ctx, struct db_full_path *path)
 }
 
 
+/* Returns 1 if the traversal should descend below node */
+static int
+node_expandable(struct traversal_ctx_t *ctx, const struct path_node_t *node)
+{
+    struct directory *dp;
+
+    if (ctx->has_maxdepth && node->depth >= ctx->maxdepth)
+	return 0;
+
+    dp = DB_FULL_PATH_CUR_DIR(node->path);
+    return (dp && (dp->d_flags & RT_DIR_COMB));
+}
+
+
+/* Append the children of the comb at node to kids, in comb tree
+ * order.
+ */
 static void
-traverse_paths(struct traversal_ctx_t *ctx, struct directory **paths, int path_cnt)
+expand_children(struct traversal_ctx_t *ctx, const struct path_node_t *node, std::vector<path_node_t> &kids)
 {
-    int i = 0;
-    std::deque<path_node_t> work;
+    struct rt_db_internal intern;
+    struct rt_comb_internal *comb = NULL;
+    struct db_full_path *path = node->path;
+    struct directory *dp = DB_FULL_PATH_CUR_DIR(path);
 
-    if (!ctx || !paths || path_cnt <= 0)
+    RT_DB_INTERNAL_INIT(&intern);
+    if (rt_db_get_internal(&intern, dp, ctx->dbip, (fastf_t *)NULL) < 0)
 	return;
 
-    for (i = 0; i < path_cnt; i++) {
-	struct directory *curr_dp = paths[i];
-	struct db_full_path *start_path = NULL;
-	struct path_node_t node;
+    comb = (struct rt_comb_internal *)intern.idb_ptr;
+    if (comb && comb->tree) {
+	std::vector<leaf_info_t> leaves;
+	std::unordered_map<std::string, int> c_inst_map;
 
-	if (curr_dp == RT_DIR_NULL)
-	    continue;
+	collect_tree_leaves(comb->tree, OP_UNION, leaves);
 
-	if ((ctx->flags & DB_SEARCH_HIDDEN) || !(curr_dp->d_flags & RT_DIR_HIDDEN)) {
-	    BU_ALLOC(start_path, struct db_full_path);
-	    db_full_path_init(start_path);
-	    db_add_node_to_full_path(start_path, curr_dp);
-	    DB_FULL_PATH_SET_CUR_BOOL(start_path, 2);
+	for (size_t li = 0; li < leaves.size(); li++) {
+	    struct directory *child_dp = NULL;
+	    struct db_full_path *child_path = NULL;
+	    const char *lname = leaves[li].name;
 
-	    if (ctx->flags & DB_SEARCH_FLAT) {
-		evaluate_path(ctx, start_path);
-		db_free_full_path(start_path);
-		BU_PUT(start_path, struct db_full_path);
-	    } else {
-		node.path = start_path;
-		node.depth = 0;
-		work.push_back(node);
+	    child_dp = db_lookup(ctx->dbip, lname, LOOKUP_QUIET);
+	    if (!child_dp)
+		continue;
+
+	    if (!(ctx->flags & DB_SEARCH_HIDDEN) && (child_dp->d_flags & RT_DIR_HIDDEN))
+		continue;
+
+	    BU_ALLOC(child_path, struct db_full_path);
+	    db_full_path_init(child_path);
+	    db_dup_full_path(child_path, path);
+	    db_add_node_to_full_path(child_path, child_dp);
+	    DB_FULL_PATH_SET_CUR_BOOL(child_path, leaves[li].bool_op);
+
+	    if (UNLIKELY(ctx->dbip->i->dbi_use_comb_instance_ids)) {
+		c_inst_map[std::string(lname)]++;
+		DB_FULL_PATH_SET_CUR_COMB_INST(child_path, c_inst_map[std::string(lname)] - 1);
 	    }
+
+	    if (db_full_path_cyclic(child_path, NULL, 0)) {
+		db_free_full_path(child_path);
+		BU_PUT(child_path, struct db_full_path);
+		continue;
+	    }
+
+	    path_node_t child_node;
+	    child_node.path = child_path;
+	    child_node.depth = node->depth + 1;
+	    kids.push_back(child_node);
 	}
     }
 
+    rt_db_free_internal(&intern);
+}
+
+
+/* Depth-first evaluation of everything on the work stack.  Paths are
+ * freed as they are finished with.
+ */
+static void
+traverse_subtrees(struct traversal_ctx_t *ctx, std::deque<path_node_t> &work)
+{
+    std::vector<path_node_t> kids;
+
     while (!work.empty()) {
 	struct path_node_t node;
-	struct db_full_path *path = NULL;
-	struct directory *dp = NULL;
 
 	node = work.back();
 	work.pop_back();
 
-	path = node.path;
-	if (!path) {
+	if (!node.path)
 	    continue;
-	}
 
-	evaluate_path(ctx, path);
+	evaluate_path(ctx, node.path);
 
-	if (ctx->has_maxdepth && node.depth >= ctx->maxdepth) {
-	    db_free_full_path(path);
-	    BU_PUT(path, struct db_full_path);
-	    continue;
+	if (node_expandable(ctx, &node)) {
+	    kids.clear();
+	    expand_children(ctx, &node, kids);
+	    for (size_t i = 0; i < kids.size(); i++)
+		work.push_back(kids[i]);
 	}
 
-	dp = DB_FULL_PATH_CUR_DIR(path);
-	if (!dp || !(dp->d_flags & RT_DIR_COMB)) {
-	    db_free_full_path(path);
-	    BU_PUT(path, struct db_full_path);
-	    continue;
-	}
+	db_free_full_path(node.path);
+	BU_PUT(node.path, struct db_full_path);
+    }
+}
 
-	/* Expand children */
-	{
-	    struct rt_db_internal intern;
-	    struct rt_comb_internal *comb = NULL;
 
-	    RT_DB_INTERNAL_INIT(&intern);
-	    if (rt_db_get_internal(&intern, dp, ctx->dbip, (fastf_t *)NULL) < 0) {
-		db_free_full_path(path);
-		BU_PUT(path, struct db_full_path);
-		continue;
-	    }
+static void
+search_parallel_worker(int UNUSED(cpu), void *data)
+{
+    struct search_parallel_t *sp = (struct search_parallel_t *)data;
 
-	    comb = (struct rt_comb_internal *)intern.idb_ptr;
-	    if (comb && comb->tree) {
-		std::vector<leaf_info_t> leaves;
-		std::unordered_map<std::string, int> c_inst_map;
+    while (1) {
+	struct search_item_t *item;
+	struct traversal_ctx_t ictx;
+	size_t mine;
 
-		collect_tree_leaves(comb->tree, OP_UNION, leaves);
+	bu_semaphore_acquire(search_sem);
+	mine = sp->next++;
+	bu_semaphore_release(search_sem);
 
-		for (size_t li = 0; li < leaves.size(); li++) {
-		    struct directory *child_dp = NULL;
-		    struct db_full_path *child_path = NULL;
-		    const char *lname = leaves[li].name;
+	if (mine >= sp->items->size())
+	    return;
 
-		    child_dp = db_lookup(ctx->dbip, lname, LOOKUP_QUIET);
-		    if (!child_dp)
-			continue;
+	item = &(*sp->items)[mine];
+	ictx = *sp->ctx;
+	ictx.results = (sp->ctx->results) ? &item->results : NULL;
+	ictx.result_cnt = 0;
 
-		    if (!(ctx->flags & DB_SEARCH_HIDDEN) && (child_dp->d_flags & RT_DIR_HIDDEN))
-			continue;
+	if (item->subtree) {
+	    std::deque<path_node_t> work;
+	    work.push_back(item->node);
+	    traverse_subtrees(&ictx, work);
+	} else {
+	    evaluate_path(&ictx, item->node.path);
+	    db_free_full_path(item->node.path);
+	    BU_PUT(item->node.path, struct db_full_path);
+	}
 
-		    BU_ALLOC(child_path, struct db_full_path);
-		    db_full_path_init(child_path);
-		    db_dup_full_path(child_path, path);
-		    db_add_node_to_full_path(child_path, child_dp);
-		    DB_FULL_PATH_SET_CUR_BOOL(child_path, leaves[li].bool_op);
+	item->result_cnt = ictx.result_cnt;
+    }
+}
 
-		    if (UNLIKELY(ctx->dbip->i->dbi_use_comb_instance_ids)) {
-			c_inst_map[std::string(lname)]++;
-			DB_FULL_PATH_SET_CUR_COMB_INST(child_path, c_inst_map[std::string(lname)] - 1);
-		    }
 
-		    if (db_full_path_cyclic(child_path, NULL, 0)) {
-			db_free_full_path(child_path);
-			BU_PUT(child_path, struct db_full_path);
-			continue;
-		    }
+/* Evaluate the plan for the start paths in roots across all available
+ * CPUs.  The paths are cut into work items in exactly the order the
+ * serial traversal would visit them, and the per-item results are
+ * merged back in that order, so the output is the same as a serial
+ * search.
+ */
+static void
+traverse_parallel(struct traversal_ctx_t *ctx, std::deque<path_node_t> &roots, size_t ncpu)
+{
+    std::vector<struct search_item_t> items;
+    struct search_parallel_t sp;
 
-		    path_node_t child_node;
-		    child_node.path = child_path;
-		    child_node.depth = node.depth + 1;
-		    work.push_back(child_node);
+    if (ctx->flags & DB_SEARCH_FLAT) {
+	for (size_t i = 0; i < roots.size(); i++) {
+	    struct search_item_t item;
+	    item.node = roots[i];
+	    item.subtree = 0;
+	    items.push_back(item);
+	}
+    } else {
+	/* The serial traversal pops roots off the back of its stack and
+	 * finishes each root's subtree before starting on the next. */
+	for (size_t i = roots.size(); i > 0; i--) {
+	    struct search_item_t item;
+	    item.node = roots[i-1];
+	    item.subtree = 1;
+	    items.push_back(item);
+	}
+
+	/* A database usually has only a few tops, so split the shallow
+	 * combs into their children until there are enough items to
+	 * keep every CPU busy.  A split comb becomes an evaluate-only
+	 * item followed by its children's subtrees, last child first. */
+	for (int level = 0; level < SEARCH_SPLIT_LEVELS && items.size() < ncpu * SEARCH_ITEMS_PER_CPU; level++) {
+	    std::vector<struct search_item_t> split;
+	    std::vector<path_node_t> kids;
+	    int expanded = 0;
+
+	    for (size_t i = 0; i < items.size(); i++) {
+		struct search_item_t item = items[i];
+
+		if (!item.subtree || !node_expandable(ctx, &item.node)) {
+		    split.push_back(item);
+		    continue;
 		}
+
+		kids.clear();
+		expand_children(ctx, &item.node, kids);
+		item.subtree = 0;
+		split.push_back(item);
+		for (size_t k = kids.size(); k > 0; k--) {
+		    struct search_item_t kitem;
+		    kitem.node = kids[k-1];
+		    kitem.subtree = 1;
+		    split.push_back(kitem);
+		}
+		expanded = 1;
 	    }
 
-	    rt_db_free_internal(&intern);
+	    items.swap(split);
+	    if (!expanded)
+		break;
+	}
+    }
+
+    for (size_t i = 0; i < items.size(); i++) {
+	BU_PTBL_INIT(&items[i].results);
+	items[i].result_cnt = 0;
+    }
+
+    sp.ctx = ctx;
+    sp.items = &items;
+    sp.next = 0;
+    bu_parallel(search_parallel_worker, ncpu, (void *)&sp);
+
+    for (size_t i = 0; i < items.size(); i++) {
+	struct bu_ptbl *ir = &items[i].results;
+
+	ctx->result_cnt += items[i].result_cnt;
+	if (ctx->results) {
+	    for (size_t j = 0; j < BU_PTBL_LEN(ir); j++) {
+		if (ctx->flags & DB_SEARCH_FLAT || ctx->flags & DB_SEARCH_RETURN_UNIQ_DP) {
+		    bu_ptbl_ins_unique(ctx->results, BU_PTBL_GET(ir, j));
+		} else {
+		    bu_ptbl_ins(ctx->results, BU_PTBL_GET(ir, j));
+		}
+	    }
+	}
+	bu_ptbl_free(ir);
+    }
+}
+
+
+static void
+traverse_paths(struct traversal_ctx_t *ctx, struct directory **paths, int path_cnt)
+{
+    int i = 0;
+    size_t ncpu;
+    std::deque<path_node_t> work;
+
+    if (!ctx || !paths || path_cnt <= 0)
+	return;
+
+    for (i = 0; i < path_cnt; i++) {
+	struct directory *curr_dp = paths[i];
+	struct db_full_path *start_path = NULL;
+	struct path_node_t node;
+
+	if (curr_dp == RT_DIR_NULL)
+	    continue;
+
+	if ((ctx->flags & DB_SEARCH_HIDDEN) || !(curr_dp->d_flags & RT_DIR_HIDDEN)) {
+	    BU_ALLOC(start_path, struct db_full_path);
+	    db_full_path_init(start_path);
+	    db_add_node_to_full_path(start_path, curr_dp);
+	    DB_FULL_PATH_SET_CUR_BOOL(start_path, 2);
+
+	    node.path = start_path;
+	    node.depth = 0;
+	    work.push_back(node);
 	}
+    }
 
-	db_free_full_path(path);
-	BU_PUT(path, struct db_full_path);
+    /* -exec hands paths to a caller supplied function, which has
+     * never been required to be thread-safe */
+    ncpu = bu_avail_cpus();
+    if (ncpu > 1 && !ctx->has_exec && !work.empty() &&
+	db_directory_size(ctx->dbip) >= SEARCH_PARALLEL_MIN_OBJS) {
+	traverse_parallel(ctx, work, ncpu);
+	return;
+    }
+
+    if (ctx->flags & DB_SEARCH_FLAT) {
+	for (size_t j = 0; j < work.size(); j++) {
+	    evaluate_path(ctx, work[j].path);
+	    db_free_full_path(work[j].path);
+	    BU_PUT(work[j].path, struct db_full_path);
+	}
+	return;
     }
+
+    traverse_subtrees(ctx, work);
 }
 
 
@@ -1217,25 +1621,15 @@ avs_check(const char *keystr, const char *value, int checkval, int strcomparison
 }
 
 
-/*
- * -param functions --
- *
- * True if the database object being examined has the parameter
- * supplied to the param option
+/* Split an -attr or -param expression into its name, comparison and
+ * value once, when the plan is formed.
  */
-static int
-f_objparam(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
+static void
+av_plan_init(struct db_plan_t *plan, const char *pattern)
 {
-    struct bu_vls paramname = BU_VLS_INIT_ZERO;
+    struct bu_vls name = BU_VLS_INIT_ZERO;
     struct bu_vls value = BU_VLS_INIT_ZERO;
-    struct bu_vls s_tcl = BU_VLS_INIT_ZERO;
-    struct rt_db_internal in;
-    struct bu_attribute_value_set avs;
-    int checkval = 0;
-    int strcomparison = 0;
     size_t i;
-    struct directory *dp;
-    int ret = 0;
 
     /* Check for unescaped >, < or = characters.  If present, the
      * attribute must not only be present but the value assigned to
@@ -1246,19 +1640,56 @@ f_objparam(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip,
      * matching.
      */
 
-    checkval = string_to_name_and_val(plan->p_un._attr_data, &paramname, &value);
+    plan->p_un.av._av_checkval = string_to_name_and_val(pattern, &name, &value);
 
     /* Now that we have the value, check to see if it is all numbers.
      * If so, use numerical comparison logic - otherwise use string
      * logic.
      */
 
-    for (i = 0; i < strlen(bu_vls_addr(&value)); i++) {
+    plan->p_un.av._av_strcmp = 0;
+    for (i = 0; i < bu_vls_strlen(&value); i++) {
 	if (!(isdigit((int)(bu_vls_addr(&value)[i])))) {
-	    strcomparison = 1;
+	    plan->p_un.av._av_strcmp = 1;
 	}
     }
 
+    plan->p_un.av._av_name = bu_vls_strdup(&name);
+    plan->p_un.av._av_value = bu_vls_strdup(&value);
+    bu_vls_free(&name);
+    bu_vls_free(&value);
+}
+
+
+static void
+free_av_plan(struct db_plan_t *splan)
+{
+    if (splan->p_un.av._av_name) {
+	bu_free(splan->p_un.av._av_name, "av_name");
+	splan->p_un.av._av_name = NULL;
+    }
+    if (splan->p_un.av._av_value) {
+	bu_free(splan->p_un.av._av_value, "av_value");
+	splan->p_un.av._av_value = NULL;
+    }
+}
+
+
+/*
+ * -param functions --
+ *
+ * True if the database object being examined has the parameter
+ * supplied to the param option
+ */
+static int
+f_objparam(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
+{
+    struct bu_vls s_tcl = BU_VLS_INIT_ZERO;
+    struct rt_db_internal in;
+    struct bu_attribute_value_set avs;
+    struct directory *dp;
+    int ret = 0;
+
     /* Get parameters for object as an avs.
      */
 
@@ -1290,11 +1721,10 @@ f_objparam(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip,
 	db_node->matched_filters = 0;
 	return 0;
     }
+    bu_vls_free(&s_tcl);
 
-    ret = avs_check(bu_vls_addr(&paramname), bu_vls_addr(&value), checkval, strcomparison, &avs);
+    ret = avs_check(plan->p_un.av._av_name, plan->p_un.av._av_value, plan->p_un.av._av_checkval, plan->p_un.av._av_strcmp, &avs);
     bu_avs_free(&avs);
-    bu_vls_free(&paramname);
-    bu_vls_free(&value);
     if (!ret)
 	db_node->matched_filters = 0;
     return ret;
@@ -1307,7 +1737,7 @@ c_objparam(char *pattern, char ***UNUSED(ignored), int UNUSED(unused), struct db
     struct db_plan_t *newplan;
 
     newplan = palloc(N_PARAM, f_objparam, tbl);
-    newplan->p_un._attr_data = pattern;
+    av_plan_init(newplan, pattern);
     (*resultplan) = newplan;
 
     return BRLCAD_OK;
@@ -1323,37 +1753,11 @@ c_objparam(char *pattern, char ***UNUSED(ignored), int UNUSED(unused), struct db
 static int
 f_attr(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
 {
-    struct bu_vls attribname = BU_VLS_INIT_ZERO;
-    struct bu_vls value = BU_VLS_INIT_ZERO;
-    struct bu_attribute_value_set avs;
-    int checkval = 0;
-    int strcomparison = 0;
-    size_t i;
+    struct bu_attribute_value_set scratch;
+    struct bu_attribute_value_set *avs;
     struct directory *dp;
     int ret = 0;
 
-    /* Check for unescaped >, < or = characters.  If present, the
-     * attribute must not only be present but the value assigned to
-     * the attribute must satisfy the logical expression.  In the case
-     * where a > or < is used with a string argument the behavior will
-     * follow ASCII lexicographical order.  In the case of equality
-     * between strings, bu_path_match() is used to support pattern
-     * matching.
-     */
-
-    checkval = string_to_name_and_val(plan->p_un._attr_data, &attribname, &value);
-
-    /* Now that we have the value, check to see if it is all numbers.
-     * If so, use numerical comparison logic - otherwise use string
-     * logic.
-     */
-
-    for (i = 0; i < strlen(bu_vls_addr(&value)); i++) {
-	if (!(isdigit((int)(bu_vls_addr(&value)[i])))) {
-	    strcomparison = 1;
-	}
-    }
-
     /* Get attributes for object.
      */
 
@@ -1363,17 +1767,12 @@ f_attr(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, str
 	return 0;
     }
 
-    bu_avs_init_empty(&avs);
-    if (db5_get_attributes(dbip, &avs, dp) < 0) {
-	bu_avs_free(&avs);
-	db_node->matched_filters = 0;
-	return 0;
-    }
+    bu_avs_init_empty(&scratch);
+    avs = search_attrs(dbip, dp, &scratch);
+    if (avs)
+	ret = avs_check(plan->p_un.av._av_name, plan->p_un.av._av_value, plan->p_un.av._av_checkval, plan->p_un.av._av_strcmp, avs);
+    bu_avs_free(&scratch);
 
-    ret = avs_check(bu_vls_addr(&attribname), bu_vls_addr(&value), checkval, strcomparison, &avs);
-    bu_avs_free(&avs);
-    bu_vls_free(&attribname);
-    bu_vls_free(&value);
     if (!ret)
 	db_node->matched_filters = 0;
     return ret;
@@ -1386,7 +1785,7 @@ c_attr(char *pattern, char ***UNUSED(ignored), int UNUSED(unused), struct db_pla
     struct db_plan_t *newplan;
 
     newplan = palloc(N_ATTR, f_attr, tbl);
-    newplan->p_un._attr_data = pattern;
+    av_plan_init(newplan, pattern);
     (*resultplan) = newplan;
     return BRLCAD_OK;
 }
@@ -1404,7 +1803,8 @@ static int
 f_stdattr(struct db_plan_t *UNUSED(plan), struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
 {
     struct bu_attribute_value_pair *avpp;
-    struct bu_attribute_value_set avs;
+    struct bu_attribute_value_set scratch;
+    struct bu_attribute_value_set *avs;
     struct directory *dp;
     int found_nonstd_attr = 0;
     int found_attr = 0;
@@ -1420,14 +1820,15 @@ f_stdattr(struct db_plan_t *UNUSED(plan), struct db_node_t *db_node, struct db_i
 	return 0;
     }
 
-    bu_avs_init_empty(&avs);
-    if (db5_get_attributes(dbip, &avs, dp) < 0) {
-	bu_avs_free(&avs);
+    bu_avs_init_empty(&scratch);
+    avs = search_attrs(dbip, dp, &scratch);
+    if (!avs) {
+	bu_avs_free(&scratch);
 	db_node->matched_filters = 0;
 	return 0;
     }
 
-    for (BU_AVS_FOR(avpp, &avs)) {
+    for (BU_AVS_FOR(avpp, avs)) {
 	found_attr = 1;
 	if (!BU_STR_EQUAL(avpp->name, "GIFTmater") &&
 	    !BU_STR_EQUAL(avpp->name, "aircode") &&
@@ -1443,7 +1844,7 @@ f_stdattr(struct db_plan_t *UNUSED(plan), struct db_node_t *db_node, struct db_i
 	}
     }
 
-    bu_avs_free(&avs);
+    bu_avs_free(&scratch);
 
     if (!found_nonstd_attr && found_attr) {
 	return 1;
@@ -1477,12 +1878,9 @@ c_stdattr(char *UNUSED(pattern), char ***UNUSED(ignored), int UNUSED(unused), st
 static int
 f_type(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
 {
-    struct rt_db_internal intern;
+    struct search_type_info_t ti;
     struct directory *dp;
-    struct rt_bot_internal *bot_ip;
     int type_match = 0;
-    int type;
-    const struct bn_tol arb_tol = BN_TOL_INIT_TOL;
 
     dp = DB_FULL_PATH_CUR_DIR(db_node->path);
     if (!dp)
@@ -1509,18 +1907,16 @@ f_type(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, str
 
     }
 
-    if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL) < 0)
+    if (search_type(dbip, dp, &ti) < 0)
 	return 0;
-    if (intern.idb_major_type != DB5_MAJORTYPE_BRLCAD) {
-	rt_db_free_internal(&intern);
+    if (!ti.brlcad) {
 	db_node->matched_filters = 0;
 	return 0;
     }
 
-    switch (intern.idb_minor_type) {
+    switch (ti.minor_type) {
 	case DB5_MINORTYPE_BRLCAD_ARB8:
-	    type = rt_arb_std_type(&intern, &arb_tol);
-	    switch (type) {
+	    switch (ti.arb_type) {
 		case ARB4:
 		    type_match = (!bu_path_match(plan->p_un._type_data, "arb4", 0));
 		    break;
@@ -1544,82 +1940,51 @@ f_type(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, str
 	case DB5_MINORTYPE_BRLCAD_ELL:
 	    /* are we looking for a sph? */
 	    if ((!bu_path_match(plan->p_un._type_data, "sph", 0) ||
-		 !bu_path_match(plan->p_un._type_data, "sphere", 0)) && rt_ell_is_sph(&intern)) {
+		 !bu_path_match(plan->p_un._type_data, "sphere", 0)) && ti.is_sph) {
 		type_match = 1;
 		break;
 	    }
 	    /* intentional fallthrough - we weren't looking for a sphere */
 	default:
-	    type_match = !bu_path_match(plan->p_un._type_data, intern.idb_meth->ft_label, 0);
+	    type_match = !bu_path_match(plan->p_un._type_data, ti.label, 0);
 	    break;
     }
 
     /* Match anything that doesn't define a 2D or 3D shape - unfortunately, this list will have to
      * be updated manually unless/until some functionality is added to generate it */
     if (!bu_path_match(plan->p_un._type_data, "shape", 0) &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_ANNOT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_COMBINATION &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_CONSTRAINT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_DATUM &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_GRIP &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_JOINT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_PNTS &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SCRIPT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SUBMODEL
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_ANNOT &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_COMBINATION &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_CONSTRAINT &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_DATUM &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_GRIP &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_JOINT &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_PNTS &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_SCRIPT &&
+	ti.minor_type != DB5_MINORTYPE_BRLCAD_SUBMODEL
 	) {
 	type_match = 1;
     }
 
-    if (!bu_path_match(plan->p_un._type_data, "plate", 0)) {
-	switch (intern.idb_minor_type) {
-	    case DB5_MINORTYPE_BRLCAD_BOT:
-		bot_ip = (struct rt_bot_internal *)intern.idb_ptr;
-		if (bot_ip->mode == RT_BOT_PLATE || bot_ip->mode == RT_BOT_PLATE_NOCOS) {
-		    type_match = 1;
-		}
-		break;
-	    case DB5_MINORTYPE_BRLCAD_BREP:
-		if (rt_brep_plate_mode(&intern)) {
-		    type_match = 1;
-		}
-		break;
-	    default:
-		break;
-	}
+    if (!bu_path_match(plan->p_un._type_data, "plate", 0) && ti.is_plate) {
+	type_match = 1;
     }
 
     if (!bu_path_match(plan->p_un._type_data, "volume", 0) &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_ANNOT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_COMBINATION &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_CONSTRAINT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_DATUM &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_GRIP &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_JOINT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_PNTS &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SCRIPT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SUBMODEL &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SKETCH) {
-	switch (intern.idb_minor_type) {
-	    case DB5_MINORTYPE_BRLCAD_BOT:
-		bot_ip = (struct rt_bot_internal *)intern.idb_ptr;
-		if (bot_ip->mode == RT_BOT_SOLID) {
-		    type_match = 1;
-		}
-		break;
-	    case DB5_MINORTYPE_BRLCAD_BREP:
-		if (!rt_brep_plate_mode(&intern)) {
-		    type_match = 1;
-		}
-		break;
-	    default:
-		type_match = 1;
-		break;
-	}
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_ANNOT &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_COMBINATION &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_CONSTRAINT &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_DATUM &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_GRIP &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_JOINT &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_PNTS &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_SCRIPT &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_SUBMODEL &&
+	    ti.minor_type != DB5_MINORTYPE_BRLCAD_SKETCH &&
+	    ti.is_solid) {
+	type_match = 1;
     }
 
-
-    rt_db_free_internal(&intern);
-
 return_label:
 
     if (!type_match)
@@ -2991,6 +3356,9 @@ db_search_free_plan(struct db_plan_t *splan)
 	    if (N_EXEC == p->type) {
 		free_exec_plan(p);
 	    }
+	    if (N_ATTR == p->type || N_PARAM == p->type) {
+		free_av_plan(p);
+	    }
 	    BU_PUT(p, struct db_plan_t);
 	}
     } else {
@@ -3000,6 +3368,9 @@ db_search_free_plan(struct db_plan_t *splan)
 	    if (N_EXEC == p->type) {
 		free_exec_plan(p);
 	    }
+	    if (N_ATTR == p->type || N_PARAM == p->type) {
+		free_av_plan(p);
+	    }
 	    BU_PUT(p, struct db_plan_t);
 	    p = plan;
 	}
@@ -3166,6 +3537,8 @@ db_search(struct bu_ptbl *search_results,
     plan_analysis_init(&plan_analysis);
     plan_analysis_update(dbplan, &plan_analysis);
 
+    search_index_init(dbip);
+
     /* execute the plan */
     {
 	struct bu_ptbl *full_paths = NULL;
@@ -3319,6 +3692,7 @@ db_search(struct bu_ptbl *search_results,
 	    tctx.results = search_results;
 	    tctx.flags = search_flags;
 	    tctx.result_cnt = 0;
+	    tctx.has_exec = plan_analysis.has_exec;
 	    tctx.has_maxdepth = plan_analysis.has_maxdepth;
 	    tctx.maxdepth = plan_analysis.maxdepth;
 
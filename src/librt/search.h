@@ -124,6 +124,12 @@ struct db_plan_t {
 	    int *_e_holes;
 	    int _e_nholes;
 	} ex;
+	struct _av {
+	    char *_av_name;		/* attribute or parameter name */
+	    char *_av_value;		/* comparison value, if any */
+	    int _av_checkval;		/* comparison operator, 0 tests presence */
+	    int _av_strcmp;		/* 1 compares as strings, 0 as numbers */
+	} av;
 	struct db_plan_t *_ab_data[2];	/* PLAN trees */
 	struct db_plan_t *_bl_data[2];  /* PLAN trees */
 	char *_a_data[2];		/* array of char pointers */
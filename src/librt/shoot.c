@@ -147,6 +147,22 @@ rt_res_pieces_clean(struct resource *resp, struct rt_i *rtip)
     _res_pieces_clean(resp, rtip);
 }
 
+/**
+ * Charge one ft_shot() or ft_piece_shot() call on stp, started at
+ * time t0, to this processor's ray cost table.
+ */
+static inline void
+shoot_profile(struct resource *resp, const struct soltab *stp, int ret, int64_t t0)
+{
+    struct rt_profile_solid *rpp = &resp->re_profile[stp->st_bit];
+
+    rpp->nsec += _rt_profile_clock() - t0;
+    rpp->shots++;
+    if (ret > 0)
+	rpp->hits++;
+}
+
+
 _BU_ATTR_FLATTEN const union cutter *
 rt_advance_to_next_cell(register struct rt_shootray_status *ssp)
 {
@@ -671,6 +687,7 @@ rt_shootray(register struct application *ap)
     struct resource *resp;
     struct rt_i *rtip;
     const int debug_shoot = RT_G_DEBUG & RT_DEBUG_SHOOT;
+    int profile;
     fastf_t pending_hit = 0; /* dist of closest odd hit pending */
 
     RT_AP_CHECK(ap);
@@ -757,6 +774,11 @@ rt_shootray(register struct application *ap)
 	/* Initialize this processors 'solid pieces' state */
 	_res_pieces_init(resp, rtip);
     }
+    profile = rtip->i->rti_profile;
+    if (UNLIKELY(profile) && resp->re_profile_len < rtip->stats.nsolids) {
+	/* Initialize (or grow) this processors ray cost table */
+	_rt_profile_res_init(resp, rtip);
+    }
     if (UNLIKELY(!BU_LIST_MAGIC_EQUAL(&resp->re_pieces_pending.l, BU_PTBL_MAGIC))) {
 	/* only happens first time through */
 	bu_ptbl_init(&resp->re_pieces_pending, 100, "re_pieces_pending");
@@ -1039,7 +1061,13 @@ rt_shootray(register struct application *ap)
 
 		ret = -1;
 		if (stp->st_meth->ft_piece_shot) {
-		    ret = stp->st_meth->ft_piece_shot(psp, plp, ss.dist_corr, &ss.newray, ap, &waiting_segs);
+		    if (UNLIKELY(profile)) {
+			int64_t t0 = _rt_profile_clock();
+			ret = stp->st_meth->ft_piece_shot(psp, plp, ss.dist_corr, &ss.newray, ap, &waiting_segs);
+			shoot_profile(resp, stp, ret, t0);
+		    } else {
+			ret = stp->st_meth->ft_piece_shot(psp, plp, ss.dist_corr, &ss.newray, ap, &waiting_segs);
+		    }
 		}
 		if (ret <= 0) {
 		    /* No hits at all */
@@ -1108,7 +1136,13 @@ rt_shootray(register struct application *ap)
 
 		ret = -1;
 		if (stp->st_meth->ft_shot) {
-		    ret = stp->st_meth->ft_shot(stp, &ss.newray, ap, &new_segs);
+		    if (UNLIKELY(profile)) {
+			int64_t t0 = _rt_profile_clock();
+			ret = stp->st_meth->ft_shot(stp, &ss.newray, ap, &new_segs);
+			shoot_profile(resp, stp, ret, t0);
+		    } else {
+			ret = stp->st_meth->ft_shot(stp, &ss.newray, ap, &new_segs);
+		    }
 		}
 		if (ret <= 0) {
 		    resp->re_shot_miss++;
@@ -0,0 +1,270 @@
+/*                  B O O L _ C O M P I L E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/tests/bool_compile.c
+ *
+ * Checks the region trees compiled by rt_bool_compile() against
+ * bool_eval().  A row of overlapping spheres is combined into regions
+ * with random union, subtraction, intersection and XOR trees, plus
+ * "X - (A u B u ...)" chains, and the model is shot twice: once with
+ * the compiled trees prep leaves in place, and once after they are
+ * released so rt_boolfinal() interprets every tree.  Both passes go
+ * through the full partition and region bit vector logic, and must
+ * give the same partitions.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/vls.h"
+#include "bn/randmt.h"
+#include "raytrace.h"
+#include "wdb.h"
+#include "../librt_private.h"
+
+#include "./test_shoot.h"
+
+
+#define NSOL 24
+#define NREG 300
+#define NRAY 2000
+#define WINDOW 8	/* leaves of a region come from this many neighbors */
+#define TOL 1.0e-9
+
+
+/* uniform in 0..n-1, from the seeded bn_randmt() sequence */
+static unsigned long
+bc_rand(unsigned long n)
+{
+    unsigned long r = (unsigned long)(bn_randmt() * n);
+    return (r < n) ? r : n - 1;
+}
+
+
+static union tree *
+bc_leaf(int first)
+{
+    union tree *tp;
+    char name[32];
+
+    BU_GET(tp, union tree);
+    RT_TREE_INIT(tp);
+    tp->tr_l.tl_op = OP_DB_LEAF;
+    snprintf(name, sizeof(name), "s%d.s", first + (int)bc_rand(WINDOW));
+    tp->tr_l.tl_name = bu_strdup(name);
+    tp->tr_l.tl_mat = (matp_t)NULL;
+    return tp;
+}
+
+
+static union tree *
+bc_node(int op, union tree *left, union tree *right)
+{
+    union tree *tp;
+
+    BU_GET(tp, union tree);
+    RT_TREE_INIT(tp);
+    tp->tr_b.tb_op = op;
+    tp->tr_b.tb_left = left;
+    tp->tr_b.tb_right = right;
+    return tp;
+}
+
+
+/* A random tree of the given depth over the spheres first..first+WINDOW-1 */
+static union tree *
+bc_tree(int depth, int first, int xor_ok)
+{
+    static const int ops[] = {OP_UNION, OP_UNION, OP_SUBTRACT, OP_SUBTRACT, OP_SUBTRACT,
+			      OP_INTERSECT, OP_INTERSECT, OP_XOR};
+    int op;
+
+    if (depth <= 0 || bc_rand(4) == 0)
+	return bc_leaf(first);
+    op = ops[bc_rand(sizeof(ops) / sizeof(ops[0]))];
+    if (op == OP_XOR && !xor_ok)
+	op = OP_UNION;
+    return bc_node(op, bc_tree(depth - 1, first, xor_ok), bc_tree(depth - 1, first, xor_ok));
+}
+
+
+/* n leaves joined by op */
+static union tree *
+bc_chain(int n, int op, int first)
+{
+    union tree *tp = bc_leaf(first);
+    int i;
+
+    for (i = 1; i < n; i++)
+	tp = bc_node(op, tp, bc_leaf(first));
+    return tp;
+}
+
+
+static void
+bc_region(struct rt_wdb *wdbp, const char *name, int id, union tree *tp)
+{
+    struct rt_comb_internal *comb;
+
+    BU_ALLOC(comb, struct rt_comb_internal);
+    RT_COMB_INTERNAL_INIT(comb);
+    comb->region_flag = 1;
+    comb->region_id = id;
+    comb->tree = tp;
+    if (wdb_export(wdbp, name, (void *)comb, ID_COMBINATION, 1.0) < 0)
+	bu_exit(1, "unable to write %s\n", name);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    struct db_i *dbip;
+    struct rt_wdb *wdbp;
+    struct rt_i *rtip;
+    struct region *regp;
+    struct wmember all;
+    struct bu_vls name = BU_VLS_INIT_ZERO;
+    struct test_shoot_ray *compiled;
+    size_t ncompiled = 0;
+    long npart = 0;
+    int failures = 0;
+    int i, j, k;
+
+    bu_setprogname(argv[0]);
+    if (argc > 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    bn_randmt_seed(1);
+
+    dbip = db_open_inmem();
+    wdbp = wdb_dbopen(dbip, RT_WDB_TYPE_DB_INMEM);
+
+    /* a row of spheres, each overlapping several neighbors */
+    for (i = 0; i < NSOL + WINDOW; i++) {
+	point_t center;
+	VSET(center, i * 4.0, (fastf_t)bc_rand(100) / 100.0 - 0.5, (fastf_t)bc_rand(100) / 100.0 - 0.5);
+	bu_vls_sprintf(&name, "s%d.s", i);
+	mk_sph(wdbp, bu_vls_cstr(&name), center, 5.0 + (fastf_t)bc_rand(400) / 100.0);
+    }
+
+    BU_LIST_INIT(&all.l);
+    for (i = 0; i < NREG; i++) {
+	int first = (int)bc_rand(NSOL);
+	union tree *tp;
+
+	if (i % 3 == 0) {
+	    /* X - (A u B u ...), with X a leaf, union or intersection */
+	    tp = bc_node(OP_SUBTRACT,
+			 bc_chain(1 + (int)bc_rand(3), bc_rand(2) ? OP_UNION : OP_INTERSECT, first),
+			 bc_chain(1 + (int)bc_rand(WINDOW), OP_UNION, first));
+	} else {
+	    tp = bc_tree(1 + (int)bc_rand(6), first, (int)bc_rand(2));
+	}
+	bu_vls_sprintf(&name, "r%d.r", i);
+	bc_region(wdbp, bu_vls_cstr(&name), 1000 + i, tp);
+	(void)mk_addmember(bu_vls_cstr(&name), &all.l, NULL, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "all.g", &all, 0, NULL, NULL, NULL, 0);
+    bu_vls_free(&name);
+
+    rtip = rt_new_rti(dbip);
+    if (rt_gettree(rtip, "all.g") != 0)
+	bu_exit(1, "rt_gettree failed\n");
+    rt_prep_parallel(rtip, 1);
+
+    for (BU_LIST_FOR(regp, region, &rtip->HeadRegion)) {
+	if (regp->reg_bool)
+	    ncompiled++;
+    }
+    if (!ncompiled) {
+	printf("  FAIL: no region trees were compiled\n");
+	failures++;
+    }
+
+    /* rays down the row, where every partition has many candidate
+     * regions, and across it */
+    compiled = (struct test_shoot_ray *)bu_calloc(NRAY, sizeof(struct test_shoot_ray), "compiled");
+    for (j = 0; j < 2; j++) {
+	bn_randmt_seed(12345);
+	for (i = 0; i < NRAY; i++) {
+	    struct test_shoot_ray interp;
+	    struct test_shoot_ray *res = (j == 0) ? &compiled[i] : &interp;
+	    point_t pt;
+	    vect_t dir;
+
+	    if (i % 2 == 0) {
+		VSET(pt, -20.0, (fastf_t)bc_rand(1000) / 100.0 - 5.0, (fastf_t)bc_rand(1000) / 100.0 - 5.0);
+		VSET(dir, 1.0, (fastf_t)bc_rand(100) / 1000.0 - 0.05, (fastf_t)bc_rand(100) / 1000.0 - 0.05);
+	    } else {
+		VSET(pt, (fastf_t)bc_rand(NSOL * 400) / 100.0, -20.0, (fastf_t)bc_rand(1000) / 100.0 - 5.0);
+		VSET(dir, (fastf_t)bc_rand(100) / 100.0 - 0.5, 1.0, (fastf_t)bc_rand(100) / 100.0 - 0.5);
+	    }
+	    VUNITIZE(dir);
+	    test_shoot(rtip, pt, dir, res);
+
+	    if (j == 0) {
+		npart += res->npart;
+		continue;
+	    }
+	    if (interp.npart != compiled[i].npart) {
+		printf("  FAIL: ray %d: %d partitions compiled, %d interpreted\n",
+		       i, compiled[i].npart, interp.npart);
+		failures++;
+		continue;
+	    }
+	    for (k = 0; k < interp.npart; k++) {
+		const struct test_shoot_part *a = &compiled[i].part[k];
+		const struct test_shoot_part *b = &interp.part[k];
+		if (a->regp != b->regp || !NEAR_EQUAL(a->in, b->in, TOL) || !NEAR_EQUAL(a->out, b->out, TOL)) {
+		    printf("  FAIL: ray %d partition %d: %s %g..%g compiled, %s %g..%g interpreted\n",
+			   i, k, a->regp->reg_name, a->in, a->out, b->regp->reg_name, b->in, b->out);
+		    failures++;
+		    break;
+		}
+	    }
+	}
+
+	/* second pass interprets every tree */
+	for (BU_LIST_FOR(regp, region, &rtip->HeadRegion))
+	    rt_bool_prog_free(regp);
+    }
+
+    bu_free(compiled, "compiled");
+    rt_free_rti(rtip);
+    db_close(dbip);
+
+    printf("bool_compile: %d regions, %zu compiled, %d rays, %ld partitions, %d failure(s)\n",
+	   NREG, ncompiled, NRAY, npart, failures);
+    return (failures > 0) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
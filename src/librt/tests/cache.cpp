@@ -30,6 +30,7 @@
 #include "bu/process.h"
 #include "bu/str.h"
 #include "raytrace.h"
+#include "../cut_hlbvh.h"
 
 const char *RTC_PREFIX = "rt_cache_test";
 
@@ -64,6 +65,52 @@ add_brep_sph(struct db_i *dbip, const char *name, point_t *v, double r, long int
     rt_db_free_internal(&intern);
 }
 
+static void
+add_bot_box(struct db_i *dbip, const char *name, point_t *v, double s, long int test_num)
+{
+    struct directory *dp;
+    struct rt_db_internal intern;
+    struct rt_bot_internal *bot;
+    static const int box_faces[36] = {
+	0, 2, 1,  0, 3, 2,  4, 5, 6,  4, 6, 7,
+	0, 1, 5,  0, 5, 4,  1, 2, 6,  1, 6, 5,
+	2, 3, 7,  2, 7, 6,  3, 0, 4,  3, 4, 7
+    };
+
+    RT_DB_INTERNAL_INIT(&intern);
+    intern.idb_major_type = DB5_MAJORTYPE_BRLCAD;
+    intern.idb_type = ID_BOT;
+    intern.idb_meth = &OBJ[ID_BOT];
+
+    BU_ALLOC(bot, struct rt_bot_internal);
+    intern.idb_ptr = (void *)bot;
+    bot->magic = RT_BOT_INTERNAL_MAGIC;
+    bot->mode = RT_BOT_SOLID;
+    bot->orientation = RT_BOT_CCW;
+    bot->num_vertices = 8;
+    bot->num_faces = 12;
+    bot->vertices = (fastf_t *)bu_calloc(8 * 3, sizeof(fastf_t), "bot vertices");
+    bot->faces = (int *)bu_malloc(sizeof(box_faces), "bot faces");
+    memcpy(bot->faces, box_faces, sizeof(box_faces));
+    for (int i = 0; i < 8; i++) {
+	fastf_t *p = &bot->vertices[i*3];
+	p[X] = (*v)[X] + ((i == 1 || i == 2 || i == 5 || i == 6) ? s : 0);
+	p[Y] = (*v)[Y] + ((i == 2 || i == 3 || i == 6 || i == 7) ? s : 0);
+	p[Z] = (*v)[Z] + ((i >= 4) ? s : 0);
+    }
+
+    dp = db_diradd(dbip, name, RT_DIR_PHONY_ADDR, 0, RT_DIR_SOLID, (void *)&intern.idb_type);
+    if (dp == RT_DIR_NULL) {
+	rt_db_free_internal(&intern);
+	bu_exit(1, "Test %ld: cannot add %s to directory\n", test_num, name);
+    }
+    if (rt_db_put_internal(dp, dbip, &intern) < 0) {
+	rt_db_free_internal(&intern);
+	bu_exit(1, "Test %ld: database write error, aborting\n", test_num);
+    }
+    rt_db_free_internal(&intern);
+}
+
 static void
 cp_brep_sph(struct db_i *dbip, const char *oname, const char *nname, long int test_num)
 {
@@ -367,6 +414,248 @@ subprocess_launcher(int id, void *data)
     bu_free(line, "line");
 }
 
+static int
+bot_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct bu_vls *hits = (struct bu_vls *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw) {
+	bu_vls_printf(hits, "%s %.6f %.6f\n", pp->pt_regionp->reg_name,
+		      pp->pt_inhit->hit_dist, pp->pt_outhit->hit_dist);
+    }
+    return 1;
+}
+
+static int
+bot_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+/* Shoot one ray down the row of boxes, recording what it hits. */
+static void
+bot_shoot(struct rt_i *rtip, struct bu_vls *hits)
+{
+    struct application ap;
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_hit = bot_hit;
+    ap.a_miss = bot_miss;
+    ap.a_uptr = (void *)hits;
+    VSET(ap.a_ray.r_pt, 0.5, -5, 0.5);
+    VSET(ap.a_ray.r_dir, 0, 1, 0);
+    (void)rt_shootray(&ap);
+}
+
+/* BoT prep round trip.  The first pass preps and stores one cache
+ * object per box, the second loads them, and both must report the same
+ * hits. */
+static int
+test_cache_bot(long int test_num, long int obj_cnt)
+{
+    struct bu_vls cache_dir = BU_VLS_INIT_ZERO;
+    struct bu_vls gfile = BU_VLS_INIT_ZERO;
+    struct bu_vls cname = BU_VLS_INIT_ZERO;
+    struct bu_vls hits_1 = BU_VLS_INIT_ZERO;
+    struct bu_vls hits_2 = BU_VLS_INIT_ZERO;
+    struct rt_i *rtip;
+    struct db_i *dbip;
+    char **ov;
+    point_t v = VINIT_ZERO;
+
+    bu_vls_sprintf(&cache_dir, "%s_dir_%ld_%ld", RTC_PREFIX, test_num, obj_cnt);
+    bu_vls_sprintf(&gfile, "%s_%ld_%ld.g", RTC_PREFIX, test_num, obj_cnt);
+
+    bu_setenv("LIBRT_CACHE", bu_dir(NULL, 0, BU_DIR_CURR, bu_vls_cstr(&cache_dir), NULL), 1);
+
+    // the boxes are far below the size normally worth caching
+    bu_setenv("LIBRT_BOT_CACHE_MIN", "0", 1);
+
+    if (bu_file_exists(getenv("LIBRT_CACHE"), NULL)) {
+	bu_exit(1, "Test %ld: stale test cache directory %s exists\n", test_num, getenv("LIBRT_CACHE"));
+    }
+
+    dbip = create_test_g_file(test_num, bu_vls_cstr(&gfile));
+
+    // A row of boxes of growing size along the Y axis
+    ov = (char **)bu_calloc(obj_cnt+1, sizeof(char *), "object array");
+    for (long int i = 0; i < obj_cnt; i++) {
+	bu_vls_sprintf(&cname, "box_%ld.s", i);
+	v[Y] = 3.0 * i;
+	add_bot_box(dbip, bu_vls_cstr(&cname), &v, 1.0 + 0.1 * i, test_num);
+	ov[i] = bu_strdup(bu_vls_cstr(&cname));
+    }
+    bu_vls_sprintf(&cname, "box_%ld.c", test_num);
+    add_comb(dbip, bu_vls_cstr(&cname), obj_cnt, (const char **)ov, test_num);
+    for (long int i = 0; i < obj_cnt; i++) {
+	bu_free(ov[i], "free string");
+    }
+    bu_free(ov, "free string array");
+
+    db_close(dbip);
+
+    rtip = build_rtip(test_num, bu_vls_cstr(&gfile), bu_vls_cstr(&cname), 1, 0, 1, NULL);
+    size_t cc = cache_count(bu_vls_cstr(&cache_dir), 0);
+    if (cc != (size_t)obj_cnt) {
+	bu_exit(1, "Test %ld: expected %ld cache object(s), found %zu\n", test_num, obj_cnt, cc);
+    }
+    bot_shoot(rtip, &hits_1);
+    rt_clean(rtip);
+    rt_free_rti(rtip);
+
+    /*** Now, do it again with the cache in place */
+    rtip = build_rtip(test_num, bu_vls_cstr(&gfile), bu_vls_cstr(&cname), 2, 0, 1, NULL);
+    bot_shoot(rtip, &hits_2);
+    rt_clean(rtip);
+    rt_free_rti(rtip);
+
+    if (!bu_vls_strlen(&hits_1) || bu_vls_strcmp(&hits_1, &hits_2)) {
+	bu_exit(1, "Test %ld: cached BoT prep shot differently:\n%s--\n%s", test_num, bu_vls_cstr(&hits_1), bu_vls_cstr(&hits_2));
+    }
+
+    cache_cleanup(&cache_dir);
+    bu_file_delete(bu_vls_cstr(&gfile));
+
+    bu_vls_free(&hits_1);
+    bu_vls_free(&hits_2);
+    bu_vls_free(&cache_dir);
+    bu_vls_free(&gfile);
+    bu_vls_free(&cname);
+    return 0;
+}
+
+/* Mirrors struct bot_prep_header in bot.c */
+struct bot_load_header {
+    uint32_t tag;
+    uint32_t sizes;
+    uint64_t max_prims;
+    double dist_sq;
+    uint64_t ntri;
+    uint64_t nnodes;
+    uint64_t has_normals;
+};
+
+/* Load a serialized BoT prep into stp, in place of its own */
+static int
+bot_load(struct soltab *stp, const struct rt_db_internal *ip, const struct bu_external *ext)
+{
+    struct bu_external copy;
+    void *prepped = stp->st_specific;
+    size_t version = 0;
+    int ret;
+
+    BU_EXTERNAL_INIT(&copy);
+    copy.ext_nbytes = ext->ext_nbytes;
+    copy.ext_buf = (uint8_t *)bu_malloc(ext->ext_nbytes, "bot load copy");
+    memcpy(copy.ext_buf, ext->ext_buf, ext->ext_nbytes);
+
+    stp->st_specific = NULL;
+    ret = rt_obj_prep_serialize(stp, ip, &copy, &version);
+    if (!ret)
+	stp->st_meth->ft_free(stp);
+    stp->st_specific = prepped;
+
+    bu_free_external(&copy);
+    return ret;
+}
+
+/* A damaged serialized BoT prep must be rejected, so the caller falls
+ * back to rt_bot_prep(), rather than loaded with node links, leaf
+ * ranges or face numbers pointing outside its arrays. */
+static int
+test_cache_bot_load(long int test_num)
+{
+    struct bu_vls gfile = BU_VLS_INIT_ZERO;
+    struct bu_external ext;
+    struct rt_db_internal intern;
+    struct bot_load_header hdr;
+    struct bvh_flat_node *node;
+    triangle_s *tri;
+    struct soltab *s, *stp = NULL;
+    struct rt_i *rtip;
+    struct db_i *dbip;
+    point_t v = VINIT_ZERO;
+    size_t version = 0;
+    long int leaf = -1, interior = -1;
+    int failures = 0;
+
+    bu_vls_sprintf(&gfile, "%s_%ld.g", RTC_PREFIX, test_num);
+    bu_setenv("LIBRT_CACHE", "0", 1);
+    bu_setenv("LIBRT_BOT_CACHE_MIN", "0", 1);
+    // small leaves, so the box gets interior nodes
+    bu_setenv("LIBRT_BOT_MINTIE", "2", 1);
+
+    dbip = create_test_g_file(test_num, bu_vls_cstr(&gfile));
+    add_bot_box(dbip, "box.s", &v, 1.0, test_num);
+    db_close(dbip);
+
+    rtip = build_rtip(test_num, bu_vls_cstr(&gfile), "box.s", 1, 0, 1, NULL);
+    RT_VISIT_ALL_SOLTABS_START(s, rtip) {
+	stp = s;
+    } RT_VISIT_ALL_SOLTABS_END;
+    if (!stp)
+	bu_exit(1, "Test %ld: box.s was not prepped\n", test_num);
+
+    RT_DB_INTERNAL_INIT(&intern);
+    if (rt_db_get_internal(&intern, stp->st_dp, rtip->rti_dbip, stp->st_matp) < 0)
+	bu_exit(1, "Test %ld: cannot read box.s\n", test_num);
+    BU_EXTERNAL_INIT(&ext);
+    if (rt_obj_prep_serialize(stp, &intern, &ext, &version) || ext.ext_nbytes < sizeof(hdr))
+	bu_exit(1, "Test %ld: box.s prep was not serialized\n", test_num);
+
+    memcpy(&hdr, ext.ext_buf, sizeof(hdr));
+    node = (struct bvh_flat_node *)(ext.ext_buf + sizeof(hdr));
+    tri = (triangle_s *)(ext.ext_buf + sizeof(hdr) + hdr.nnodes * sizeof(struct bvh_flat_node));
+    for (long int i = 0; i < (long int)hdr.nnodes; i++) {
+	if (node[i].n_primitives > 0 && leaf < 0)
+	    leaf = i;
+	if (node[i].n_primitives == 0 && interior < 0)
+	    interior = i;
+    }
+    if (leaf < 0 || interior < 0)
+	bu_exit(1, "Test %ld: expected leaf and interior nodes, got %ld nodes\n", test_num, (long int)hdr.nnodes);
+
+    if (bot_load(stp, &intern, &ext)) {
+	bu_log("Test %ld: intact BoT prep was rejected\n", test_num);
+	failures++;
+    }
+
+#define BOT_LOAD_BAD(what, field, value) { \
+	long int saved = (long int)(field); \
+	(field) = (value); \
+	if (!bot_load(stp, &intern, &ext)) { \
+	    bu_log("Test %ld: loaded BoT prep with %s\n", test_num, what); \
+	    failures++; \
+	} \
+	(field) = saved; \
+    }
+
+    BOT_LOAD_BAD("leaf past the triangles", node[leaf].data.first_prim_offset, (long int)hdr.ntri);
+    BOT_LOAD_BAD("leaf overrunning the triangles", node[leaf].data.first_prim_offset, (long int)hdr.ntri - node[leaf].n_primitives + 1);
+    BOT_LOAD_BAD("negative leaf offset", node[leaf].data.first_prim_offset, -1);
+    BOT_LOAD_BAD("oversized leaf", node[leaf].n_primitives, (long int)hdr.ntri + 1);
+    BOT_LOAD_BAD("negative leaf size", node[leaf].n_primitives, -1);
+    BOT_LOAD_BAD("child past the nodes", node[interior].data.first_prim_offset, (long int)hdr.nnodes);
+    BOT_LOAD_BAD("child on top of the first child", node[interior].data.first_prim_offset, interior + 1);
+    BOT_LOAD_BAD("child before its parent", node[interior].data.first_prim_offset, interior);
+    BOT_LOAD_BAD("face past the BoT faces", tri[hdr.ntri - 1].face_id, (long int)((struct rt_bot_internal *)intern.idb_ptr)->num_faces);
+
+#undef BOT_LOAD_BAD
+
+    bu_free_external(&ext);
+    rt_db_free_internal(&intern);
+    rt_clean(rtip);
+    rt_free_rti(rtip);
+    bu_file_delete(bu_vls_cstr(&gfile));
+    bu_vls_free(&gfile);
+
+    if (failures)
+	bu_exit(1, "Test %ld: %d damaged BoT prep(s) loaded\n", test_num, failures);
+    return 0;
+}
+
 /* Core test routine.  Check that the cache object is created, that only the
  * correct number of object(s) is/are created, and that a second rtip can be
  * successfully created after the cache is initialized. */
@@ -533,6 +822,8 @@ const char *rt_cache_test_usage =
 "       rt_cache 5 [obj_count] (Multiple distinct object serial test)\n"
 "       rt_cache 6 [obj_count] (Multiple distinct object parallel test)\n"
 "       rt_cache 7 [obj_count] (Multiple distinct objects, multiple instances in tree parallel test)\n"
+"       rt_cache 8 [obj_count] (Multiple distinct BoT objects, cached shot test)\n"
+"       rt_cache 9             (Damaged BoT prep load test)\n"
 "       rt_cache 20 [obj_count] [subprocess_count] (Multiple process identical objects test)\n"
 "       rt_cache 21 [obj_count] [subprocess_count] (Multiple process distinct objects test)\n";
 
@@ -612,6 +903,12 @@ main(int ac, char *av[])
 	case 7:
 	    /* Parallel prep API, multiple objects, non-unique content, multiple instances in tree */
 	    return test_cache(rp, test_num, obj_cnt, 1, 1, 0, 5);
+	case 8:
+	    /* Serial prep API, multiple BoT objects, shot before and after caching */
+	    return test_cache_bot(test_num, obj_cnt);
+	case 9:
+	    /* Damaged serialized BoT preps fall back to a fresh prep */
+	    return test_cache_bot_load(test_num);
 	case 20:
 	    /* Multiple objects, same content, multi-process */
 	    return test_cache(rp, test_num, obj_cnt, 1, 0, subprocess_cnt, 0);
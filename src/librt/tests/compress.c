@@ -0,0 +1,223 @@
+/*                      C O M P R E S S . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "bu/str.h"
+#include "raytrace.h"
+
+
+/* Round trip nbytes of pixel-like data through the LZ4 helpers */
+static int
+round_trip(size_t nbytes, int pattern)
+{
+    struct bu_external src, z, out;
+    size_t i;
+    int ret = 0;
+
+    BU_EXTERNAL_INIT(&src);
+    src.ext_nbytes = nbytes;
+    src.ext_buf = (uint8_t *)bu_malloc(nbytes + 1, "src");
+    for (i = 0; i < nbytes; i++) {
+	if (pattern)
+	    src.ext_buf[i] = (uint8_t)((i / 3 / 17) & 0xff);	/* flat runs */
+	else
+	    src.ext_buf[i] = (uint8_t)((i * 2654435761U) >> 24);	/* noise */
+    }
+
+    if (rt_compress_external(&z, &src) < 0) {
+	bu_log("compress of %zu bytes failed\n", nbytes);
+	bu_free_external(&src);
+	return 1;
+    }
+    if (rt_uncompress_external(&out, &z) < 0) {
+	bu_log("uncompress of %zu bytes failed\n", nbytes);
+	ret = 1;
+    } else if (out.ext_nbytes != nbytes || (nbytes && memcmp(out.ext_buf, src.ext_buf, nbytes) != 0)) {
+	bu_log("round trip of %zu bytes does not match\n", nbytes);
+	ret = 1;
+    }
+    if (pattern && nbytes > 4096 && z.ext_nbytes * 4 > nbytes) {
+	bu_log("%zu bytes of flat data only compressed to %zu\n", nbytes, z.ext_nbytes);
+	ret = 1;
+    }
+    if (out.ext_buf)
+	bu_free_external(&out);
+
+    /* The block need not be aligned */
+    {
+	struct bu_external shifted;
+	BU_EXTERNAL_INIT(&shifted);
+	shifted.ext_nbytes = z.ext_nbytes;
+	shifted.ext_buf = (uint8_t *)bu_malloc(z.ext_nbytes + 1, "shifted") + 1;
+	memcpy(shifted.ext_buf, z.ext_buf, z.ext_nbytes);
+	if (rt_uncompress_external(&out, &shifted) < 0 || out.ext_nbytes != nbytes) {
+	    bu_log("unaligned block of %zu bytes was not expanded\n", nbytes);
+	    ret = 1;
+	} else {
+	    bu_free_external(&out);
+	}
+	bu_free(shifted.ext_buf - 1, "shifted");
+    }
+
+    /* A header claiming more than LZ4 can expand to must be rejected
+     * before it sizes an allocation */
+    {
+	uint8_t huge[8] = {0x7f, 0xff, 0xff, 0xf0, 0x1f, 0, 0, 0};
+	struct bu_external bogus;
+	BU_EXTERNAL_INIT(&bogus);
+	bogus.ext_nbytes = sizeof(huge);
+	bogus.ext_buf = huge;
+	if (rt_uncompress_external(&out, &bogus) == 0) {
+	    bu_log("oversized header was accepted\n");
+	    bu_free_external(&out);
+	    ret = 1;
+	}
+	bogus.ext_nbytes = SIZEOF_NETWORK_LONG - 1;
+	if (rt_uncompress_external(&out, &bogus) == 0) {
+	    bu_log("short header was accepted\n");
+	    bu_free_external(&out);
+	    ret = 1;
+	}
+    }
+
+    /* A truncated block must be rejected, not overrun */
+    if (nbytes > 64) {
+	z.ext_nbytes /= 2;
+	if (rt_uncompress_external(&out, &z) == 0) {
+	    bu_log("truncated block of %zu bytes was accepted\n", nbytes);
+	    bu_free_external(&out);
+	    ret = 1;
+	}
+    }
+
+    bu_free_external(&z);
+    bu_free_external(&src);
+    return ret;
+}
+
+
+/* Write a v5 object with compressed sections and expand it again */
+static int
+db5_round_trip(size_t nbytes, int pattern)
+{
+    struct bu_external attrib, body, obj, plain;
+    struct bu_attribute_value_set avs;
+    struct db5_raw_internal raw;
+    uint32_t seed = 12345;
+    size_t i;
+    int ret = 0;
+
+    bu_avs_init_empty(&avs);
+    for (i = 0; i < 64; i++) {
+	char key[32];
+	snprintf(key, sizeof(key), "attr_%zu", i);
+	bu_avs_add(&avs, key, "a fairly repetitive attribute value");
+    }
+    db5_export_attributes(&attrib, &avs);
+
+    BU_EXTERNAL_INIT(&body);
+    body.ext_nbytes = nbytes;
+    body.ext_buf = (uint8_t *)bu_malloc(nbytes, "body");
+    for (i = 0; i < nbytes; i++) {
+	seed = seed * 1103515245U + 12345U;
+	if (pattern)
+	    body.ext_buf[i] = (uint8_t)((i / 3 / 17) & 0xff);
+	else
+	    body.ext_buf[i] = (uint8_t)(seed >> 24);	/* incompressible */
+    }
+
+    db5_export_object3(&obj, DB5HDR_HFLAGS_DLI_APPLICATION_DATA_OBJECT, "obj.s", 0,
+		       &attrib, &body, DB5_MAJORTYPE_BINARY_UNIF, DB5_MINORTYPE_BINU_8BITINT_U,
+		       DB5_ZZZ_LZ4, DB5_ZZZ_LZ4);
+    if (db5_get_raw_internal_ptr(&raw, obj.ext_buf) == NULL) {
+	bu_log("compressed object of %zu bytes does not parse\n", nbytes);
+	ret = 1;
+	goto done;
+    }
+    /* flat data must shrink, noise must fall back to uncompressed */
+    if (raw.a_zzz != DB5_ZZZ_LZ4 || raw.b_zzz != (pattern ? DB5_ZZZ_LZ4 : DB5_ZZZ_UNCOMPRESSED)) {
+	bu_log("object of %zu bytes has compression %d/%d\n", nbytes, raw.a_zzz, raw.b_zzz);
+	ret = 1;
+    }
+    if (pattern && obj.ext_nbytes * 4 > nbytes) {
+	bu_log("object of %zu bytes only compressed to %zu\n", nbytes, obj.ext_nbytes);
+	ret = 1;
+    }
+
+    if (db5_compress_external(&plain, &obj, DB5_ZZZ_UNCOMPRESSED) < 0
+	|| db5_get_raw_internal_ptr(&raw, plain.ext_buf) == NULL) {
+	bu_log("expanding object of %zu bytes failed\n", nbytes);
+	ret = 1;
+	goto done;
+    }
+    if (raw.a_zzz || raw.b_zzz || !BU_STR_EQUAL((const char *)raw.name.ext_buf, "obj.s")
+	|| raw.attributes.ext_nbytes != attrib.ext_nbytes
+	|| memcmp(raw.attributes.ext_buf, attrib.ext_buf, attrib.ext_nbytes) != 0
+	|| raw.body.ext_nbytes != nbytes
+	|| memcmp(raw.body.ext_buf, body.ext_buf, nbytes) != 0) {
+	bu_log("expanded object of %zu bytes does not match\n", nbytes);
+	ret = 1;
+    }
+    bu_free_external(&plain);
+
+done:
+    bu_free_external(&obj);
+    bu_free_external(&body);
+    bu_free_external(&attrib);
+    bu_avs_free(&avs);
+    return ret;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    ret += round_trip(0, 1);
+    ret += round_trip(3, 1);
+    ret += round_trip(1024*3, 0);
+    ret += round_trip(1024*768*3, 1);
+    ret += round_trip(1024*768*3, 0);
+
+    ret += db5_round_trip(1024*64, 1);
+    ret += db5_round_trip(1024*64, 0);
+
+    return ret ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
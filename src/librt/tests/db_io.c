@@ -0,0 +1,182 @@
+/*                         D B _ I O . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file db_io.c
+ *
+ * Concurrent db_read() and db_borrow_external() checks, against both
+ * a mapped (read-only) and an unmapped (read-write) database.
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+
+#define NOBJ 500
+#define NTHREAD 4	/* fixed, so even one-cpu hosts run readers concurrently */
+
+struct io_state {
+    struct db_i *dbip;
+    struct directory *dps[NOBJ];
+    struct bu_external refs[NOBJ];	/* copies read up front */
+    int failed;
+};
+
+
+static void
+io_worker(int cpu, void *data)
+{
+    struct io_state *s = (struct io_state *)data;
+    int round, i;
+
+    for (round = 0; round < 20; round++) {
+	for (i = 0; i < NOBJ; i++) {
+	    /* walk the objects in a different order on each thread */
+	    int j = (i * 7 + cpu * 13 + round) % NOBJ;
+	    struct bu_external ext;
+	    struct rt_db_internal intern;
+
+	    if (db_borrow_external(&ext, s->dps[j], s->dbip) < 0
+		|| ext.ext_nbytes != s->refs[j].ext_nbytes
+		|| memcmp(ext.ext_buf, s->refs[j].ext_buf, ext.ext_nbytes)) {
+		bu_log("borrowed %s does not match\n", s->dps[j]->d_namep);
+		s->failed = 1;
+	    }
+	    db_release_external(&ext, s->dbip);
+
+	    if (db_get_external(&ext, s->dps[j], s->dbip) < 0
+		|| ext.ext_nbytes != s->refs[j].ext_nbytes
+		|| memcmp(ext.ext_buf, s->refs[j].ext_buf, ext.ext_nbytes)) {
+		bu_log("copied %s does not match\n", s->dps[j]->d_namep);
+		s->failed = 1;
+	    }
+	    bu_free_external(&ext);
+
+	    if (rt_db_get_internal(&intern, s->dps[j], s->dbip, NULL) != ID_ELL) {
+		bu_log("import of %s failed\n", s->dps[j]->d_namep);
+		s->failed = 1;
+	    } else {
+		struct rt_ell_internal *ell = (struct rt_ell_internal *)intern.idb_ptr;
+		if (!NEAR_EQUAL(ell->v[X], (double)j, SMALL_FASTF)) {
+		    bu_log("import of %s has the wrong vertex\n", s->dps[j]->d_namep);
+		    s->failed = 1;
+		}
+		rt_db_free_internal(&intern);
+	    }
+	}
+    }
+}
+
+
+static int
+check_db(const char *path, const char *mode)
+{
+    struct io_state *s;
+    struct bu_vls name = BU_VLS_INIT_ZERO;
+    int i, ret;
+
+    BU_ALLOC(s, struct io_state);
+    s->dbip = db_open(path, mode);
+    if (s->dbip == DBI_NULL || db_dirbuild(s->dbip) < 0) {
+	bu_log("unable to open %s\n", path);
+	bu_free(s, "io_state");
+	return 1;
+    }
+
+    for (i = 0; i < NOBJ; i++) {
+	bu_vls_sprintf(&name, "s%d.s", i);
+	s->dps[i] = db_lookup(s->dbip, bu_vls_cstr(&name), LOOKUP_QUIET);
+	if (!s->dps[i] || db_get_external(&s->refs[i], s->dps[i], s->dbip) < 0) {
+	    bu_log("unable to read %s\n", bu_vls_cstr(&name));
+	    s->failed = 1;
+	    s->dps[i] = NULL;
+	    break;
+	}
+    }
+    bu_vls_free(&name);
+
+    if (!s->failed)
+	bu_parallel(io_worker, NTHREAD, s);
+
+    for (i = 0; i < NOBJ && s->dps[i]; i++)
+	bu_free_external(&s->refs[i]);
+    db_close(s->dbip);
+    ret = s->failed;
+    bu_free(s, "io_state");
+    return ret;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    char path[MAXPATHLEN];
+    struct rt_wdb *wdbp;
+    int i, ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    {
+	FILE *fp = bu_temp_file(path, MAXPATHLEN);
+	if (fp == NULL) {
+	    bu_log("%s error: unable to create temporary .g file\n", argv[0]);
+	    return 1;
+	}
+	fclose(fp);
+	bu_file_delete(path);
+    }
+
+    wdbp = wdb_fopen(path);
+    if (!wdbp) {
+	bu_log("%s error: unable to create %s\n", argv[0], path);
+	return 1;
+    }
+    for (i = 0; i < NOBJ; i++) {
+	char name[32];
+	point_t c;
+	VSET(c, i, 0, 0);
+	snprintf(name, sizeof(name), "s%d.s", i);
+	mk_sph(wdbp, name, c, 0.5 + i);
+    }
+    wdb_close(wdbp);
+
+    ret += check_db(path, DB_OPEN_READONLY);
+    ret += check_db(path, DB_OPEN_READWRITE);
+
+    bu_file_delete(path);
+    return ret ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
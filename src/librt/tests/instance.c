@@ -0,0 +1,266 @@
+/*                      I N S T A N C E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/tests/instance.c
+ *
+ * Checks instanced soltabs against ordinary ones.  One BoT is placed
+ * NPLACE times under rotated, scaled, mirrored and translated
+ * matrices, and the same rays are shot at the model twice: once with
+ * rti_dont_instance set, so every placement is prepped on its own,
+ * and once with instancing on.  Partitions, hit distances, normals
+ * and regions must match.  The mirrored placement is not instanced;
+ * it checks that reflected placements still go through ordinary prep.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/vls.h"
+#include "bn/mat.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#include "./test_shoot.h"
+
+
+#define NPLACE 6
+#define NGRID 9
+#define TOL 1.0e-6
+
+
+/* Rotate by (ax, ay, az) degrees, scale by s, then move to (tx, ty, tz) */
+static void
+inst_mat(mat_t m, double ax, double ay, double az, double s, double tx, double ty, double tz)
+{
+    int i, j;
+
+    bn_mat_angles(m, ax, ay, az);
+    for (i = 0; i < 3; i++)
+	for (j = 0; j < 3; j++)
+	    m[i*4+j] *= s;
+    MAT_DELTAS(m, tx, ty, tz);
+}
+
+
+static int
+inst_compare(const struct test_shoot_ray *a, const struct test_shoot_ray *b, const point_t pt, const vect_t dir)
+{
+    int i;
+
+    if (a->npart != b->npart) {
+	printf("  FAIL: ray (%g %g %g) dir (%g %g %g): %d partitions, %d instanced\n",
+	       V3ARGS(pt), V3ARGS(dir), a->npart, b->npart);
+	return 1;
+    }
+    for (i = 0; i < a->npart; i++) {
+	const struct test_shoot_part *pa = &a->part[i];
+	const struct test_shoot_part *pb = &b->part[i];
+
+	if (!NEAR_EQUAL(pa->in, pb->in, TOL) || !NEAR_EQUAL(pa->out, pb->out, TOL)
+	    || !VNEAR_EQUAL(pa->in_norm, pb->in_norm, TOL) || !VNEAR_EQUAL(pa->out_norm, pb->out_norm, TOL)
+	    || !BU_STR_EQUAL(pa->regp->reg_name, pb->regp->reg_name)) {
+	    printf("  FAIL: ray (%g %g %g) dir (%g %g %g) partition %d:\n"
+		   "    %s %.9g..%.9g in (%g %g %g) out (%g %g %g)\n"
+		   "    %s %.9g..%.9g in (%g %g %g) out (%g %g %g) instanced\n",
+		   V3ARGS(pt), V3ARGS(dir), i,
+		   pa->regp->reg_name, pa->in, pa->out, V3ARGS(pa->in_norm), V3ARGS(pa->out_norm),
+		   pb->regp->reg_name, pb->in, pb->out, V3ARGS(pb->in_norm), V3ARGS(pb->out_norm));
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+
+static struct rt_i *
+inst_prep(struct db_i *dbip, int dont_instance)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+
+    rtip->rti_dont_instance = dont_instance;
+    if (rt_gettree(rtip, "all.g") != 0)
+	bu_exit(1, "rt_gettree failed\n");
+    rt_prep_parallel(rtip, 1);
+    return rtip;
+}
+
+
+static size_t
+inst_count(struct rt_i *rtip)
+{
+    struct soltab *stp;
+    size_t cnt = 0;
+
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (BU_STR_EQUAL(stp->st_meth->ft_name, "ID_INSTANCE"))
+	    cnt++;
+    } RT_VISIT_ALL_SOLTABS_END;
+    return cnt;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    /* a closed, slightly irregular hexahedron, so that every face
+     * normal differs */
+    fastf_t verts[] = {
+	-10, -10, -10,	 12, -10, -10,	 10,  14, -10,	-10,  10, -10,
+	-10, -10,  10,	 10, -10,  12,	 10,  10,  10,	-12,  10,  10
+    };
+    int faces[] = {
+	0, 2, 1,  0, 3, 2,	/* bottom */
+	4, 5, 6,  4, 6, 7,	/* top */
+	0, 1, 5,  0, 5, 4,	/* front */
+	1, 2, 6,  1, 6, 5,	/* right */
+	2, 3, 7,  2, 7, 6,	/* back */
+	3, 0, 4,  3, 4, 7	/* left */
+    };
+    /* rotation (degrees), uniform scale, then translation */
+    const double place[NPLACE][7] = {
+	{  0,  0,  0, 1.0,   0, 0, 0},
+	{ 30, 10, 45, 1.0, 100, 0, 0},
+	{  0, 90,  0, 2.0, 200, 0, 0},
+	{ 15, 25, 35, 0.5, 300, 0, 0},
+	{ 60,  0, 20, 1.5, 400, 0, 0},
+	{ 10, 20, 30, 1.0, 500, 0, 0}	/* mirrored below */
+    };
+    const vect_t dirs[] = {
+	{0, 1, 0},
+	{0.3, 0.5, -0.8},
+	{-0.6, -0.2, 0.7}
+    };
+    struct db_i *dbip;
+    struct rt_wdb *wdbp;
+    struct rt_i *plain, *inst;
+    struct wmember all;
+    struct bu_vls name = BU_VLS_INIT_ZERO;
+    size_t ninst;
+    int failures = 0;
+    int nrays = 0;
+    int i, j, k, d;
+
+    bu_setprogname(argv[0]);
+    if (argc > 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    dbip = db_open_inmem();
+    wdbp = wdb_dbopen(dbip, RT_WDB_TYPE_DB_INMEM);
+    mk_bot(wdbp, "box.s", RT_BOT_SOLID, RT_BOT_CCW, 0, 8, 12, verts, faces, NULL, NULL);
+
+    /* one region per placement, all referencing the same BoT */
+    BU_LIST_INIT(&all.l);
+    for (i = 0; i < NPLACE; i++) {
+	struct wmember head, *wm;
+
+	BU_LIST_INIT(&head.l);
+	wm = mk_addmember("box.s", &head.l, NULL, WMOP_UNION);
+	inst_mat(wm->wm_mat, place[i][0], place[i][1], place[i][2], place[i][3], place[i][4], place[i][5], place[i][6]);
+	if (i == NPLACE - 1) {
+	    /* mirror in y */
+	    wm->wm_mat[1] = -wm->wm_mat[1];
+	    wm->wm_mat[5] = -wm->wm_mat[5];
+	    wm->wm_mat[9] = -wm->wm_mat[9];
+	}
+	bu_vls_sprintf(&name, "box%d.r", i);
+	mk_lcomb(wdbp, bu_vls_cstr(&name), &head, 1, NULL, NULL, NULL, 0);
+	(void)mk_addmember(bu_vls_cstr(&name), &all.l, NULL, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "all.g", &all, 0, NULL, NULL, NULL, 0);
+    db_update_nref(dbip);
+    bu_vls_free(&name);
+
+    plain = inst_prep(dbip, 1);
+    inst = inst_prep(dbip, 0);
+
+    if (inst_count(plain) != 0) {
+	printf("  FAIL: instances created with rti_dont_instance set\n");
+	failures++;
+    }
+    ninst = inst_count(inst);
+    if (ninst == 0) {
+	printf("  FAIL: no instances were created\n");
+	failures++;
+    }
+
+    /* a grid of rays through each placement from several directions */
+    for (i = 0; i < NPLACE; i++) {
+	for (d = 0; d < (int)(sizeof(dirs) / sizeof(dirs[0])); d++) {
+	    vect_t dir, u, v;
+
+	    VMOVE(dir, dirs[d]);
+	    VUNITIZE(dir);
+	    bn_vec_ortho(u, dir);
+	    VCROSS(v, dir, u);
+	    for (j = 0; j < NGRID; j++) {
+		for (k = 0; k < NGRID; k++) {
+		    struct test_shoot_ray a, b;
+		    point_t pt;
+		    fastf_t du = 50.0 * ((fastf_t)j / (NGRID - 1) - 0.5);
+		    fastf_t dv = 50.0 * ((fastf_t)k / (NGRID - 1) - 0.5);
+
+		    VSET(pt, place[i][4], place[i][5], place[i][6]);
+		    VJOIN3(pt, pt, -200.0, dir, du, u, dv, v);
+		    test_shoot(plain, pt, dir, &a);
+		    test_shoot(inst, pt, dir, &b);
+		    failures += inst_compare(&a, &b, pt, dir);
+		    nrays++;
+		}
+	    }
+	}
+    }
+
+    /* one ray down the row through every placement; the mirrored
+     * solid BoT is inside out, so only the others yield a partition */
+    {
+	struct test_shoot_ray a, b;
+	point_t pt = {-100, 0.5, 0.25};
+	vect_t dir = {1, 0, 0};
+
+	test_shoot(plain, pt, dir, &a);
+	test_shoot(inst, pt, dir, &b);
+	failures += inst_compare(&a, &b, pt, dir);
+	if (a.npart != NPLACE - 1) {
+	    printf("  FAIL: expected %d partitions along the row, got %d\n", NPLACE - 1, a.npart);
+	    failures++;
+	}
+	nrays++;
+    }
+
+    rt_free_rti(plain);
+    rt_free_rti(inst);
+    db_close(dbip);
+
+    printf("instance: %d rays, %zu instances, %d failure(s)\n", nrays, ninst, failures);
+    return (failures > 0) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,295 @@
+/*                       P R O F I L E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/tests/profile.c
+ *
+ * Checks the ray cost profiler against a known set of rays: per
+ * primitive and per region counts, sorting, enable/disable, reset,
+ * CSV output and attribute write-back.
+ *
+ * Two spheres, each in its own region under all.g:
+ *
+ *   big.s   r=5 at (-20, 0, 0)  in big.r,   hit by NBIG rays
+ *   small.s r=2 at ( 20, 0, 0)  in small.r, hit by NSMALL rays
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/avs.h"
+#include "bu/vls.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+
+#define NBIG 10
+#define NSMALL 4
+
+
+static int
+profile_hit(struct application *UNUSED(ap), struct partition *UNUSED(PartHeadp), struct seg *UNUSED(segs))
+{
+    return 1;
+}
+
+
+static int
+profile_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+/* Shoot n rays along +Y, spread in Z, through the plane x = x */
+static void
+profile_shoot(struct rt_i *rtip, fastf_t x, int n)
+{
+    struct application ap;
+    int i;
+
+    for (i = 0; i < n; i++) {
+	RT_APPLICATION_INIT(&ap);
+	ap.a_rt_i = rtip;
+	ap.a_hit = profile_hit;
+	ap.a_miss = profile_miss;
+	VSET(ap.a_ray.r_pt, x, -50, -0.5 + (fastf_t)i / (fastf_t)n);
+	VSET(ap.a_ray.r_dir, 0, 1, 0);
+	(void)rt_shootray(&ap);
+    }
+}
+
+
+static const struct rt_profile_entry *
+profile_find(const struct rt_profile_entry *rows, size_t cnt, const char *name)
+{
+    size_t i;
+    for (i = 0; i < cnt; i++) {
+	if (BU_STR_EQUAL(rows[i].name, name))
+	    return &rows[i];
+    }
+    return NULL;
+}
+
+
+static int
+profile_check(struct rt_i *rtip, int scale)
+{
+    struct rt_profile_entry *rows = NULL;
+    const struct rt_profile_entry *e;
+    size_t cnt, i;
+    int failures = 0;
+
+    cnt = rt_profile_solids(rtip, &rows);
+    if (cnt != 2) {
+	printf("  FAIL: expected 2 primitives, got %zu\n", cnt);
+	failures++;
+    }
+    e = profile_find(rows, cnt, "big.s");
+    if (!e || e->cost.hits != (size_t)(NBIG * scale) || e->cost.shots < e->cost.hits || !e->stp || e->regp) {
+	printf("  FAIL: big.s hits %zu, expected %d\n", e ? e->cost.hits : 0, NBIG * scale);
+	failures++;
+    }
+    e = profile_find(rows, cnt, "small.s");
+    if (!e || e->cost.hits != (size_t)(NSMALL * scale) || e->cost.shots < e->cost.hits) {
+	printf("  FAIL: small.s hits %zu, expected %d\n", e ? e->cost.hits : 0, NSMALL * scale);
+	failures++;
+    }
+    for (i = 1; i < cnt; i++) {
+	if (rows[i].cost.nsec > rows[i-1].cost.nsec) {
+	    printf("  FAIL: primitives not sorted by cost\n");
+	    failures++;
+	}
+    }
+    if (rows)
+	bu_free(rows, "rows");
+
+    cnt = rt_profile_regions(rtip, &rows);
+    if (cnt != 2) {
+	printf("  FAIL: expected 2 regions, got %zu\n", cnt);
+	failures++;
+    }
+    e = profile_find(rows, cnt, "/all.g/big.r");
+    if (!e || e->cost.hits != (size_t)(NBIG * scale) || !e->regp || e->stp) {
+	printf("  FAIL: /all.g/big.r hits %zu, expected %d\n", e ? e->cost.hits : 0, NBIG * scale);
+	failures++;
+    }
+    e = profile_find(rows, cnt, "/all.g/small.r");
+    if (!e || e->cost.hits != (size_t)(NSMALL * scale)) {
+	printf("  FAIL: /all.g/small.r hits %zu, expected %d\n", e ? e->cost.hits : 0, NSMALL * scale);
+	failures++;
+    }
+    if (rows)
+	bu_free(rows, "rows");
+
+    return failures;
+}
+
+
+static int
+profile_check_attr(struct db_i *dbip, const char *name, const char *expected)
+{
+    struct bu_attribute_value_set avs;
+    struct directory *dp;
+    const char *val;
+    int failures = 0;
+
+    dp = db_lookup(dbip, name, LOOKUP_QUIET);
+    bu_avs_init_empty(&avs);
+    if (!dp || db5_get_attributes(dbip, &avs, dp) < 0) {
+	printf("  FAIL: unable to read attributes of %s\n", name);
+	return 1;
+    }
+    val = bu_avs_get(&avs, "rt_profile_hits");
+    if (!val || !BU_STR_EQUAL(val, expected)) {
+	printf("  FAIL: %s rt_profile_hits=%s, expected %s\n", name, val ? val : "(none)", expected);
+	failures++;
+    }
+    if (!bu_avs_get(&avs, "rt_profile_shots") || !bu_avs_get(&avs, "rt_profile_nsec")) {
+	printf("  FAIL: %s is missing profile attributes\n", name);
+	failures++;
+    }
+    bu_avs_free(&avs);
+    return failures;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    struct db_i *dbip;
+    struct rt_wdb *wdbp;
+    struct rt_i *rtip;
+    struct wmember head;
+    struct rt_profile_entry *rows = NULL;
+    struct bu_vls report = BU_VLS_INIT_ZERO;
+    point_t c;
+    FILE *fp;
+    char line[256];
+    int lines = 0;
+    int failures = 0;
+
+    bu_setprogname(argv[0]);
+    if (argc > 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    dbip = db_open_inmem();
+    wdbp = wdb_dbopen(dbip, RT_WDB_TYPE_DB_INMEM);
+    VSET(c, -20, 0, 0);
+    mk_sph(wdbp, "big.s", c, 5.0);
+    VSET(c, 20, 0, 0);
+    mk_sph(wdbp, "small.s", c, 2.0);
+    mk_comb1(wdbp, "big.r", "big.s", 1);
+    mk_comb1(wdbp, "small.r", "small.s", 1);
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("big.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("small.r", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "all.g", &head, 0, NULL, NULL, NULL, 0);
+    db_update_nref(dbip);
+
+    rtip = rt_new_rti(dbip);
+    if (rt_gettree(rtip, "all.g") != 0)
+	bu_exit(1, "rt_gettree failed\n");
+    rt_prep_parallel(rtip, 1);
+
+    /* Nothing is recorded until profiling is enabled */
+    profile_shoot(rtip, -20, NBIG);
+    if (rt_profile_solids(rtip, &rows) != 0) {
+	printf("  FAIL: costs recorded while disabled\n");
+	failures++;
+    }
+
+    rt_profile_enable(rtip, 1);
+    if (!rt_profile_enabled(rtip)) {
+	printf("  FAIL: rt_profile_enabled() after enable\n");
+	failures++;
+    }
+    profile_shoot(rtip, -20, NBIG);
+    profile_shoot(rtip, 20, NSMALL);
+    profile_shoot(rtip, 0, 3);	/* between the two, hits nothing */
+    failures += profile_check(rtip, 1);
+
+    /* Counters accumulate until reset */
+    profile_shoot(rtip, -20, NBIG);
+    profile_shoot(rtip, 20, NSMALL);
+    failures += profile_check(rtip, 2);
+
+    rt_profile_report(&report, rtip, 10);
+    printf("%s", bu_vls_cstr(&report));
+    if (!strstr(bu_vls_cstr(&report), "big.s") || !strstr(bu_vls_cstr(&report), "/all.g/small.r")) {
+	printf("  FAIL: report is missing entries\n");
+	failures++;
+    }
+    bu_vls_free(&report);
+
+    fp = tmpfile();
+    if (!fp || rt_profile_csv(fp, rtip) != 0) {
+	printf("  FAIL: rt_profile_csv\n");
+	failures++;
+    } else {
+	rewind(fp);
+	while (fgets(line, sizeof(line), fp))
+	    lines++;
+	if (lines != 5) {
+	    printf("  FAIL: expected 5 CSV lines, got %d\n", lines);
+	    failures++;
+	}
+    }
+    if (fp)
+	fclose(fp);
+
+    if (rt_profile_write_attributes(rtip) != 4) {
+	printf("  FAIL: rt_profile_write_attributes did not update 4 objects\n");
+	failures++;
+    }
+    failures += profile_check_attr(dbip, "big.s", "20");
+    failures += profile_check_attr(dbip, "big.r", "20");
+    failures += profile_check_attr(dbip, "small.r", "8");
+
+    rt_profile_reset(rtip);
+    if (rt_profile_solids(rtip, &rows) != 0) {
+	printf("  FAIL: costs remain after reset\n");
+	failures++;
+    }
+
+    rt_profile_enable(rtip, 0);
+    profile_shoot(rtip, -20, NBIG);
+    if (rt_profile_solids(rtip, &rows) != 0) {
+	printf("  FAIL: costs recorded after disable\n");
+	failures++;
+    }
+
+    rt_free_rti(rtip);
+    db_close(dbip);
+
+    printf("profile: %d failure(s)\n", failures);
+    return (failures > 0) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
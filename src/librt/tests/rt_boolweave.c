@@ -24,16 +24,19 @@
 
 #include "common.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h> /* for ap init */
 
 #include "bu.h"
+#include "bn/randmt.h"
 #include "rt/boolweave.h"
 #include "rt/rt_instance.h"
 #include "rt/resource.h"
 #include "rt/db_io.h"
 #include "rt/seg.h"
+#include "rt/ray_partition.h"
 
 
 static struct seg*
@@ -41,6 +44,7 @@ create_segment(double in_dist, double out_dist)
 {
     struct seg* segment;
     RT_GET_SEG(segment, (&rt_uniresource));
+    segment->seg_stp = NULL;
     segment->seg_in.hit_dist = in_dist;
     segment->seg_out.hit_dist = out_dist;
     return segment;
@@ -105,14 +109,174 @@ test_rt_boolweave(void)
 }
 
 
+/* Weave one segment set with the given method.  The segment number is
+ * kept in seg_in.hit_surfno so the two weaves can be matched up. */
+static void
+weave_with(struct application *ap, int method, size_t nseg, const double *dist,
+	   struct seg *out_hd, struct partition *PartHdp)
+{
+    struct seg in_hd;
+    size_t i;
+
+    BU_LIST_INIT(&in_hd.l);
+    BU_LIST_INIT(&out_hd->l);
+    PartHdp->pt_forw = PartHdp->pt_back = PartHdp;
+    PartHdp->pt_magic = PT_HD_MAGIC;
+
+    for (i = 0; i < nseg; i++) {
+	struct seg *segp = create_segment(dist[2*i], dist[2*i+1]);
+	segp->seg_in.hit_surfno = (int)i;
+	segp->seg_out.hit_surfno = (int)i;
+	BU_LIST_INSERT(&(in_hd.l), &(segp->l));
+    }
+
+    ap->a_rt_i->rti_weave = method;
+    rt_boolweave(out_hd, &in_hd, PartHdp, ap);
+}
+
+
+/* The sorted segment numbers of a partition */
+static size_t
+weave_members(const struct partition *pp, int *ids, size_t max)
+{
+    size_t i, j, n = 0;
+
+    for (i = 0; i < BU_PTBL_LEN(&pp->pt_seglist) && n < max; i++) {
+	const struct seg *segp = (const struct seg *)BU_PTBL_GET(&pp->pt_seglist, i);
+	int id = segp->seg_in.hit_surfno;
+	for (j = n; j > 0 && ids[j-1] > id; j--)
+	    ids[j] = ids[j-1];
+	ids[j] = id;
+	n++;
+    }
+    return n;
+}
+
+
+#define WEAVE_MAXSEG 400
+
+/* The sorted endpoint sweep must give the same partitions as the
+ * list weave: the same count, boundaries within tolerance and the
+ * same contributing segments.  Endpoints are drawn from a coarse grid
+ * so many coincide exactly, some are nudged by less than the distance
+ * tolerance, and some segments have zero thickness. */
+static int
+test_weave_sweep(void)
+{
+    static double dist[2*WEAVE_MAXSEG], sorted[2*WEAVE_MAXSEG];
+    static int ids_l[WEAVE_MAXSEG], ids_s[WEAVE_MAXSEG];
+    struct application ap;
+    struct rt_i *rtip;
+    double tol;
+    long nparts = 0;
+    int failures = 0;
+    int trial;
+
+    RT_APPLICATION_INIT(&ap);
+    rtip = rt_dirbuild_inmem(NULL, 0, NULL, 0);
+    ap.a_rt_i = rtip;
+    ap.a_resource = &rt_uniresource;
+    tol = rtip->rti_tol.dist;
+
+    /* a fixed sequence, so failures are reproducible */
+    bn_randmt_seed(1);
+
+    for (trial = 0; trial < 500; trial++) {
+	struct seg list_hd, sweep_hd;
+	struct partition list_parts, sweep_parts;
+	struct partition *lp, *sp;
+	size_t nseg = 1 + (size_t)(bn_randmt() * ((trial % 4) ? 63 : WEAVE_MAXSEG - 1));
+	double grid = (trial % 2) ? 1.0 : 10.0;
+	size_t i;
+	int k;
+
+	for (i = 0; i < nseg; i++) {
+	    double in = floor(bn_randmt() * 100.0 / grid) * grid;
+	    double out = in + floor(bn_randmt() * 30.0 / grid) * grid;
+	    double r = bn_randmt();
+
+	    if (r < 0.15) {
+		out = in;		/* zero thickness */
+	    } else if (r < 0.3) {
+		in += tol * 0.4 * bn_randmt();	/* coincident within tolerance */
+		out -= tol * 0.4 * bn_randmt();
+	    } else if (r < 0.4) {
+		in += bn_randmt();		/* off the grid */
+		out = in + bn_randmt() * 5.0;
+	    }
+	    if (out < in)
+		out = in;
+	    dist[2*i] = in;
+	    dist[2*i+1] = out;
+	}
+
+	/* Half the time the zero-thickness segments arrive last, which
+	 * the sweep weaves itself; otherwise they are mixed in and the
+	 * sweep leaves the ray to the list weave. */
+	if (trial % 4 >= 2) {
+	    size_t n = 0;
+	    int pass;
+	    for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < nseg; i++) {
+		    if ((dist[2*i+1] - dist[2*i] < tol) == pass) {
+			sorted[2*n] = dist[2*i];
+			sorted[2*n+1] = dist[2*i+1];
+			n++;
+		    }
+		}
+	    }
+	    memcpy(dist, sorted, 2 * nseg * sizeof(double));
+	}
+
+	weave_with(&ap, RT_WEAVE_LIST, nseg, dist, &list_hd, &list_parts);
+	weave_with(&ap, RT_WEAVE_SWEEP, nseg, dist, &sweep_hd, &sweep_parts);
+
+	for (lp = list_parts.pt_forw, sp = sweep_parts.pt_forw, k = 0;
+	     lp != &list_parts && sp != &sweep_parts;
+	     lp = lp->pt_forw, sp = sp->pt_forw, k++) {
+	    size_t nl = weave_members(lp, ids_l, WEAVE_MAXSEG);
+	    size_t ns = weave_members(sp, ids_s, WEAVE_MAXSEG);
+
+	    if (!NEAR_EQUAL(lp->pt_inhit->hit_dist, sp->pt_inhit->hit_dist, tol)
+		|| !NEAR_EQUAL(lp->pt_outhit->hit_dist, sp->pt_outhit->hit_dist, tol)
+		|| nl != ns || (nl && memcmp(ids_l, ids_s, nl * sizeof(int)) != 0)) {
+		bu_log("trial %d partition %d: list %g..%g (%zu segs), sweep %g..%g (%zu segs)\n",
+		       trial, k, lp->pt_inhit->hit_dist, lp->pt_outhit->hit_dist, nl,
+		       sp->pt_inhit->hit_dist, sp->pt_outhit->hit_dist, ns);
+		failures++;
+		break;
+	    }
+	    nparts++;
+	}
+	if ((lp == &list_parts) != (sp == &sweep_parts)) {
+	    bu_log("trial %d: partition counts differ after %d\n", trial, k);
+	    failures++;
+	}
+
+	RT_FREE_PT_LIST(&list_parts, (&rt_uniresource));
+	RT_FREE_PT_LIST(&sweep_parts, (&rt_uniresource));
+	RT_FREE_SEG_LIST(&list_hd, (&rt_uniresource));
+	RT_FREE_SEG_LIST(&sweep_hd, (&rt_uniresource));
+    }
+
+    rt_free_rti(rtip);
+    bu_log("weave sweep: 500 segment sets, %ld partitions, %d failure(s)\n", nparts, failures);
+    return failures;
+}
+
+
 int
 main(int ac, char *av[])
 {
+    int failures = 0;
+
     bu_setprogname(av[0]);
-    if (ac && av)
+    if (ac && av) {
 	test_rt_boolweave();
+	failures += test_weave_sweep();
+    }
 
-    return 0;
+    return (failures > 0) ? 1 : 0;
 }
 
 
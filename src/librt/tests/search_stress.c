@@ -2140,6 +2140,108 @@ test_csg_below_perf(struct db_i *dbip, int fan_w, int fan_k)
     return failures;
 }
 
+/* ------------------------------------------------------------------ */
+/*  Attribute/type index on a disk database                           */
+/* ------------------------------------------------------------------ */
+
+static int
+flat_count(struct db_i *dbip, const char *filter)
+{
+    struct bu_ptbl results = BU_PTBL_INIT_ZERO;
+    int cnt = db_search(&results, DB_SEARCH_FLAT, filter, 0, NULL, dbip,
+			NULL, NULL, NULL);
+    int len = (int)BU_PTBL_LEN(&results);
+    bu_ptbl_free(&results);
+    return (cnt < 0) ? cnt : len;
+}
+
+
+/*
+ * db_search() keeps the attributes and types of objects it has read
+ * from a disk database.  Build enough objects for the search to run
+ * in parallel, then check the answers follow the database as objects
+ * are edited and removed.
+ */
+static int
+test_attr_index(void)
+{
+    int failures = 0;
+    int new_cnt, old_cnt;
+    char tmpfile[MAXPATHLEN];
+    char name[64], val[64];
+    point_t center = VINIT_ZERO;
+    struct wmember wm, top;
+    struct directory *dp;
+    struct db_i *dbip;
+    struct rt_wdb *wdbp;
+    FILE *fp;
+    int i, j;
+
+    fp = bu_temp_file(tmpfile, MAXPATHLEN);
+    if (!fp) {
+	bu_log("ERROR: unable to create temporary .g file\n");
+	return 1;
+    }
+    fclose(fp);
+
+    dbip = db_create(tmpfile, 5);
+    if (dbip == DBI_NULL) {
+	bu_log("ERROR: db_create of %s failed\n", tmpfile);
+	bu_file_delete(tmpfile);
+	return 1;
+    }
+    wdbp = wdb_dbopen(dbip, RT_WDB_TYPE_DB_DISK);
+
+    /* 60 regions of 10 spheres each, region_id 0, 100, ... 5900 */
+    BU_LIST_INIT(&top.l);
+    for (i = 0; i < 60; i++) {
+	BU_LIST_INIT(&wm.l);
+	for (j = 0; j < 10; j++) {
+	    snprintf(name, sizeof(name), "idx_%d_%d.s", i, j);
+	    mk_sph(wdbp, name, center, 1.0);
+	    mk_addmember(name, &wm.l, NULL, (j % 4 == 3) ? WMOP_SUBTRACT : WMOP_UNION);
+	}
+	snprintf(name, sizeof(name), "idx_%d.r", i);
+	mk_lcomb(wdbp, name, &wm, 1, NULL, NULL, NULL, 0);
+	snprintf(val, sizeof(val), "%d", i * 100);
+	db5_update_attribute(name, "region_id", val, dbip);
+	mk_addmember(name, &top.l, NULL, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "idx_all", &top, 0, NULL, NULL, NULL, 0);
+    db_update_nref(dbip);
+
+    CHECK(flat_count(dbip, "-attr region_id>1000") == 49, "index: -attr region_id>1000");
+    CHECK(flat_count(dbip, "-type region") == 60, "index: -type region");
+    CHECK(flat_count(dbip, "-type sph") == 600, "index: -type sph");
+
+    run_both(dbip, DB_SEARCH_TREE, "-attr region_id>1000", &new_cnt, &old_cnt);
+    CROSS_CHECK(new_cnt, old_cnt, "-attr region_id>1000 (disk)");
+    run_both(dbip, DB_SEARCH_TREE, "-type region", &new_cnt, &old_cnt);
+    CROSS_CHECK(new_cnt, old_cnt, "-type region (disk)");
+
+    /* Edits must be seen by the next search */
+    db5_update_attribute("idx_3.r", "region_id", "5000", dbip);
+    db5_update_attribute("idx_55.r", "region_id", "5", dbip);
+    CHECK(flat_count(dbip, "-attr region_id>1000 -name idx_3.r") == 1, "index: edited attribute now matches");
+    CHECK(flat_count(dbip, "-attr region_id>1000 -name idx_55.r") == 0, "index: edited attribute no longer matches");
+    CHECK(flat_count(dbip, "-attr region_id>1000") == 49, "index: -attr region_id>1000 after edit");
+
+    /* ... as must removals */
+    dp = db_lookup(dbip, "idx_20.r", LOOKUP_QUIET);
+    if (dp && db_delete(dbip, dp) == 0)
+	db_dirdelete(dbip, dp);
+    CHECK(flat_count(dbip, "-attr region_id>1000") == 48, "index: -attr region_id>1000 after kill");
+    CHECK(flat_count(dbip, "-type region") == 59, "index: -type region after kill");
+
+    run_both(dbip, DB_SEARCH_TREE, "-attr region_id<=1000", &new_cnt, &old_cnt);
+    CROSS_CHECK(new_cnt, old_cnt, "-attr region_id<=1000 (disk)");
+
+    wdb_close(wdbp);
+    bu_file_delete(tmpfile);
+    return failures;
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -2193,6 +2295,9 @@ main(int argc, char *argv[])
     /* wdb_close also closes dbip via db_close */
     wdb_close(wdbp);
 
+    bu_log("Running attribute/type index tests...\n");
+    failures += test_attr_index();
+
     /* ---- Stress tests at increasing depths ---- */
     {
         int depths[] = {3, 5, 7, 0};
@@ -0,0 +1,108 @@
+/*                   T E S T _ S H O O T . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/tests/test_shoot.h
+ *
+ * Shoot one ray and keep its partitions, for tests that compare the
+ * results of two ways of raytracing the same geometry.
+ */
+
+#ifndef LIBRT_TESTS_TEST_SHOOT_H
+#define LIBRT_TESTS_TEST_SHOOT_H
+
+#include "common.h"
+
+#include <string.h>
+
+#include "vmath.h"
+#include "raytrace.h"
+
+
+#define TEST_SHOOT_MAXPART 64
+
+
+struct test_shoot_part {
+    fastf_t in, out;
+    vect_t in_norm, out_norm;
+    const struct region *regp;
+};
+
+struct test_shoot_ray {
+    int npart;
+    struct test_shoot_part part[TEST_SHOOT_MAXPART];
+};
+
+
+static int
+test_shoot_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct test_shoot_ray *res = (struct test_shoot_ray *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp && res->npart < TEST_SHOOT_MAXPART; pp = pp->pt_forw) {
+	struct test_shoot_part *p = &res->part[res->npart++];
+
+	p->in = pp->pt_inhit->hit_dist;
+	p->out = pp->pt_outhit->hit_dist;
+	RT_HIT_NORMAL(p->in_norm, pp->pt_inhit, pp->pt_inseg->seg_stp, &ap->a_ray, pp->pt_inflip);
+	RT_HIT_NORMAL(p->out_norm, pp->pt_outhit, pp->pt_outseg->seg_stp, &ap->a_ray, pp->pt_outflip);
+	p->regp = pp->pt_regionp;
+    }
+    return 1;
+}
+
+
+static int
+test_shoot_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+/* Fire one ray from pt along dir into rtip, filling in res */
+static void
+test_shoot(struct rt_i *rtip, const point_t pt, const vect_t dir, struct test_shoot_ray *res)
+{
+    struct application ap;
+
+    memset(res, 0, sizeof(*res));
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_resource = &rt_uniresource;
+    ap.a_hit = test_shoot_hit;
+    ap.a_miss = test_shoot_miss;
+    ap.a_logoverlap = rt_silent_logoverlap;
+    ap.a_uptr = (void *)res;
+    VMOVE(ap.a_ray.r_pt, pt);
+    VMOVE(ap.a_ray.r_dir, dir);
+    (void)rt_shootray(&ap);
+}
+
+
+#endif /* LIBRT_TESTS_TEST_SHOOT_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,360 @@
+/*              T I E _ K D T R E E _ B E N C H . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file tie_kdtree_bench.c
+ *
+ * Compare the TIE kd-tree builders on a synthetic scene.
+ *
+ * Builds the same triangle set with TIE_KDTREE_FAST and TIE_KDTREE_SAH
+ * (and optionally TIE_KDTREE_OPTIMAL), then fires the same rays through
+ * each tree.  Reports build time, trace time and the mean
+ * number of interior nodes visited per ray, and checks that every
+ * builder returns the same first hit as the FAST tree.
+ *
+ * The scene is a ground grid plus clusters of small tessellated
+ * spheres, which gives both large empty regions and dense detail.
+ *
+ * Usage:
+ *   rt_tie_kdtree_bench [-n <spheres>] [-r <rays>] [-s <seed>] [-o]
+ *
+ *   -o  also time the OPTIMAL builder.  It is very slow on large scenes
+ *      and its disagreements are only reported, not counted as failure.
+ *
+ * Exits non-zero if the SAH tree disagrees with FAST on a first hit.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/exit.h"
+#include "bu/getopt.h"
+#include "bu/malloc.h"
+#include "bu/time.h"
+#include "vmath.h"
+#include "rt/tie.h"
+
+
+#define SPHERE_SEGS 12			/* longitude slices per sphere */
+#define SPHERE_RINGS 6			/* latitude bands per sphere */
+#define GRID_CELLS 64			/* ground grid is GRID_CELLS^2 quads */
+
+
+struct scene {
+    TIE_3 *verts;			/* 3 per triangle */
+    size_t tri_num;
+    size_t tri_alloc;
+};
+
+struct trace_result {
+    int id;				/* triangle index, -1 for a miss */
+    fastf_t dist;
+};
+
+
+static uint32_t bench_seed = 1;
+
+static double
+bench_rand(void)
+{
+    /* xorshift32, so the scene is the same on every platform */
+    bench_seed ^= bench_seed << 13;
+    bench_seed ^= bench_seed >> 17;
+    bench_seed ^= bench_seed << 5;
+    return (double)bench_seed / 4294967296.0;
+}
+
+
+static void
+scene_tri(struct scene *s, const point_t a, const point_t b, const point_t c)
+{
+    if (s->tri_num == s->tri_alloc) {
+	s->tri_alloc = s->tri_alloc ? s->tri_alloc * 2 : 4096;
+	s->verts = (TIE_3 *)bu_realloc(s->verts, s->tri_alloc * 3 * sizeof(TIE_3), "scene verts");
+    }
+    VMOVE(s->verts[s->tri_num*3+0].v, a);
+    VMOVE(s->verts[s->tri_num*3+1].v, b);
+    VMOVE(s->verts[s->tri_num*3+2].v, c);
+    s->tri_num++;
+}
+
+
+static void
+scene_sphere(struct scene *s, const point_t center, fastf_t radius)
+{
+    int i, j;
+
+    for (j = 0; j < SPHERE_RINGS; j++) {
+	fastf_t t0 = M_PI * j / SPHERE_RINGS;
+	fastf_t t1 = M_PI * (j + 1) / SPHERE_RINGS;
+	for (i = 0; i < SPHERE_SEGS; i++) {
+	    fastf_t p0 = M_2PI * i / SPHERE_SEGS;
+	    fastf_t p1 = M_2PI * (i + 1) / SPHERE_SEGS;
+	    point_t q[4];
+
+	    VSET(q[0], sin(t0)*cos(p0), sin(t0)*sin(p0), cos(t0));
+	    VSET(q[1], sin(t0)*cos(p1), sin(t0)*sin(p1), cos(t0));
+	    VSET(q[2], sin(t1)*cos(p1), sin(t1)*sin(p1), cos(t1));
+	    VSET(q[3], sin(t1)*cos(p0), sin(t1)*sin(p0), cos(t1));
+	    VJOIN1(q[0], center, radius, q[0]);
+	    VJOIN1(q[1], center, radius, q[1]);
+	    VJOIN1(q[2], center, radius, q[2]);
+	    VJOIN1(q[3], center, radius, q[3]);
+	    if (j > 0)
+		scene_tri(s, q[0], q[1], q[2]);
+	    if (j < SPHERE_RINGS - 1)
+		scene_tri(s, q[0], q[2], q[3]);
+	}
+    }
+}
+
+
+static void
+scene_build(struct scene *s, int nspheres)
+{
+    int i, j;
+    point_t centers[8];
+
+    /* ground grid */
+    for (j = 0; j < GRID_CELLS; j++) {
+	for (i = 0; i < GRID_CELLS; i++) {
+	    point_t a, b, c, d;
+	    fastf_t x0 = -1000.0 + 2000.0 * i / GRID_CELLS;
+	    fastf_t x1 = -1000.0 + 2000.0 * (i + 1) / GRID_CELLS;
+	    fastf_t y0 = -1000.0 + 2000.0 * j / GRID_CELLS;
+	    fastf_t y1 = -1000.0 + 2000.0 * (j + 1) / GRID_CELLS;
+	    VSET(a, x0, y0, 0);
+	    VSET(b, x1, y0, 0);
+	    VSET(c, x1, y1, 0);
+	    VSET(d, x0, y1, 0);
+	    scene_tri(s, a, b, c);
+	    scene_tri(s, a, c, d);
+	}
+    }
+
+    /* clusters of small spheres */
+    for (i = 0; i < 8; i++)
+	VSET(centers[i], -800.0 + 1600.0 * bench_rand(), -800.0 + 1600.0 * bench_rand(), 50.0 + 300.0 * bench_rand());
+    for (i = 0; i < nspheres; i++) {
+	point_t p;
+	const fastf_t *c = centers[i % 8];
+	fastf_t spread = 150.0;
+	VSET(p,
+	     c[X] + spread * (bench_rand() - 0.5),
+	     c[Y] + spread * (bench_rand() - 0.5),
+	     c[Z] + spread * (bench_rand() - 0.5));
+	scene_sphere(s, p, 0.5 + 4.0 * bench_rand());
+    }
+}
+
+
+static void *
+bench_hit(struct tie_ray_s *UNUSED(ray), struct tie_id_s *UNUSED(id), struct tie_tri_s *tri, void *UNUSED(ptr))
+{
+    return tri->ptr;
+}
+
+
+static void
+bench_ray(struct tie_ray_s *ray, size_t n)
+{
+    /* deterministic per ray index, so all builders see the same rays */
+    uint32_t saved = bench_seed;
+    point_t target;
+    fastf_t az, el;
+
+    bench_seed = (uint32_t)(n * 2654435761U) | 1;
+    az = M_2PI * bench_rand();
+    el = 0.1 + 1.2 * bench_rand();
+    VSET(ray->pos, 3000.0 * cos(az) * cos(el), 3000.0 * sin(az) * cos(el), 3000.0 * sin(el));
+    VSET(target, -900.0 + 1800.0 * bench_rand(), -900.0 + 1800.0 * bench_rand(), 400.0 * bench_rand());
+    VSUB2(ray->dir, target, ray->pos);
+    VUNITIZE(ray->dir);
+    ray->depth = 0;
+    bench_seed = saved;
+}
+
+
+static int
+bench_method(const char *label, unsigned int method, const struct scene *s, int *ids, size_t nrays, struct trace_result *ref)
+{
+    struct tie_s tie;
+    TIE_3 **tlist;
+    int64_t t0, t_build, t_trace;
+    size_t i, hits = 0, mismatches = 0;
+    uint64_t depth_sum = 0;
+
+    tlist = (TIE_3 **)bu_malloc(s->tri_num * 3 * sizeof(TIE_3 *), "tlist");
+    for (i = 0; i < s->tri_num * 3; i++)
+	tlist[i] = &s->verts[i];
+
+    TIE_INIT(&tie, (unsigned int)s->tri_num, method);
+    TIE_PUSH(&tie, tlist, (unsigned int)s->tri_num, ids, sizeof(int));
+    bu_free(tlist, "tlist");
+
+    t0 = bu_gettime();
+    TIE_PREP(&tie);
+    t_build = bu_gettime() - t0;
+
+    t0 = bu_gettime();
+    for (i = 0; i < nrays; i++) {
+	struct tie_ray_s ray;
+	struct tie_id_s id;
+	int *hit;
+
+	bench_ray(&ray, i);
+	hit = (int *)TIE_WORK(&tie, &ray, &id, bench_hit, NULL);
+	depth_sum += (uint64_t)ray.kdtree_depth;
+	if (hit)
+	    hits++;
+
+	if (!ref)
+	    continue;
+	if (ref[i].id < 0 && !hit)
+	    continue;
+	if (ref[i].id < 0 || !hit) {
+	    mismatches++;
+	    continue;
+	}
+	/* coincident triangles may legitimately come back in either order */
+	if (*hit != ref[i].id && fabs(id.dist - ref[i].dist) > 1.0e-6 * (1.0 + fabs(ref[i].dist)))
+	    mismatches++;
+    }
+    t_trace = bu_gettime() - t0;
+
+    printf("%-8s build %10.2f ms   trace %10.2f ms   %9.0f rays/s   %6.2f nodes/ray   %zu hits",
+	   label, t_build / 1000.0, t_trace / 1000.0,
+	   t_trace > 0 ? nrays / (t_trace / 1.0e6) : 0.0,
+	   nrays ? (double)depth_sum / nrays : 0.0, hits);
+    if (ref)
+	printf("   %zu mismatches", mismatches);
+    printf("\n");
+
+    TIE_FREE(&tie);
+    return (int)mismatches;
+}
+
+
+static void
+bench_reference(const struct scene *s, int *ids, size_t nrays, struct trace_result *ref)
+{
+    struct tie_s tie;
+    TIE_3 **tlist;
+    size_t i;
+
+    tlist = (TIE_3 **)bu_malloc(s->tri_num * 3 * sizeof(TIE_3 *), "tlist");
+    for (i = 0; i < s->tri_num * 3; i++)
+	tlist[i] = &s->verts[i];
+    TIE_INIT(&tie, (unsigned int)s->tri_num, TIE_KDTREE_FAST);
+    TIE_PUSH(&tie, tlist, (unsigned int)s->tri_num, ids, sizeof(int));
+    bu_free(tlist, "tlist");
+    TIE_PREP(&tie);
+
+    for (i = 0; i < nrays; i++) {
+	struct tie_ray_s ray;
+	struct tie_id_s id;
+	int *hit;
+
+	bench_ray(&ray, i);
+	hit = (int *)TIE_WORK(&tie, &ray, &id, bench_hit, NULL);
+	ref[i].id = hit ? *hit : -1;
+	ref[i].dist = hit ? id.dist : 0.0;
+    }
+    TIE_FREE(&tie);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    struct scene s = {NULL, 0, 0};
+    struct trace_result *ref;
+    int nspheres = 2000;
+    size_t nrays = 200000;
+    int do_optimal = 0;
+    int *ids;
+    int c, bad = 0;
+    size_t i;
+
+    bu_setprogname(argv[0]);
+
+    while ((c = bu_getopt(argc, argv, "n:r:s:o")) != -1) {
+	switch (c) {
+	    case 'n':
+		nspheres = atoi(bu_optarg);
+		break;
+	    case 'r':
+		nrays = (size_t)strtoul(bu_optarg, NULL, 10);
+		break;
+	    case 's':
+		bench_seed = (uint32_t)strtoul(bu_optarg, NULL, 10) | 1;
+		break;
+	    case 'o':
+		do_optimal = 1;
+		break;
+	    default:
+		bu_exit(1, "Usage: %s [-n spheres] [-r rays] [-s seed] [-o]\n", argv[0]);
+	}
+    }
+    if (nspheres < 0)
+	nspheres = 0;
+
+    scene_build(&s, nspheres);
+    ids = (int *)bu_malloc(s.tri_num * sizeof(int), "ids");
+    for (i = 0; i < s.tri_num; i++)
+	ids[i] = (int)i;
+
+    printf("%zu triangles, %zu rays\n", s.tri_num, nrays);
+
+    /* disable the degenerate check; the scene has none and it only adds noise */
+    tie_check_degenerate = 0;
+
+    ref = (struct trace_result *)bu_calloc(nrays ? nrays : 1, sizeof(struct trace_result), "ref");
+    bench_reference(&s, ids, nrays, ref);
+
+    bad += bench_method("FAST", TIE_KDTREE_FAST, &s, ids, nrays, ref);
+    bad += bench_method("SAH", TIE_KDTREE_SAH, &s, ids, nrays, ref);
+    if (do_optimal)
+	(void)bench_method("OPTIMAL", TIE_KDTREE_OPTIMAL, &s, ids, nrays, ref);
+
+    bu_free(ref, "ref");
+    bu_free(ids, "ids");
+    bu_free(s.verts, "scene verts");
+
+    if (bad) {
+	printf("FAIL: %d rays disagree with the FAST tree\n", bad);
+	return 1;
+    }
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
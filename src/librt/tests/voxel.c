@@ -0,0 +1,322 @@
+/*                         V O X E L . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2026 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/tests/voxel.c
+ *
+ * Checks the empty brick skipping in the vol and ebm shot routines.
+ * Each primitive gets a sparse grid (a few clusters of full cells, and
+ * for vol some cells outside [lo, hi]) on a size that is not a multiple
+ * of the brick size.  Oblique and axis-aligned rays are shot at it, and
+ * points sampled along every ray must be inside a partition exactly
+ * when they are in a full cell.  Both primitives must also refuse to
+ * prep without bitmap data.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bn/randmt.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#include "./test_shoot.h"
+
+
+#define VOL_X 37
+#define VOL_Y 29
+#define VOL_Z 21
+#define EBM_X 45
+#define EBM_Y 38
+#define EBM_TALL 6.0
+#define NRAY 3000
+#define STEP 0.05	/* sample spacing, in cells */
+#define EDGE 1.0e-3	/* samples this close to a cell face are not checked */
+
+
+/* the grid as the test sees it */
+struct vx_grid {
+    int dim[3];
+    vect_t cellsize;
+    const unsigned char *full;	/* one flag per cell, x fastest */
+};
+
+
+/* Is P in a full cell?  -1 if it is too close to a cell face to say. */
+static int
+vx_full(const struct vx_grid *g, const point_t P)
+{
+    int c[3];
+    int i;
+
+    for (i = 0; i < 3; i++) {
+	double f = P[i] / g->cellsize[i];
+	c[i] = (int)floor(f);
+	if (f - c[i] < EDGE || c[i] + 1 - f < EDGE)
+	    return -1;
+	if (c[i] < 0 || c[i] >= g->dim[i])
+	    return 0;
+    }
+    return g->full[((size_t)c[Z] * g->dim[Y] + c[Y]) * g->dim[X] + c[X]] ? 1 : 0;
+}
+
+
+/* Shoot NRAY rays through the grid, returning the number of bad
+ * rays.  Some rays have a zero direction component along one of the
+ * axes in zero_ok (a bit per axis), or run along one of those axes.
+ */
+static int
+vx_shoot(struct rt_i *rtip, const struct vx_grid *g, int zero_ok, const char *what)
+{
+    vect_t size;
+    double step, diag;
+    int failures = 0;
+    int i, k;
+
+    VSET(size, g->dim[X] * g->cellsize[X], g->dim[Y] * g->cellsize[Y], g->dim[Z] * g->cellsize[Z]);
+    diag = MAGNITUDE(size);
+    step = STEP * FMIN(g->cellsize[X], FMIN(g->cellsize[Y], g->cellsize[Z]));
+
+    for (i = 0; i < NRAY; i++) {
+	struct test_shoot_ray res;
+	point_t target, pt, P;
+	vect_t dir;
+	double t;
+
+	/* aim at a random point of the grid, some rays along the axes */
+	VSET(target, bn_randmt() * size[X], bn_randmt() * size[Y], bn_randmt() * size[Z]);
+	VSET(dir, bn_randmt() - 0.5, bn_randmt() - 0.5, bn_randmt() - 0.5);
+	if (i % 5 == 0 && (zero_ok & (1 << (i / 5 % 3))))
+	    dir[i / 5 % 3] = 0.0;
+	if (i % 7 == 0 && (zero_ok & (1 << (i / 7 % 3)))) {
+	    VSETALL(dir, 0.0);
+	    dir[i / 7 % 3] = (i % 2) ? 1.0 : -1.0;
+	}
+	VUNITIZE(dir);
+
+	VJOIN1(pt, target, -2.0 * diag, dir);
+	test_shoot(rtip, pt, dir, &res);
+
+	for (t = diag; t < 3.0 * diag; t += step) {
+	    int expect, got = 0;
+
+	    VJOIN1(P, pt, t, dir);
+	    if ((expect = vx_full(g, P)) < 0)
+		continue;
+	    for (k = 0; k < res.npart; k++) {
+		if (t >= res.part[k].in && t <= res.part[k].out) {
+		    got = 1;
+		    break;
+		}
+	    }
+	    if (got != expect) {
+		printf("  FAIL: %s ray %d (%g %g %g) dir (%g %g %g): %s at %g, %d partition(s)\n",
+		       what, i, V3ARGS(pt), V3ARGS(dir),
+		       expect ? "missed a full cell" : "hit an empty cell", t, res.npart);
+		failures++;
+		break;
+	    }
+	}
+    }
+    return failures;
+}
+
+
+/* Mark a box of cells, clipped to the grid */
+static void
+vx_fill(unsigned char *cells, const int dim[3], int x0, int y0, int z0, int n, unsigned char val)
+{
+    int x, y, z;
+
+    for (z = z0; z < z0 + n && z < dim[Z]; z++)
+	for (y = y0; y < y0 + n && y < dim[Y]; y++)
+	    for (x = x0; x < x0 + n && x < dim[X]; x++)
+		cells[((size_t)z * dim[Y] + y) * dim[X] + x] = val;
+}
+
+
+/* A soltab and internal that prep without going through a database */
+static int
+vx_prep_nodata(struct rt_i *rtip, int type, void *idb_ptr, const char *name)
+{
+    struct rt_db_internal intern;
+    struct directory dir;
+    struct soltab st;
+    int ret;
+
+    memset(&dir, 0, sizeof(dir));
+    dir.d_namep = (char *)name;
+    memset(&st, 0, sizeof(st));
+    st.l.magic = RT_SOLTAB_MAGIC;
+    st.st_dp = &dir;
+    st.st_rtip = rtip;
+    st.st_meth = &OBJ[type];
+
+    RT_DB_INTERNAL_INIT(&intern);
+    intern.idb_major_type = DB5_MAJORTYPE_BRLCAD;
+    intern.idb_type = type;
+    intern.idb_meth = &OBJ[type];
+    intern.idb_ptr = idb_ptr;
+
+    ret = OBJ[type].ft_prep(&st, &intern, rtip);
+    if (st.st_specific)
+	OBJ[type].ft_free(&st);
+    if (!ret) {
+	printf("  FAIL: %s prepped without bitmap data\n", name);
+	return 1;
+    }
+    return 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    static unsigned char vol_data[VOL_X * VOL_Y * VOL_Z];
+    static unsigned char vol_full[VOL_X * VOL_Y * VOL_Z];
+    static unsigned char ebm_data[EBM_X * EBM_Y];
+    static unsigned char ebm_full[EBM_X * EBM_Y];
+    const int vol_dim[3] = {VOL_X, VOL_Y, VOL_Z};
+    const int ebm_dim[3] = {EBM_X, EBM_Y, 1};
+    struct rt_ebm_internal *ebm;
+    struct rt_vol_internal vol_nodata;
+    struct rt_ebm_internal ebm_nodata;
+    struct vx_grid g;
+    struct db_i *dbip;
+    struct rt_wdb *wdbp;
+    struct rt_i *rtip;
+    vect_t cellsize;
+    mat_t mat;
+    int failures = 0;
+    int i;
+
+    bu_setprogname(argv[0]);
+    if (argc > 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    /* a fixed sequence, so failures are reproducible */
+    bn_randmt_seed(1);
+
+    /* clusters of full cells (value in [lo, hi]), and cells above and
+     * below the threshold, which are empty */
+    vx_fill(vol_data, vol_dim, 2, 3, 1, 3, 100);
+    vx_fill(vol_data, vol_dim, 17, 12, 9, 5, 150);
+    vx_fill(vol_data, vol_dim, 33, 25, 17, 6, 60);
+    vx_fill(vol_data, vol_dim, 9, 22, 14, 2, 250);
+    vx_fill(vol_data, vol_dim, 26, 4, 3, 4, 10);
+    vx_fill(vol_data, vol_dim, 27, 5, 4, 1, 200);
+    for (i = 0; i < VOL_X * VOL_Y * VOL_Z; i++)
+	vol_full[i] = (vol_data[i] >= 50 && vol_data[i] <= 200);
+
+    /* the same for the bitmap, which is extruded along Z */
+    vx_fill(ebm_data, ebm_dim, 1, 1, 0, 2, 1);
+    vx_fill(ebm_data, ebm_dim, 20, 15, 0, 6, 1);
+    vx_fill(ebm_data, ebm_dim, 41, 34, 0, 8, 1);
+    vx_fill(ebm_data, ebm_dim, 9, 30, 0, 1, 1);
+    for (i = 0; i < EBM_X * EBM_Y; i++)
+	ebm_full[i] = (ebm_data[i] > 0);
+
+    dbip = db_open_inmem();
+    wdbp = wdb_dbopen(dbip, RT_WDB_TYPE_DB_INMEM);
+    MAT_IDN(mat);
+
+    mk_binunif(wdbp, "vol.bin", vol_data, WDB_BINUNIF_UCHAR, VOL_X * VOL_Y * VOL_Z);
+    VSET(cellsize, 1.5, 2.0, 1.0);
+    mk_vol(wdbp, "vol.s", RT_VOL_SRC_OBJ, "vol.bin", VOL_X, VOL_Y, VOL_Z, 50, 200, cellsize, mat);
+
+    /* mk_ebm() only knows about files */
+    mk_binunif(wdbp, "ebm.bin", ebm_data, WDB_BINUNIF_UCHAR, EBM_X * EBM_Y);
+    BU_ALLOC(ebm, struct rt_ebm_internal);
+    ebm->magic = RT_EBM_INTERNAL_MAGIC;
+    bu_strlcpy(ebm->name, "ebm.bin", RT_EBM_NAME_LEN);
+    ebm->datasrc = RT_EBM_SRC_OBJ;
+    ebm->xdim = EBM_X;
+    ebm->ydim = EBM_Y;
+    ebm->tallness = EBM_TALL;
+    MAT_IDN(ebm->mat);
+    if (wdb_export(wdbp, "ebm.s", (void *)ebm, ID_EBM, 1.0) < 0)
+	bu_exit(1, "unable to write ebm.s\n");
+
+    rtip = rt_new_rti(dbip);
+    if (rt_gettree(rtip, "vol.s") != 0)
+	bu_exit(1, "rt_gettree(vol.s) failed\n");
+    rt_prep_parallel(rtip, 1);
+    g.dim[X] = VOL_X;
+    g.dim[Y] = VOL_Y;
+    g.dim[Z] = VOL_Z;
+    VMOVE(g.cellsize, cellsize);
+    g.full = vol_full;
+    failures += vx_shoot(rtip, &g, 7, "vol");
+    rt_free_rti(rtip);
+
+    rtip = rt_new_rti(dbip);
+    if (rt_gettree(rtip, "ebm.s") != 0)
+	bu_exit(1, "rt_gettree(ebm.s) failed\n");
+    rt_prep_parallel(rtip, 1);
+    g.dim[X] = EBM_X;
+    g.dim[Y] = EBM_Y;
+    g.dim[Z] = 1;
+    VSET(g.cellsize, 1.0, 1.0, EBM_TALL);
+    g.full = ebm_full;
+    /* the ebm DDA has never handled rays parallel to its X or Y cell
+     * planes, so only Z components are zeroed */
+    failures += vx_shoot(rtip, &g, 4, "ebm");
+
+    /* no bitmap data is a prep failure for both */
+    memset(&vol_nodata, 0, sizeof(vol_nodata));
+    vol_nodata.magic = RT_VOL_INTERNAL_MAGIC;
+    vol_nodata.datasrc = RT_VOL_SRC_OBJ;
+    vol_nodata.xdim = VOL_X;
+    vol_nodata.ydim = VOL_Y;
+    vol_nodata.zdim = VOL_Z;
+    vol_nodata.lo = 50;
+    vol_nodata.hi = 200;
+    VMOVE(vol_nodata.cellsize, cellsize);
+    MAT_IDN(vol_nodata.mat);
+    failures += vx_prep_nodata(rtip, ID_VOL, &vol_nodata, "nodata.vol");
+
+    memset(&ebm_nodata, 0, sizeof(ebm_nodata));
+    ebm_nodata.magic = RT_EBM_INTERNAL_MAGIC;
+    ebm_nodata.datasrc = RT_EBM_SRC_OBJ;
+    ebm_nodata.xdim = EBM_X;
+    ebm_nodata.ydim = EBM_Y;
+    ebm_nodata.tallness = EBM_TALL;
+    MAT_IDN(ebm_nodata.mat);
+    failures += vx_prep_nodata(rtip, ID_EBM, &ebm_nodata, "nodata.ebm");
+
+    rt_free_rti(rtip);
+    db_close(dbip);
+
+    printf("voxel: %d rays per primitive, %d failure(s)\n", NRAY, failures);
+    return (failures > 0) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -36,35 +36,16 @@
 #include "librt_private.h"
 
 
-#define ACQUIRE_SEMAPHORE_TREE(_hash) switch ((_hash)&03) {	\
-	case 0:							\
-	    bu_semaphore_acquire(RT_SEM_TREE0);			\
-	    break;						\
-	case 1:							\
-	    bu_semaphore_acquire(RT_SEM_TREE1);			\
-	    break;						\
-	case 2:							\
-	    bu_semaphore_acquire(RT_SEM_TREE2);			\
-	    break;						\
-	default:						\
-	    bu_semaphore_acquire(RT_SEM_TREE3);			\
-	    break;						\
-    }
+/*
+ * The solid table critical sections are sharded on the low bits of the
+ * directory name hash, so one name (and one rti_solidheads[] bucket)
+ * always maps to the same semaphore.
+ */
+#define ACQUIRE_SEMAPHORE_TREE(_hash) \
+    bu_semaphore_acquire(rt_sem_tree_shard[(_hash) & (RT_SEM_TREE_SHARDS-1)])
 
-#define RELEASE_SEMAPHORE_TREE(_hash) switch ((_hash)&03) {	\
-	case 0:							\
-	    bu_semaphore_release(RT_SEM_TREE0);			\
-	    break;						\
-	case 1:							\
-	    bu_semaphore_release(RT_SEM_TREE1);			\
-	    break;						\
-	case 2:							\
-	    bu_semaphore_release(RT_SEM_TREE2);			\
-	    break;						\
-	default:						\
-	    bu_semaphore_release(RT_SEM_TREE3);			\
-	    break;						\
-    }
+#define RELEASE_SEMAPHORE_TREE(_hash) \
+    bu_semaphore_release(rt_sem_tree_shard[(_hash) & (RT_SEM_TREE_SHARDS-1)])
 
 
 static void
@@ -115,7 +96,10 @@ _rt_gettree_region_start(struct db_tree_state *tsp, const struct db_full_path *p
 
 	/* Ignore "air" regions unless wanted */
 	if (tsp->ts_rtip->useair == 0 &&  tsp->ts_aircode != 0) {
+	    /* region discovery runs in parallel */
+	    bu_semaphore_acquire(BU_SEM_GENERAL);
 	    tsp->ts_rtip->i->rti_air_discards++;
+	    bu_semaphore_release(BU_SEM_GENERAL);
 	    return -1;	/* drop this region */
 	}
     }
@@ -495,11 +479,18 @@ _rt_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
     VSETALL(stp->st_min,  INFINITY);
 
     /*
+     * Repeated placements of a heavy primitive share one prep done in
+     * the primitive's own frame (see instance.c).  If that does not
+     * apply, prep this placement in model space as usual.
+     *
      * If prep wants to keep the internal structure, that is OK, as
      * long as idb_ptr is set to null.  Note that the prep routine may
      * have changed st_id.
      */
-    if (rtip->rti_dbip->i->dbi_version > 4) {
+    if (rt_instance_wanted(rtip, dp, ip->idb_type, stp->st_matp)
+	&& rt_instance_prep(stp, data->cache) == 0) {
+	ret = 0;
+    } else if (rtip->rti_dbip->i->dbi_version > 4) {
 	ret = rt_cache_prep(data->cache, stp, ip);
     } else {
 	ret = rt_obj_prep(stp, ip, stp->st_rtip);
@@ -562,8 +553,8 @@ _rt_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
 
 	/* verbose=1, mm2local=1.0 */
 	ret = -1;
-	if (stp->st_meth->ft_describe) {
-	    ret = stp->st_meth->ft_describe(&str, ip, 1, 1.0);
+	if (OBJ[ip->idb_type].ft_describe) {
+	    ret = OBJ[ip->idb_type].ft_describe(&str, ip, 1, 1.0);
 	}
 	if (ret < 0) {
 	    bu_log("_rt_gettree_leaf(%s):  solid describe failure\n",
@@ -59,8 +59,8 @@ vshot_stub(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struc
 	    /* skip call if solid table pointer is NULL */
 	    /* do scalar call, place results in segp array */
 	    ret = -1;
-	    if (OBJ[stp[i]->st_id].ft_shot) {
-		ret = OBJ[stp[i]->st_id].ft_shot(stp[i], rp[i], ap, &seghead);
+	    if (stp[i]->st_meth->ft_shot) {
+		ret = stp[i]->st_meth->ft_shot(stp[i], rp[i], ap, &seghead);
 	    }
 	    if (ret <= 0) {
 		segp[i].seg_stp=(struct soltab *) 0;
@@ -222,8 +222,11 @@ rt_vshootray(struct application *ap)
 	goto out;
     }
 
-    /* For each type of solid to be shot at, assemble the vectors */
-    for (id = 1; id <= ID_MAX_SOLID; id++) {
+    /* For each type of solid to be shot at, assemble the vectors.
+     * Instanced solids of every type are under ID_NULL, which has no
+     * vshot method and so goes through vshot_stub().
+     */
+    for (id = ID_NULL; id <= ID_MAX_SOLID; id++) {
 	register int nsol;
 
 	if ((nsol = rtip->i->rti_nsol_by_type[id]) <= 0) continue;
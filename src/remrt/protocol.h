@@ -26,8 +26,14 @@
 #ifndef REMRT_PROTOCOL_H
 #define REMRT_PROTOCOL_H
 
+#include "bu/hash.h"
+#include "bu/mapped_file.h"
+
 /* For use in MSG_VERSION exchanges */
-#define PROTOCOL_VERSION	"BRL-CAD REMRT Protocol v2.0"
+#define PROTOCOL_VERSION	"BRL-CAD REMRT Protocol v2.1"
+
+/* Older workers are still accepted, without protocol extensions */
+#define PROTOCOL_VERSION_V20	"BRL-CAD REMRT Protocol v2.0"
 
 #define MSG_MATRIX	2
 #define MSG_OPTIONS	3
@@ -40,19 +46,59 @@
 #define	MSG_CD		10	/* change directory */
 #define MSG_CMD		11	/* server sends command to dispatcher */
 #define MSG_VERSION	12	/* server sends version to dispatcher */
-#define MSG_DB		13	/* request/send database lines 16k max */
+#define MSG_DB		13	/* database file chunk, see REMRT_CAP_DBXFER */
 #define MSG_CHECK	14	/* check database files for match */
 #define MSG_DIRBUILD		15	/* request rt_dirbuild() be called */
 #define MSG_DIRBUILD_REPLY	16	/* response to MSG_DIRBUILD */
 #define MSG_GETTREES		17	/* request rt_gettrees() be called */
 #define MSG_GETTREES_REPLY	18	/* response to MSG_GETTREES */
+#define MSG_CAPS		19	/* protocol extensions to use */
+#define MSG_PIXELS_Z		20	/* compressed response to MSG_LINES */
+#define MSG_DBHASH		21	/* offer database by content hash */
+#define MSG_DBHASH_REPLY	22	/* response to MSG_DBHASH or final MSG_DB */
+
+/*
+ * Protocol extensions (v2.1).
+ *
+ * A worker lists the extensions it supports, as a hex bit mask, in
+ * its MSG_VERSION payload after REMRT_CAPS_PREFIX.  The dispatcher
+ * answers with a MSG_CAPS message holding the subset to be used, in
+ * the same format.  No extension is used before MSG_CAPS arrives.
+ *
+ * REMRT_CAP_LZ4: pixels are returned in MSG_PIXELS_Z messages,
+ * holding an rt_compress_external() block.  Uncompressed, the block
+ * is a 4-byte network order span count followed by, for each span,
+ * an exported line_info and its (li_endpix-li_startpix+1)*3 bytes of
+ * pixels.  Spans are in the order they were assigned.
+ *
+ * REMRT_CAP_BATCH: MSG_LINES may hold several "start stop frame"
+ * triples.  They are all answered in a single MSG_PIXELS_Z message
+ * if REMRT_CAP_LZ4 is also in use, else by one MSG_PIXELS per span.
+ *
+ * REMRT_CAP_DBXFER: before MSG_DIRBUILD, the dispatcher may send a
+ * MSG_DBHASH of "hash size basename".  The worker looks for that file
+ * in its cache and answers MSG_DBHASH_REPLY "have" (it has changed to
+ * the directory holding it) or "need".  After "need", the file follows
+ * as MSG_DB messages of rt_compress_external() blocks of at most
+ * REMRT_DB_CHUNK bytes each, ended by an empty MSG_DB, which the
+ * worker answers with "have" once the content hash is verified, or
+ * "bad".
+ */
+#define REMRT_CAPS_PREFIX	" caps="
+#define REMRT_CAP_LZ4		0x1
+#define REMRT_CAP_BATCH		0x2
+#define REMRT_CAP_DBXFER	0x4
+#define REMRT_CAP_ALL		(REMRT_CAP_LZ4|REMRT_CAP_BATCH|REMRT_CAP_DBXFER)
+
+#define REMRT_MAX_BATCH		16		/* max spans per MSG_LINES */
+#define REMRT_DB_CHUNK		(1024*1024)	/* uncompressed MSG_DB size */
 
 /*
  * MSG_VERSION payload format when session authentication is in use:
  *
- *   PROTOCOL_VERSION REMRT_AUTH_TOKEN_PREFIX <hex-token>
+ *   PROTOCOL_VERSION [REMRT_CAPS_PREFIX <hex-caps>] REMRT_AUTH_TOKEN_PREFIX <hex-token>
  *
- * e.g. "BRL-CAD REMRT Protocol v2.0 token=3fa2...c81b"
+ * e.g. "BRL-CAD REMRT Protocol v2.1 caps=7 token=3fa2...c81b"
  *
  * Workers started without a token omit the suffix.  remrt accepts
  * both forms; it only rejects a connection when the worker sends a
@@ -94,6 +140,32 @@ static struct bu_structparse desc_line_info[] =  {
     {"",   0, NULL,		0,			BU_STRUCTPARSE_FUNC_NULL, NULL, NULL }
 };
 
+/*
+ * Content hash of a database file, used to name it in MSG_DBHASH.
+ * Both ends must come from the same release, which the protocol
+ * version check already ensures.
+ *
+ * Returns -
+ * -1 file could not be read
+ * 0 OK, hash written to 'hex' and file size to '*size'
+ */
+static int
+remrt_db_hash(const char *path, char *hex, size_t hexlen, size_t *size)
+{
+    struct bu_mapped_file *mp;
+    bu_h128_t h;
+
+    if ((mp = bu_open_mapped_file(path, NULL)) == NULL)
+	return -1;
+    h = bu_data_hash128(mp->buf, mp->buflen);
+    if (size)
+	*size = mp->buflen;
+    snprintf(hex, hexlen, "%016llx%016llx",
+	     (unsigned long long)h.w[1], (unsigned long long)h.w[0]);
+    bu_close_mapped_file(mp);
+    return 0;
+}
+
 #endif  /* REMRT_PROTOCOL_H */
 /*
  * Local Variables:
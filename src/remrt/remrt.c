@@ -130,6 +130,8 @@ extern int gettimeofday(struct timeval *, void *);
 #define N_SERVER_ASSIGNMENTS	1		/* desired # of assignments */
 #define MIN_ASSIGNMENT_TIME	5		/* desired seconds/result */
 #define SERVER_CHECK_INTERVAL	(10*60)		/* seconds */
+#define MIN_TILE_TIME		0.5		/* min seconds/result, cost method */
+#define SPECULATE_RATIO		1.5		/* duplicate tile if this much faster */
 #ifndef SSH
 #  define SSH "ssh"
 #endif
@@ -177,6 +179,8 @@ static int helper_proc_count = 0;
  *	UNUSED		NEW		connection rcvd
  *	NEW		VERSOK		ph_version pkg rcvd.
  *					Optionally send loglvl & "cd" cmds.
+ *	VERSOK		DOING_DBXFER	MSG_DBHASH sent ("xfer" hosts)
+ *	DOING_DBXFER	VERSOK		"have" MSG_DBHASH_REPLY rcvd
  *	VERSOK		DOING_DIRBUILD	MSG_DIRBUILD sent
  *	DOING_DIRBUILD	READY		MSG_DIRBUILD_REPLY rcvd
  *
@@ -243,6 +247,7 @@ struct servers {
 #define SRST_RESTART		6	/* about to restart */
 #define SRST_CLOSING		7	/* Needs to be closed */
 #define SRST_DOING_GETTREES	8	/* doing gettrees */
+#define SRST_DOING_DBXFER	9	/* offered database, awaiting reply */
     struct frame *sr_curframe;	/* ptr to current frame */
     /* Timings */
     struct timeval sr_sendtime;	/* time of last sending */
@@ -262,6 +267,9 @@ struct servers {
     int sr_nsamp;	/* number of samples summed over */
     double sr_prep_cpu;	/* sum of cpu time for preps */
     double sr_l_percent;	/* last: percent of CPU */
+    double sr_w_cost;	/* weighted avg: cost units/elapsed_sec */
+    int sr_caps;	/* protocol extensions in use, REMRT_CAP_xxx */
+    int sr_dbok;	/* database already in place, skip MSG_CD */
 } servers[MAXSERVERS];
 
 
@@ -305,6 +313,10 @@ struct list {
     struct frame *li_frame;
     int li_start;
     int li_stop;
+    int li_spec;	/* speculative state, LI_xxx */
+#define LI_NORMAL	0	/* only copy of this assignment */
+#define LI_DUPLICATED	1	/* a twin is outstanding on another server */
+#define LI_STALE	2	/* twin already delivered, discard reply */
 };
 
 
@@ -313,13 +325,14 @@ struct bu_list FreeList;
 #define LIST_NULL ((struct list*)0)
 #define LIST_MAGIC 0x4c494c49
 
-#define GET_LIST(p) if (BU_LIST_IS_EMPTY(&FreeList)) { \
+#define GET_LIST(p) { if (BU_LIST_IS_EMPTY(&FreeList)) { \
 	BU_ALLOC((p), struct list); \
 	(p)->l.magic = LIST_MAGIC; \
     } else { \
 	(p) = BU_LIST_FIRST(list, &FreeList); \
 	BU_LIST_DEQUEUE(&(p)->l); \
-    }
+    } \
+    (p)->li_spec = LI_NORMAL; }
 
 #define FREE_LIST(p) { BU_LIST_APPEND(&FreeList, &(p)->l); }
 
@@ -465,11 +478,42 @@ static SSL_CTX *remrt_ssl_ctx = NULL;
 #define OPT_FRAME 0	/* Free for all */
 #define OPT_LOAD 1	/* 10% per server per frame */
 #define OPT_MOVIE 2	/* one server per frame */
+#define OPT_COST 3	/* cost-balanced tiles, free for all */
 int work_allocate_method = OPT_MOVIE;
+
+/* Protocol extensions offered to new workers, see protocol.h */
+static int remrt_caps = REMRT_CAP_ALL;
 char *allocate_method[] = {
     "Frame",
     "Load Averaging",
-    "One per Frame"};
+    "One per Frame",
+    "Cost Balanced"};
+
+
+/*
+ * Coarse cost map of the image, used by the "cost" allocation method.
+ *
+ * The image is divided into COSTMAP_BANDS horizontal bands of
+ * scanlines, each holding an estimate of the cost of one of its
+ * pixels in abstract cost units.  Each server keeps a weighted
+ * throughput estimate in the same units (sr_w_cost).  Every
+ * MSG_PIXELS reply refines both: the server's throughput from the
+ * predicted cost of the assignment, and the bands from the cost the
+ * server's throughput says was actually spent.  The map is kept from
+ * one frame to the next, as long as the frame size does not change,
+ * since consecutive animation frames tend to cost about the same.
+ */
+#define COSTMAP_BANDS	256
+#define COSTMAP_GAIN	0.5	/* fraction of an observation blended in */
+#define COSTMAP_MIN	1.0e-3	/* floor on per-pixel cost */
+
+static struct costmap {
+    int cm_width;
+    int cm_height;
+    int cm_nbands;
+    int cm_bandpix;	/* pixels per band */
+    double cm_cost[COSTMAP_BANDS];	/* cost units per pixel */
+} costmap;
 
 
 /*
@@ -494,6 +538,7 @@ stamp(void)
 
 /* Forward declaration: defined later in this file */
 static void reap_helpers(void);
+static struct list *find_twin(struct servers *sp, struct list *lp);
 
 
 /*
@@ -524,6 +569,8 @@ state_to_string(int state)
 	    return "Closing";
 	case SRST_DOING_GETTREES:
 	    return "GetTrees";
+	case SRST_DOING_DBXFER:
+	    return "DbXfer";
     }
     snprintf(buf, sizeof(buf), "UNKNOWN_x%x", state);
     return buf;
@@ -602,9 +649,24 @@ drop_server(struct servers *sp, char *why)
 
     /* Need to requeue any work that was in progress */
     while (BU_LIST_WHILE(lp, list, &sp->sr_work)) {
+	BU_LIST_DEQUEUE(&lp->l);
+	if (lp->li_spec == LI_STALE) {
+	    /* The twin already delivered these pixels */
+	    FREE_LIST(lp);
+	    continue;
+	}
+	if (lp->li_spec == LI_DUPLICATED) {
+	    struct list *tp = find_twin(sp, lp);
+	    if (tp != LIST_NULL) {
+		/* Let the twin finish the job on its own */
+		tp->li_spec = LI_NORMAL;
+		FREE_LIST(lp);
+		continue;
+	    }
+	    lp->li_spec = LI_NORMAL;
+	}
 	fr = lp->li_frame;
 	CHECK_FRAME(fr);
-	BU_LIST_DEQUEUE(&lp->l);
 	bu_log("%s requeueing fr%ld %d..%d\n",
 	       stamp(),
 	       fr->fr_number,
@@ -1361,6 +1423,7 @@ reap_helpers(void)
  * with bu_process_create(), which is portable to Windows as well.
  *
  * HT_CD:      ssh -f -n <host> "cd <path> && rtsrv <ctrl> <port> [-S <tok>]"
+ * HT_XFER:    as HT_CD, the database is sent over the connection later
  * HT_CONVERT: /bin/sh -c "g2asc<db | ssh <host> 'cd <path>; asc2g><rem>; rtsrv ...'"
  *
  * For HT_CD, "ssh -f" returns as soon as it has forked the remote
@@ -1403,6 +1466,7 @@ add_host(struct ihost *ihp)
 
     switch (ihp->ht_where) {
 	case HT_CD:
+	case HT_XFER:
 	    /* Build the remote command string */
 	    if (session_token[0] != '\0') {
 		snprintf(cmd, sizeof(cmd),
@@ -1822,6 +1886,189 @@ server_q_len(struct servers *sp)
 }
 
 
+/*
+ * Make sure the cost map describes a frame of this size,
+ * starting over with a uniform map if it does not.
+ */
+static void
+costmap_setup(struct frame *fr)
+{
+    int i;
+    int lines;
+
+    CHECK_FRAME(fr);
+
+    if (costmap.cm_width == fr->fr_width &&
+	costmap.cm_height == fr->fr_height)
+	return;
+
+    costmap.cm_width = fr->fr_width;
+    costmap.cm_height = fr->fr_height;
+    lines = (fr->fr_height + COSTMAP_BANDS - 1) / COSTMAP_BANDS;
+    if (lines < 1) lines = 1;
+    costmap.cm_bandpix = lines * fr->fr_width;
+    if (costmap.cm_bandpix < 1) costmap.cm_bandpix = 1;
+    costmap.cm_nbands = (fr->fr_width * fr->fr_height +
+			 costmap.cm_bandpix - 1) / costmap.cm_bandpix;
+    if (costmap.cm_nbands > COSTMAP_BANDS) costmap.cm_nbands = COSTMAP_BANDS;
+    for (i = 0; i < COSTMAP_BANDS; i++)
+	costmap.cm_cost[i] = 1.0;
+}
+
+
+static int
+costmap_band(int pix)
+{
+    int band = pix / costmap.cm_bandpix;
+
+    if (band < 0) return 0;
+    if (band >= costmap.cm_nbands) return costmap.cm_nbands - 1;
+    return band;
+}
+
+
+/*
+ * Predicted cost of the inclusive pixel span a..b
+ */
+static double
+costmap_span_cost(int a, int b)
+{
+    int band;
+    int lo, hi;
+    double cost = 0.0;
+
+    if (costmap.cm_nbands <= 0 || b < a) return 0.0;
+
+    for (band = costmap_band(a); band <= costmap_band(b); band++) {
+	lo = band * costmap.cm_bandpix;
+	hi = lo + costmap.cm_bandpix - 1;
+	if (lo < a) lo = a;
+	if (hi > b) hi = b;
+	cost += (hi - lo + 1) * costmap.cm_cost[band];
+    }
+    return cost;
+}
+
+
+/*
+ * Starting at pixel a, find the last pixel (no further than stop)
+ * of a span whose predicted cost reaches 'target'.
+ */
+static int
+costmap_span_end(int a, int stop, double target)
+{
+    int band;
+    int lo, hi;
+    double cost;
+
+    if (costmap.cm_nbands <= 0) return stop;
+
+    for (band = costmap_band(a); band < costmap.cm_nbands; band++) {
+	lo = band * costmap.cm_bandpix;
+	hi = lo + costmap.cm_bandpix - 1;
+	if (lo < a) lo = a;
+	if (hi >= stop) hi = stop;
+	cost = (hi - lo + 1) * costmap.cm_cost[band];
+	if (cost >= target) {
+	    lo += (int)(target / costmap.cm_cost[band]);
+	    return (lo > hi) ? hi : lo;
+	}
+	if (hi >= stop) break;
+	target -= cost;
+    }
+    return stop;
+}
+
+
+/*
+ * Blend the observed/predicted cost ratio of span a..b into
+ * the bands it covers, weighted by how much of each band it covers.
+ */
+static void
+costmap_update(int a, int b, double ratio)
+{
+    int band;
+    int lo, hi;
+    double frac;
+
+    if (costmap.cm_nbands <= 0 || b < a) return;
+
+    /* One odd sample should not swamp the map */
+    if (ratio < 0.1) ratio = 0.1;
+    else if (ratio > 10.0) ratio = 10.0;
+
+    for (band = costmap_band(a); band <= costmap_band(b); band++) {
+	lo = band * costmap.cm_bandpix;
+	hi = lo + costmap.cm_bandpix - 1;
+	if (lo < a) lo = a;
+	if (hi > b) hi = b;
+	frac = (double)(hi - lo + 1) / costmap.cm_bandpix;
+	costmap.cm_cost[band] *= 1.0 + COSTMAP_GAIN * frac * (ratio - 1.0);
+	if (costmap.cm_cost[band] < COSTMAP_MIN)
+	    costmap.cm_cost[band] = COSTMAP_MIN;
+    }
+}
+
+
+/*
+ * Determine how much work, in cost units, to assign to a server
+ * under the "cost" allocation method.  Normally that is
+ * assignment_time() worth of its measured throughput.  Once the
+ * remaining work of the frame shrinks below that, hand out half of
+ * this server's fair share of what is left instead, so the last
+ * tiles are small and all the servers finish at about the same time.
+ */
+static double
+cost_assignment(struct servers *sp, struct frame *fr)
+{
+    struct servers *csp;
+    struct list *lp;
+    double remaining = 0.0;
+    double aggregate = 0.0;
+    double sec;
+
+    for (BU_LIST_FOR(lp, list, &fr->fr_todo))
+	remaining += costmap_span_cost(lp->li_start, lp->li_stop);
+
+    for (csp = &servers[0]; csp < &servers[MAXSERVERS]; csp++) {
+	if (csp->sr_pc == PKC_NULL) continue;
+	if (csp->sr_state != SRST_READY) continue;
+	aggregate += csp->sr_w_cost;
+    }
+
+    sec = assignment_time();
+    if (aggregate > 0.0 && remaining / aggregate / 2.0 < sec)
+	sec = remaining / aggregate / 2.0;
+    if (sec < MIN_TILE_TIME)
+	sec = MIN_TILE_TIME;
+
+    return sec * sp->sr_w_cost;
+}
+
+
+/*
+ * Find the twin of a duplicated assignment on some other server.
+ */
+static struct list *
+find_twin(struct servers *sp, struct list *lp)
+{
+    struct servers *csp;
+    struct list *tp;
+
+    for (csp = &servers[0]; csp < &servers[MAXSERVERS]; csp++) {
+	if (csp == sp || csp->sr_pc == PKC_NULL) continue;
+	for (BU_LIST_FOR(tp, list, &csp->sr_work)) {
+	    if (tp->li_spec != LI_DUPLICATED) continue;
+	    if (tp->li_frame != lp->li_frame) continue;
+	    if (tp->li_start != lp->li_start || tp->li_stop != lp->li_stop)
+		continue;
+	    return tp;
+	}
+    }
+    return LIST_NULL;
+}
+
+
 static void
 send_loglvl(struct servers *sp)
 {
@@ -1862,13 +2109,16 @@ static int
 all_servers_idle(void)
 {
     struct servers *sp;
+    struct list *lp;
 
     for (sp = &servers[0]; sp < &servers[MAXSERVERS]; sp++) {
 	if (sp->sr_pc == PKC_NULL) continue;
 	if (sp->sr_state != SRST_READY &&
 	    sp->sr_state != SRST_NEED_TREE) continue;
-	if (BU_LIST_IS_EMPTY(&sp->sr_work)) continue;
-	return 0;		/* nope, still more work */
+	for (BU_LIST_FOR(lp, list, &sp->sr_work)) {
+	    if (lp->li_spec == LI_STALE) continue;
+	    return 0;		/* nope, still more work */
+	}
     }
     return 1;			/* All done */
 }
@@ -1901,6 +2151,107 @@ all_done(void)
 }
 
 
+/*
+ * Content hash of the current database, recomputed only when a
+ * different database is loaded or the file has changed on disk
+ * since it was hashed.
+ */
+static char db_hash[64];
+static size_t db_size;
+static char db_hash_name[MAXPATHLEN];
+static time_t db_hash_mtime;
+static off_t db_hash_fsize;
+
+static int
+db_hash_update(void)
+{
+    struct stat sb;
+
+    if (stat(file_fullname, &sb) < 0)
+	return -1;
+    if (BU_STR_EQUAL(db_hash_name, file_fullname)
+	&& sb.st_mtime == db_hash_mtime && sb.st_size == db_hash_fsize)
+	return 0;
+    db_hash_name[0] = '\0';
+    if (remrt_db_hash(file_fullname, db_hash, sizeof(db_hash), &db_size) < 0)
+	return -1;
+    bu_strlcpy(db_hash_name, file_fullname, sizeof(db_hash_name));
+    db_hash_mtime = sb.st_mtime;
+    db_hash_fsize = sb.st_size;
+    return 0;
+}
+
+
+/*
+ * Offer the database to an "xfer" host by content hash.  The worker
+ * answers with MSG_DBHASH_REPLY, see ph_dbhash_reply().
+ */
+static void
+send_dbhash(struct servers *sp)
+{
+    char obuf[MAXPATHLEN+128];
+
+    if (db_hash_update() < 0) {
+	bu_log("%s unable to read %s\n", stamp(), file_fullname);
+	drop_server(sp, "database unreadable");
+	return;
+    }
+    snprintf(obuf, sizeof(obuf), "%s %zu %s", db_hash, db_size, file_basename);
+    if (rem_debug > 1) bu_log("%s MSG_DBHASH %s\n", stamp(), obuf);
+    if (pkg_send(MSG_DBHASH, obuf, strlen(obuf)+1, sp->sr_pc) < 0) {
+	drop_server(sp, "MSG_DBHASH pkg_send error");
+	return;
+    }
+    statechange(sp, SRST_DOING_DBXFER);
+    (void)gettimeofday(&sp->sr_sendtime, (struct timezone *)0);
+}
+
+
+/*
+ * Send the database to a worker which asked for it, as a series of
+ * compressed MSG_DB chunks ended by an empty one.
+ *
+ * Returns -
+ * -1 error
+ * 0 OK
+ */
+static int
+send_db(struct servers *sp)
+{
+    struct bu_mapped_file *mp;
+    struct bu_external raw;
+    struct bu_external z;
+    size_t off;
+    int ret;
+
+    if ((mp = bu_open_mapped_file(file_fullname, NULL)) == NULL)
+	return -1;
+
+    for (off = 0; off < mp->buflen; off += REMRT_DB_CHUNK) {
+	BU_EXTERNAL_INIT(&raw);
+	raw.ext_buf = (uint8_t *)mp->buf + off;
+	raw.ext_nbytes = mp->buflen - off;
+	if (raw.ext_nbytes > REMRT_DB_CHUNK)
+	    raw.ext_nbytes = REMRT_DB_CHUNK;
+	if (rt_compress_external(&z, &raw) < 0) {
+	    bu_close_mapped_file(mp);
+	    return -1;
+	}
+	ret = pkg_send(MSG_DB, (const char *)z.ext_buf, z.ext_nbytes, sp->sr_pc);
+	bu_free_external(&z);
+	if (ret < 0) {
+	    bu_close_mapped_file(mp);
+	    return -1;
+	}
+    }
+    bu_close_mapped_file(mp);
+
+    if (pkg_send(MSG_DB, "", 0, sp->sr_pc) < 0)
+	return -1;
+    return 0;
+}
+
+
 static void
 send_dirbuild(struct servers *sp)
 {
@@ -1911,6 +2262,14 @@ send_dirbuild(struct servers *sp)
 
     ihp = sp->sr_host;
     switch (ihp->ht_where) {
+	case HT_XFER:
+	    if (sp->sr_dbok)
+		break;	/* worker is already in the database's directory */
+	    if (sp->sr_caps & REMRT_CAP_DBXFER) {
+		send_dbhash(sp);
+		return;
+	    }
+	    /* fall through — worker predates the transfer, treat as HT_CD */
 	case HT_LOCAL:  /* fall through — same as HT_CD: send MSG_CD then MSG_DIRBUILD */
 	case HT_CD:
 	    if (rem_debug > 1) bu_log("%s MSG_CD %s\n", stamp(), ihp->ht_path);
@@ -1957,6 +2316,7 @@ this_frame_done(struct frame *fr)
     if (BU_LIST_NON_EMPTY(&fr->fr_todo))
 	return 1;		/* more work still to be sent */
 
+    /* Stale speculative copies have li_frame cleared, never match */
     for (sp = &servers[0]; sp < &servers[MAXSERVERS]; sp++) {
 	if (sp->sr_pc == PKC_NULL) continue;
 	for (BU_LIST_FOR(lp, list, &sp->sr_work)) {
@@ -2054,15 +2414,15 @@ send_gettrees(struct servers *sp, struct frame *fr)
 }
 
 
+/*
+ * Send one or more (with REMRT_CAP_BATCH) "start stop frame" triples.
+ */
 static void
-send_do_lines(struct servers *sp, int start, int stop, int framenum)
+send_do_lines(struct servers *sp, const char *spans)
 {
-    char obuf[256] = {0};
-
     if (sp->sr_pc == PKC_NULL) return;
 
-    snprintf(obuf, sizeof(obuf), "%d %d %d", start, stop, framenum);
-    if (pkg_send(MSG_LINES, obuf, strlen(obuf)+1, sp->sr_pc) < 0)
+    if (pkg_send(MSG_LINES, spans, strlen(spans)+1, sp->sr_pc) < 0)
 	drop_server(sp, "MSG_LINES pkg_send error");
 
     (void)gettimeofday(&sp->sr_sendtime, (struct timezone *)0);
@@ -2086,6 +2446,10 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
     int a, b;
     int lump;
     int maxlump;
+    int costsized = 0;
+    int nspans = 0;
+    int total = 0;
+    struct bu_vls spans = BU_VLS_INIT_ZERO;
 
     if (sp->sr_pc == PKC_NULL) return 0;
 
@@ -2173,12 +2537,21 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
      * local processing delays
      */
     /* Base new assignment on desired result rate & measured speed */
-    lump = assignment_time() * sp->sr_w_elapsed;
+    if (work_allocate_method == OPT_COST && sp->sr_w_cost > 0.0) {
+	/* Size by predicted cost of the pixels, not by pixel count */
+	costmap_setup(fr);
+	lp = BU_LIST_FIRST(list, &fr->fr_todo);
+	lump = costmap_span_end(lp->li_start, lp->li_stop,
+				cost_assignment(sp, fr)) - lp->li_start + 1;
+	costsized = 1;
+    } else {
+	lump = assignment_time() * sp->sr_w_elapsed;
+    }
 
     /* If each frame has a dedicated server, make lumps big */
     if (work_allocate_method == OPT_MOVIE) {
 	lump = fr->fr_width * 2;	/* 2 scanlines at a whack */
-    } else {
+    } else if (!costsized) {
 	/* Limit growth in assignment size to 1.5X each assignment */
 	if (lump > 1.5*sp->sr_lump) lump = 1.5*sp->sr_lump;
     }
@@ -2197,28 +2570,42 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
     maxlump = fr->fr_height / 32;
     if (maxlump < 1) maxlump = 1;
     maxlump *= fr->fr_width;
-    if (lump > maxlump) lump=maxlump;
-    sp->sr_lump = lump;
-
-    lp = BU_LIST_FIRST(list, &fr->fr_todo);
-    a = lp->li_start;
-    b = a+sp->sr_lump-1;	/* work increment */
-    if (b >= lp->li_stop) {
-	b = lp->li_stop;
-	sp->sr_lump = b-a+1;	/* Indicate short assignment */
-	BU_LIST_DEQUEUE(&lp->l);
-	FREE_LIST(lp);
-	lp = LIST_NULL;
-    } else
-	lp->li_start = b+1;
+    if (lump > maxlump && !costsized) lump=maxlump;
 
-    /* Record newly allocated pixel range */
-    GET_LIST(lp);
-    lp->li_frame = fr;
-    lp->li_start = a;
-    lp->li_stop = b;
-    BU_LIST_INSERT(&sp->sr_work, &lp->l);
-    send_do_lines(sp, a, b, fr->fr_number);
+    /*
+     * Carve the assignment off the front of the todo list.  When the
+     * list has become fragmented (requeued work, the tail of a frame)
+     * a worker that can batch is sent several pieces at once rather
+     * than paying a round trip for each short one.
+     */
+    do {
+	lp = BU_LIST_FIRST(list, &fr->fr_todo);
+	a = lp->li_start;
+	b = a+(lump-total)-1;	/* work increment */
+	if (b >= lp->li_stop) {
+	    b = lp->li_stop;
+	    BU_LIST_DEQUEUE(&lp->l);
+	    FREE_LIST(lp);
+	    lp = LIST_NULL;
+	} else
+	    lp->li_start = b+1;
+
+	/* Record newly allocated pixel range */
+	GET_LIST(lp);
+	lp->li_frame = fr;
+	lp->li_start = a;
+	lp->li_stop = b;
+	BU_LIST_INSERT(&sp->sr_work, &lp->l);
+	bu_vls_printf(&spans, "%s%d %d %ld", nspans ? " " : "", a, b, fr->fr_number);
+	total += b-a+1;
+	nspans++;
+    } while ((sp->sr_caps & REMRT_CAP_BATCH) &&
+	     nspans < REMRT_MAX_BATCH && total < lump &&
+	     BU_LIST_NON_EMPTY(&fr->fr_todo));
+
+    sp->sr_lump = total;	/* less than lump indicates short assignment */
+    send_do_lines(sp, bu_vls_cstr(&spans));
+    bu_vls_free(&spans);
 
     /* See if server will need more assignments */
     if (server_q_len(sp) < N_SERVER_ASSIGNMENTS)
@@ -2227,6 +2614,72 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
 }
 
 
+/*
+ * Under the "cost" allocation method, once a frame has no unassigned
+ * work left, an idle server may be handed a copy of the outstanding
+ * assignment that is predicted to finish last, provided it would
+ * finish that assignment well before its current owner.  Whichever
+ * copy comes back first is kept, the other is discarded on arrival.
+ *
+ * Returns -
+ * 0 nothing was duplicated
+ * 1 a speculative assignment was sent
+ */
+static int
+speculate(struct servers *sp, struct frame *fr, struct timeval *nowp)
+{
+    struct servers *csp;
+    struct list *lp;
+    struct list *best = LIST_NULL;
+    double best_left = 0.0;
+    double left;
+    double mine;
+    char obuf[128];
+
+    CHECK_FRAME(fr);
+
+    if (sp->sr_pc == PKC_NULL || sp->sr_state != SRST_READY) return 0;
+    if (sp->sr_curframe != fr || sp->sr_w_cost <= 0.0) return 0;
+    if (server_q_len(sp) > 0) return 0;
+
+    for (csp = &servers[0]; csp < &servers[MAXSERVERS]; csp++) {
+	if (csp == sp || csp->sr_pc == PKC_NULL) continue;
+	if (csp->sr_state != SRST_READY || csp->sr_w_cost <= 0.0) continue;
+
+	/* Assignments are worked in order, the first one since sendtime */
+	left = -tvdiff(nowp, &csp->sr_sendtime);
+	for (BU_LIST_FOR(lp, list, &csp->sr_work)) {
+	    left += costmap_span_cost(lp->li_start, lp->li_stop) / csp->sr_w_cost;
+	    if (lp->li_frame != fr || lp->li_spec != LI_NORMAL) continue;
+	    if (left > best_left) {
+		best_left = left;
+		best = lp;
+	    }
+	}
+    }
+    if (best == LIST_NULL) return 0;
+
+    mine = costmap_span_cost(best->li_start, best->li_stop) / sp->sr_w_cost;
+    if (mine * SPECULATE_RATIO >= best_left) return 0;
+
+    if (rem_debug) {
+	bu_log("%s %s: duplicating fr%ld %d..%d, %g sec vs %g sec left\n",
+	       stamp(), sp->sr_host->ht_name, fr->fr_number,
+	       best->li_start, best->li_stop, mine, best_left);
+    }
+    best->li_spec = LI_DUPLICATED;
+    GET_LIST(lp);
+    lp->li_frame = fr;
+    lp->li_start = best->li_start;
+    lp->li_stop = best->li_stop;
+    lp->li_spec = LI_DUPLICATED;
+    BU_LIST_INSERT(&sp->sr_work, &lp->l);
+    snprintf(obuf, sizeof(obuf), "%d %d %ld", lp->li_start, lp->li_stop, fr->fr_number);
+    send_do_lines(sp, obuf);
+    return 1;
+}
+
+
 /*
  * This routine is called by the main loop, after each batch of PKGs
  * have arrived.
@@ -2279,6 +2732,7 @@ schedule(struct timeval *nowp)
 
 	    case SRST_DOING_DIRBUILD:
 	    case SRST_DOING_GETTREES:
+	    case SRST_DOING_DBXFER:
 		/* Drop the server if the setup phase takes too long.
 		 * Without this check, a hung rt_dirbuild() or
 		 * rt_gettrees() inside rtsrv would leave remrt waiting
@@ -2378,6 +2832,18 @@ top:
 	work_allocate_method--;
 	goto top;
     }
+
+    /* Put idle servers to work on copies of the stragglers */
+    if (work_allocate_method == OPT_COST) {
+	for (fr = FrameHead.fr_forw; fr != &FrameHead; fr = fr->fr_forw) {
+	    CHECK_FRAME(fr);
+	    if (BU_LIST_NON_EMPTY(&fr->fr_todo)) continue;
+	    for (sp = &servers[0]; sp < &servers[MAXSERVERS]; sp++) {
+		if (sp->sr_pc == PKC_NULL) continue;
+		(void)speculate(sp, fr, nowp);
+	    }
+	}
+    }
     /* No work remains to be assigned, or servers are stuffed full */
 out:
     scheduler_going = 0;
@@ -2427,6 +2893,28 @@ cd_debug(const int argc, const char **argv)
 }
 
 
+/*
+ * Set the protocol extensions offered to workers connecting from
+ * now on.
+ */
+static int
+cd_caps(const int argc, const char **argv)
+{
+    unsigned int caps;
+
+    if (argc > 1) {
+	if (sscanf(argv[1], "%x", &caps) != 1) {
+	    bu_log("%s Bad caps '%s'\n", stamp(), argv[1]);
+	    return -1;
+	}
+	remrt_caps = (int)caps & REMRT_CAP_ALL;
+    }
+    bu_log("%s Protocol extensions=x%x (lz4=%x batch=%x xfer=%x)\n", stamp(),
+	   remrt_caps, REMRT_CAP_LZ4, REMRT_CAP_BATCH, REMRT_CAP_DBXFER);
+    return 0;
+}
+
+
 /*
  * Send a string to the command processor on all the remote workers.
  * Typically this would be of the form "opt -x42;"
@@ -2761,6 +3249,8 @@ cd_allocate(const int argc, const char **argv)
 	work_allocate_method = OPT_MOVIE;
     } else if (BU_STR_EQUAL(argv[1], "load")) {
 	work_allocate_method = OPT_LOAD;
+    } else if (BU_STR_EQUAL(argv[1], "cost")) {
+	work_allocate_method = OPT_COST;
     } else {
 	bu_log("%s Bad allocateby type '%s'\n", stamp(), argv[1]);
 	return -1;
@@ -2990,6 +3480,10 @@ cd_status(const int UNUSED(argc), const char **UNUSED(argv))
 	bu_log("\t r/s:  weighted=%gr/s missed = %d\n",
 	       sp->sr_w_rays,
 	       sp->sr_host->ht_rs_miss);
+	bu_log("\t cost: weighted=%gu/s\n",
+	       sp->sr_w_cost);
+	bu_log("\t caps: x%x\n",
+	       sp->sr_caps);
 
 	if (rem_debug)
 	    pr_list(&(sp->sr_work));
@@ -3090,7 +3584,7 @@ cd_help(const int UNUSED(argc), const char **UNUSED(argv))
 
 
 /*
- * host name always|night|passive cd|convert path
+ * host name always|night|passive cd|convert|xfer path
  */
 static int
 cd_host(const int argc, const char **argv)
@@ -3136,6 +3630,9 @@ cd_host(const int argc, const char **argv)
 		case HT_LOCAL:
 		    bu_log("local %s\n", ihp->ht_path);
 		    break;
+		case HT_XFER:
+		    bu_log("xfer %s\n", ihp->ht_path);
+		    break;
 		default:
 		    bu_log("?where?\n");
 		    break;
@@ -3190,6 +3687,11 @@ cd_host(const int argc, const char **argv)
 	 * lives (same role as the path argument for "cd").             */
 	ihp->ht_where = HT_LOCAL;
 	ihp->ht_path = bu_strdup(argv[argpoint+1]);
+    } else if (BU_STR_EQUAL(argv[argpoint], "xfer")) {
+	/* Like "cd", but the database is sent to the worker, which
+	 * keeps it in its cache directory by content hash. */
+	ihp->ht_where = HT_XFER;
+	ihp->ht_path = bu_strdup(argv[argpoint+1]);
     } else {
 	bu_log("unknown 'where' string '%s'\n", argv[argpoint]);
     }
@@ -3633,7 +4135,9 @@ ph_version(struct pkg_conn *pc, char *buf)
 {
     struct servers *sp;
     const char *tok_prefix;
+    const char *caps_prefix;
     const char *recv_token = NULL;
+    unsigned int worker_caps = 0;
 
     sp = get_server_by_pc(pc);
     if (sp == SERVERS_NULL) {
@@ -3642,8 +4146,10 @@ ph_version(struct pkg_conn *pc, char *buf)
 	return;
     }
 
-    /* Check protocol version (must be exact prefix match) */
-    if (bu_strncmp(PROTOCOL_VERSION, buf, strlen(PROTOCOL_VERSION)) != 0) {
+    /* Check protocol version (must be exact prefix match).  Workers
+     * speaking the previous version are accepted, minus extensions. */
+    if (bu_strncmp(PROTOCOL_VERSION, buf, strlen(PROTOCOL_VERSION)) != 0 &&
+	bu_strncmp(PROTOCOL_VERSION_V20, buf, strlen(PROTOCOL_VERSION_V20)) != 0) {
 	bu_log("ERROR %s: protocol version mismatch\n",
 	       sp->sr_host->ht_name);
 	bu_log("  local='%s'\n", PROTOCOL_VERSION);
@@ -3653,10 +4159,14 @@ ph_version(struct pkg_conn *pc, char *buf)
 	return;
     }
 
-    /* Extract optional session token from the version string */
-    tok_prefix = buf + strlen(PROTOCOL_VERSION);
-    if (bu_strncmp(tok_prefix, REMRT_AUTH_TOKEN_PREFIX,
-		   strlen(REMRT_AUTH_TOKEN_PREFIX)) == 0) {
+    /* Extract optional extensions and session token from the version string */
+    if (bu_strncmp(PROTOCOL_VERSION, buf, strlen(PROTOCOL_VERSION)) == 0 &&
+	(caps_prefix = strstr(buf, REMRT_CAPS_PREFIX)) != NULL) {
+	if (sscanf(caps_prefix + strlen(REMRT_CAPS_PREFIX), "%x", &worker_caps) != 1)
+	    worker_caps = 0;
+    }
+    tok_prefix = strstr(buf, REMRT_AUTH_TOKEN_PREFIX);
+    if (tok_prefix != NULL) {
 	recv_token = tok_prefix + strlen(REMRT_AUTH_TOKEN_PREFIX);
     }
 
@@ -3688,6 +4198,60 @@ ph_version(struct pkg_conn *pc, char *buf)
     }
     statechange(sp, SRST_VERSOK);
     if (buf) (void)free(buf);
+
+    /* Tell the worker which of its extensions to use */
+    sp->sr_caps = (int)worker_caps & remrt_caps;
+    if (sp->sr_caps) {
+	char obuf[32];
+
+	snprintf(obuf, sizeof(obuf), "%x", sp->sr_caps);
+	if (pkg_send(MSG_CAPS, obuf, strlen(obuf)+1, sp->sr_pc) < 0)
+	    drop_server(sp, "MSG_CAPS pkg_send error");
+    }
+}
+
+
+/*
+ * The server answers our MSG_DBHASH, and the final MSG_DB of a
+ * transfer, with "have" once the database is in its current
+ * directory, "need" if it wants us to send it, or "bad".
+ */
+static void
+ph_dbhash_reply(struct pkg_conn *pc, char *buf)
+{
+    struct servers *sp;
+
+    sp = get_server_by_pc(pc);
+    if (sp == SERVERS_NULL) {
+	bu_log("MSG_DBHASH_REPLY from unknown connection fd %d\n", pkg_get_read_fd(pc));
+	if (buf) (void)free(buf);
+	return;
+    }
+    if (sp->sr_state != SRST_DOING_DBXFER) {
+	bu_log("MSG_DBHASH_REPLY in state %s?\n",
+	       state_to_string(sp->sr_state));
+	drop_server(sp, "wrong state");
+	if (buf) (void)free(buf);
+	return;
+    }
+
+    if (buf && BU_STR_EQUAL(buf, "have")) {
+	bu_log("%s %s has database %s\n",
+	       stamp(), sp->sr_host->ht_name, db_hash);
+	sp->sr_dbok = 1;
+	statechange(sp, SRST_VERSOK);
+	send_dirbuild(sp);
+    } else if (buf && BU_STR_EQUAL(buf, "need")) {
+	bu_log("%s %s sending database %s (%zu bytes)\n",
+	       stamp(), sp->sr_host->ht_name, file_basename, db_size);
+	if (send_db(sp) < 0)
+	    drop_server(sp, "database transfer error");
+	else
+	    (void)gettimeofday(&sp->sr_sendtime, (struct timezone *)0);
+    } else {
+	drop_server(sp, "database transfer failed");
+    }
+    if (buf) (void)free(buf);
 }
 
 
@@ -3711,75 +4275,72 @@ ph_cmd(struct pkg_conn *pc, char *buf)
 
 
 /*
- * When a scanline is received from a server, file it away.
+ * Fold the elapsed time of a finished assignment a..b into the cost
+ * map and into the server's throughput estimate.  The ratio of the
+ * cost the server's throughput says was spent to the predicted cost
+ * corrects the map, and the (corrected) predicted cost over the
+ * elapsed time is a new throughput sample.
  */
 static void
-ph_pixels(struct pkg_conn *pc, char *buf)
+cost_observe(struct servers *sp, int a, int b)
 {
-    size_t i;
-    struct servers *sp;
-    struct frame *fr;
-    struct list *lp;
-    struct line_info info;
-    struct timeval tvnow;
-    int npix;
-    int fd;
-    ssize_t cnt;
-    struct bu_external ext;
+    double predicted;
+    double rate;
 
-    (void)gettimeofday(&tvnow, (struct timezone *)0);
+    predicted = costmap_span_cost(a, b);
+    if (predicted <= 0.0 || sp->sr_l_elapsed <= 0.0) return;
 
-    sp = get_server_by_pc(pc);
-    if (sp == SERVERS_NULL) {
-	bu_log("%s Ignoring MSG_PIXELS from unknown connection fd %d\n",
-	       stamp(), pkg_get_read_fd(pc));
-	goto out;
-    }
-    if (sp->sr_state != SRST_READY && sp->sr_state != SRST_NEED_TREE &&
-	sp->sr_state != SRST_DOING_GETTREES) {
-	bu_log("%s Ignoring MSG_PIXELS from %s\n",
-	       stamp(), sp->sr_host->ht_name);
-	goto out;
-    }
+    if (sp->sr_w_cost > 0.0)
+	costmap_update(a, b, sp->sr_l_elapsed * sp->sr_w_cost / predicted);
 
-    /* XXX Is this measuring the processing time for
-     * XXX one assignment, or for the whole pipeline of N_SERVER_ASSIGNMENTS
-     * XXX worth of assignments?  It looks like the latter.
-     */
+    rate = costmap_span_cost(a, b) / sp->sr_l_elapsed;
+    if (sp->sr_w_cost <= 0.0)
+	sp->sr_w_cost = rate;
+    else
+	sp->sr_w_cost = (1.0 - COSTMAP_GAIN) * sp->sr_w_cost + COSTMAP_GAIN * rate;
+}
 
-    /*
-     * If the elapsed time is less than MIN_ELAPSED_TIME, the package
-     * was probably waiting in either the kernel's or libraries
-     * input buffer.  Don't use these statistics.
-     */
+
+/*
+ * If the elapsed time is less than MIN_ELAPSED_TIME, the package
+ * was probably waiting in either the kernel's or libraries
+ * input buffer.  Don't use these statistics.
+ */
 #define MIN_ELAPSED_TIME 0.02
-    if ((sp->sr_l_elapsed = tvdiff(&tvnow, &sp->sr_sendtime)) < MIN_ELAPSED_TIME)
-	sp->sr_l_elapsed = MIN_ELAPSED_TIME;
 
-    /* Consider the next assignment to have been sent "now" */
-    (void)gettimeofday(&sp->sr_sendtime, (struct timezone *)0);
-    bu_struct_wrap_buf(&ext, (void *) buf);
 
-    cnt = bu_struct_import((void *)&info, desc_line_info, &ext, NULL);
-    if (cnt < 0) {
-	bu_log("bu_struct_import error, %zu\n", cnt);
-	drop_server(sp, "bu_struct_import error");
-	goto out;
-    }
+/*
+ * File away the pixels of one finished assignment, described by
+ * 'info', with 'len' bytes available at 'pixels'.  The server's
+ * sr_l_elapsed must hold the time spent on this assignment.
+ *
+ * Returns -
+ * -1 the server was dropped
+ * 0 OK
+ */
+static int
+file_pixels(struct servers *sp, const struct line_info *info, const unsigned char *pixels, size_t len)
+{
+    size_t i;
+    struct frame *fr;
+    struct list *lp;
+    int npix;
+    int fd;
+    ssize_t cnt;
 
     if (rem_debug) {
 	bu_log("%s %s %d/%d..%d, ray=%d, cpu=%.2g, el=%g\n",
 	       stamp(),
 	       sp->sr_host->ht_name,
-	       info.li_frame, info.li_startpix, info.li_endpix,
-	       info.li_nrays, info.li_cpusec, sp->sr_l_elapsed);
+	       info->li_frame, info->li_startpix, info->li_endpix,
+	       info->li_nrays, info->li_cpusec, sp->sr_l_elapsed);
     }
 
     if (BU_LIST_IS_EMPTY(&sp->sr_work)) {
 	bu_log("%s responded with pixels when none were assigned!\n",
 	       sp->sr_host->ht_name);
 	drop_server(sp, "server responded, no assignment");
-	goto out;
+	return -1;
     }
 
     /*
@@ -3789,53 +4350,76 @@ ph_pixels(struct pkg_conn *pc, char *buf)
      * then the server is dropped.
      */
     lp = BU_LIST_FIRST(list, &sp->sr_work);
+
+    if (lp->li_spec == LI_STALE) {
+	/*
+	 * A speculative twin of this assignment already delivered
+	 * these pixels, and the frame may be gone by now.
+	 * Keep only the timing.
+	 */
+	if (info->li_startpix != lp->li_start ||
+	    info->li_endpix != lp->li_stop) {
+	    drop_server(sp, "pixel assignment mismatch");
+	    return -1;
+	}
+	if (rem_debug) {
+	    bu_log("%s %s: discarding duplicate %d..%d\n", stamp(),
+		   sp->sr_host->ht_name, lp->li_start, lp->li_stop);
+	}
+	if (sp->sr_l_elapsed > MIN_ELAPSED_TIME)
+	    cost_observe(sp, lp->li_start, lp->li_stop);
+	BU_LIST_DEQUEUE(&lp->l);
+	FREE_LIST(lp);
+	return 0;
+    }
+
     fr = lp->li_frame;
     CHECK_FRAME(fr);
 
-    if (info.li_frame != fr->fr_number) {
+    if (info->li_frame != fr->fr_number) {
 	bu_log("%s: frame number mismatch, got=%d, assigned=%ld\n",
 	       sp->sr_host->ht_name,
-	       info.li_frame, fr->fr_number);
+	       info->li_frame, fr->fr_number);
 	drop_server(sp, "frame number mismatch");
-	goto out;
+	return -1;
     }
-    if (info.li_startpix != lp->li_start ||
-	info.li_endpix != lp->li_stop) {
+    if (info->li_startpix != lp->li_start ||
+	info->li_endpix != lp->li_stop) {
 	bu_log("%s:  assignment mismatch, sent %d..%d, got %d..%d\n",
 	       sp->sr_host->ht_name,
 	       lp->li_start, lp->li_stop,
-	       info.li_startpix, info.li_endpix);
+	       info->li_startpix, info->li_endpix);
 	drop_server(sp, "pixel assignment mismatch");
-	goto out;
+	return -1;
     }
 
-    if (info.li_startpix < 0 ||
-	info.li_endpix >= fr->fr_width*fr->fr_height) {
+    if (info->li_startpix < 0 ||
+	info->li_endpix >= fr->fr_width*fr->fr_height) {
 	bu_log("pixel numbers out of range\n");
 	drop_server(sp, "pixel out of range");
-	goto out;
+	return -1;
     }
 
     /* Stash pixels in bottom-to-top .pix order */
-    npix = info.li_endpix - info.li_startpix + 1;
+    npix = info->li_endpix - info->li_startpix + 1;
     i = npix*3;
-    if (pc->pkc_len - ext.ext_nbytes < i) {
+    if (len < i) {
 	bu_log("short scanline, s/b=%zu, was=%zu\n",
-	       i, pc->pkc_len - ext.ext_nbytes);
+	       i, len);
 	drop_server(sp, "short scanline");
-	goto out;
+	return -1;
     }
     /* Write pixels into file */
     /* Later, can implement FD cache here */
     if ((fd = open(fr->fr_filename, O_RDWR | O_BINARY)) < 0) {
 	/* open failed */
 	perror(fr->fr_filename);
-    } else if (bu_lseek(fd, info.li_startpix*3, 0) < 0) {
+    } else if (bu_lseek(fd, info->li_startpix*3, 0) < 0) {
 	/* seek failed */
 	perror(fr->fr_filename);
 	(void)close(fd);
     } else {
-	cnt = write(fd, buf+ext.ext_nbytes, i);
+	cnt = write(fd, pixels, i);
 	(void)close(fd);
 
 	if (cnt != (ssize_t)i) {
@@ -3855,23 +4439,23 @@ ph_pixels(struct pkg_conn *pc, char *buf)
 	    drop_server(sp, "disk write error");
 
 	    /* Return, as if nothing had happened. */
-	    goto out;
+	    return -1;
 	}
     }
 
     /* If display attached, also draw it */
     if (fbp != FB_NULL) {
-	write_fb((unsigned char *)buf + ext.ext_nbytes, fr,
-		 info.li_startpix, info.li_endpix+1);
+	write_fb((unsigned char *)pixels, fr,
+		 info->li_startpix, info->li_endpix+1);
     }
 
     /*
      * Stash the statistics that came back.
      * Only perform weighted averages if elapsed times are reasonable.
      */
-    fr->fr_nrays += info.li_nrays;
-    fr->fr_cpu += info.li_cpusec;
-    sp->sr_l_percent = info.li_percent;
+    fr->fr_nrays += info->li_nrays;
+    fr->fr_cpu += info->li_cpusec;
+    sp->sr_l_percent = info->li_percent;
     if (sp->sr_l_elapsed > MIN_ELAPSED_TIME) {
 	double blend1;	/* fraction of historical value to use */
 	double blend2;	/* fraction of new value to use */
@@ -3903,16 +4487,28 @@ ph_pixels(struct pkg_conn *pc, char *buf)
 	sp->sr_w_elapsed = blend1 * sp->sr_w_elapsed +
 	    blend2 * sp->sr_l_el_rate;
 	sp->sr_w_rays = blend1 * sp->sr_w_rays +
-	    blend2 * (info.li_nrays/sp->sr_l_elapsed);
-	sp->sr_l_cpu = info.li_cpusec;
-	sp->sr_s_cpu += info.li_cpusec;
+	    blend2 * (info->li_nrays/sp->sr_l_elapsed);
+	sp->sr_l_cpu = info->li_cpusec;
+	sp->sr_s_cpu += info->li_cpusec;
 	sp->sr_s_elapsed += sp->sr_l_el_rate;
 	sp->sr_sq_elapsed += sp->sr_l_el_rate * sp->sr_l_el_rate;
 	sp->sr_nsamp++;
+
+	costmap_setup(fr);
+	cost_observe(sp, info->li_startpix, info->li_endpix);
+    }
+
+    /* First copy of a duplicated assignment back wins */
+    if (lp->li_spec == LI_DUPLICATED) {
+	struct list *tp = find_twin(sp, lp);
+	if (tp != LIST_NULL) {
+	    tp->li_spec = LI_STALE;
+	    tp->li_frame = FRAME_NULL;
+	}
     }
 
     /* Remove from work list */
-    list_remove(&(sp->sr_work), info.li_startpix, info.li_endpix);
+    list_remove(&(sp->sr_work), info->li_startpix, info->li_endpix);
 
 /*
  * Check to see if this host is load limited.  If the host is loaded
@@ -3920,7 +4516,7 @@ ph_pixels(struct pkg_conn *pc, char *buf)
  */
     if (sp->sr_host->ht_when == HT_RS ||
 	sp->sr_host->ht_when == HT_PASSRS) {
-	if (sp->sr_host->ht_rs >= info.li_nrays / sp->sr_l_elapsed) {
+	if (sp->sr_host->ht_rs >= info->li_nrays / sp->sr_l_elapsed) {
 	    if (++sp->sr_host->ht_rs_miss > 60) {
 		sp->sr_host->ht_rs_miss = 0;
 		sp->sr_host->ht_rs_wait = 3;
@@ -3930,7 +4526,172 @@ ph_pixels(struct pkg_conn *pc, char *buf)
 	    sp->sr_host->ht_rs_miss /= 2;
 	}
     }
+    return 0;
+}
+
+
+/*
+ * When a scanline is received from a server, file it away.
+ */
+static void
+ph_pixels(struct pkg_conn *pc, char *buf)
+{
+    struct servers *sp;
+    struct line_info info;
+    struct timeval tvnow;
+    ssize_t cnt;
+    struct bu_external ext;
+
+    (void)gettimeofday(&tvnow, (struct timezone *)0);
+
+    sp = get_server_by_pc(pc);
+    if (sp == SERVERS_NULL) {
+	bu_log("%s Ignoring MSG_PIXELS from unknown connection fd %d\n",
+	       stamp(), pkg_get_read_fd(pc));
+	goto out;
+    }
+    if (sp->sr_state != SRST_READY && sp->sr_state != SRST_NEED_TREE &&
+	sp->sr_state != SRST_DOING_GETTREES) {
+	bu_log("%s Ignoring MSG_PIXELS from %s\n",
+	       stamp(), sp->sr_host->ht_name);
+	goto out;
+    }
+
+    /* XXX Is this measuring the processing time for
+     * XXX one assignment, or for the whole pipeline of N_SERVER_ASSIGNMENTS
+     * XXX worth of assignments?  It looks like the latter.
+     */
+    if ((sp->sr_l_elapsed = tvdiff(&tvnow, &sp->sr_sendtime)) < MIN_ELAPSED_TIME)
+	sp->sr_l_elapsed = MIN_ELAPSED_TIME;
+
+    /* Consider the next assignment to have been sent "now" */
+    (void)gettimeofday(&sp->sr_sendtime, (struct timezone *)0);
+    bu_struct_wrap_buf(&ext, (void *) buf);
+
+    cnt = bu_struct_import((void *)&info, desc_line_info, &ext, NULL);
+    if (cnt < 0) {
+	bu_log("bu_struct_import error, %zu\n", cnt);
+	drop_server(sp, "bu_struct_import error");
+	goto out;
+    }
+
+    (void)file_pixels(sp, &info, (unsigned char *)buf + ext.ext_nbytes,
+		      pc->pkc_len - ext.ext_nbytes);
+out:
+    if (buf) (void)free(buf);
+}
+
+
+/*
+ * Several assignments worth of pixels in one compressed message,
+ * see REMRT_CAP_LZ4.  The elapsed time is shared out between the
+ * assignments in proportion to the CPU time each took.
+ */
+static void
+ph_pixels_z(struct pkg_conn *pc, char *buf)
+{
+    struct servers *sp;
+    struct line_info info[REMRT_MAX_BATCH];
+    size_t where[REMRT_MAX_BATCH];	/* offset of each span's pixels */
+    size_t avail[REMRT_MAX_BATCH];	/* bytes of each span's pixels */
+    struct timeval tvnow;
+    struct bu_external zext;
+    struct bu_external raw;
+    struct bu_external ext;
+    uint32_t nspans;
+    uint32_t n;
+    size_t off;
+    size_t len;
+    double elapsed;
+    double cpusum = 0.0;
+    double pixsum = 0.0;
+    ssize_t cnt;
+
+    (void)gettimeofday(&tvnow, (struct timezone *)0);
+    BU_EXTERNAL_INIT(&raw);
+
+    sp = get_server_by_pc(pc);
+    if (sp == SERVERS_NULL) {
+	bu_log("%s Ignoring MSG_PIXELS_Z from unknown connection fd %d\n",
+	       stamp(), pkg_get_read_fd(pc));
+	goto out;
+    }
+    if (sp->sr_state != SRST_READY && sp->sr_state != SRST_NEED_TREE &&
+	sp->sr_state != SRST_DOING_GETTREES) {
+	bu_log("%s Ignoring MSG_PIXELS_Z from %s\n",
+	       stamp(), sp->sr_host->ht_name);
+	goto out;
+    }
+
+    if ((elapsed = tvdiff(&tvnow, &sp->sr_sendtime)) < MIN_ELAPSED_TIME)
+	elapsed = MIN_ELAPSED_TIME;
+    (void)gettimeofday(&sp->sr_sendtime, (struct timezone *)0);
+
+    BU_EXTERNAL_INIT(&zext);
+    zext.ext_buf = (uint8_t *)buf;
+    zext.ext_nbytes = pc->pkc_len;
+    if (!buf || rt_uncompress_external(&raw, &zext) < 0 ||
+	raw.ext_nbytes < sizeof(nspans)) {
+	drop_server(sp, "bad MSG_PIXELS_Z");
+	goto out;
+    }
+    memcpy(&nspans, raw.ext_buf, sizeof(nspans));
+    nspans = ntohl(nspans);
+    if (nspans < 1 || nspans > REMRT_MAX_BATCH) {
+	drop_server(sp, "bad MSG_PIXELS_Z span count");
+	goto out;
+    }
+
+    /* Unpack and check every span before filing any of them */
+    off = sizeof(nspans);
+    for (n = 0; n < nspans; n++) {
+	unsigned char *cp = raw.ext_buf + off;
+
+	if (raw.ext_nbytes - off < 6) {
+	    drop_server(sp, "short MSG_PIXELS_Z");
+	    goto out;
+	}
+	len = ((size_t)cp[2] << 24) | ((size_t)cp[3] << 16) |
+	    ((size_t)cp[4] << 8) | (size_t)cp[5];
+	if (len < 8 || len > raw.ext_nbytes - off) {
+	    drop_server(sp, "short MSG_PIXELS_Z");
+	    goto out;
+	}
+	bu_struct_wrap_buf(&ext, (void *)cp);
+	cnt = bu_struct_import((void *)&info[n], desc_line_info, &ext, NULL);
+	if (cnt < 0) {
+	    bu_log("bu_struct_import error, %zu\n", cnt);
+	    drop_server(sp, "bu_struct_import error");
+	    goto out;
+	}
+	off += ext.ext_nbytes;
+	len = (size_t)(info[n].li_endpix - info[n].li_startpix + 1) * 3;
+	if (info[n].li_endpix < info[n].li_startpix || len > raw.ext_nbytes - off) {
+	    drop_server(sp, "short MSG_PIXELS_Z");
+	    goto out;
+	}
+	where[n] = off;
+	avail[n] = len;
+	off += len;
+
+	cpusum += info[n].li_cpusec;
+	pixsum += info[n].li_endpix - info[n].li_startpix + 1;
+    }
+
+    for (n = 0; n < nspans; n++) {
+	if (cpusum > 0.0)
+	    sp->sr_l_elapsed = elapsed * info[n].li_cpusec / cpusum;
+	else
+	    sp->sr_l_elapsed = elapsed * (info[n].li_endpix - info[n].li_startpix + 1) / pixsum;
+	if (sp->sr_l_elapsed < MIN_ELAPSED_TIME)
+	    sp->sr_l_elapsed = MIN_ELAPSED_TIME;
+
+	if (file_pixels(sp, &info[n], raw.ext_buf + where[n], avail[n]) < 0 ||
+	    sp->sr_state == SRST_CLOSING)
+	    break;
+    }
 out:
+    bu_free_external(&raw);
     if (buf) (void)free(buf);
 }
 
@@ -4178,6 +4939,8 @@ struct pkg_switch pkgswitch[] = {
     { MSG_LINES,		ph_default,		"Compute lines", NULL },
     { MSG_END,			ph_default,		"End", NULL },
     { MSG_PIXELS,		ph_pixels,		"Pixels", NULL },
+    { MSG_PIXELS_Z,		ph_pixels_z,		"Compressed pixels", NULL },
+    { MSG_DBHASH_REPLY,		ph_dbhash_reply,	"Database hash ACK", NULL },
     { MSG_PRINT,		ph_print,		"Log Message", NULL },
     { MSG_VERSION,		ph_version,		"Protocol version check", NULL },
     { MSG_CMD,			ph_cmd,			"Run one command", NULL },
@@ -4222,7 +4985,7 @@ struct command_tab cmd_tab[] = {
      cd_status,	1, 1},
     {"detach", "",		"detach from interactive keyboard",
      cd_detach,	1, 1},
-    {"host", "name always|night|passive|rs[ rays/sec]|passrs[ rays/sec] cd|convert path", "server host",
+    {"host", "name always|night|passive|rs[ rays/sec]|passrs[ rays/sec] cd|convert|xfer path", "server host",
      cd_host,	1, 6},
     {"wait", "",		"wait for current work assignment to finish",
      cd_wait,	1, 1},
@@ -4242,6 +5005,8 @@ struct command_tab cmd_tab[] = {
     /* FLAGS */
     {"debug", "[hex_flags]",	"set local debugging flag bits",
      cd_debug,	1, 2},
+    {"caps", "[hex_flags]",	"set protocol extensions offered to workers",
+     cd_caps,	1, 2},
     {"rdebug", "options",	"set remote debugging via 'opt' command",
      cd_rdebug,	2, 2},
     {"f", "square_size",	"set square frame size",
@@ -42,6 +42,7 @@
 #  include <sys/types.h>
 #endif
 #include "bio.h"
+#include "bnetwork.h"
 #include "bresource.h"
 #include "bsocket.h"
 
@@ -116,6 +117,16 @@ static volatile int rtsrv_connection_lost = 0;
  * -> view_2init -> do_run). */
 static int last_setup_frame = -1;
 
+/* Protocol extensions enabled by the dispatcher's MSG_CAPS, REMRT_CAP_xxx */
+static int srv_caps = 0;
+
+/* Database transfer in progress (REMRT_CAP_DBXFER) */
+static FILE *dbxfer_fp = NULL;
+static char dbxfer_hash[64] = {0};
+static char dbxfer_dir[MAXPATHLEN] = {0};
+static char dbxfer_file[MAXPATHLEN] = {0};
+static char dbxfer_tmp[MAXPATHLEN] = {0};
+
 static char *title_file = NULL;
 static char *title_obj = NULL;	/* name of file and first object */
 
@@ -142,6 +153,9 @@ void ph_end(struct pkg_conn *pc, char *buf);
 void ph_restart(struct pkg_conn *pc, char *buf);
 void ph_loglvl(struct pkg_conn *pc, char *buf);
 void ph_cd(struct pkg_conn *pc, char *buf);
+void ph_caps(struct pkg_conn *pc, char *buf);
+void ph_dbhash(struct pkg_conn *pc, char *buf);
+void ph_db(struct pkg_conn *pc, char *buf);
 
 void prepare(void);
 
@@ -156,6 +170,9 @@ struct pkg_switch pkgswitch[] = {
     { MSG_LOGLVL,	ph_loglvl,	"Change log level", NULL },
     { MSG_RESTART,	ph_restart,	"Restart", NULL },
     { MSG_CD,		ph_cd,		"Change Dir", NULL },
+    { MSG_CAPS,		ph_caps,	"Protocol extensions", NULL },
+    { MSG_DBHASH,	ph_dbhash,	"Database hash", NULL },
+    { MSG_DB,		ph_db,		"Database chunk", NULL },
     { 0,		0,		NULL, NULL }
 };
 
@@ -408,13 +425,15 @@ main(int argc, char **argv)
     }
 
     /* Send our version string, optionally including the session token.
-     * Format: PROTOCOL_VERSION REMRT_AUTH_TOKEN_PREFIX <hex-token>
+     * Format: PROTOCOL_VERSION REMRT_CAPS_PREFIX <hex-caps>
+     *         REMRT_AUTH_TOKEN_PREFIX <hex-token>
      * The token is only appended when one was supplied on the command
      * line (i.e., this process was auto-launched by remrt via SSH).
      */
     {
 	struct bu_vls ver = BU_VLS_INIT_ZERO;
 	bu_vls_strcat(&ver, PROTOCOL_VERSION);
+	bu_vls_printf(&ver, "%s%x", REMRT_CAPS_PREFIX, REMRT_CAP_ALL);
 	if (srv_auth_token[0] != '\0') {
 	    bu_vls_strcat(&ver, REMRT_AUTH_TOKEN_PREFIX);
 	    bu_vls_strcat(&ver, srv_auth_token);
@@ -566,6 +585,154 @@ ph_cd(struct pkg_conn *UNUSED(pc), char *buf)
 }
 
 
+/*
+ * The dispatcher's choice of protocol extensions, as a hex bit mask.
+ */
+void
+ph_caps(struct pkg_conn *UNUSED(pc), char *buf)
+{
+    unsigned int caps = 0;
+
+    if (debug)
+	fprintf(stderr, "ph_caps %s\n", buf);
+
+    if (sscanf(buf, "%x", &caps) == 1)
+	srv_caps = (int)caps & REMRT_CAP_ALL;
+    (void)free(buf);
+}
+
+
+static void
+send_dbhash_reply(const char *reply)
+{
+    if (pkg_send(MSG_DBHASH_REPLY, reply, strlen(reply)+1, pcsrv) < 0)
+	fprintf(stderr, "MSG_DBHASH_REPLY error\n");
+}
+
+
+/*
+ * Offer of a database as "hash size basename".  If a file with that
+ * content is already in our cache, change to its directory and say so,
+ * otherwise get ready to receive it.
+ */
+void
+ph_dbhash(struct pkg_conn *UNUSED(pc), char *buf)
+{
+    char have[64];
+    unsigned long size = 0;
+    size_t have_size = 0;
+    const char *name;
+    int n = 0;
+
+    if (debug)
+	fprintf(stderr, "ph_dbhash %s\n", buf);
+
+    if (dbxfer_fp) {
+	fclose(dbxfer_fp);
+	dbxfer_fp = NULL;
+	bu_file_delete(dbxfer_tmp);
+    }
+
+    if (sscanf(buf, "%63s %lu %n", dbxfer_hash, &size, &n) < 2 || n <= 0) {
+	bu_log("ph_dbhash: bad request '%s'\n", buf);
+	send_dbhash_reply("bad");
+	(void)free(buf);
+	return;
+    }
+
+    /* The name comes off the network, keep it inside the cache */
+    name = buf + n;
+    if (name[0] == '\0' || name[0] == '.' || strchr(name, '/') || strchr(name, '\\')) {
+	bu_log("ph_dbhash: refusing database name '%s'\n", name);
+	send_dbhash_reply("bad");
+	(void)free(buf);
+	return;
+    }
+
+    bu_dir(dbxfer_dir, sizeof(dbxfer_dir), BU_DIR_CACHE, "rtsrv", dbxfer_hash, NULL);
+    bu_mkdir(dbxfer_dir);
+    snprintf(dbxfer_file, sizeof(dbxfer_file), "%s%c%s", dbxfer_dir, BU_DIR_SEPARATOR, name);
+
+    if (bu_file_exists(dbxfer_file, NULL) &&
+	remrt_db_hash(dbxfer_file, have, sizeof(have), &have_size) == 0 &&
+	have_size == (size_t)size && BU_STR_EQUAL(have, dbxfer_hash)) {
+	if (chdir(dbxfer_dir) < 0) {
+	    bu_log("ph_dbhash: chdir(%s) failure\n", dbxfer_dir);
+	    send_dbhash_reply("bad");
+	} else {
+	    send_dbhash_reply("have");
+	}
+	(void)free(buf);
+	return;
+    }
+
+    snprintf(dbxfer_tmp, sizeof(dbxfer_tmp), "%s.%d", dbxfer_file, bu_pid());
+    if ((dbxfer_fp = fopen(dbxfer_tmp, "wb")) == NULL) {
+	bu_log("ph_dbhash: unable to create %s\n", dbxfer_tmp);
+	send_dbhash_reply("bad");
+    } else {
+	send_dbhash_reply("need");
+    }
+    (void)free(buf);
+}
+
+
+/*
+ * One compressed chunk of the database offered by MSG_DBHASH.
+ * An empty chunk ends the transfer.
+ */
+void
+ph_db(struct pkg_conn *pc, char *buf)
+{
+    struct bu_external ext;
+    struct bu_external out;
+    char have[64];
+
+    if (!dbxfer_fp) {
+	bu_log("ph_db: no database transfer in progress\n");
+	if (buf) (void)free(buf);
+	return;
+    }
+
+    if (pc->pkc_len > 0) {
+	BU_EXTERNAL_INIT(&ext);
+	ext.ext_buf = (uint8_t *)buf;
+	ext.ext_nbytes = pc->pkc_len;
+	if (rt_uncompress_external(&out, &ext) < 0 ||
+	    fwrite(out.ext_buf, 1, out.ext_nbytes, dbxfer_fp) != out.ext_nbytes) {
+	    bu_log("ph_db: unable to store database chunk in %s\n", dbxfer_tmp);
+	    fclose(dbxfer_fp);
+	    dbxfer_fp = NULL;
+	    bu_file_delete(dbxfer_tmp);
+	    send_dbhash_reply("bad");
+	}
+	if (out.ext_buf)
+	    bu_free_external(&out);
+	(void)free(buf);
+	return;
+    }
+    if (buf) (void)free(buf);
+
+    /* End of transfer, make sure we got what was offered */
+    fclose(dbxfer_fp);
+    dbxfer_fp = NULL;
+    if (remrt_db_hash(dbxfer_tmp, have, sizeof(have), NULL) < 0 ||
+	!BU_STR_EQUAL(have, dbxfer_hash)) {
+	bu_log("ph_db: content hash mismatch on %s\n", dbxfer_tmp);
+	bu_file_delete(dbxfer_tmp);
+	send_dbhash_reply("bad");
+	return;
+    }
+    bu_file_delete(dbxfer_file);
+    if (rename(dbxfer_tmp, dbxfer_file) < 0 || chdir(dbxfer_dir) < 0) {
+	bu_log("ph_db: unable to install %s\n", dbxfer_file);
+	send_dbhash_reply("bad");
+	return;
+    }
+    send_dbhash_reply("have");
+}
+
+
 void
 ph_restart(struct pkg_conn *UNUSED(pc), char *buf)
 {
@@ -855,17 +1022,44 @@ prepare(void)
 
 
 /*
- * Process pixels from 'a' to 'b' inclusive.  The results are sent
- * back all at once.  Limitation: may not do more than 'width' pixels
- * at once, because that is the size of the buffer (for now).
+ * Append len bytes to a growing external buffer, whose allocated
+ * size is kept in *alloc.
+ */
+static void
+append_external(struct bu_external *ep, size_t *alloc, const void *data, size_t len)
+{
+    if (ep->ext_nbytes + len > *alloc) {
+	*alloc = 2 * (ep->ext_nbytes + len);
+	ep->ext_buf = (uint8_t *)bu_realloc(ep->ext_buf, *alloc, "append_external");
+    }
+    memcpy(ep->ext_buf + ep->ext_nbytes, data, len);
+    ep->ext_nbytes += len;
+}
+
+
+/*
+ * Process pixels from 'a' to 'b' inclusive, for each "a b frame"
+ * triple in the request (several only with REMRT_CAP_BATCH).  The
+ * results of each span are sent back all at once, or with
+ * REMRT_CAP_LZ4 the results of all the spans are sent back together
+ * in one compressed MSG_PIXELS_Z.  Limitation: may not do more than
+ * 'width' pixels at once per span, because that is the size of the
+ * buffer (for now).
  */
 void
 ph_lines(struct pkg_conn *UNUSED(pc), char *buf)
 {
     int a, b, fr;
+    int spans[REMRT_MAX_BATCH][3];
+    int nspans = 0;
+    int i, n;
+    const char *cp;
     struct line_info info;
     struct rt_i *rtip = APP.a_rt_i;
     struct bu_external ext;
+    struct bu_external zraw;	/* MSG_PIXELS_Z contents, uncompressed */
+    size_t zalloc = 0;
+    uint32_t count;
     int ret;
 
     RT_CK_RTI(rtip);
@@ -881,25 +1075,15 @@ ph_lines(struct pkg_conn *UNUSED(pc), char *buf)
 	return;
     }
 
-    a=0;
-    b=0;
-    fr=0;
-    if (sscanf(buf, "%d %d %d", &a, &b, &fr) != 3)
+    cp = buf;
+    while (nspans < REMRT_MAX_BATCH &&
+	   sscanf(cp, "%d %d %d%n", &spans[nspans][0], &spans[nspans][1], &spans[nspans][2], &n) == 3) {
+	cp += n;
+	nspans++;
+    }
+    if (nspans == 0)
 	bu_exit(2, "ph_lines:  %s conversion error\n", buf);
-
-    srv_startpix = a;		/* buffer un-offset for view_pixel */
-
-    /* FIXME: if we do less than we were assigned, remrt is just going
-     * to drop us!  If we go over our scanlen, we'll probably overstep
-     * memory in the view front-end.
-     */
-    if (b-a+1 > srv_scanlen)
-	b = a + srv_scanlen - 1;
-
-    rtip->stats.rti_nrays = 0;
-    info.li_startpix = a;
-    info.li_endpix = b;
-    info.li_frame = fr;
+    fr = spans[0][2];
 
     /* Set up grid vectors and lighting on the first MSG_LINES for each
      * frame (identified by the frame number 'fr').  This mirrors the
@@ -948,29 +1132,69 @@ ph_lines(struct pkg_conn *UNUSED(pc), char *buf)
 	last_setup_frame = fr;
     }
 
-    rt_prep_timer();
-    do_run(a, b);
-    info.li_nrays = rtip->stats.rti_nrays;
-    info.li_cpusec = rt_read_timer((char *)0, 0);
-    info.li_percent = 42.0;	/* for now */
+    BU_EXTERNAL_INIT(&zraw);
+    if (srv_caps & REMRT_CAP_LZ4) {
+	count = htonl((uint32_t)nspans);
+	append_external(&zraw, &zalloc, &count, sizeof(count));
+    }
 
-    if (!bu_struct_export(&ext, (void *)&info, desc_line_info))
-	bu_exit(98, "ph_lines: bu_struct_export failure\n");
+    for (i = 0; i < nspans; i++) {
+	a = spans[i][0];
+	b = spans[i][1];
 
-    if (debug) {
-	fprintf(stderr, "PIXELS fr=%d pix=%d..%d, rays=%d, cpu=%g\n",
-		info.li_frame,
-		info.li_startpix, info.li_endpix,
-		info.li_nrays, info.li_cpusec);
-    }
+	srv_startpix = a;		/* buffer un-offset for view_pixel */
 
-    ret = pkg_2send(MSG_PIXELS, (const char *)ext.ext_buf, ext.ext_nbytes, (const char *)scanbuf, (b-a+1)*3, pcsrv);
-    if (ret < 0) {
-	fprintf(stderr, "MSG_PIXELS send error\n");
+	/* FIXME: if we do less than we were assigned, remrt is just going
+	 * to drop us!  If we go over our scanlen, we'll probably overstep
+	 * memory in the view front-end.
+	 */
+	if (b-a+1 > srv_scanlen)
+	    b = a + srv_scanlen - 1;
+
+	rtip->stats.rti_nrays = 0;
+	info.li_startpix = a;
+	info.li_endpix = b;
+	info.li_frame = spans[i][2];
+
+	rt_prep_timer();
+	do_run(a, b);
+	info.li_nrays = rtip->stats.rti_nrays;
+	info.li_cpusec = rt_read_timer((char *)0, 0);
+	info.li_percent = 42.0;	/* for now */
+
+	if (!bu_struct_export(&ext, (void *)&info, desc_line_info))
+	    bu_exit(98, "ph_lines: bu_struct_export failure\n");
+
+	if (debug) {
+	    fprintf(stderr, "PIXELS fr=%d pix=%d..%d, rays=%d, cpu=%g\n",
+		    info.li_frame,
+		    info.li_startpix, info.li_endpix,
+		    info.li_nrays, info.li_cpusec);
+	}
+
+	if (srv_caps & REMRT_CAP_LZ4) {
+	    append_external(&zraw, &zalloc, ext.ext_buf, ext.ext_nbytes);
+	    append_external(&zraw, &zalloc, scanbuf, (b-a+1)*3);
+	} else {
+	    ret = pkg_2send(MSG_PIXELS, (const char *)ext.ext_buf, ext.ext_nbytes, (const char *)scanbuf, (b-a+1)*3, pcsrv);
+	    if (ret < 0)
+		fprintf(stderr, "MSG_PIXELS send error\n");
+	}
 	bu_free_external(&ext);
     }
 
-    bu_free_external(&ext);
+    if (srv_caps & REMRT_CAP_LZ4) {
+	struct bu_external z;
+
+	if (rt_compress_external(&z, &zraw) < 0)
+	    bu_exit(98, "ph_lines: pixel compression failure\n");
+	ret = pkg_send(MSG_PIXELS_Z, (const char *)z.ext_buf, z.ext_nbytes, pcsrv);
+	if (ret < 0)
+	    fprintf(stderr, "MSG_PIXELS_Z send error\n");
+	bu_free_external(&z);
+	bu_free_external(&zraw);
+    }
+    free(buf);
 }
 
 
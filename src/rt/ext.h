@@ -139,6 +139,10 @@ extern vect_t dx_model;			/* view delta-X as model-space vect (width of pixel as
 extern vect_t dx_unit;			/* unit-len dir vector of pixel side-to-side */
 extern vect_t dy_model;			/* view delta-Y as model-space vect (height of pixel as vector) */
 extern vect_t dy_unit;			/* unit-len dir vector of pixel top-to-bottom */
+extern double adaptive_threshold;	/* >0 enables adaptive hypersampling */
+extern int adaptive_heatgraph;		/* !0 draws a sample-count heat graph */
+extern size_t adaptive_samples[MAX_PSW];	/* rays fired per CPU */
+extern size_t adaptive_pixels[MAX_PSW];	/* pixels sampled per CPU */
 /** 'jitter' variable values **/
 #define JITTER_CELL 0x1			/* jitter position of ray in each cell */
 #define JITTER_FRAME 0x2		/* jitter position of entire frame */
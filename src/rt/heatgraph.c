@@ -21,7 +21,8 @@
 /** @file rt/heatgraph.c
  *
  * Holds information on the time table used for the heat graph, which
- * is a light mode used in view.c
+ * is a light mode used in view.c.  The same table also records the
+ * number of rays fired per pixel when adaptive_heatgraph is set.
  *
  */
 
@@ -57,8 +58,6 @@ timeTable_init(int x, int y)
 {
     static fastf_t **timeTable = NULL;
 
-    bu_log("Initializing heatgraph timers\n");
-
     /*
      * Time table will be initialized to the size of the current
      * framebuffer by using a malloc.
@@ -72,6 +71,7 @@ timeTable_init(int x, int y)
 
 	/* Semaphore Acquire goes here */
 	if (timeTable == NULL) {
+	    bu_log("Initializing heatgraph timers\n");
 	    timeTable = (fastf_t **)bu_malloc(x * sizeof(fastf_t *), "timeTable");
 	    for (i = 0; i < x; i++) {
 		timeTable[i] = (fastf_t *)bu_malloc(y * sizeof(fastf_t), "timeTable[i]");
@@ -143,6 +143,14 @@ int a_onehit = -1;
  */
 int a_no_booleans = -1;
 
+/**
+ * Ray cost profiling, with -c 'set profile=#' to log the # most
+ * expensive primitives and regions after each frame, and/or -c 'set
+ * profile_csv=file.csv' to write every entry to a CSV file.
+ */
+int profile_rows = 0;
+struct bu_vls profile_csv = BU_VLS_INIT_ZERO;
+
 /* Viewing module specific "set" variables:
  *
  * Note: The actual byte offsets will get set at run time in
@@ -165,6 +173,10 @@ struct bu_structparse view_parse[] = {
     {"%g", 1, "ambOffset", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"%d", 1, "ambSlow", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"%d", 1, "embed_icv_metadata", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%g", 1, "adaptive_threshold", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%d", 1, "adaptive_heatgraph", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%d", 1, "profile", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%V", 1, "profile_csv", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"", 0, (char *)0, 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL}
 };
 
@@ -551,13 +563,45 @@ view_eol(struct application *UNUSED(ap))
 void
 view_end(struct application *ap)
 {
+    if (adaptive_threshold > 0.0 && hypersample > 0) {
+	size_t samples = 0;
+	size_t pixels = 0;
+	int i;
+
+	for (i = 0; i < MAX_PSW; i++) {
+	    samples += adaptive_samples[i];
+	    pixels += adaptive_pixels[i];
+	    adaptive_samples[i] = adaptive_pixels[i] = 0;
+	}
+	if (pixels)
+	    bu_log("Adaptive sampling: %zu rays for %zu pixels (%.2f per pixel, %d max)\n",
+		   samples, pixels, (double)samples / (double)pixels, hypersample + 1);
+    }
+
+    if (rt_profile_enabled(ap->a_rt_i)) {
+	if (profile_rows > 0) {
+	    struct bu_vls report = BU_VLS_INIT_ZERO;
+	    rt_profile_report(&report, ap->a_rt_i, (size_t)profile_rows);
+	    bu_log("%s", bu_vls_cstr(&report));
+	    bu_vls_free(&report);
+	}
+	if (bu_vls_strlen(&profile_csv) > 0) {
+	    FILE *fp = fopen(bu_vls_cstr(&profile_csv), "w");
+	    if (!fp || rt_profile_csv(fp, ap->a_rt_i) != 0)
+		bu_log("WARNING: unable to write ray cost profile to %s\n", bu_vls_cstr(&profile_csv));
+	    if (fp)
+		fclose(fp);
+	}
+    }
+
     /* If the heat graph is on, render it after all pixels completed */
-    if (lightmodel == 8) {
+    if (lightmodel == 8 || adaptive_heatgraph) {
 	fastf_t **timeTable;
 	timeTable = timeTable_init(0, 0);
-	bu_log("Building Heat-Graph!\n");
+	bu_log("Building %s Heat-Graph!\n", lightmodel == 8 ? "Time" : "Sample-Count");
 	bu_log("X:%d Y:%d W:%zu H%zu\n", ap->a_x, ap->a_y, width, height);
-	timeTable_process(timeTable, ap, fbp);
+	if (timeTable)
+	    timeTable_process(timeTable, ap, fbp);
     }
 
     if (fullfloat_mode) {
@@ -1535,6 +1579,12 @@ view_2init(struct application *ap, char *UNUSED(framename))
 	ap->a_no_booleans = a_no_booleans;
     }
 
+    /* Each frame gets its own ray cost profile */
+    if (profile_rows > 0 || bu_vls_strlen(&profile_csv) > 0) {
+	rt_profile_reset(ap->a_rt_i);
+	rt_profile_enable(ap->a_rt_i, 1);
+    }
+
     pwidth = 3;
 
     /* Always allocate the scanline[] array (unless we already have
@@ -1872,6 +1922,10 @@ application_init(void)
     view_parse[10].sp_offset = bu_byteoffset(ambOffset);
     view_parse[11].sp_offset = bu_byteoffset(ambSlow);
     view_parse[12].sp_offset = bu_byteoffset(embed_icv_metadata);
+    view_parse[13].sp_offset = bu_byteoffset(adaptive_threshold);
+    view_parse[14].sp_offset = bu_byteoffset(adaptive_heatgraph);
+    view_parse[15].sp_offset = bu_byteoffset(profile_rows);
+    view_parse[16].sp_offset = bu_byteoffset(profile_csv);
 
     option("", "-A #", "Set image brightness, ambient light intensity (default: 0.4)", 0);
     option("Raytrace", "-i", "Enable incremental (progressive-style) rendering", 1);
@@ -1879,6 +1933,10 @@ application_init(void)
     option("Advanced", "-O file.dpix", "Render to .dpix format file, double precision image data", 1);
     option("Advanced", "-m density, r, g, b", "Render hazy air (e.g., 0.0002, 0.8, 0.9, 1 for sky-blue haze)", 1);
     option("Advanced", "-c 'set embed_icv_metadata=1'", "Embed scene+camera metadata in output PNG for icv_diff/imgdiff nirt analysis", 1);
+    option("Advanced", "-c 'set adaptive_threshold=#'", "With -H, stop sampling flat pixels once samples agree within # (e.g., 0.02)", 1);
+    option("Advanced", "-c 'set adaptive_heatgraph=1'", "Replace the image with a heat graph of rays fired per pixel", 1);
+    option("Advanced", "-c 'set profile=#'", "Log the # most expensive primitives and regions after each frame", 1);
+    option("Advanced", "-c 'set profile_csv=file.csv'", "Write the ray cost of every primitive and region to a CSV file", 1);
     option("Developer", "-l #", "Select lighting model (default is 0)", 1);
 
     /* this reassignment hack ensures help is last in the first list */
@@ -79,6 +79,18 @@ int last_pixel = 0;			/* last pixel number */
 
 int stop_worker = 0;
 
+/* Adaptive hypersampling, set with -c 'set adaptive_threshold=#' */
+double adaptive_threshold = 0.0;	/* max per-channel sample contrast */
+int adaptive_heatgraph = 0;		/* !0 draws a sample-count heat graph */
+size_t adaptive_samples[MAX_PSW] = {0};
+size_t adaptive_pixels[MAX_PSW] = {0};
+
+/* samples fired before the first convergence test, and between tests */
+#define ADAPTIVE_BASE_SAMPLES 4
+
+/* depth spread, as a fraction of hit distance, treated as an edge */
+#define ADAPTIVE_DEPTH_RATIO 0.01
+
 /**
  * For certain hypersample values there is a particular advantage to
  * subdividing the pixel and shooting a ray in each sub-pixel.  This
@@ -121,6 +133,80 @@ static struct jitter_pattern pt_pats[] = {
 };
 
 
+/**
+ * Order in which the adaptive sampler visits the sub-pixels of each
+ * pt_pats[] entry, so that the base samples are spread across the
+ * whole pixel instead of bunching up along one edge.
+ */
+static const int pt_order[][16] = {
+    {0, 3, 1, 2},
+    {0, 3, 1, 2, 4},
+    {0, 8, 2, 6, 4, 1, 7, 3, 5},
+    {0, 10, 8, 2, 5, 15, 13, 7, 1, 11, 9, 3, 4, 14, 12, 6}
+};
+
+
+/**
+ * Running statistics of the samples fired so far for one pixel.
+ */
+struct adaptive_stats {
+    vect_t cmin;
+    vect_t cmax;
+    fastf_t dmin;
+    fastf_t dmax;
+    const void *region;
+    int hits;
+    int misses;
+    int edge;		/* saw a region or depth discontinuity */
+};
+
+
+static void
+adaptive_add(struct adaptive_stats *as, const struct application *ap)
+{
+    if (as->hits + as->misses == 0) {
+	VMOVE(as->cmin, ap->a_color);
+	VMOVE(as->cmax, ap->a_color);
+    } else {
+	VMIN(as->cmin, ap->a_color);
+	VMAX(as->cmax, ap->a_color);
+    }
+
+    if (ap->a_user == 0) {
+	as->misses++;
+	return;
+    }
+    if (as->hits++ == 0) {
+	as->region = ap->a_uptr;
+	as->dmin = as->dmax = ap->a_dist;
+	return;
+    }
+    if (ap->a_uptr != as->region)
+	as->edge = 1;
+    V_MIN(as->dmin, ap->a_dist);
+    V_MAX(as->dmax, ap->a_dist);
+    if (as->dmax - as->dmin > ADAPTIVE_DEPTH_RATIO * FMAX(fabs(as->dmin), fabs(as->dmax)))
+	as->edge = 1;
+}
+
+
+/**
+ * A pixel is done once its samples agree: no silhouette (hit and
+ * miss mixed), no region or depth edge, and no color channel
+ * spreading further than adaptive_threshold.
+ */
+static int
+adaptive_converged(const struct adaptive_stats *as)
+{
+    if (as->edge || (as->hits && as->misses))
+	return 0;
+
+    return as->cmax[X] - as->cmin[X] <= adaptive_threshold
+	&& as->cmax[Y] - as->cmin[Y] <= adaptive_threshold
+	&& as->cmax[Z] - as->cmin[Z] <= adaptive_threshold;
+}
+
+
 /**
  * Compute the origin for this ray, based upon the number of samples
  * per pixel and the number of the current sample.  For certain
@@ -157,6 +243,7 @@ do_pixel(int cpu, int pat_num, int pixelnum)
     vect_t point;		/* Ref point on eye or view plane */
     vect_t colorsum = {(fastf_t)0.0, (fastf_t)0.0, (fastf_t)0.0};
     int samplenum = 0;
+    int nsamples = 1;
     static const double one_over_255 = 1.0 / 255.0;
     const int pindex = (pixelnum * sizeof(RGBpixel));
 
@@ -335,6 +422,11 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 
     } else {
 	/* hypersampling, so iterate */
+	struct adaptive_stats as;
+	int adaptive = (adaptive_threshold > 0.0);
+
+	memset(&as, 0, sizeof(as));
+	nsamples = 0;
 
 	for (samplenum=0; samplenum<=hypersample; samplenum++) {
 	    /* shoot at a point based on the jitter pattern number */
@@ -344,7 +436,10 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 	    /**********************/
 
 	    if (jitter & JITTER_CELL) {
-		jitter_start_pnt(point, &a, samplenum, pat_num);
+		if (adaptive && pat_num >= 0)
+		    jitter_start_pnt(point, &a, pt_order[pat_num][samplenum], pat_num);
+		else
+		    jitter_start_pnt(point, &a, samplenum, pat_num);
 	    }
 
 	    if (a.a_rt_i->rti_prismtrace) {
@@ -413,6 +508,14 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 		VSET(a.a_color, left, 0, right);
 	    }
 	    VADD2(colorsum, colorsum, a.a_color);
+	    nsamples++;
+
+	    /* stop early once a flat pixel has had its base samples */
+	    if (adaptive) {
+		adaptive_add(&as, &a);
+		if (nsamples % ADAPTIVE_BASE_SAMPLES == 0 && adaptive_converged(&as))
+		    break;
+	    }
 
 	    /********************/
 	    /* END NON-UNROLLED */
@@ -422,11 +525,14 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 	{
 	    /* scale the hypersampled results */
 	    fastf_t f;
-	    f = 1.0 / (hypersample+1);
+	    f = 1.0 / nsamples;
 	    VSCALE(a.a_color, colorsum, f);
 	}
     } /* end unrolling else case */
 
+    adaptive_samples[cpu] += nsamples;
+    adaptive_pixels[cpu]++;
+
     /* bu_log("2: [%d, %d] : [%.2f, %.2f, %.2f]\n", pixelnum%width, pixelnum/width, a.a_color[0], a.a_color[1], a.a_color[2]); */
 
     /* Add get_pixel_timer here to get total time taken to get pixel, when asked */
@@ -440,6 +546,14 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 	timeTable = timeTable_init(width, height);
 	timeTable_input(a.a_x, a.a_y, pixelTime, timeTable);
 	bu_semaphore_release(RT_SEM_RESULTS);
+    } else if (adaptive_heatgraph) {
+	/* Same table, but recording how many rays this pixel took */
+	fastf_t **timeTable;
+
+	bu_semaphore_acquire(RT_SEM_RESULTS);
+	timeTable = timeTable_init(width, height);
+	timeTable_input(a.a_x, a.a_y, (fastf_t)nsamples, timeTable);
+	bu_semaphore_release(RT_SEM_RESULTS);
     }
 
     /* we're done */